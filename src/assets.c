@@ -0,0 +1,554 @@
+#include "assets.h"
+#include "jobs.h"
+#include "memtrack.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef union {
+    SpriteAtlas atlas;
+    LodModel lod;
+    Image image;
+} AssetData;
+
+typedef struct {
+    bool used;
+    bool queued;                    // in the upload ring
+    bool reload;                    // file changed while in the pipeline, decode again when out
+    AssetKind kind;
+    AssetState state;
+    uint32_t version;
+    int32_t refCount;
+    uint32_t lastUsed;              // UpdateAssets() frame, for the LRU
+    uint64_t hash;                  // of fileName
+    size_t bytes;                   // live data, counted in the kind's category
+    char fileName[ASSET_PATH_LENGTH];
+    AssetData live;                 // what the getters hand out once ready
+    AssetData decoded;              // worker output, owned by the pipeline until uploaded
+} AssetSlot;
+
+static struct {
+    bool initialized;
+    AssetSlot slots[ASSETS_MAX];
+    int32_t uploads[ASSETS_MAX];    // ring of slots the workers are done with
+    int32_t uploadHead;
+    int32_t uploadTail;
+    int32_t inFlight;               // decode jobs not finished yet
+    pthread_mutex_t lock;
+    pthread_cond_t idle;
+    uint32_t frame;
+    size_t bytes[ASSET_MEMORY_COUNT];
+    size_t budget[ASSET_MEMORY_COUNT];
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t evictions;
+    Image placeholderImage;
+    Texture2D placeholder;
+    SpriteAtlas placeholderAtlas;
+    LodModel placeholderLod;
+    float uploadMs;
+} assets = { .initialized = false };
+
+// Per kind
+//----------------------------------------------------------------------------------
+static const AssetMemory assetMemory[ASSET_KIND_COUNT] = {
+    [ASSET_SPRITE_ATLAS] = ASSET_MEMORY_GPU_TEXTURES,
+    [ASSET_LOD_MODEL] = ASSET_MEMORY_MESHES,
+    [ASSET_IMAGE] = ASSET_MEMORY_CPU_IMAGES,
+};
+
+static bool AssetDecode(AssetKind kind, const char *fileName, AssetData *data)
+{
+    switch (kind)
+    {
+        case ASSET_SPRITE_ATLAS: data->atlas = LoadSpriteAtlas(fileName); return IsSpriteAtlasReady(&data->atlas);
+        case ASSET_LOD_MODEL: data->lod = LoadLodModel(fileName); return IsLodModelReady(&data->lod);
+        case ASSET_IMAGE:
+        {
+            data->image = LoadImage(fileName);
+            if (!IsImageReady(data->image)) return false;
+            MemChargeTagged(MEM_TAG_ASSETS, GetImageMemorySize(data->image));
+            return true;
+        }
+        default: return false;
+    }
+}
+
+static void AssetUpload(AssetKind kind, AssetData *data)
+{
+    switch (kind)
+    {
+        case ASSET_SPRITE_ATLAS: UploadSpriteAtlas(&data->atlas); break;
+        case ASSET_LOD_MODEL: UploadLodModel(&data->lod); break;
+        default: break;
+    }
+}
+
+// CPU or GPU side, whichever the data is on
+static void AssetUnloadData(AssetKind kind, AssetData *data)
+{
+    switch (kind)
+    {
+        case ASSET_SPRITE_ATLAS: UnloadSpriteAtlas(&data->atlas); break;
+        case ASSET_LOD_MODEL: UnloadLodModel(&data->lod); break;
+        case ASSET_IMAGE:
+        {
+            MemReleaseTagged(MEM_TAG_ASSETS, GetImageMemorySize(data->image));
+            UnloadImage(data->image);
+        } break;
+        default: break;
+    }
+}
+
+// Live data only, atlas pages are on the GPU by then
+static size_t AssetSize(AssetKind kind, const AssetData *data)
+{
+    size_t size = 0;
+    switch (kind)
+    {
+        case ASSET_SPRITE_ATLAS:
+        {
+            for (int32_t p = 0; p < data->atlas.pageCount; p++)
+            {
+                const Texture2D *page = &data->atlas.textures[p];
+                size += GetImageMemorySize((Image){ NULL, page->width, page->height, page->mipmaps, page->format });
+            }
+        } break;
+        case ASSET_LOD_MODEL:
+        {
+            for (int32_t l = 0; l < data->lod.levelCount; l++) size += GetMeshMemorySize(&data->lod.meshes[l]);
+        } break;
+        case ASSET_IMAGE: size = GetImageMemorySize(data->image); break;
+        default: break;
+    }
+    return size;
+}
+
+// Registry
+//----------------------------------------------------------------------------------
+// FNV-1a
+static uint64_t AssetHash(const char *fileName)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (const unsigned char *c = (const unsigned char *)fileName; *c != '\0'; c++) hash = (hash ^ *c)*1099511628211ull;
+    return hash;
+}
+
+static bool AssetValid(int32_t asset)
+{
+    return assets.initialized && asset >= 0 && asset < ASSETS_MAX && assets.slots[asset].used;
+}
+
+// Takes a reference on the cached asset for fileName, -1 when it is not cached
+static int32_t AssetFind(AssetKind kind, const char *fileName, uint64_t hash)
+{
+    for (int32_t i = 0; i < ASSETS_MAX; i++)
+    {
+        AssetSlot *slot = &assets.slots[i];
+        if (!slot->used || slot->hash != hash || slot->kind != kind || strcmp(slot->fileName, fileName) != 0) continue;
+
+        slot->refCount++;
+        slot->lastUsed = assets.frame;
+        assets.hits++;
+        return i;
+    }
+    return -1;
+}
+
+static int32_t AssetAllocate(AssetKind kind, const char *fileName, uint64_t hash)
+{
+    for (int32_t i = 0; i < ASSETS_MAX; i++)
+    {
+        AssetSlot *slot = &assets.slots[i];
+        if (slot->used) continue;
+
+        *slot = (AssetSlot){ .used = true, .kind = kind, .state = ASSET_STATE_DECODING, .refCount = 1,
+                             .lastUsed = assets.frame, .hash = hash };
+        snprintf(slot->fileName, sizeof(slot->fileName), "%s", fileName);
+        assets.misses++;
+        return i;
+    }
+    TraceLog(LOG_WARNING, "ASSETS: [%s] out of asset slots (%d)", fileName, ASSETS_MAX);
+    return -1;
+}
+
+// Slot must be out of the pipeline (not decoding, not queued)
+static void AssetFree(AssetSlot *slot)
+{
+    if (slot->state == ASSET_STATE_DECODED) AssetUnloadData(slot->kind, &slot->decoded);
+    if (slot->version > 0) AssetUnloadData(slot->kind, &slot->live);
+    assets.bytes[assetMemory[slot->kind]] -= slot->bytes;
+    *slot = (AssetSlot){ 0 };
+}
+
+// Pipeline
+//----------------------------------------------------------------------------------
+static void AssetPushUpload(int32_t index)
+{
+    assets.slots[index].queued = true;
+    assets.uploads[assets.uploadTail % ASSETS_MAX] = index;
+    assets.uploadTail++;
+}
+
+static void AssetDecodeJob(void *user)
+{
+    AssetSlot *slot = user;
+    // the slot's file name and decoded data belong to this job until it is queued
+    bool ok = AssetDecode(slot->kind, slot->fileName, &slot->decoded);
+    // a reload that fails leaves the version already live alone
+    bool reloaded = (slot->version > 0);
+    if (!ok) TraceLog(LOG_WARNING, "ASSETS: [%s] could not be decoded, keeping the %s", slot->fileName, reloaded ? "previous version" : "placeholder");
+
+    pthread_mutex_lock(&assets.lock);
+    slot->state = ok ? ASSET_STATE_DECODED : reloaded ? ASSET_STATE_READY : ASSET_STATE_FAILED;
+    AssetPushUpload((int32_t)(slot - assets.slots));
+    assets.inFlight--;
+    pthread_cond_broadcast(&assets.idle);
+    pthread_mutex_unlock(&assets.lock);
+}
+
+// Slot must be out of the pipeline
+static void AssetSubmitDecode(int32_t index)
+{
+    pthread_mutex_lock(&assets.lock);
+    assets.slots[index].state = ASSET_STATE_DECODING;
+    assets.inFlight++;
+    pthread_mutex_unlock(&assets.lock);
+    JobsSubmit(AssetDecodeJob, &assets.slots[index]);
+}
+
+static int32_t AssetLoadAsync(AssetKind kind, const char *fileName)
+{
+    if (!assets.initialized) return -1;
+
+    uint64_t hash = AssetHash(fileName);
+    int32_t index = AssetFind(kind, fileName, hash);
+    if (index >= 0) return index;
+    index = AssetAllocate(kind, fileName, hash);
+    if (index >= 0) AssetSubmitDecode(index);
+    return index;
+}
+
+static int32_t AssetAdd(AssetKind kind, const char *name, AssetData data)
+{
+    uint64_t hash = AssetHash(name);
+    int32_t index = assets.initialized ? AssetFind(kind, name, hash) : -1;
+    bool cached = (index >= 0);
+    if (index < 0 && assets.initialized) index = AssetAllocate(kind, name, hash);
+
+    // a cached slot still decoding or waiting for its upload owns decoded until then
+    bool pipelined = false;
+    if (cached)
+    {
+        pthread_mutex_lock(&assets.lock);
+        pipelined = assets.slots[index].queued || assets.slots[index].state == ASSET_STATE_DECODING;
+        pthread_mutex_unlock(&assets.lock);
+    }
+    if (index < 0 || assets.slots[index].refCount > 1 || pipelined)
+    {
+        // no room, somebody built it before, or that version is on its way
+        AssetUnloadData(kind, &data);
+        return index;
+    }
+
+    pthread_mutex_lock(&assets.lock);
+    assets.slots[index].decoded = data;
+    assets.slots[index].state = ASSET_STATE_DECODED;
+    AssetPushUpload(index);
+    pthread_mutex_unlock(&assets.lock);
+    return index;
+}
+
+// Raylib thread, slot state is ASSET_STATE_DECODED
+static void AssetGoLive(AssetSlot *slot)
+{
+    AssetUpload(slot->kind, &slot->decoded);
+    if (slot->version > 0) AssetUnloadData(slot->kind, &slot->live);
+    slot->live = slot->decoded;
+    slot->decoded = (AssetData){ 0 };
+    slot->version++;
+
+    const AssetMemory category = assetMemory[slot->kind];
+    assets.bytes[category] -= slot->bytes;
+    slot->bytes = AssetSize(slot->kind, &slot->live);
+    assets.bytes[category] += slot->bytes;
+
+    pthread_mutex_lock(&assets.lock);
+    slot->state = ASSET_STATE_READY;
+    pthread_mutex_unlock(&assets.lock);
+}
+
+static void AssetEvict(void)
+{
+    for (int32_t category = 0; category < ASSET_MEMORY_COUNT; category++)
+    {
+        while (assets.bytes[category] > assets.budget[category])
+        {
+            // referenced assets are never evicted, a category can stay over budget
+            int32_t oldest = -1;
+            pthread_mutex_lock(&assets.lock);
+            for (int32_t i = 0; i < ASSETS_MAX; i++)
+            {
+                const AssetSlot *slot = &assets.slots[i];
+                if (!slot->used || slot->refCount > 0 || slot->queued || slot->state != ASSET_STATE_READY) continue;
+                if ((int32_t)assetMemory[slot->kind] != category) continue;
+                if (oldest < 0 || (int32_t)(slot->lastUsed - assets.slots[oldest].lastUsed) < 0) oldest = i;
+            }
+            pthread_mutex_unlock(&assets.lock);
+            if (oldest < 0) break;
+
+            AssetFree(&assets.slots[oldest]);
+            assets.evictions++;
+        }
+    }
+}
+
+void InitAssets(void)
+{
+    if (assets.initialized) return;
+
+    memset(assets.slots, 0, sizeof(assets.slots));
+    assets.uploadHead = assets.uploadTail = 0;
+    assets.inFlight = 0;
+    assets.frame = 0;
+    memset(assets.bytes, 0, sizeof(assets.bytes));
+    assets.budget[ASSET_MEMORY_CPU_IMAGES] = ASSET_BUDGET_CPU_IMAGES;
+    assets.budget[ASSET_MEMORY_GPU_TEXTURES] = ASSET_BUDGET_GPU_TEXTURES;
+    assets.budget[ASSET_MEMORY_MESHES] = ASSET_BUDGET_MESHES;
+    assets.hits = assets.misses = assets.evictions = 0;
+    pthread_mutex_init(&assets.lock, NULL);
+    pthread_cond_init(&assets.idle, NULL);
+
+    // loud enough that nobody mistakes it for art
+    assets.placeholderImage = GenImageChecked(64, 64, 8, 8, MAGENTA, BLACK);
+    assets.placeholder = LoadTextureFromImage(assets.placeholderImage);
+    assets.placeholderAtlas = (SpriteAtlas){ .pageCount = 1, .textures = { assets.placeholder } };
+    // GenMeshCube() uploads already
+    assets.placeholderLod = (LodModel){ .levelCount = 1, .meshes = { GenMeshCube(1.0f, 1.0f, 1.0f) }, .radius = 0.87f, .uploaded = true };
+    MemChargeTagged(MEM_TAG_ASSETS, GetImageMemorySize(assets.placeholderImage));
+    // UnloadLodModel() releases the cube's arrays
+    MemChargeTagged(MEM_TAG_ASSETS, GetMeshMemorySize(&assets.placeholderLod.meshes[0]));
+    assets.initialized = true;
+}
+
+void CloseAssets(void)
+{
+    if (!assets.initialized) return;
+
+    pthread_mutex_lock(&assets.lock);
+    while (assets.inFlight > 0) pthread_cond_wait(&assets.idle, &assets.lock);
+    pthread_mutex_unlock(&assets.lock);
+
+    for (int32_t i = 0; i < ASSETS_MAX; i++)
+    {
+        AssetSlot *slot = &assets.slots[i];
+        if (!slot->used) continue;
+        // everything the game loaded should have been released by now
+        if (slot->refCount > 0) TraceLog(LOG_WARNING, "ASSETS: [%s] still has %d references at close", slot->fileName, slot->refCount);
+        AssetFree(slot);
+    }
+
+    UnloadLodModel(&assets.placeholderLod);
+    UnloadTexture(assets.placeholder);
+    MemReleaseTagged(MEM_TAG_ASSETS, GetImageMemorySize(assets.placeholderImage));
+    UnloadImage(assets.placeholderImage);
+    pthread_cond_destroy(&assets.idle);
+    pthread_mutex_destroy(&assets.lock);
+    assets.initialized = false;
+}
+
+int32_t LoadSpriteAtlasAsync(const char *fileName)
+{
+    return AssetLoadAsync(ASSET_SPRITE_ATLAS, fileName);
+}
+
+int32_t LoadLodModelAsync(const char *fileName)
+{
+    return AssetLoadAsync(ASSET_LOD_MODEL, fileName);
+}
+
+int32_t LoadImageAsync(const char *fileName)
+{
+    return AssetLoadAsync(ASSET_IMAGE, fileName);
+}
+
+int32_t AddSpriteAtlasAsset(const char *name, SpriteAtlas atlas)
+{
+    return AssetAdd(ASSET_SPRITE_ATLAS, name, (AssetData){ .atlas = atlas });
+}
+
+int32_t AddLodModelAsset(const char *name, LodModel lod)
+{
+    return AssetAdd(ASSET_LOD_MODEL, name, (AssetData){ .lod = lod });
+}
+
+void ReleaseAsset(int32_t asset)
+{
+    if (!AssetValid(asset) || assets.slots[asset].refCount <= 0) return;
+
+    AssetSlot *slot = &assets.slots[asset];
+    slot->refCount--;
+    slot->lastUsed = assets.frame;
+    if (slot->refCount > 0) return;
+
+    // a failure is not worth caching, the file may be fixed by the next load.
+    // Still with a worker or in the upload queue, UpdateAssets() sees to it.
+    pthread_mutex_lock(&assets.lock);
+    bool failed = (slot->state == ASSET_STATE_FAILED) && !slot->queued;
+    pthread_mutex_unlock(&assets.lock);
+    if (failed) AssetFree(slot);
+}
+
+int32_t ReloadAssetFile(const char *fileName)
+{
+    if (!assets.initialized) return 0;
+
+    uint64_t hash = AssetHash(fileName);
+    int32_t count = 0;
+    for (int32_t i = 0; i < ASSETS_MAX; i++)
+    {
+        AssetSlot *slot = &assets.slots[i];
+        if (!slot->used || slot->hash != hash || strcmp(slot->fileName, fileName) != 0) continue;
+
+        pthread_mutex_lock(&assets.lock);
+        bool pending = (slot->state == ASSET_STATE_DECODING) || slot->queued;
+        if (pending) slot->reload = true;
+        pthread_mutex_unlock(&assets.lock);
+
+        // nobody holds it, the next load reads the new file
+        if (!pending && slot->refCount == 0) AssetFree(slot);
+        else if (!pending) AssetSubmitDecode(i);
+        if (slot->used) count++;
+    }
+    return count;
+}
+
+void WaitForAsset(int32_t asset)
+{
+    if (!AssetValid(asset)) return;
+
+    AssetSlot *slot = &assets.slots[asset];
+    pthread_mutex_lock(&assets.lock);
+    while (slot->state == ASSET_STATE_DECODING) pthread_cond_wait(&assets.idle, &assets.lock);
+    bool decoded = (slot->state == ASSET_STATE_DECODED);
+    pthread_mutex_unlock(&assets.lock);
+    // stays in the upload ring, UpdateAssets() skips it when it comes out
+    if (decoded) AssetGoLive(slot);
+}
+
+void UpdateAssets(float budgetMs)
+{
+    if (!assets.initialized) return;
+
+    assets.frame++;
+    double start = GetTime();
+    for (;;)
+    {
+        pthread_mutex_lock(&assets.lock);
+        int32_t index = (assets.uploadHead != assets.uploadTail) ? assets.uploads[assets.uploadHead % ASSETS_MAX] : -1;
+        if (index >= 0)
+        {
+            assets.uploadHead++;
+            assets.slots[index].queued = false;
+        }
+        pthread_mutex_unlock(&assets.lock);
+        if (index < 0) break;
+
+        AssetSlot *slot = &assets.slots[index];
+        if (slot->state == ASSET_STATE_DECODED) AssetGoLive(slot);
+        else if (slot->state == ASSET_STATE_FAILED && slot->refCount == 0) AssetFree(slot);
+        if (slot->used && slot->reload)
+        {
+            slot->reload = false;
+            AssetSubmitDecode(index);
+        }
+
+        if ((GetTime() - start)*1000.0 >= budgetMs) break;
+    }
+    assets.uploadMs = (float)((GetTime() - start)*1000.0);
+
+    AssetEvict();
+}
+
+void SetAssetBudget(AssetMemory category, size_t bytes)
+{
+    if (category < 0 || category >= ASSET_MEMORY_COUNT) return;
+    assets.budget[category] = bytes;
+}
+
+AssetState GetAssetState(int32_t asset)
+{
+    if (!AssetValid(asset)) return ASSET_STATE_FAILED;
+
+    pthread_mutex_lock(&assets.lock);
+    AssetState state = assets.slots[asset].state;
+    pthread_mutex_unlock(&assets.lock);
+    return state;
+}
+
+uint32_t GetAssetVersion(int32_t asset)
+{
+    return AssetValid(asset) ? assets.slots[asset].version : 0;
+}
+
+// version and live are only touched on the raylib thread, no lock needed
+static const AssetData *AssetLive(int32_t asset, AssetKind kind)
+{
+    if (!AssetValid(asset)) return NULL;
+
+    AssetSlot *slot = &assets.slots[asset];
+    if (slot->kind != kind || slot->version == 0) return NULL;
+    slot->lastUsed = assets.frame;
+    return &slot->live;
+}
+
+const SpriteAtlas *GetAssetSpriteAtlas(int32_t asset)
+{
+    const AssetData *data = AssetLive(asset, ASSET_SPRITE_ATLAS);
+    return (data != NULL) ? &data->atlas : &assets.placeholderAtlas;
+}
+
+const LodModel *GetAssetLodModel(int32_t asset)
+{
+    const AssetData *data = AssetLive(asset, ASSET_LOD_MODEL);
+    return (data != NULL) ? &data->lod : &assets.placeholderLod;
+}
+
+const Image *GetAssetImage(int32_t asset)
+{
+    const AssetData *data = AssetLive(asset, ASSET_IMAGE);
+    return (data != NULL) ? &data->image : &assets.placeholderImage;
+}
+
+Texture2D GetPlaceholderTexture(void)
+{
+    return assets.placeholder;
+}
+
+AssetStats GetAssetStats(void)
+{
+    AssetStats stats = { .uploadMs = assets.uploadMs };
+    if (!assets.initialized) return stats;
+
+    memcpy(stats.bytes, assets.bytes, sizeof(stats.bytes));
+    memcpy(stats.budget, assets.budget, sizeof(stats.budget));
+    stats.hits = assets.hits;
+    stats.misses = assets.misses;
+    stats.evictions = assets.evictions;
+
+    pthread_mutex_lock(&assets.lock);
+    for (int32_t i = 0; i < ASSETS_MAX; i++)
+    {
+        const AssetSlot *slot = &assets.slots[i];
+        if (!slot->used) continue;
+        if (slot->state == ASSET_STATE_DECODING) stats.decoding++;
+        else if (slot->state == ASSET_STATE_DECODED) stats.uploading++;
+        else if (slot->state == ASSET_STATE_READY) stats.ready++;
+        else stats.failed++;
+
+        if (slot->refCount > 0) stats.referenced++;
+        else if (slot->state == ASSET_STATE_READY) stats.cached++;
+    }
+    pthread_mutex_unlock(&assets.lock);
+    return stats;
+}
@@ -0,0 +1,107 @@
+#ifndef ASSETS_H
+#define ASSETS_H
+
+#include "atlas.h"
+#include "lod.h"
+#include "raylib.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Asynchronous, reference counted asset cache.
+// Load*Async() returns an asset id at once and decodes the file on the job
+// system. Decoded assets wait in an upload queue that UpdateAssets() drains
+// on the raylib thread (GL lives there) until the frame's time budget is
+// spent. Until an asset is ready its getter hands out the kind's
+// placeholder, nothing ever blocks on a load.
+//
+// Assets are keyed by the hash of their path (and kind): loading a path
+// that is already in the cache takes another reference on the same asset.
+// ReleaseAsset() drops one; an asset nobody references stays cached and
+// is only evicted, least recently used first, once its memory category
+// goes over budget.
+
+#define ASSETS_MAX 256
+#define ASSET_PATH_LENGTH 256
+#define ASSET_UPLOAD_BUDGET_MS 2.0f
+
+typedef enum {
+    ASSET_SPRITE_ATLAS = 0,
+    ASSET_LOD_MODEL,
+    ASSET_IMAGE,                    // CPU side only
+    ASSET_KIND_COUNT
+} AssetKind;
+
+typedef enum {
+    ASSET_STATE_DECODING = 0,       // on a worker
+    ASSET_STATE_DECODED,            // waiting in the upload queue
+    ASSET_STATE_READY,
+    ASSET_STATE_FAILED              // placeholder for good
+} AssetState;
+
+// Every kind is accounted in one category
+typedef enum {
+    ASSET_MEMORY_CPU_IMAGES = 0,    // ASSET_IMAGE
+    ASSET_MEMORY_GPU_TEXTURES,      // ASSET_SPRITE_ATLAS pages, mips included
+    ASSET_MEMORY_MESHES,            // ASSET_LOD_MODEL, every level
+    ASSET_MEMORY_COUNT
+} AssetMemory;
+
+#define ASSET_BUDGET_CPU_IMAGES (64u << 20)
+#define ASSET_BUDGET_GPU_TEXTURES (256u << 20)
+#define ASSET_BUDGET_MESHES (128u << 20)
+
+typedef struct {
+    int32_t decoding;
+    int32_t uploading;              // decoded, waiting for UpdateAssets()
+    int32_t ready;
+    int32_t failed;
+    int32_t referenced;             // assets somebody holds
+    int32_t cached;                 // ready but unreferenced, first to go
+    size_t bytes[ASSET_MEMORY_COUNT];   // live assets, referenced or not
+    size_t budget[ASSET_MEMORY_COUNT];
+    uint32_t hits;                  // loads served from the cache, since InitAssets()
+    uint32_t misses;
+    uint32_t evictions;
+    float uploadMs;                 // spent in the last UpdateAssets()
+} AssetStats;
+
+void InitAssets(void);              // after InitWindow(), creates the placeholders
+void CloseAssets(void);             // waits for decodes in flight, unloads everything
+
+// -1 when out of asset slots
+int32_t LoadSpriteAtlasAsync(const char *fileName);
+int32_t LoadLodModelAsync(const char *fileName);
+int32_t LoadImageAsync(const char *fileName);
+// Assets built in memory (fallbacks), CPU side only, they are uploaded through
+// the queue. Keyed by name like a path: when name is cached the data passed
+// in is unloaded and the cached asset is referenced instead.
+int32_t AddSpriteAtlasAsset(const char *name, SpriteAtlas atlas);
+int32_t AddLodModelAsset(const char *name, LodModel lod);
+void ReleaseAsset(int32_t asset);
+
+// The file changed on disk: every asset loaded from it is decoded again on a
+// worker and swapped in by UpdateAssets() once uploaded. The old version
+// stays live until then, and for good when the new one cannot be decoded.
+// Returns how many assets are being reloaded.
+int32_t ReloadAssetFile(const char *fileName);
+
+// Blocks until the asset is decoded and makes it live right away, for
+// startup code that cannot go on without it. Raylib thread only.
+void WaitForAsset(int32_t asset);
+
+// Once per frame on the raylib thread, uploads at least one asset when any
+// is waiting, then evicts unreferenced assets from categories over budget
+void UpdateAssets(float budgetMs);
+void SetAssetBudget(AssetMemory category, size_t bytes);
+
+AssetState GetAssetState(int32_t asset);
+// Changes every time a new version of the asset goes live, 0 while on the placeholder
+uint32_t GetAssetVersion(int32_t asset);
+const SpriteAtlas *GetAssetSpriteAtlas(int32_t asset);     // placeholder: one checker page, no sprites
+const LodModel *GetAssetLodModel(int32_t asset);           // placeholder: a unit cube
+const Image *GetAssetImage(int32_t asset);                 // placeholder: the checker
+Texture2D GetPlaceholderTexture(void);
+AssetStats GetAssetStats(void);
+
+#endif
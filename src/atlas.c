@@ -0,0 +1,340 @@
+#include "atlas.h"
+#include "bundle.h"
+#include "memtrack.h"
+#include "rlgl.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ATLAS_MAX_NODES 512
+
+#if defined(_WIN32)
+#define ATLAS_GLAPI __stdcall
+#else
+#define ATLAS_GLAPI
+#endif
+#define ATLAS_GL_TEXTURE_2D 0x0DE1
+#define ATLAS_GL_TEXTURE_MAX_LEVEL 0x813D
+
+// GL 1.1, exported by every GL library. rlgl has no setter for the max level
+extern void ATLAS_GLAPI glTexParameteri(unsigned int target, unsigned int pname, int param);
+
+typedef struct {
+    int32_t x;
+    int32_t y;
+    int32_t width;
+} SkylineNode;
+
+typedef struct {
+    SkylineNode nodes[ATLAS_MAX_NODES];
+    int32_t nodeCount;
+} Skyline;
+
+static void SkylineInit(Skyline *sky)
+{
+    sky->nodes[0] = (SkylineNode){ 0, 0, ATLAS_PAGE_SIZE };
+    sky->nodeCount = 1;
+}
+
+// height the rect would sit at when its left edge is on node i, -1 if it does not fit
+static int32_t SkylineFit(const Skyline *sky, int32_t i, int32_t width, int32_t height)
+{
+    int32_t x = sky->nodes[i].x;
+    if (x + width > ATLAS_PAGE_SIZE) return -1;
+
+    int32_t y = 0;
+    int32_t left = width;
+    while (left > 0 && i < sky->nodeCount)
+    {
+        if (sky->nodes[i].y > y) y = sky->nodes[i].y;
+        left -= sky->nodes[i].width;
+        i++;
+    }
+    return (y + height <= ATLAS_PAGE_SIZE) ? y : -1;
+}
+
+// bottom-left skyline: lowest top edge wins, narrower node breaks ties
+static bool SkylinePack(Skyline *sky, int32_t width, int32_t height, int32_t *outX, int32_t *outY)
+{
+    int32_t best = -1, bestTop = ATLAS_PAGE_SIZE + 1, bestWidth = ATLAS_PAGE_SIZE + 1, bestY = 0;
+    for (int32_t i = 0; i < sky->nodeCount; i++)
+    {
+        int32_t y = SkylineFit(sky, i, width, height);
+        if (y < 0) continue;
+        if (y + height < bestTop || (y + height == bestTop && sky->nodes[i].width < bestWidth))
+        {
+            best = i;
+            bestTop = y + height;
+            bestWidth = sky->nodes[i].width;
+            bestY = y;
+        }
+    }
+    if (best < 0 || sky->nodeCount >= ATLAS_MAX_NODES) return false;
+
+    SkylineNode node = { sky->nodes[best].x, bestY + height, width };
+    memmove(&sky->nodes[best + 1], &sky->nodes[best], sizeof(SkylineNode)*(sky->nodeCount - best));
+    sky->nodes[best] = node;
+    sky->nodeCount++;
+
+    // trim the nodes now covered by the new one
+    for (int32_t i = best + 1; i < sky->nodeCount; i++)
+    {
+        SkylineNode *prev = &sky->nodes[i - 1];
+        SkylineNode *cur = &sky->nodes[i];
+        int32_t overlap = prev->x + prev->width - cur->x;
+        if (overlap <= 0) break;
+
+        cur->x += overlap;
+        cur->width -= overlap;
+        if (cur->width > 0) break;
+
+        memmove(cur, cur + 1, sizeof(SkylineNode)*(sky->nodeCount - i - 1));
+        sky->nodeCount--;
+        i--;
+    }
+
+    // merge neighbours at the same height
+    for (int32_t i = 0; i < sky->nodeCount - 1; i++)
+    {
+        if (sky->nodes[i].y != sky->nodes[i + 1].y) continue;
+        sky->nodes[i].width += sky->nodes[i + 1].width;
+        memmove(&sky->nodes[i + 1], &sky->nodes[i + 2], sizeof(SkylineNode)*(sky->nodeCount - i - 2));
+        sky->nodeCount--;
+        i--;
+    }
+
+    *outX = node.x;
+    *outY = bestY;
+    return true;
+}
+
+static int32_t AtlasPageBytes(void)
+{
+    int32_t bytes = 0;
+    for (int32_t level = 0; level < ATLAS_MIP_LEVELS; level++) bytes += (ATLAS_PAGE_SIZE >> level)*(ATLAS_PAGE_SIZE >> level)*4;
+    return bytes;
+}
+
+static Image AtlasNewPage(void)
+{
+    Image page = {
+        .data = MemAlloc(AtlasPageBytes()),
+        .width = ATLAS_PAGE_SIZE,
+        .height = ATLAS_PAGE_SIZE,
+        .mipmaps = ATLAS_MIP_LEVELS,
+        .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8
+    };
+    MemChargeTagged(MEM_TAG_ASSETS, GetImageMemorySize(page));
+    return page;
+}
+
+static void AtlasUnloadPage(Image *page)
+{
+    MemReleaseTagged(MEM_TAG_ASSETS, GetImageMemorySize(*page));
+    UnloadImage(*page);
+    *page = (Image){ 0 };
+}
+
+// copies the sprite with its edge pixels smeared over the padding
+static void AtlasBlit(Image *page, const Color *pixels, int32_t width, int32_t height, int32_t x, int32_t y)
+{
+    Color *dst = page->data;
+    for (int32_t py = -ATLAS_PADDING; py < height + ATLAS_PADDING; py++)
+    {
+        int32_t sy = (py < 0) ? 0 : (py >= height) ? height - 1 : py;
+        for (int32_t px = -ATLAS_PADDING; px < width + ATLAS_PADDING; px++)
+        {
+            int32_t sx = (px < 0) ? 0 : (px >= width) ? width - 1 : px;
+            dst[(y + py)*ATLAS_PAGE_SIZE + (x + px)] = pixels[sy*width + sx];
+        }
+    }
+}
+
+// 2x2 box filter, levels follow each other in the data like raylib expects
+static void AtlasGenerateMips(Image *page)
+{
+    unsigned char *src = page->data;
+    for (int32_t level = 1; level < ATLAS_MIP_LEVELS; level++)
+    {
+        int32_t srcSize = ATLAS_PAGE_SIZE >> (level - 1);
+        int32_t size = srcSize >> 1;
+        unsigned char *dst = src + srcSize*srcSize*4;
+
+        for (int32_t y = 0; y < size; y++)
+        {
+            for (int32_t x = 0; x < size; x++)
+            {
+                const unsigned char *a = src + ((y*2)*srcSize + x*2)*4;
+                const unsigned char *b = a + srcSize*4;
+                for (int32_t c = 0; c < 4; c++) dst[(y*size + x)*4 + c] = (unsigned char)((a[c] + a[c + 4] + b[c] + b[c + 4] + 2)/4);
+            }
+        }
+        src = dst;
+    }
+}
+
+SpriteAtlas BuildSpriteAtlas(const Image *images, const char **names, int32_t count)
+{
+    SpriteAtlas atlas = { 0 };
+    if (count <= 0) return atlas;
+
+    // tallest first packs tighter on a skyline
+    int32_t *order = MemAllocTagged(MEM_TAG_ASSETS, sizeof(int32_t)*count);
+    for (int32_t i = 0; i < count; i++) order[i] = i;
+    for (int32_t i = 1; i < count; i++)
+    {
+        int32_t k = order[i], j = i - 1;
+        while (j >= 0 && images[order[j]].height < images[k].height) { order[j + 1] = order[j]; j--; }
+        order[j + 1] = k;
+    }
+
+    atlas.sprites = MemCallocTagged(MEM_TAG_ASSETS, count, sizeof(AtlasSprite));
+    Skyline *sky = MemAllocTagged(MEM_TAG_ASSETS, sizeof(Skyline));
+    SkylineInit(sky);
+    atlas.pages[0] = AtlasNewPage();
+    atlas.pageCount = 1;
+    bool ok = true;
+
+    for (int32_t n = 0; n < count && ok; n++)
+    {
+        int32_t i = order[n];
+        int32_t w = images[i].width, h = images[i].height;
+        int32_t x, y;
+
+        if (!SkylinePack(sky, w + ATLAS_PADDING*2, h + ATLAS_PADDING*2, &x, &y))
+        {
+            // next page, a sprite that does not fit an empty page never will
+            if (atlas.pageCount >= ATLAS_MAX_PAGES) { ok = false; break; }
+            SkylineInit(sky);
+            atlas.pages[atlas.pageCount++] = AtlasNewPage();
+            if (!SkylinePack(sky, w + ATLAS_PADDING*2, h + ATLAS_PADDING*2, &x, &y)) { ok = false; break; }
+        }
+
+        Color *pixels = LoadImageColors(images[i]);
+        AtlasBlit(&atlas.pages[atlas.pageCount - 1], pixels, w, h, x + ATLAS_PADDING, y + ATLAS_PADDING);
+        UnloadImageColors(pixels);
+
+        AtlasSprite *sprite = &atlas.sprites[i];
+        strncpy(sprite->name, names[i], ATLAS_NAME_LENGTH - 1);
+        sprite->page = atlas.pageCount - 1;
+        sprite->source = (Rectangle){ (float)(x + ATLAS_PADDING), (float)(y + ATLAS_PADDING), (float)w, (float)h };
+        sprite->uv = (Rectangle){ sprite->source.x/ATLAS_PAGE_SIZE, sprite->source.y/ATLAS_PAGE_SIZE, (float)w/ATLAS_PAGE_SIZE, (float)h/ATLAS_PAGE_SIZE };
+    }
+
+    MemFreeTagged(sky);
+    MemFreeTagged(order);
+    if (!ok)
+    {
+        UnloadSpriteAtlas(&atlas);
+        return atlas;
+    }
+
+    for (int32_t p = 0; p < atlas.pageCount; p++) AtlasGenerateMips(&atlas.pages[p]);
+    atlas.spriteCount = count;
+    return atlas;
+}
+
+typedef struct {
+    char magic[4];
+    int32_t version;
+    int32_t pageSize;
+    int32_t mipLevels;
+    int32_t pageCount;
+    int32_t spriteCount;
+} AtlasFileHeader;
+
+bool SaveSpriteAtlas(const SpriteAtlas *atlas, const char *fileName)
+{
+    if (!IsSpriteAtlasReady(atlas) || atlas->pages[0].data == NULL) return false;
+
+    FILE *file = fopen(fileName, "wb");
+    if (file == NULL) return false;
+
+    AtlasFileHeader header = { { 'A', 'T', 'L', ' ' }, ATLAS_FILE_VERSION, ATLAS_PAGE_SIZE, ATLAS_MIP_LEVELS, atlas->pageCount, atlas->spriteCount };
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = ok && fwrite(atlas->sprites, sizeof(AtlasSprite), atlas->spriteCount, file) == (size_t)atlas->spriteCount;
+    for (int32_t p = 0; ok && p < atlas->pageCount; p++) ok = fwrite(atlas->pages[p].data, AtlasPageBytes(), 1, file) == 1;
+    fclose(file);
+
+    return ok;
+}
+
+SpriteAtlas LoadSpriteAtlas(const char *fileName)
+{
+    SpriteAtlas atlas = { 0 };
+    FILE *file = OpenAssetFile(fileName);
+    if (file == NULL) return atlas;
+
+    AtlasFileHeader header;
+    bool ok = fread(&header, sizeof(header), 1, file) == 1 && memcmp(header.magic, "ATL ", 4) == 0 &&
+              header.version == ATLAS_FILE_VERSION && header.pageSize == ATLAS_PAGE_SIZE && header.mipLevels == ATLAS_MIP_LEVELS &&
+              header.pageCount > 0 && header.pageCount <= ATLAS_MAX_PAGES && header.spriteCount > 0;
+
+    if (ok)
+    {
+        atlas.sprites = MemCallocTagged(MEM_TAG_ASSETS, header.spriteCount, sizeof(AtlasSprite));
+        ok = atlas.sprites != NULL && fread(atlas.sprites, sizeof(AtlasSprite), header.spriteCount, file) == (size_t)header.spriteCount;
+    }
+    for (int32_t p = 0; ok && p < header.pageCount; p++)
+    {
+        atlas.pages[p] = AtlasNewPage();
+        atlas.pageCount++;
+        ok = fread(atlas.pages[p].data, AtlasPageBytes(), 1, file) == 1;
+    }
+    for (int32_t i = 0; ok && i < header.spriteCount; i++)
+    {
+        atlas.sprites[i].name[ATLAS_NAME_LENGTH - 1] = '\0';
+        ok = atlas.sprites[i].page >= 0 && atlas.sprites[i].page < header.pageCount;
+    }
+    fclose(file);
+
+    if (!ok)
+    {
+        UnloadSpriteAtlas(&atlas);
+        return atlas;
+    }
+    atlas.spriteCount = header.spriteCount;
+    return atlas;
+}
+
+bool IsSpriteAtlasReady(const SpriteAtlas *atlas)
+{
+    return atlas->spriteCount > 0 && atlas->pageCount > 0;
+}
+
+void UploadSpriteAtlas(SpriteAtlas *atlas)
+{
+    for (int32_t p = 0; p < atlas->pageCount; p++)
+    {
+        if (atlas->pages[p].data == NULL) continue;
+        atlas->textures[p] = LoadTextureFromImage(atlas->pages[p]);
+        SetTextureFilter(atlas->textures[p], TEXTURE_FILTER_TRILINEAR);
+        // the chain stops at ATLAS_MIP_LEVELS, GL's default max level of 1000 would
+        // leave the texture mipmap incomplete and trilinear sampling black
+        rlEnableTexture(atlas->textures[p].id);
+        glTexParameteri(ATLAS_GL_TEXTURE_2D, ATLAS_GL_TEXTURE_MAX_LEVEL, ATLAS_MIP_LEVELS - 1);
+        rlDisableTexture();
+        SetTextureWrap(atlas->textures[p], TEXTURE_WRAP_CLAMP);
+        AtlasUnloadPage(&atlas->pages[p]);
+    }
+}
+
+void UnloadSpriteAtlas(SpriteAtlas *atlas)
+{
+    for (int32_t p = 0; p < atlas->pageCount; p++)
+    {
+        if (atlas->pages[p].data != NULL) AtlasUnloadPage(&atlas->pages[p]);
+        if (atlas->textures[p].id != 0) UnloadTexture(atlas->textures[p]);
+    }
+    MemFreeTagged(atlas->sprites);
+    *atlas = (SpriteAtlas){ 0 };
+}
+
+int32_t GetAtlasSpriteIndex(const SpriteAtlas *atlas, const char *name)
+{
+    for (int32_t i = 0; i < atlas->spriteCount; i++)
+    {
+        if (strncmp(atlas->sprites[i].name, name, ATLAS_NAME_LENGTH) == 0) return i;
+    }
+    return -1;
+}
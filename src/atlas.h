@@ -0,0 +1,51 @@
+#ifndef ATLAS_H
+#define ATLAS_H
+
+#include "raylib.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Sprite atlas: sprites packed into pages with a skyline packer, each page
+// carries a precomputed box filtered mip chain and a UV table maps sprite
+// ids to page rects. Built offline by tools/atlas_pack.c (make atlas), with
+// the same code path available at runtime as a fallback.
+//
+// Sprites are padded by ATLAS_PADDING pixels of extruded edge, enough that
+// ATLAS_MIP_LEVELS levels never bleed neighbours into each other.
+
+#define ATLAS_PAGE_SIZE 1024
+#define ATLAS_MAX_PAGES 4
+#define ATLAS_PADDING 8
+#define ATLAS_MIP_LEVELS 4          // base level plus three, ATLAS_PADDING >> 3 == 1
+#define ATLAS_NAME_LENGTH 32
+#define ATLAS_FILE_VERSION 1
+
+typedef struct {
+    char name[ATLAS_NAME_LENGTH];
+    int32_t page;
+    Rectangle source;       // pixels inside the page, what DrawTexturePro() wants
+    Rectangle uv;           // same rect normalized, for meshes and batchers
+} AtlasSprite;
+
+typedef struct {
+    int32_t pageCount;
+    Image pages[ATLAS_MAX_PAGES];           // CPU copies, released by UploadSpriteAtlas()
+    Texture2D textures[ATLAS_MAX_PAGES];
+    int32_t spriteCount;
+    AtlasSprite *sprites;
+} SpriteAtlas;
+
+// Packs count images (any format) named names[i], returns an atlas with no sprites if they do not fit
+SpriteAtlas BuildSpriteAtlas(const Image *images, const char **names, int32_t count);
+bool SaveSpriteAtlas(const SpriteAtlas *atlas, const char *fileName);
+SpriteAtlas LoadSpriteAtlas(const char *fileName);
+bool IsSpriteAtlasReady(const SpriteAtlas *atlas);
+
+// Moves the pages to the GPU with trilinear filtering over the baked mips
+void UploadSpriteAtlas(SpriteAtlas *atlas);
+void UnloadSpriteAtlas(SpriteAtlas *atlas);
+
+// -1 when there is no such sprite, resolve once and keep the index
+int32_t GetAtlasSpriteIndex(const SpriteAtlas *atlas, const char *name);
+
+#endif
@@ -0,0 +1,186 @@
+#include "bundle.h"
+#include "memtrack.h"
+#include "raylib.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__GNUC__) && !defined(_WIN32)
+#define BUNDLE_EMBEDDED
+// Around the blob make bundle links in, both NULL in a build without it
+extern const unsigned char physim_bundle[] __attribute__((weak));
+extern const unsigned char physim_bundle_end[] __attribute__((weak));
+#endif
+
+static struct {
+    pthread_once_t once;            // loaders on workers may be first to ask
+    const uint8_t *data;            // NULL when there is no valid bundle
+    const BundleEntry *entries;
+    uint32_t entryCount;
+} bundle = { .once = PTHREAD_ONCE_INIT };
+
+// FNV-1a
+static uint64_t BundleHash(const char *name)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (const unsigned char *c = (const unsigned char *)name; *c != '\0'; c++) hash = (hash ^ *c)*1099511628211ull;
+    return hash;
+}
+
+static uint64_t BundleAlign(uint64_t offset)
+{
+    return (offset + BUNDLE_ALIGNMENT - 1) & ~(uint64_t)(BUNDLE_ALIGNMENT - 1);
+}
+
+// Offline
+//----------------------------------------------------------------------------------
+typedef struct {
+    BundleEntry entry;
+    unsigned char *data;
+} BundleInput;
+
+static int BundleInputCompare(const void *a, const void *b)
+{
+    uint64_t ha = ((const BundleInput *)a)->entry.hash, hb = ((const BundleInput *)b)->entry.hash;
+    return (ha > hb) - (ha < hb);
+}
+
+bool SaveBundle(const char *fileName, const char **files, int32_t count)
+{
+    if (count <= 0) return false;
+    BundleInput *inputs = MemCallocTagged(MEM_TAG_ASSETS, count, sizeof(BundleInput));
+    if (inputs == NULL) return false;
+
+    bool ok = true;
+    for (int32_t i = 0; ok && i < count; i++)
+    {
+        // stored by the name the game asks for, without the directory it was baked in
+        const char *name = GetFileName(files[i]);
+        int size = 0;
+        inputs[i].data = LoadFileData(files[i], &size);
+        ok = (inputs[i].data != NULL) && (strlen(name) < BUNDLE_NAME_LENGTH);
+        if (!ok) TraceLog(LOG_WARNING, "BUNDLE: [%s] could not be read or its name is too long", files[i]);
+        inputs[i].entry.hash = BundleHash(name);
+        inputs[i].entry.size = (uint64_t)size;
+        snprintf(inputs[i].entry.name, BUNDLE_NAME_LENGTH, "%s", name);
+    }
+
+    qsort(inputs, count, sizeof(BundleInput), BundleInputCompare);
+    uint64_t cursor = sizeof(BundleHeader) + sizeof(BundleEntry)*(uint64_t)count;
+    for (int32_t i = 0; ok && i < count; i++)
+    {
+        if (i > 0 && inputs[i].entry.hash == inputs[i - 1].entry.hash)
+        {
+            TraceLog(LOG_WARNING, "BUNDLE: [%s] and [%s] share a name hash", inputs[i].entry.name, inputs[i - 1].entry.name);
+            ok = false;
+        }
+        inputs[i].entry.offset = BundleAlign(cursor);
+        cursor = inputs[i].entry.offset + inputs[i].entry.size;
+    }
+
+    BundleHeader header = { .magic = { 'B', 'N', 'D', 'L' }, .version = BUNDLE_VERSION, .byteOrder = 0x01020304,
+                            .entryCount = (uint32_t)count, .size = cursor };
+    FILE *file = ok ? fopen(fileName, "wb") : NULL;
+    if (file != NULL)
+    {
+        static const uint8_t padding[BUNDLE_ALIGNMENT] = { 0 };
+        ok = fwrite(&header, sizeof(header), 1, file) == 1;
+        for (int32_t i = 0; ok && i < count; i++) ok = fwrite(&inputs[i].entry, sizeof(BundleEntry), 1, file) == 1;
+        cursor = sizeof(BundleHeader) + sizeof(BundleEntry)*(uint64_t)count;
+        for (int32_t i = 0; ok && i < count; i++)
+        {
+            size_t pad = (size_t)(inputs[i].entry.offset - cursor);
+            ok = (pad == 0 || fwrite(padding, pad, 1, file) == 1);
+            ok = ok && (inputs[i].entry.size == 0 || fwrite(inputs[i].data, (size_t)inputs[i].entry.size, 1, file) == 1);
+            cursor = inputs[i].entry.offset + inputs[i].entry.size;
+        }
+        ok = (fclose(file) == 0) && ok;
+    }
+    else ok = false;
+
+    for (int32_t i = 0; i < count; i++) UnloadFileData(inputs[i].data);
+    MemFreeTagged(inputs);
+    return ok;
+}
+
+// Runtime
+//----------------------------------------------------------------------------------
+static bool BundleValid(const uint8_t *data, size_t size)
+{
+    if (size < sizeof(BundleHeader)) return false;
+    const BundleHeader *header = (const BundleHeader *)data;
+    if (memcmp(header->magic, "BNDL", 4) != 0 || header->version != BUNDLE_VERSION || header->byteOrder != 0x01020304 ||
+        header->size > size || (uint64_t)header->entryCount*sizeof(BundleEntry) > header->size - sizeof(BundleHeader)) return false;
+
+    const BundleEntry *entries = (const BundleEntry *)(data + sizeof(BundleHeader));
+    for (uint32_t i = 0; i < header->entryCount; i++)
+    {
+        const BundleEntry *entry = &entries[i];
+        if (entry->offset % BUNDLE_ALIGNMENT != 0 || entry->offset > header->size || entry->size > header->size - entry->offset) return false;
+        if (memchr(entry->name, '\0', BUNDLE_NAME_LENGTH) == NULL || entry->hash != BundleHash(entry->name)) return false;
+        if (i > 0 && entries[i - 1].hash >= entry->hash) return false;
+    }
+    return true;
+}
+
+static void BundleInit(void)
+{
+#if defined(BUNDLE_EMBEDDED)
+    if (physim_bundle == NULL || physim_bundle_end == NULL) return;
+
+    const uint8_t *data = physim_bundle;
+    size_t size = (size_t)(physim_bundle_end - physim_bundle);
+    if (!BundleValid(data, size))
+    {
+        TraceLog(LOG_WARNING, "BUNDLE: Linked bundle is damaged or from another version, ignored");
+        return;
+    }
+    bundle.data = data;
+    bundle.entries = (const BundleEntry *)(data + sizeof(BundleHeader));
+    bundle.entryCount = ((const BundleHeader *)data)->entryCount;
+    TraceLog(LOG_INFO, "BUNDLE: %u files linked in", bundle.entryCount);
+#endif
+}
+
+bool IsBundleLinked(void)
+{
+    pthread_once(&bundle.once, BundleInit);
+    return bundle.data != NULL;
+}
+
+const void *GetBundleFile(const char *name, size_t *size)
+{
+    if (!IsBundleLinked()) return NULL;
+
+    uint64_t hash = BundleHash(name);
+    uint32_t low = 0, high = bundle.entryCount;
+    while (low < high)
+    {
+        uint32_t middle = low + (high - low)/2;
+        if (bundle.entries[middle].hash < hash) low = middle + 1;
+        else high = middle;
+    }
+    if (low == bundle.entryCount || bundle.entries[low].hash != hash || strcmp(bundle.entries[low].name, name) != 0) return NULL;
+
+    if (size != NULL) *size = (size_t)bundle.entries[low].size;
+    return bundle.data + bundle.entries[low].offset;
+}
+
+bool AssetFileExists(const char *name)
+{
+    return FileExists(name) || GetBundleFile(name, NULL) != NULL;
+}
+
+FILE *OpenAssetFile(const char *name)
+{
+    FILE *file = fopen(name, "rb");
+    if (file != NULL) return file;
+
+#if defined(BUNDLE_EMBEDDED)
+    size_t size = 0;
+    const void *data = GetBundleFile(name, &size);
+    // read only mode never writes through the pointer
+    if (data != NULL && size > 0) return fmemopen((void *)data, size, "rb");
+#endif
+    return NULL;
+}
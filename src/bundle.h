@@ -0,0 +1,52 @@
+#ifndef BUNDLE_H
+#define BUNDLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Asset bundle: baked asset files packed into one blob by tools/bundle_pack.c
+// and linked into physim (make bundle), so it runs from a single file.
+// The blob is a header, a table of contents sorted by name hash and the
+// files themselves, each on a BUNDLE_ALIGNMENT boundary. Nothing is copied
+// or decoded up front: a lookup is a binary search of the table and hands
+// out the bytes in place, the loaders decode them when first asked.
+//
+// Loaders go through OpenAssetFile(), a file on disk wins over the bundled
+// one so local bakes and hot reload keep working in a bundled build.
+
+#define BUNDLE_VERSION 1
+#define BUNDLE_ALIGNMENT 64
+#define BUNDLE_NAME_LENGTH 48
+
+typedef struct {
+    char magic[4];                  // "BNDL"
+    uint32_t version;
+    uint32_t byteOrder;             // 0x01020304 as stored by a little endian writer
+    uint32_t entryCount;
+    uint64_t size;                  // whole bundle
+} BundleHeader;
+
+typedef struct {
+    uint64_t hash;                  // FNV-1a of name, the table is sorted by it
+    uint64_t offset;                // from the start of the bundle, BUNDLE_ALIGNMENT aligned
+    uint64_t size;
+    char name[BUNDLE_NAME_LENGTH];  // as the game asks for it, "ye.lvl"
+} BundleEntry;
+
+// Offline, files are stored under the names given
+bool SaveBundle(const char *fileName, const char **files, int32_t count);
+
+// False when physim was linked without one (or it does not validate)
+bool IsBundleLinked(void);
+// Bytes of a bundled file, read only and valid for the life of the process;
+// NULL when it is not in the bundle
+const void *GetBundleFile(const char *name, size_t *size);
+
+// On disk or in the bundle
+bool AssetFileExists(const char *name);
+// Disk first, then a read only stream over the bundled bytes, NULL when neither
+FILE *OpenAssetFile(const char *name);
+
+#endif
@@ -0,0 +1,224 @@
+#include "decals.h"
+#include "memtrack.h"
+#include "raymath.h"
+#include "rlgl.h"
+#include <math.h>
+#include <stdlib.h>
+
+#define DECAL_OFFSET 0.01f          // lift off the surface against z-fighting
+
+static int32_t DecalChunkOf(const DecalManager *decals, Vector3 position)
+{
+    int32_t x = (int32_t)floorf(position.x - decals->origin.x + 0.5f)/PVS_CLUSTER_SIZE;
+    int32_t z = (int32_t)floorf(position.z - decals->origin.z + 0.5f)/PVS_CLUSTER_SIZE;
+    x = (x < 0) ? 0 : (x >= decals->chunksX) ? decals->chunksX - 1 : x;
+    z = (z < 0) ? 0 : (z >= decals->chunksZ) ? decals->chunksZ - 1 : z;
+    return z*decals->chunksX + x;
+}
+
+DecalManager *LoadDecalManager(int32_t gridWidth, int32_t gridHeight, Vector3 mapPosition)
+{
+    DecalManager *decals = MemCallocTagged(MEM_TAG_RENDER, 1, sizeof(DecalManager));
+    if (decals == NULL) return NULL;
+
+    decals->chunksX = (gridWidth + PVS_CLUSTER_SIZE - 1)/PVS_CLUSTER_SIZE;
+    decals->chunksZ = (gridHeight + PVS_CLUSTER_SIZE - 1)/PVS_CLUSTER_SIZE;
+    if (decals->chunksX < 1) decals->chunksX = 1;
+    if (decals->chunksZ < 1) decals->chunksZ = 1;
+    decals->origin = mapPosition;
+    decals->chunkHeads = MemAllocTagged(MEM_TAG_RENDER, sizeof(int32_t)*decals->chunksX*decals->chunksZ);
+    for (int32_t i = 0; i < decals->chunksX*decals->chunksZ; i++) decals->chunkHeads[i] = -1;
+    for (int32_t i = 0; i < DECAL_CAPACITY; i++) decals->decals[i].page = -1;
+    decals->material = LoadMaterialDefault();
+    decals->cameraChunk = -1;
+
+    return decals;
+}
+
+void UnloadDecalManager(DecalManager *decals)
+{
+    if (decals == NULL) return;
+
+    for (int32_t i = 0; i < decals->pageCount; i++)
+    {
+        MemReleaseTagged(MEM_TAG_RENDER, GetMeshMemorySize(&decals->pages[i].mesh));
+        UnloadMesh(decals->pages[i].mesh);
+        UnloadTexture(decals->pages[i].texture);
+    }
+    // the page textures are already gone, keep UnloadMaterial() off them
+    decals->material.maps[MATERIAL_MAP_DIFFUSE].texture.id = rlGetTextureIdDefault();
+    UnloadMaterial(decals->material);
+    MemFreeTagged(decals->chunkHeads);
+    MemFreeTagged(decals);
+}
+
+int32_t AddDecalPage(DecalManager *decals, Texture2D texture)
+{
+    if (decals->pageCount >= DECAL_MAX_PAGES) return -1;
+
+    DecalPage *page = &decals->pages[decals->pageCount];
+    page->texture = texture;
+    page->quadCount = 0;
+
+    Mesh mesh = { 0 };
+    mesh.vertexCount = DECAL_CAPACITY*4;
+    mesh.triangleCount = DECAL_CAPACITY*2;
+    mesh.vertices = MemAlloc(sizeof(float)*3*mesh.vertexCount);
+    mesh.texcoords = MemAlloc(sizeof(float)*2*mesh.vertexCount);
+    mesh.colors = MemAlloc(4*mesh.vertexCount);
+    mesh.indices = MemAlloc(sizeof(unsigned short)*3*mesh.triangleCount);
+    MemChargeTagged(MEM_TAG_RENDER, GetMeshMemorySize(&mesh));
+    for (int32_t q = 0; q < DECAL_CAPACITY; q++)
+    {
+        unsigned short *idx = mesh.indices + q*6;
+        unsigned short v = (unsigned short)(q*4);
+        idx[0] = v; idx[1] = v + 1; idx[2] = v + 2;
+        idx[3] = v; idx[4] = v + 2; idx[5] = v + 3;
+    }
+    UploadMesh(&mesh, true);
+    page->mesh = mesh;
+
+    decals->dirty = true;
+    return decals->pageCount++;
+}
+
+static void DecalUnlink(DecalManager *decals, int32_t index)
+{
+    Decal *d = &decals->decals[index];
+    if (d->prev >= 0) decals->decals[d->prev].next = d->next;
+    else decals->chunkHeads[d->chunk] = d->next;
+    if (d->next >= 0) decals->decals[d->next].prev = d->prev;
+}
+
+void AddDecal(DecalManager *decals, int32_t page, Rectangle uv, Vector3 position, Vector3 normal, float size, float rotation, Color tint)
+{
+    if (page < 0 || page >= decals->pageCount) return;
+
+    // ring buffer: once full the oldest decal makes room
+    int32_t index = decals->head;
+    if (decals->decals[index].page >= 0) DecalUnlink(decals, index);
+    else decals->count++;
+    decals->head = (decals->head + 1) % DECAL_CAPACITY;
+
+    int32_t chunk = DecalChunkOf(decals, position);
+    decals->decals[index] = (Decal){
+        .position = position,
+        .normal = Vector3Normalize(normal),
+        .size = size,
+        .rotation = rotation,
+        .uv = uv,
+        .tint = tint,
+        .page = (int16_t)page,
+        .chunk = chunk,
+        .prev = -1,
+        .next = decals->chunkHeads[chunk]
+    };
+    if (decals->chunkHeads[chunk] >= 0) decals->decals[decals->chunkHeads[chunk]].prev = index;
+    decals->chunkHeads[chunk] = index;
+    decals->dirty = true;
+}
+
+static void DecalWriteQuad(DecalPage *page, const Decal *d)
+{
+    int32_t q = page->quadCount++;
+    float *v = page->mesh.vertices + q*12;
+    float *t = page->mesh.texcoords + q*8;
+    unsigned char *c = page->mesh.colors + q*16;
+
+    Vector3 n = d->normal;
+    Vector3 helper = (fabsf(n.y) < 0.99f) ? (Vector3){ 0.0f, 1.0f, 0.0f } : (Vector3){ 1.0f, 0.0f, 0.0f };
+    Vector3 tangent = Vector3Normalize(Vector3CrossProduct(helper, n));
+    Vector3 bitangent = Vector3CrossProduct(n, tangent);
+    float cs = cosf(d->rotation)*d->size*0.5f, sn = sinf(d->rotation)*d->size*0.5f;
+    Vector3 right = Vector3Add(Vector3Scale(tangent, cs), Vector3Scale(bitangent, sn));
+    Vector3 up = Vector3Subtract(Vector3Scale(bitangent, cs), Vector3Scale(tangent, sn));
+    Vector3 center = Vector3Add(d->position, Vector3Scale(n, DECAL_OFFSET));
+
+    Vector3 corners[4] = {
+        Vector3Subtract(Vector3Subtract(center, right), up),
+        Vector3Subtract(Vector3Add(center, right), up),
+        Vector3Add(Vector3Add(center, right), up),
+        Vector3Add(Vector3Subtract(center, right), up)
+    };
+    float u[4] = { d->uv.x, d->uv.x + d->uv.width, d->uv.x + d->uv.width, d->uv.x };
+    float w[4] = { d->uv.y + d->uv.height, d->uv.y + d->uv.height, d->uv.y, d->uv.y };
+
+    for (int i = 0; i < 4; i++)
+    {
+        v[i*3 + 0] = corners[i].x;
+        v[i*3 + 1] = corners[i].y;
+        v[i*3 + 2] = corners[i].z;
+        t[i*2 + 0] = u[i];
+        t[i*2 + 1] = w[i];
+        c[i*4 + 0] = d->tint.r;
+        c[i*4 + 1] = d->tint.g;
+        c[i*4 + 2] = d->tint.b;
+        c[i*4 + 3] = d->tint.a;
+    }
+}
+
+static void DecalRebuild(DecalManager *decals, const PVS *pvs)
+{
+    bool usePvs = !decals->overWalls && (pvs != NULL) && IsPVSReady(pvs) && pvs->clustersX == decals->chunksX && pvs->clustersZ == decals->chunksZ;
+    int32_t cx = decals->cameraChunk % decals->chunksX;
+    int32_t cz = decals->cameraChunk / decals->chunksX;
+
+    for (int32_t p = 0; p < decals->pageCount; p++) decals->pages[p].quadCount = 0;
+
+    // only the window around the camera is walked, cost does not depend on the map size
+    for (int32_t z = cz - DECAL_DRAW_DISTANCE; z <= cz + DECAL_DRAW_DISTANCE; z++)
+    {
+        if (z < 0 || z >= decals->chunksZ) continue;
+        for (int32_t x = cx - DECAL_DRAW_DISTANCE; x <= cx + DECAL_DRAW_DISTANCE; x++)
+        {
+            if (x < 0 || x >= decals->chunksX) continue;
+            int32_t chunk = z*decals->chunksX + x;
+            if (usePvs && !PVSClusterVisible(pvs, decals->cameraChunk, chunk)) continue;
+
+            for (int32_t i = decals->chunkHeads[chunk]; i >= 0; i = decals->decals[i].next)
+            {
+                DecalWriteQuad(&decals->pages[decals->decals[i].page], &decals->decals[i]);
+            }
+        }
+    }
+
+    for (int32_t p = 0; p < decals->pageCount; p++)
+    {
+        DecalPage *page = &decals->pages[p];
+        if (page->quadCount == 0) continue;
+        int vertices = page->quadCount*4;
+        UpdateMeshBuffer(page->mesh, 0, page->mesh.vertices, (int)sizeof(float)*3*vertices, 0);
+        UpdateMeshBuffer(page->mesh, 1, page->mesh.texcoords, (int)sizeof(float)*2*vertices, 0);
+        UpdateMeshBuffer(page->mesh, 3, page->mesh.colors, 4*vertices, 0);
+    }
+    decals->dirty = false;
+}
+
+void DrawDecals(DecalManager *decals, const PVS *pvs, Vector3 cameraPosition)
+{
+    if (decals == NULL) return;
+
+    int32_t cameraChunk = DecalChunkOf(decals, cameraPosition);
+    bool overWalls = !PVSAppliesAt(cameraPosition.y - decals->origin.y);
+    if (decals->dirty || cameraChunk != decals->cameraChunk || overWalls != decals->overWalls)
+    {
+        decals->cameraChunk = cameraChunk;
+        decals->overWalls = overWalls;
+        DecalRebuild(decals, pvs);
+    }
+
+    rlDrawRenderBatchActive();
+    rlDisableDepthMask();
+    for (int32_t p = 0; p < decals->pageCount; p++)
+    {
+        DecalPage *page = &decals->pages[p];
+        if (page->quadCount == 0) continue;
+
+        // draw only the filled part of the index buffer
+        Mesh mesh = page->mesh;
+        mesh.triangleCount = page->quadCount*2;
+        decals->material.maps[MATERIAL_MAP_DIFFUSE].texture = page->texture;
+        DrawMesh(mesh, decals->material, MatrixIdentity());
+    }
+    rlEnableDepthMask();
+}
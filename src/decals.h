@@ -0,0 +1,67 @@
+#ifndef DECALS_H
+#define DECALS_H
+
+#include "raylib.h"
+#include "pvs.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Bounded decals (bullet holes, scorch marks).
+// Decals live in a fixed ring buffer, the oldest one is recycled once it is
+// full, so memory never grows during a match. Every decal is binned into the
+// chunk under it (chunks match the PVS clusters) through an intrusive list, and
+// only chunks the PVS marks visible get their quads generated. Quads are written
+// into one dynamic mesh per atlas page, one draw call per page.
+
+#define DECAL_CAPACITY 2048         // 4 vertices each keeps indices in 16 bits
+#define DECAL_MAX_PAGES 4
+#define DECAL_DRAW_DISTANCE 6       // in chunks around the camera
+
+typedef struct {
+    Vector3 position;
+    Vector3 normal;
+    float size;
+    float rotation;
+    Rectangle uv;           // normalized rect inside the page
+    Color tint;
+    int16_t page;           // -1 for a free slot
+    int32_t chunk;
+    int32_t prev;           // intrusive chunk list links
+    int32_t next;
+} Decal;
+
+typedef struct {
+    Texture2D texture;
+    Mesh mesh;              // dynamic, refilled when the visible set changes
+    int32_t quadCount;
+} DecalPage;
+
+typedef struct {
+    Decal decals[DECAL_CAPACITY];
+    int32_t head;           // next slot to write, oldest decal once wrapped
+    int32_t count;
+    int32_t *chunkHeads;    // first decal per chunk, -1 when empty
+    int32_t chunksX;
+    int32_t chunksZ;
+    Vector3 origin;         // world position of cell (0, 0)
+    DecalPage pages[DECAL_MAX_PAGES];
+    int32_t pageCount;
+    Material material;
+    int32_t cameraChunk;    // visible set the page meshes were built for
+    bool overWalls;         // built with the camera above the walls, PVS skipped
+    bool dirty;
+} DecalManager;
+
+// Chunks cover a gridWidth x gridHeight cell map placed at mapPosition
+DecalManager *LoadDecalManager(int32_t gridWidth, int32_t gridHeight, Vector3 mapPosition);
+void UnloadDecalManager(DecalManager *decals);
+
+// Takes ownership of the texture, returns the page id or -1
+int32_t AddDecalPage(DecalManager *decals, Texture2D texture);
+
+void AddDecal(DecalManager *decals, int32_t page, Rectangle uv, Vector3 position, Vector3 normal, float size, float rotation, Color tint);
+
+// Call inside BeginMode3D(), pvs may be NULL or not ready
+void DrawDecals(DecalManager *decals, const PVS *pvs, Vector3 cameraPosition);
+
+#endif
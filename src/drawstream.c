@@ -0,0 +1,339 @@
+#include "drawstream.h"
+#include "memtrack.h"
+#define RAYMATH_STATIC_INLINE       // replay tools link without raylib
+#include "raymath.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+const uint8_t drawOpPayloadSize[DRAW_OP_COUNT] = {
+    [DRAW_OP_FRAME] = 0,
+    [DRAW_OP_FLUSH] = 0,
+    [DRAW_OP_BEGIN] = 4,
+    [DRAW_OP_END] = 0,
+    [DRAW_OP_VERTEX2] = 8,
+    [DRAW_OP_VERTEX3] = 12,
+    [DRAW_OP_TEXCOORD] = 8,
+    [DRAW_OP_NORMAL] = 12,
+    [DRAW_OP_COLOR] = 4,
+    [DRAW_OP_SET_TEXTURE] = 4,
+    [DRAW_OP_ENABLE_TEXTURE] = 4,
+    [DRAW_OP_PUSH_MATRIX] = 0,
+    [DRAW_OP_POP_MATRIX] = 0,
+    [DRAW_OP_LOAD_IDENTITY] = 0,
+    [DRAW_OP_TRANSLATE] = 12,
+    [DRAW_OP_ROTATE] = 16,
+    [DRAW_OP_SCALE] = 12,
+    [DRAW_OP_MULT_MATRIX] = 64,
+    [DRAW_OP_DRAW_ARRAYS] = 12,
+    [DRAW_OP_DRAW_ELEMENTS] = 12,
+    [DRAW_OP_MATRIX_MODE] = 4,
+    [DRAW_OP_FRUSTUM] = 24,
+    [DRAW_OP_ORTHO] = 24,
+    [DRAW_OP_DEPTH_TEST] = 1,
+    [DRAW_OP_CULL_FACE] = 1,
+    [DRAW_OP_TARGET] = 12,
+    [DRAW_OP_CLEAR] = 4,
+    [DRAW_OP_STATE] = 136,
+    [DRAW_OP_DEPTH_MASK] = 1,
+    [DRAW_OP_BUFFER] = 8,
+    [DRAW_OP_BUFFER_DATA] = 12,
+    [DRAW_OP_VERTEX_ARRAY] = 4,
+    [DRAW_OP_ATTRIBUTE] = 8 + sizeof(DrawAttribute),
+    [DRAW_OP_ELEMENT_BUFFER] = 8,
+    [DRAW_OP_BIND_VERTEX_ARRAY] = 4,
+    [DRAW_OP_TEXTURE] = 12,
+    [DRAW_OP_TEXTURE_DATA] = 24,
+    [DRAW_OP_PROGRAM] = 8,
+    [DRAW_OP_BIND_PROGRAM] = 4,
+    [DRAW_OP_BATCH_PROGRAM] = 4,
+    [DRAW_OP_UNIFORM] = 72,
+};
+
+static bool DrawOpHasData(uint8_t op)
+{
+    return op == DRAW_OP_BUFFER_DATA || op == DRAW_OP_TEXTURE_DATA;
+}
+
+size_t GetDrawOpSize(const uint8_t *op)
+{
+    size_t size = 1 + drawOpPayloadSize[op[0]];
+    if (DrawOpHasData(op[0]))
+    {
+        uint32_t data;
+        memcpy(&data, op + size - 4, 4);
+        size += data;
+    }
+    return size;
+}
+
+static void DrawTrackCloseDraw(DrawStreamTracker *tracker)
+{
+    if (tracker->drawVertices == 0) return;
+    tracker->drawVertices = 0;
+    // rlgl flushes once its draw list is full
+    if (++tracker->pendingDraws >= RL_DEFAULT_BATCH_DRAWCALLS) DrawTrackFlush(tracker);
+}
+
+void DrawTrackBegin(DrawStreamTracker *tracker, int mode)
+{
+    if (tracker->mode == mode) return;
+    // a new draw starts with the default texture
+    DrawTrackCloseDraw(tracker);
+    tracker->mode = mode;
+    tracker->texture = 0;
+}
+
+void DrawTrackVertex(DrawStreamTracker *tracker)
+{
+    if (tracker->pendingVertices >= DRAW_STREAM_BATCH_VERTICES) DrawTrackFlush(tracker);
+    tracker->drawVertices++;
+    tracker->pendingVertices++;
+    tracker->stats.vertices++;
+}
+
+void DrawTrackSetTexture(DrawStreamTracker *tracker, uint32_t id)
+{
+    if (id == tracker->texture) return;
+    DrawTrackCloseDraw(tracker);
+    tracker->texture = id;
+    tracker->stats.textureBinds++;
+}
+
+void DrawTrackFlush(DrawStreamTracker *tracker)
+{
+    if (tracker->drawVertices > 0)
+    {
+        tracker->drawVertices = 0;
+        tracker->pendingDraws++;
+    }
+    if (tracker->pendingDraws > 0)
+    {
+        tracker->stats.batches++;
+        tracker->stats.drawCalls += tracker->pendingDraws;
+    }
+    tracker->pendingDraws = 0;
+    tracker->pendingVertices = 0;
+    tracker->mode = RL_QUADS;
+    tracker->texture = 0;
+}
+
+void DrawTrackVertexArray(DrawStreamTracker *tracker, int32_t count, int32_t instances)
+{
+    tracker->stats.drawCalls++;
+    tracker->stats.meshDraws++;
+    tracker->stats.vertices += count*instances;
+}
+
+void DrawTrackEnableTexture(DrawStreamTracker *tracker)
+{
+    tracker->stats.textureBinds++;
+}
+
+void ResetDrawState(DrawStreamState *state, int32_t width, int32_t height)
+{
+    *state = (DrawStreamState){
+        .projection = MatrixOrtho(0.0, width, height, 0.0, 0.0, 1.0),
+        .modelview = MatrixIdentity(),
+        .transform = MatrixIdentity(),
+        .matrixMode = RL_MODELVIEW,
+        .depthMask = true,
+        .cullFace = true,
+        .width = width,
+        .height = height,
+        .screenWidth = width,
+        .screenHeight = height
+    };
+}
+
+static Matrix *DrawStateCurrent(DrawStreamState *state)
+{
+    if (state->currentMatrix == DRAW_STATE_MATRIX_PROJECTION) return &state->projection;
+    if (state->currentMatrix == DRAW_STATE_MATRIX_TRANSFORM) return &state->transform;
+    return &state->modelview;
+}
+
+bool ApplyDrawStateOp(DrawStreamState *state, DrawOp op, const uint8_t *payload)
+{
+    float f[16];
+    Matrix *current = DrawStateCurrent(state);
+
+    // same multiplication orders as rlgl
+    switch (op)
+    {
+        case DRAW_OP_PUSH_MATRIX:
+        {
+            if (state->matrixMode == RL_MODELVIEW)
+            {
+                state->transformRequired = true;
+                state->currentMatrix = DRAW_STATE_MATRIX_TRANSFORM;
+                current = &state->transform;
+            }
+            if (state->stackDepth < RL_MAX_MATRIX_STACK_SIZE) state->stack[state->stackDepth++] = *current;
+        } break;
+        case DRAW_OP_POP_MATRIX:
+        {
+            if (state->stackDepth > 0) *current = state->stack[--state->stackDepth];
+            if (state->stackDepth == 0 && state->matrixMode == RL_MODELVIEW)
+            {
+                state->currentMatrix = DRAW_STATE_MATRIX_MODELVIEW;
+                state->transformRequired = false;
+            }
+        } break;
+        case DRAW_OP_LOAD_IDENTITY: *current = MatrixIdentity(); break;
+        case DRAW_OP_TRANSLATE: memcpy(f, payload, 12); *current = MatrixMultiply(MatrixTranslate(f[0], f[1], f[2]), *current); break;
+        case DRAW_OP_ROTATE:
+        {
+            memcpy(f, payload, 16);
+            *current = MatrixMultiply(MatrixRotate((Vector3){ f[1], f[2], f[3] }, f[0]*DEG2RAD), *current);
+        } break;
+        case DRAW_OP_SCALE: memcpy(f, payload, 12); *current = MatrixMultiply(MatrixScale(f[0], f[1], f[2]), *current); break;
+        case DRAW_OP_MULT_MATRIX:
+        {
+            memcpy(f, payload, 64);
+            Matrix m = {
+                f[0], f[4], f[8], f[12],
+                f[1], f[5], f[9], f[13],
+                f[2], f[6], f[10], f[14],
+                f[3], f[7], f[11], f[15]
+            };
+            *current = MatrixMultiply(*current, m);
+        } break;
+        case DRAW_OP_MATRIX_MODE:
+        {
+            int32_t mode;
+            memcpy(&mode, payload, 4);
+            state->matrixMode = mode;
+            if (mode == RL_PROJECTION) state->currentMatrix = DRAW_STATE_MATRIX_PROJECTION;
+            else if (mode == RL_MODELVIEW) state->currentMatrix = DRAW_STATE_MATRIX_MODELVIEW;
+        } break;
+        case DRAW_OP_FRUSTUM: memcpy(f, payload, 24); *current = MatrixMultiply(*current, MatrixFrustum(f[0], f[1], f[2], f[3], f[4], f[5])); break;
+        case DRAW_OP_ORTHO: memcpy(f, payload, 24); *current = MatrixMultiply(*current, MatrixOrtho(f[0], f[1], f[2], f[3], f[4], f[5])); break;
+        case DRAW_OP_DEPTH_TEST: state->depthTest = payload[0] != 0; break;
+        case DRAW_OP_CULL_FACE: state->cullFace = payload[0] != 0; break;
+        case DRAW_OP_DEPTH_MASK: state->depthMask = payload[0] != 0; break;
+        case DRAW_OP_TARGET:
+        {
+            int32_t size[2];
+            memcpy(&state->target, payload, 4);
+            memcpy(size, payload + 4, 8);
+            state->width = size[0];
+            state->height = size[1];
+        } break;
+        case DRAW_OP_STATE:
+        {
+            int32_t size[2];
+            memcpy(size, payload, 8);
+            ResetDrawState(state, size[0], size[1]);
+            memcpy(&state->projection, payload + 8, sizeof(Matrix));
+            memcpy(&state->modelview, payload + 72, sizeof(Matrix));
+        } break;
+        default: return false;
+    }
+    return true;
+}
+
+Vector3 DrawStateVertex(const DrawStreamState *state, float x, float y, float z)
+{
+    if (!state->transformRequired) return (Vector3){ x, y, z };
+    return Vector3Transform((Vector3){ x, y, z }, state->transform);
+}
+
+Matrix GetDrawStateMVP(const DrawStreamState *state)
+{
+    return MatrixMultiply(state->modelview, state->projection);
+}
+
+bool WriteDrawOp(DrawStreamBuffer *buffer, DrawOp op, const void *payload)
+{
+    return WriteDrawOpData(buffer, op, payload, NULL, 0);
+}
+
+bool WriteDrawOpData(DrawStreamBuffer *buffer, DrawOp op, const void *payload, const void *data, uint32_t size)
+{
+    size_t total = 1 + drawOpPayloadSize[op] + size;
+    if (buffer->size + total > buffer->capacity)
+    {
+        size_t capacity = (buffer->capacity > 0) ? buffer->capacity*2 : 64*1024;
+        while (capacity < buffer->size + total) capacity *= 2;
+        uint8_t *grown = MemReallocTagged(MEM_TAG_RENDER, buffer->data, capacity);
+        if (grown == NULL) return false;
+        buffer->data = grown;
+        buffer->capacity = capacity;
+    }
+
+    uint8_t *at = buffer->data + buffer->size;
+    at[0] = (uint8_t)op;
+    if (drawOpPayloadSize[op] > 0) memcpy(at + 1, payload, drawOpPayloadSize[op]);
+    if (size > 0) memcpy(at + 1 + drawOpPayloadSize[op], data, size);
+    buffer->size += total;
+    if (op == DRAW_OP_FRAME) buffer->frameCount++;
+    return true;
+}
+
+bool SaveDrawStream(const DrawStreamBuffer *buffer, const char *fileName)
+{
+    FILE *file = fopen(fileName, "wb");
+    if (file == NULL) return false;
+
+    DrawStreamHeader header = { { 'D', 'R', 'W', ' ' }, DRAW_STREAM_FILE_VERSION, buffer->frameCount, DRAW_STREAM_BATCH_VERTICES, buffer->size };
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = ok && (buffer->size == 0 || fwrite(buffer->data, buffer->size, 1, file) == 1);
+    fclose(file);
+
+    return ok;
+}
+
+DrawStreamBuffer LoadDrawStream(const char *fileName)
+{
+    DrawStreamBuffer buffer = { 0 };
+    FILE *file = fopen(fileName, "rb");
+    if (file == NULL) return buffer;
+
+    DrawStreamHeader header;
+    bool ok = fread(&header, sizeof(header), 1, file) == 1 && memcmp(header.magic, "DRW ", 4) == 0 &&
+              header.version == DRAW_STREAM_FILE_VERSION && header.size > 0;
+    if (ok) buffer.data = MemAllocTagged(MEM_TAG_RENDER, header.size);
+    ok = ok && buffer.data != NULL && fread(buffer.data, header.size, 1, file) == 1;
+    fclose(file);
+
+    // every op, payload and trailing data has to be inside the buffer before anyone walks it
+    size_t at = 0;
+    while (ok && at < header.size)
+    {
+        ok = buffer.data[at] < DRAW_OP_COUNT && at + 1 + drawOpPayloadSize[buffer.data[at]] <= header.size;
+        ok = ok && GetDrawOpSize(buffer.data + at) <= header.size - at;
+        if (ok) at += GetDrawOpSize(buffer.data + at);
+    }
+
+    if (!ok)
+    {
+        MemFreeTagged(buffer.data);
+        return (DrawStreamBuffer){ 0 };
+    }
+    buffer.size = buffer.capacity = header.size;
+    buffer.frameCount = header.frameCount;
+    return buffer;
+}
+
+void UnloadDrawStream(DrawStreamBuffer *buffer)
+{
+    MemFreeTagged(buffer->data);
+    *buffer = (DrawStreamBuffer){ 0 };
+}
+
+void *GetDrawTableEntry(void **items, int32_t *capacity, size_t itemSize, uint32_t id)
+{
+    if (id > DRAW_MAX_ID) return NULL;
+    if ((int32_t)id >= *capacity)
+    {
+        int32_t grown = (*capacity > 0) ? *capacity : 64;
+        while (grown <= (int32_t)id) grown *= 2;
+        uint8_t *table = MemReallocTagged(MEM_TAG_RENDER, *items, itemSize*grown);
+        if (table == NULL) return NULL;
+        memset(table + itemSize*(*capacity), 0, itemSize*(grown - *capacity));
+        *items = table;
+        *capacity = grown;
+    }
+    return (uint8_t *)*items + itemSize*id;
+}
@@ -0,0 +1,190 @@
+#ifndef DRAWSTREAM_H
+#define DRAWSTREAM_H
+
+#include "raylib.h"         // before rlgl.h so both agree on Matrix
+#include "rlgl.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// rlgl draw stream: the immediate mode and vertex array calls a frame makes,
+// as recorded by rlstats.c and played back by tools/draw_replay.c.
+// Every command is one op byte followed by a fixed size payload in native
+// byte order; BUFFER_DATA and TEXTURE_DATA end their payload with a byte
+// count and that many bytes follow. Texture ids are recorded with rlgl's
+// default texture as 0; rlSetTexture(0) changes nothing in rlgl and is not
+// recorded.
+// Matrix, depth/cull and render target changes are recorded too, so a
+// replay can rebuild what every immediate mode vertex ends up as on screen.
+// With resource tracking on (TrackDrawResources()) the stream also carries
+// vertex buffer contents, vertex array layouts, textures as RGBA8 and the
+// shaders and uniforms vertex array draws use: a capture opens with every
+// live resource and records changes as they happen.
+//
+// DrawStreamTracker mirrors how rlgl groups that stream into batches and
+// draws, so live counters and replays count the same way without GL.
+// DrawStreamState mirrors rlgl's matrix stack and the state a rasterizer needs.
+
+#define DRAW_STREAM_FILE_VERSION 3
+#define DRAW_STREAM_BATCH_VERTICES (RL_DEFAULT_BATCH_BUFFER_ELEMENTS*4)
+#define DRAW_MAX_ATTRIBUTES 8
+#define DRAW_MAX_ID (1 << 20)       // GL names above this are not tracked
+
+typedef enum {
+    DRAW_OP_FRAME = 0,              // end of frame
+    DRAW_OP_FLUSH,                  // render batch drawn (mode/target/shader/blend/scissor change)
+    DRAW_OP_BEGIN,                  // int32 mode
+    DRAW_OP_END,
+    DRAW_OP_VERTEX2,                // float x, y
+    DRAW_OP_VERTEX3,                // float x, y, z
+    DRAW_OP_TEXCOORD,               // float u, v
+    DRAW_OP_NORMAL,                 // float x, y, z
+    DRAW_OP_COLOR,                  // uint8 r, g, b, a
+    DRAW_OP_SET_TEXTURE,            // uint32 id
+    DRAW_OP_ENABLE_TEXTURE,         // uint32 id, vertex array draws
+    DRAW_OP_PUSH_MATRIX,
+    DRAW_OP_POP_MATRIX,
+    DRAW_OP_LOAD_IDENTITY,
+    DRAW_OP_TRANSLATE,              // float x, y, z
+    DRAW_OP_ROTATE,                 // float angle, x, y, z
+    DRAW_OP_SCALE,                  // float x, y, z
+    DRAW_OP_MULT_MATRIX,            // float m[16]
+    DRAW_OP_DRAW_ARRAYS,            // int32 offset, count, instances
+    DRAW_OP_DRAW_ELEMENTS,          // int32 offset, count, instances
+    DRAW_OP_MATRIX_MODE,            // int32 mode
+    DRAW_OP_FRUSTUM,                // float left, right, bottom, top, near, far
+    DRAW_OP_ORTHO,                  // float left, right, bottom, top, near, far
+    DRAW_OP_DEPTH_TEST,             // uint8 enabled
+    DRAW_OP_CULL_FACE,              // uint8 enabled
+    DRAW_OP_TARGET,                 // uint32 texture id (0 = screen), int32 width, height
+    DRAW_OP_CLEAR,                  // uint8 r, g, b, a
+    DRAW_OP_STATE,                  // int32 width, height, float projection[16], modelview[16]; first op of a capture
+    DRAW_OP_DEPTH_MASK,             // uint8 enabled
+    DRAW_OP_BUFFER,                 // uint32 id, size; loaded zero filled, size 0 unloads
+    DRAW_OP_BUFFER_DATA,            // uint32 id, offset, size, then size bytes
+    DRAW_OP_VERTEX_ARRAY,           // uint32 id; loaded or unloaded, attributes reset
+    DRAW_OP_ATTRIBUTE,              // uint32 vertex array, location, DrawAttribute
+    DRAW_OP_ELEMENT_BUFFER,         // uint32 vertex array, buffer of uint16 indices
+    DRAW_OP_BIND_VERTEX_ARRAY,      // uint32 id vertex array draws read, 0 for none
+    DRAW_OP_TEXTURE,                // uint32 id, int32 width, height; width 0 unloads
+    DRAW_OP_TEXTURE_DATA,           // uint32 id, int32 x, y, width, height, uint32 size, then RGBA8 rows
+    DRAW_OP_PROGRAM,                // uint32 id, int32 DrawProgram; a shader was loaded
+    DRAW_OP_BIND_PROGRAM,           // uint32 id vertex array draws run, 0 for none
+    DRAW_OP_BATCH_PROGRAM,          // uint32 id the render batch is drawn with
+    DRAW_OP_UNIFORM,                // uint32 program, int32 DRAW_UNIFORM_*, float value[16]
+    DRAW_OP_COUNT
+} DrawOp;
+
+// What a shader does, told apart when it is loaded by a uniform or attribute
+// only that shader has. Unknown shaders replay as raylib's default one.
+typedef enum {
+    DRAW_PROGRAM_DEFAULT = 0,       // raylib's default shader: texture*color*colDiffuse, DrawMesh()
+    DRAW_PROGRAM_PACKED,            // meshopt.c quantized meshes, vertex color only
+    DRAW_PROGRAM_PARTICLE,          // particles_draw.c camera facing discs
+    DRAW_PROGRAM_SPRITE,            // spritebatch.c quads and discs
+    DRAW_PROGRAM_SDF,               // text.c distance field glyphs, drawn by the render batch
+    DRAW_PROGRAM_COUNT
+} DrawProgram;
+
+// Uniforms a replay needs, PARAM0/PARAM1 are meshOffset/meshScale for packed
+// meshes and cameraRight/cameraUp for particles
+enum { DRAW_UNIFORM_MVP = 0, DRAW_UNIFORM_COLOR, DRAW_UNIFORM_PARAM0, DRAW_UNIFORM_PARAM1, DRAW_UNIFORM_COUNT };
+
+// One vertex array attribute as glVertexAttribPointer() left it
+typedef struct {
+    uint32_t buffer;                // vertex buffer read, 0 for none
+    int32_t components;
+    int32_t type;                   // GL type: RL_FLOAT, RL_UNSIGNED_BYTE, GL_SHORT...
+    int32_t normalized;
+    int32_t stride;                 // 0 for tightly packed
+    int32_t offset;                 // bytes into the buffer
+    int32_t divisor;                // 0 per vertex, 1 per instance
+    int32_t enabled;                // disabled ones read (0, 0, 0, 1), white for colors
+} DrawAttribute;
+
+typedef struct {
+    char magic[4];
+    int32_t version;
+    int32_t frameCount;
+    int32_t batchVertices;          // DRAW_STREAM_BATCH_VERTICES of the recording build
+    uint64_t size;                  // command bytes after the header
+} DrawStreamHeader;
+
+typedef struct {
+    int32_t batches;                // render batch flushes that had vertices
+    int32_t drawCalls;              // batch draws plus vertex array draws
+    int32_t vertices;               // immediate mode vertices plus vertex array vertices
+    int32_t textureBinds;
+    int32_t meshDraws;              // vertex array draws (DrawMesh, instanced renderers)
+} DrawStats;
+
+typedef struct {
+    DrawStats stats;
+    int32_t mode;
+    uint32_t texture;
+    int32_t drawVertices;           // vertices in the open draw
+    int32_t pendingDraws;           // closed draws waiting for the flush
+    int32_t pendingVertices;
+} DrawStreamTracker;
+
+enum { DRAW_STATE_MATRIX_MODELVIEW = 0, DRAW_STATE_MATRIX_PROJECTION, DRAW_STATE_MATRIX_TRANSFORM };
+
+typedef struct {
+    Matrix projection;
+    Matrix modelview;
+    Matrix transform;               // pushed modelview matrix applied to vertices on the CPU
+    Matrix stack[RL_MAX_MATRIX_STACK_SIZE];
+    int32_t stackDepth;
+    int32_t matrixMode;
+    int32_t currentMatrix;          // what rlgl's currentMatrix points at, DRAW_STATE_MATRIX_*
+    bool transformRequired;
+    bool depthTest;
+    bool depthMask;
+    bool cullFace;
+    uint32_t target;                // texture id of the render target, 0 for the screen
+    int32_t width;                  // render target size
+    int32_t height;
+    int32_t screenWidth;
+    int32_t screenHeight;
+} DrawStreamState;
+
+typedef struct {
+    uint8_t *data;
+    size_t size;
+    size_t capacity;
+    int32_t frameCount;
+} DrawStreamBuffer;
+
+// Fixed payload bytes following each op
+extern const uint8_t drawOpPayloadSize[DRAW_OP_COUNT];
+// Op byte, payload and trailing data of the op at op
+size_t GetDrawOpSize(const uint8_t *op);
+
+void DrawTrackBegin(DrawStreamTracker *tracker, int mode);
+void DrawTrackVertex(DrawStreamTracker *tracker);
+void DrawTrackSetTexture(DrawStreamTracker *tracker, uint32_t id);
+void DrawTrackFlush(DrawStreamTracker *tracker);
+void DrawTrackVertexArray(DrawStreamTracker *tracker, int32_t count, int32_t instances);
+void DrawTrackEnableTexture(DrawStreamTracker *tracker);
+
+// Outside any mode, as rlgl is between frames
+void ResetDrawState(DrawStreamState *state, int32_t width, int32_t height);
+// Applies matrix, depth/cull/mask, target and STATE ops; false for anything else
+bool ApplyDrawStateOp(DrawStreamState *state, DrawOp op, const uint8_t *payload);
+// Vertex position as rlgl stores it in the batch
+Vector3 DrawStateVertex(const DrawStreamState *state, float x, float y, float z);
+// What rlgl draws the batch with
+Matrix GetDrawStateMVP(const DrawStreamState *state);
+
+bool WriteDrawOp(DrawStreamBuffer *buffer, DrawOp op, const void *payload);
+// BUFFER_DATA and TEXTURE_DATA, the payload's last 4 bytes have to be size
+bool WriteDrawOpData(DrawStreamBuffer *buffer, DrawOp op, const void *payload, const void *data, uint32_t size);
+bool SaveDrawStream(const DrawStreamBuffer *buffer, const char *fileName);
+DrawStreamBuffer LoadDrawStream(const char *fileName);
+void UnloadDrawStream(DrawStreamBuffer *buffer);
+
+// Tables indexed by GL id: grows *items so id fits, new entries zeroed.
+// NULL when id is above DRAW_MAX_ID or out of memory.
+void *GetDrawTableEntry(void **items, int32_t *capacity, size_t itemSize, uint32_t id);
+
+#endif
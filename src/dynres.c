@@ -0,0 +1,94 @@
+#include "dynres.h"
+#include "rlgl.h"
+
+#define DYNRES_SCALE_DOWN 0.9f      // multiplicative decrease on a missed budget
+#define DYNRES_SCALE_UP 0.02f       // additive increase while within budget
+#define DYNRES_OVER_BUDGET 1.10f    // slack so vsync jitter does not trigger a drop
+#define DYNRES_COOLDOWN 1.0f
+#define DYNRES_SMOOTHING 0.1f
+
+static void DynamicResolutionResize(DynamicResolution *dynres, int width, int height)
+{
+    if (IsRenderTextureReady(dynres->target)) UnloadRenderTexture(dynres->target);
+    dynres->target = LoadRenderTexture(width, height);
+    SetTextureFilter(dynres->target.texture, TEXTURE_FILTER_BILINEAR);
+    dynres->width = width;
+    dynres->height = height;
+}
+
+DynamicResolution LoadDynamicResolution(float budget)
+{
+    DynamicResolution dynres = {
+        .scale = DYNRES_MAX_SCALE,
+        .budget = budget,
+        .averageFrameTime = budget,
+        .cooldown = 0.0f,
+        .enabled = true
+    };
+    DynamicResolutionResize(&dynres, GetScreenWidth(), GetScreenHeight());
+    return dynres;
+}
+
+void UnloadDynamicResolution(DynamicResolution *dynres)
+{
+    UnloadRenderTexture(dynres->target);
+    *dynres = (DynamicResolution){ 0 };
+}
+
+void UpdateDynamicResolution(DynamicResolution *dynres, float frameTime)
+{
+    if (GetScreenWidth() != dynres->width || GetScreenHeight() != dynres->height)
+    {
+        if (GetScreenWidth() > 0 && GetScreenHeight() > 0) DynamicResolutionResize(dynres, GetScreenWidth(), GetScreenHeight());
+    }
+
+    if (!dynres->enabled)
+    {
+        dynres->scale = DYNRES_MAX_SCALE;
+        return;
+    }
+
+    dynres->averageFrameTime += (frameTime - dynres->averageFrameTime)*DYNRES_SMOOTHING;
+    if (dynres->cooldown > 0.0f) dynres->cooldown -= frameTime;
+
+    if (dynres->averageFrameTime > dynres->budget*DYNRES_OVER_BUDGET)
+    {
+        if (dynres->cooldown <= 0.0f && dynres->scale > DYNRES_MIN_SCALE)
+        {
+            dynres->scale *= DYNRES_SCALE_DOWN;
+            if (dynres->scale < DYNRES_MIN_SCALE) dynres->scale = DYNRES_MIN_SCALE;
+            // let the average settle on the new scale before judging it
+            dynres->averageFrameTime = dynres->budget;
+            dynres->cooldown = DYNRES_COOLDOWN;
+        }
+    }
+    else if (dynres->cooldown <= 0.0f && dynres->scale < DYNRES_MAX_SCALE)
+    {
+        dynres->scale += DYNRES_SCALE_UP;
+        if (dynres->scale > DYNRES_MAX_SCALE) dynres->scale = DYNRES_MAX_SCALE;
+        dynres->cooldown = DYNRES_COOLDOWN*0.25f;
+    }
+}
+
+void BeginDynamicResolution(DynamicResolution *dynres)
+{
+    BeginTextureMode(dynres->target);
+    // BeginMode3D() takes the aspect from the full target, which the scaled viewport keeps
+    rlViewport(0, 0, (int)(dynres->width*dynres->scale), (int)(dynres->height*dynres->scale));
+}
+
+void EndDynamicResolution(DynamicResolution *dynres)
+{
+    (void)dynres;
+    EndTextureMode();
+}
+
+void DrawDynamicResolution(const DynamicResolution *dynres)
+{
+    float width = (float)(int)(dynres->width*dynres->scale);
+    float height = (float)(int)(dynres->height*dynres->scale);
+
+    // the scene sits in the bottom rows of the (upside down) render texture
+    DrawTexturePro(dynres->target.texture, (Rectangle){ 0, 0, width, -height },
+        (Rectangle){ 0, 0, (float)GetScreenWidth(), (float)GetScreenHeight() }, (Vector2){ 0, 0 }, 0.0f, WHITE);
+}
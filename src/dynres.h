@@ -0,0 +1,44 @@
+#ifndef DYNRES_H
+#define DYNRES_H
+
+#include "raylib.h"
+#include <stdbool.h>
+
+// Dynamic resolution for the 3D pass.
+// The scene is rendered into the lower-left corner of a native sized render
+// texture using a smaller viewport, then stretched over the screen. Scaling
+// the viewport instead of the texture means no reallocation when the scale moves.
+//
+// The controller is AIMD on the measured frame time: a frame over budget cuts
+// the scale, while frames that fit the budget slowly probe it back up.
+// With SetTargetFPS() the frame time never drops under the target so there is
+// no way to see headroom other than trying.
+
+#define DYNRES_MIN_SCALE 0.5f
+#define DYNRES_MAX_SCALE 1.0f
+
+typedef struct {
+    RenderTexture2D target;
+    int width;              // native size the target was allocated for
+    int height;
+    float scale;            // current fraction of native resolution per axis
+    float budget;           // frame time budget in seconds
+    float averageFrameTime;
+    float cooldown;         // seconds before the scale may go back up
+    bool enabled;
+} DynamicResolution;
+
+DynamicResolution LoadDynamicResolution(float budget);
+void UnloadDynamicResolution(DynamicResolution *dynres);
+
+// Feeds the last frame time to the controller and follows window resizes
+void UpdateDynamicResolution(DynamicResolution *dynres, float frameTime);
+
+// Wraps the 3D pass, ClearBackground() and BeginMode3D() go between these
+void BeginDynamicResolution(DynamicResolution *dynres);
+void EndDynamicResolution(DynamicResolution *dynres);
+
+// Stretches the scaled scene over the whole screen, call inside BeginDrawing()
+void DrawDynamicResolution(const DynamicResolution *dynres);
+
+#endif
@@ -0,0 +1,194 @@
+#include "filewatch.h"
+#include "raylib.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+typedef struct {
+    char path[FILE_WATCH_PATH_LENGTH];  // as passed to WatchFile()
+    const char *name;                   // into path, past the directory
+    int wd;                             // watch on the directory
+    bool pending;                       // changed, not handed out yet
+} WatchedFile;
+
+static struct {
+    bool running;
+    bool quit;
+    int fd;
+    WatchedFile files[FILE_WATCH_MAX_FILES];
+    int32_t fileCount;
+    double lastChange;
+    pthread_t thread;
+    pthread_mutex_t lock;
+} watch = { .running = false };
+
+// Own clock, the watcher thread cannot ask raylib
+static double FileWatchNow(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec*1e-9;
+}
+
+#if defined(__linux__)
+static void *FileWatchThread(void *arg)
+{
+    (void)arg;
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    struct pollfd poller = { .fd = watch.fd, .events = POLLIN };
+
+    for (;;)
+    {
+        pthread_mutex_lock(&watch.lock);
+        bool quit = watch.quit;
+        pthread_mutex_unlock(&watch.lock);
+        if (quit) break;
+
+        // wakes up now and then to notice CloseFileWatch()
+        if (poll(&poller, 1, 100) <= 0) continue;
+        ssize_t length = read(watch.fd, buffer, sizeof(buffer));
+        if (length <= 0) continue;
+
+        double now = FileWatchNow();
+        pthread_mutex_lock(&watch.lock);
+        for (const char *p = buffer; p < buffer + length; )
+        {
+            const struct inotify_event *event = (const struct inotify_event *)p;
+            p += sizeof(struct inotify_event) + event->len;
+            if (event->len == 0) continue;
+
+            // everything else in the directory is not ours
+            for (int32_t i = 0; i < watch.fileCount; i++)
+            {
+                WatchedFile *file = &watch.files[i];
+                if (file->wd != event->wd || strcmp(file->name, event->name) != 0) continue;
+                file->pending = true;
+                watch.lastChange = now;
+            }
+        }
+        pthread_mutex_unlock(&watch.lock);
+    }
+    return NULL;
+}
+#endif
+
+bool InitFileWatch(void)
+{
+    if (watch.running) return true;
+
+#if defined(__linux__)
+    watch.fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (watch.fd < 0)
+    {
+        TraceLog(LOG_WARNING, "WATCH: inotify not available, no hot reload");
+        return false;
+    }
+    watch.fileCount = 0;
+    watch.lastChange = 0.0;
+    watch.quit = false;
+    pthread_mutex_init(&watch.lock, NULL);
+    watch.running = (pthread_create(&watch.thread, NULL, FileWatchThread, NULL) == 0);
+    if (!watch.running)
+    {
+        pthread_mutex_destroy(&watch.lock);
+        close(watch.fd);
+        TraceLog(LOG_WARNING, "WATCH: Watcher thread could not be started");
+    }
+    return watch.running;
+#else
+    TraceLog(LOG_WARNING, "WATCH: File watching needs inotify, no hot reload on this platform");
+    return false;
+#endif
+}
+
+void CloseFileWatch(void)
+{
+    if (!watch.running) return;
+
+#if defined(__linux__)
+    pthread_mutex_lock(&watch.lock);
+    watch.quit = true;
+    pthread_mutex_unlock(&watch.lock);
+    pthread_join(watch.thread, NULL);
+    close(watch.fd);
+    pthread_mutex_destroy(&watch.lock);
+#endif
+    watch.running = false;
+    watch.fileCount = 0;
+}
+
+bool WatchFile(const char *fileName)
+{
+    if (!watch.running) return false;
+    if (strlen(fileName) >= FILE_WATCH_PATH_LENGTH)
+    {
+        TraceLog(LOG_WARNING, "WATCH: [%s] path too long", fileName);
+        return false;
+    }
+
+#if defined(__linux__)
+    // watching the same directory twice hands back the same watch
+    char directory[FILE_WATCH_PATH_LENGTH] = ".";
+    const char *slash = strrchr(fileName, '/');
+    if (slash == fileName) snprintf(directory, sizeof(directory), "/");
+    else if (slash != NULL) snprintf(directory, sizeof(directory), "%.*s", (int)(slash - fileName), fileName);
+    int wd = inotify_add_watch(watch.fd, directory, IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (wd < 0)
+    {
+        TraceLog(LOG_WARNING, "WATCH: [%s] directory could not be watched", fileName);
+        return false;
+    }
+
+    pthread_mutex_lock(&watch.lock);
+    bool added = (watch.fileCount < FILE_WATCH_MAX_FILES);
+    if (added)
+    {
+        WatchedFile *file = &watch.files[watch.fileCount];
+        snprintf(file->path, sizeof(file->path), "%s", fileName);
+        file->name = (slash != NULL) ? file->path + (slash - fileName) + 1 : file->path;
+        file->wd = wd;
+        file->pending = false;
+        watch.fileCount++;
+    }
+    pthread_mutex_unlock(&watch.lock);
+    if (!added) TraceLog(LOG_WARNING, "WATCH: [%s] too many watched files (%d)", fileName, FILE_WATCH_MAX_FILES);
+    return added;
+#else
+    return false;
+#endif
+}
+
+bool PollFileChanges(FileChangeBatch *batch)
+{
+    batch->count = 0;
+    if (!watch.running) return false;
+
+    pthread_mutex_lock(&watch.lock);
+    // nothing until the files have been quiet for a while
+    if ((FileWatchNow() - watch.lastChange) >= FILE_WATCH_DEBOUNCE)
+    {
+        for (int32_t i = 0; i < watch.fileCount; i++)
+        {
+            if (!watch.files[i].pending) continue;
+            watch.files[i].pending = false;
+            batch->files[batch->count++] = watch.files[i].path;
+        }
+    }
+    pthread_mutex_unlock(&watch.lock);
+    return batch->count > 0;
+}
+
+bool IsFileInBatch(const FileChangeBatch *batch, const char *fileName)
+{
+    for (int32_t i = 0; i < batch->count; i++)
+    {
+        if (strcmp(batch->files[i], fileName) == 0) return true;
+    }
+    return false;
+}
@@ -0,0 +1,33 @@
+#ifndef FILEWATCH_H
+#define FILEWATCH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// File change notifications for hot reload.
+// A watcher thread follows the directories the watched files are in
+// (inotify, Linux only): editors and bakes often replace a file by renaming
+// over it, which a watch on the file itself would not survive. Changes are
+// debounced, a batch is only handed out once none of the watched files
+// changed for FILE_WATCH_DEBOUNCE seconds, so a save written in several
+// steps or a bake writing several files reloads once.
+
+#define FILE_WATCH_MAX_FILES 32
+#define FILE_WATCH_PATH_LENGTH 256
+#define FILE_WATCH_DEBOUNCE 0.25f
+
+typedef struct {
+    int32_t count;
+    const char *files[FILE_WATCH_MAX_FILES];    // as passed to WatchFile(), valid until CloseFileWatch()
+} FileChangeBatch;
+
+// false where there is no inotify, nothing is ever reported then
+bool InitFileWatch(void);
+void CloseFileWatch(void);
+bool WatchFile(const char *fileName);
+
+// Non blocking, true when a debounced batch is ready
+bool PollFileChanges(FileChangeBatch *batch);
+bool IsFileInBatch(const FileChangeBatch *batch, const char *fileName);
+
+#endif
@@ -0,0 +1,244 @@
+#include "framecapture.h"
+#include "memtrack.h"
+#include "raylib.h"
+#include "rlgl.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#define FRAME_CAPTURE_GLAPI __stdcall
+#else
+#define FRAME_CAPTURE_GLAPI
+#endif
+#define FRAME_CAPTURE_GL_RGBA 0x1908
+#define FRAME_CAPTURE_GL_UNSIGNED_BYTE 0x1401
+
+// GL 1.1, exported by every GL library. rlgl only reads back into a fresh
+// allocation it then flips into a second one, this reads into the pool.
+extern void FRAME_CAPTURE_GLAPI glReadPixels(int x, int y, int width, int height, unsigned int format, unsigned int type, void *pixels);
+
+typedef struct {
+    unsigned char *pixels;          // RGBA8, bottom row first as read, the encoder flips it
+    size_t capacity;
+    int32_t width;
+    int32_t height;
+    char fileName[FRAME_CAPTURE_NAME_LENGTH];
+} CaptureBuffer;
+
+static struct {
+    CaptureBuffer buffers[FRAME_CAPTURE_MAX_BUFFERS];
+    int32_t bufferCount;
+    int32_t free[FRAME_CAPTURE_MAX_BUFFERS];    // buffers the main thread may fill
+    int32_t freeCount;
+    int32_t queue[FRAME_CAPTURE_MAX_BUFFERS];   // ring of buffers waiting for the encoder
+    int32_t head;
+    int32_t tail;
+    bool running;
+    bool quit;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+
+    char screenshot[FRAME_CAPTURE_NAME_LENGTH];
+    char sequencePrefix[FRAME_CAPTURE_NAME_LENGTH];
+    char sequenceExtension[16];
+    int32_t sequenceFrame;
+    int32_t sequenceLength;
+    FrameCaptureStats stats;
+} capture = { .running = false };
+
+// Images are top row first and opaque, the frame's alpha is whatever blending left
+static void FinishCapturePixels(CaptureBuffer *buffer)
+{
+    const size_t stride = (size_t)buffer->width*4;
+    unsigned char chunk[1024];
+    for (int32_t y = 0; y < buffer->height/2; y++)
+    {
+        unsigned char *top = buffer->pixels + y*stride, *bottom = buffer->pixels + (buffer->height - 1 - y)*stride;
+        for (size_t at = 0; at < stride; at += sizeof(chunk))
+        {
+            size_t n = (stride - at < sizeof(chunk)) ? stride - at : sizeof(chunk);
+            memcpy(chunk, top + at, n);
+            memcpy(top + at, bottom + at, n);
+            memcpy(bottom + at, chunk, n);
+        }
+    }
+    for (size_t i = 3; i < stride*buffer->height; i += 4) buffer->pixels[i] = 255;
+}
+
+static void *FrameCaptureEncoder(void *arg)
+{
+    (void)arg;
+    pthread_mutex_lock(&capture.lock);
+    for (;;)
+    {
+        while (capture.head == capture.tail && !capture.quit) pthread_cond_wait(&capture.wake, &capture.lock);
+        if (capture.head == capture.tail) break;
+
+        int32_t index = capture.queue[capture.head % FRAME_CAPTURE_MAX_BUFFERS];
+        capture.head++;
+        pthread_mutex_unlock(&capture.lock);
+
+        // the buffer is ours until it goes back on the free list
+        CaptureBuffer *buffer = &capture.buffers[index];
+        FinishCapturePixels(buffer);
+        Image image = {
+            .data = buffer->pixels,
+            .width = buffer->width,
+            .height = buffer->height,
+            .mipmaps = 1,
+            .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8
+        };
+        bool written = ExportImage(image, buffer->fileName);
+
+        pthread_mutex_lock(&capture.lock);
+        capture.free[capture.freeCount++] = index;
+        capture.stats.queued--;
+        if (written) capture.stats.written++;
+        else capture.stats.failed++;
+    }
+    pthread_mutex_unlock(&capture.lock);
+    return NULL;
+}
+
+void InitFrameCapture(int32_t bufferCount)
+{
+    if (capture.running) return;
+    if (bufferCount <= 0) bufferCount = FRAME_CAPTURE_BUFFERS;
+    if (bufferCount > FRAME_CAPTURE_MAX_BUFFERS) bufferCount = FRAME_CAPTURE_MAX_BUFFERS;
+
+    // pixel storage is allocated on first use, at the size of the screen then
+    capture.bufferCount = bufferCount;
+    capture.freeCount = 0;
+    for (int32_t i = 0; i < bufferCount; i++)
+    {
+        capture.buffers[i] = (CaptureBuffer){ 0 };
+        capture.free[capture.freeCount++] = i;
+    }
+    capture.head = capture.tail = 0;
+    capture.quit = false;
+    capture.screenshot[0] = '\0';
+    capture.sequenceLength = 0;
+    capture.stats = (FrameCaptureStats){ 0 };
+
+    pthread_mutex_init(&capture.lock, NULL);
+    pthread_cond_init(&capture.wake, NULL);
+    capture.running = (pthread_create(&capture.thread, NULL, FrameCaptureEncoder, NULL) == 0);
+    if (!capture.running)
+    {
+        pthread_cond_destroy(&capture.wake);
+        pthread_mutex_destroy(&capture.lock);
+        TraceLog(LOG_WARNING, "CAPTURE: Encoder thread could not be started");
+    }
+}
+
+void CloseFrameCapture(void)
+{
+    if (!capture.running) return;
+
+    pthread_mutex_lock(&capture.lock);
+    capture.quit = true;
+    pthread_cond_signal(&capture.wake);
+    pthread_mutex_unlock(&capture.lock);
+    pthread_join(capture.thread, NULL);
+    capture.running = false;
+
+    pthread_cond_destroy(&capture.wake);
+    pthread_mutex_destroy(&capture.lock);
+    for (int32_t i = 0; i < capture.bufferCount; i++) MemFreeTagged(capture.buffers[i].pixels);
+    capture.bufferCount = 0;
+}
+
+void RequestScreenshot(const char *fileName)
+{
+    snprintf(capture.screenshot, sizeof(capture.screenshot), "%s", fileName);
+}
+
+void StartFrameSequence(const char *prefix, const char *extension, int32_t frameCount)
+{
+    snprintf(capture.sequencePrefix, sizeof(capture.sequencePrefix), "%s", prefix);
+    snprintf(capture.sequenceExtension, sizeof(capture.sequenceExtension), "%s", extension);
+    capture.sequenceFrame = 0;
+    capture.sequenceLength = (frameCount > 0) ? frameCount : 0;
+}
+
+bool IsFrameSequenceActive(void)
+{
+    return capture.sequenceFrame < capture.sequenceLength;
+}
+
+// Reads the back buffer into a free pooled buffer and queues it, false when
+// every buffer is still with the encoder
+static bool CaptureFrame(const char *fileName)
+{
+    pthread_mutex_lock(&capture.lock);
+    int32_t index = (capture.freeCount > 0) ? capture.free[--capture.freeCount] : -1;
+    if (index < 0) capture.stats.dropped++;
+    pthread_mutex_unlock(&capture.lock);
+    if (index < 0) return false;
+
+    double start = GetTime();
+    CaptureBuffer *buffer = &capture.buffers[index];
+    buffer->width = GetRenderWidth();
+    buffer->height = GetRenderHeight();
+    size_t size = (size_t)buffer->width*buffer->height*4;
+    if (size > buffer->capacity)
+    {
+        // only when the window grew, the pool settles at the largest size seen
+        MemFreeTagged(buffer->pixels);
+        buffer->pixels = MemAllocTagged(MEM_TAG_RENDER, size);
+        buffer->capacity = (buffer->pixels != NULL) ? size : 0;
+    }
+
+    // vertices still batched belong in the frame
+    rlDrawRenderBatchActive();
+    bool ready = (buffer->pixels != NULL);
+    if (ready) glReadPixels(0, 0, buffer->width, buffer->height, FRAME_CAPTURE_GL_RGBA, FRAME_CAPTURE_GL_UNSIGNED_BYTE, buffer->pixels);
+    snprintf(buffer->fileName, sizeof(buffer->fileName), "%s", fileName);
+    capture.stats.readbackMs = (float)((GetTime() - start)*1000.0);
+
+    pthread_mutex_lock(&capture.lock);
+    if (ready)
+    {
+        capture.queue[capture.tail % FRAME_CAPTURE_MAX_BUFFERS] = index;
+        capture.tail++;
+        capture.stats.queued++;
+        pthread_cond_signal(&capture.wake);
+    }
+    else
+    {
+        capture.free[capture.freeCount++] = index;
+        capture.stats.failed++;
+    }
+    pthread_mutex_unlock(&capture.lock);
+    return ready;
+}
+
+void UpdateFrameCapture(void)
+{
+    if (!capture.running) return;
+
+    if (capture.screenshot[0] != '\0')
+    {
+        CaptureFrame(capture.screenshot);
+        capture.screenshot[0] = '\0';
+    }
+
+    if (IsFrameSequenceActive())
+    {
+        // dropped frames keep their number, gaps show where the encoder fell behind
+        CaptureFrame(TextFormat("%s%04d%s", capture.sequencePrefix, capture.sequenceFrame, capture.sequenceExtension));
+        capture.sequenceFrame++;
+    }
+}
+
+FrameCaptureStats GetFrameCaptureStats(void)
+{
+    if (!capture.running) return capture.stats;
+    pthread_mutex_lock(&capture.lock);
+    FrameCaptureStats stats = capture.stats;
+    pthread_mutex_unlock(&capture.lock);
+    return stats;
+}
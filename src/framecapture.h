@@ -0,0 +1,40 @@
+#ifndef FRAMECAPTURE_H
+#define FRAMECAPTURE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Screenshots and frame sequences without TakeScreenshot()'s hitch.
+// The main thread only reads the frame back into one of a few pooled
+// buffers; a background encoder thread encodes and writes it, the file
+// extension picks the format like ExportImage() (.qoi encodes an order of
+// magnitude faster than .png, sequences want it). When every buffer still
+// waits for the encoder the frame is dropped and counted, capture never
+// stalls the game.
+
+#define FRAME_CAPTURE_BUFFERS 4
+#define FRAME_CAPTURE_MAX_BUFFERS 16
+#define FRAME_CAPTURE_NAME_LENGTH 256
+
+typedef struct {
+    int32_t queued;                 // read back, waiting for or being encoded
+    int32_t written;
+    int32_t dropped;                // no free buffer at capture time
+    int32_t failed;                 // encode or write errors
+    float readbackMs;               // main thread cost of the last capture
+} FrameCaptureStats;
+
+void InitFrameCapture(int32_t bufferCount);     // <= 0 picks FRAME_CAPTURE_BUFFERS
+void CloseFrameCapture(void);                   // writes what is still queued
+
+// Taken at the next UpdateFrameCapture()
+void RequestScreenshot(const char *fileName);
+// The next frameCount frames as <prefix>NNNN<extension>, e.g. ("clip_", ".qoi")
+void StartFrameSequence(const char *prefix, const char *extension, int32_t frameCount);
+bool IsFrameSequenceActive(void);
+
+// Call once the frame is drawn, right before EndDrawing()
+void UpdateFrameCapture(void);
+FrameCaptureStats GetFrameCaptureStats(void);
+
+#endif
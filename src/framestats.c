@@ -0,0 +1,274 @@
+#include "framestats.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#define FRAME_STATS_SERIES (1 + FRAME_STATS_MAX_SYSTEMS)
+#define FRAME_STATS_SUB_BUCKETS 32      // per power of two, the relative precision
+#define FRAME_STATS_MAX_US (1u << 26)   // ~67 s, longer frames count as this
+#define FRAME_STATS_BUCKETS (FRAME_STATS_SUB_BUCKETS*(26 - 5 + 1))
+
+typedef struct {
+    const char *name;
+    uint32_t buckets[FRAME_STATS_BUCKETS];
+    uint64_t sum;                   // microseconds in the window, for the mean
+    double begin;                   // GetTime() at BeginFrameSystem(), < 0 outside
+    double current;                 // seconds this frame so far
+} FrameSeries;
+
+static struct {
+    float window;
+    FrameSeries series[FRAME_STATS_SERIES];
+    int32_t seriesCount;
+    uint32_t frames[FRAME_STATS_MAX_FRAMES][FRAME_STATS_SERIES];    // microseconds, ring
+    int32_t first;
+    int32_t count;
+} frameStats = { .window = FRAME_STATS_WINDOW, .seriesCount = 1 };
+
+static const Color frameSeriesColors[FRAME_STATS_SERIES] = {
+    LIGHTGRAY, SKYBLUE, ORANGE, LIME, VIOLET, GOLD, PINK, BEIGE, MAROON
+};
+
+// exact below 64 us, then the top 6 bits of the value
+static int32_t FrameStatsBucket(uint32_t us)
+{
+    if (us < 2*FRAME_STATS_SUB_BUCKETS) return (int32_t)us;
+    if (us >= FRAME_STATS_MAX_US) us = FRAME_STATS_MAX_US - 1;
+    int32_t shift = 1;
+    while ((us >> shift) >= 2*FRAME_STATS_SUB_BUCKETS) shift++;
+    return (shift + 1)*FRAME_STATS_SUB_BUCKETS + (int32_t)(us >> shift) - FRAME_STATS_SUB_BUCKETS;
+}
+
+// largest value landing in the bucket, percentiles round up rather than hide a slow frame
+static uint32_t FrameStatsBucketValue(int32_t bucket)
+{
+    if (bucket < 2*FRAME_STATS_SUB_BUCKETS) return (uint32_t)bucket;
+    int32_t shift = bucket/FRAME_STATS_SUB_BUCKETS - 1;
+    uint32_t sub = (uint32_t)(bucket%FRAME_STATS_SUB_BUCKETS + FRAME_STATS_SUB_BUCKETS);
+    return ((sub + 1) << shift) - 1;
+}
+
+static uint32_t FrameStatsMicroseconds(double seconds)
+{
+    double us = seconds*1e6 + 0.5;
+    return (us <= 0.0) ? 0 : (us >= FRAME_STATS_MAX_US) ? FRAME_STATS_MAX_US - 1 : (uint32_t)us;
+}
+
+void InitFrameStats(float window)
+{
+    memset(&frameStats, 0, sizeof(frameStats));
+    frameStats.window = (window > 0.0f) ? window : FRAME_STATS_WINDOW;
+    frameStats.series[FRAME_STATS_TOTAL].name = "frame";
+    frameStats.seriesCount = 1;
+}
+
+void CloseFrameStats(void)
+{
+    InitFrameStats(frameStats.window);
+}
+
+// systems are few, a pointer compare finds literals and strcmp the rest
+static FrameSeries *FrameStatsSystem(const char *name)
+{
+    for (int32_t i = 1; i < frameStats.seriesCount; i++)
+    {
+        if (frameStats.series[i].name == name || strcmp(frameStats.series[i].name, name) == 0) return &frameStats.series[i];
+    }
+    if (frameStats.seriesCount >= FRAME_STATS_SERIES) return NULL;
+
+    // earlier frames in the window already count 0 for it, the column was always recorded
+    FrameSeries *series = &frameStats.series[frameStats.seriesCount++];
+    series->name = name;
+    series->begin = -1.0;
+    return series;
+}
+
+void BeginFrameSystem(const char *name)
+{
+    FrameSeries *series = FrameStatsSystem(name);
+    if (series != NULL) series->begin = GetTime();
+}
+
+void EndFrameSystem(const char *name)
+{
+    FrameSeries *series = FrameStatsSystem(name);
+    if (series == NULL || series->begin < 0.0) return;
+    series->current += GetTime() - series->begin;
+    series->begin = -1.0;
+}
+
+static void FrameStatsDropOldest(void)
+{
+    const uint32_t *row = frameStats.frames[frameStats.first];
+    for (int32_t i = 0; i < FRAME_STATS_SERIES; i++)
+    {
+        frameStats.series[i].buckets[FrameStatsBucket(row[i])]--;
+        frameStats.series[i].sum -= row[i];
+    }
+    frameStats.first = (frameStats.first + 1)%FRAME_STATS_MAX_FRAMES;
+    frameStats.count--;
+}
+
+void UpdateFrameStats(float frameTime)
+{
+    if (frameStats.count == FRAME_STATS_MAX_FRAMES) FrameStatsDropOldest();
+
+    uint32_t *row = frameStats.frames[(frameStats.first + frameStats.count)%FRAME_STATS_MAX_FRAMES];
+    frameStats.series[FRAME_STATS_TOTAL].current = frameTime;
+    for (int32_t i = 0; i < FRAME_STATS_SERIES; i++)
+    {
+        FrameSeries *series = &frameStats.series[i];
+        row[i] = FrameStatsMicroseconds(series->current);
+        series->buckets[FrameStatsBucket(row[i])]++;
+        series->sum += row[i];
+        series->current = 0.0;
+    }
+    frameStats.count++;
+
+    // the newest frame always stays, however long it took
+    uint64_t windowUs = (uint64_t)(frameStats.window*1e6);
+    while (frameStats.count > 1 && frameStats.series[FRAME_STATS_TOTAL].sum > windowUs) FrameStatsDropOldest();
+}
+
+int32_t GetFrameStatsSeriesCount(void)
+{
+    return frameStats.seriesCount;
+}
+
+static float FrameStatsPercentile(const FrameSeries *series, float percentile)
+{
+    uint32_t target = (uint32_t)ceilf(percentile*frameStats.count);
+    if (target < 1) target = 1;
+    uint32_t seen = 0;
+    for (int32_t bucket = 0; bucket < FRAME_STATS_BUCKETS; bucket++)
+    {
+        seen += series->buckets[bucket];
+        if (seen >= target) return FrameStatsBucketValue(bucket)/1000.0f;
+    }
+    return 0.0f;
+}
+
+FrameTimeSummary GetFrameTimeSummary(int32_t series)
+{
+    FrameTimeSummary summary = { 0 };
+    if (series < 0 || series >= frameStats.seriesCount) return summary;
+
+    const FrameSeries *stats = &frameStats.series[series];
+    summary.name = stats->name;
+    summary.frames = frameStats.count;
+    if (frameStats.count == 0) return summary;
+
+    uint32_t max = 0;
+    for (int32_t i = 0; i < frameStats.count; i++)
+    {
+        uint32_t us = frameStats.frames[(frameStats.first + i)%FRAME_STATS_MAX_FRAMES][series];
+        if (us > max) max = us;
+    }
+    // a bucket's top can lie past the slowest frame in it
+    summary.max = max/1000.0f;
+    summary.p50 = fminf(FrameStatsPercentile(stats, 0.50f), summary.max);
+    summary.p95 = fminf(FrameStatsPercentile(stats, 0.95f), summary.max);
+    summary.p99 = fminf(FrameStatsPercentile(stats, 0.99f), summary.max);
+    summary.p999 = fminf(FrameStatsPercentile(stats, 0.999f), summary.max);
+    summary.mean = (float)((double)stats->sum/frameStats.count/1000.0);
+    return summary;
+}
+
+void DrawFrameStatsGraph(const TextRenderer *text, Rectangle bounds)
+{
+    const int fontSize = 16;
+    const int rowHeight = fontSize + 2;
+    FrameTimeSummary total = GetFrameTimeSummary(FRAME_STATS_TOTAL);
+    Rectangle graph = { bounds.x + 4, bounds.y + 4, bounds.width - 8, bounds.height - 12 - rowHeight*(frameStats.seriesCount + 1) };
+    // two 60 Hz frames tall unless most frames are longer, a single spike is clipped not rescaled
+    float top = fmaxf(1000.0f/30.0f, total.p99*1.25f);
+    float pixelsPerMs = graph.height/top;
+
+    DrawRectangleRec(bounds, (Color){ 0, 0, 0, 170 });
+    int32_t bars = (frameStats.count < (int32_t)graph.width) ? frameStats.count : (int32_t)graph.width;
+    for (int32_t i = 0; i < bars; i++)
+    {
+        const uint32_t *row = frameStats.frames[(frameStats.first + frameStats.count - bars + i)%FRAME_STATS_MAX_FRAMES];
+        float x = graph.x + graph.width - bars + i;
+        float bottom = graph.y + graph.height;
+        float frame = fminf(row[FRAME_STATS_TOTAL]/1000.0f*pixelsPerMs, graph.height);
+        float y = bottom;
+        for (int32_t s = 1; s < frameStats.seriesCount && y > bottom - frame; s++)
+        {
+            float height = fminf(row[s]/1000.0f*pixelsPerMs, y - (bottom - frame));
+            DrawRectangleRec((Rectangle){ x, y - height, 1.0f, height }, frameSeriesColors[s]);
+            y -= height;
+        }
+        // whatever no system accounted for, red when the frame is clipped
+        DrawRectangleRec((Rectangle){ x, bottom - frame, 1.0f, y - (bottom - frame) },
+                         (row[FRAME_STATS_TOTAL]/1000.0f > top) ? RED : frameSeriesColors[FRAME_STATS_TOTAL]);
+    }
+
+    const float lines[] = { 1000.0f/60.0f, 1000.0f/30.0f, total.p99 };
+    const Color lineColors[] = { GREEN, YELLOW, RED };
+    for (int32_t i = 0; i < 3; i++)
+    {
+        if (lines[i] <= 0.0f || lines[i] > top) continue;
+        DrawRectangleRec((Rectangle){ graph.x, graph.y + graph.height - lines[i]*pixelsPerMs, graph.width, 1.0f }, lineColors[i]);
+    }
+    float tableY = graph.y + graph.height + 8;
+    for (int32_t s = 0; s < frameStats.seriesCount; s++)
+    {
+        DrawRectangleRec((Rectangle){ graph.x, tableY + rowHeight*(s + 1) + 4, 10, 10 }, frameSeriesColors[s]);
+    }
+
+    // rectangles first, the SDF shader is only meant for glyphs
+    BeginText(text);
+    for (int32_t i = 0; i < 3; i++)
+    {
+        if (lines[i] <= 0.0f || lines[i] > top) continue;
+        DrawTextSdf(text, TextFormat((i == 2) ? "p99 %.1f" : "%.1f", lines[i]), (int)graph.x + 2,
+                    (int)(graph.y + graph.height - lines[i]*pixelsPerMs) - fontSize, fontSize, lineColors[i]);
+    }
+    DrawTextSdf(text, TextFormat("%-12s %7s %7s %7s %7s %7s  ms, last %d frames", "", "p50", "p95", "p99", "p99.9", "max", total.frames),
+                (int)graph.x + 14, (int)tableY, fontSize, WHITE);
+    for (int32_t s = 0; s < frameStats.seriesCount; s++)
+    {
+        FrameTimeSummary summary = GetFrameTimeSummary(s);
+        DrawTextSdf(text, TextFormat("%-12s %7.2f %7.2f %7.2f %7.2f %7.2f", summary.name, summary.p50, summary.p95, summary.p99,
+                                     summary.p999, summary.max), (int)graph.x + 14, (int)tableY + rowHeight*(s + 1), fontSize, WHITE);
+    }
+    EndText();
+}
+
+bool ExportFrameStatsCsv(const char *fileName)
+{
+    FILE *file = fopen(fileName, "w");
+    if (file == NULL) return false;
+
+    fprintf(file, "series,frames,p50_ms,p95_ms,p99_ms,p99_9_ms,max_ms,mean_ms\n");
+    for (int32_t s = 0; s < frameStats.seriesCount; s++)
+    {
+        FrameTimeSummary summary = GetFrameTimeSummary(s);
+        fprintf(file, "%s,%d,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n", summary.name, summary.frames, summary.p50, summary.p95,
+                summary.p99, summary.p999, summary.max, summary.mean);
+    }
+    return fclose(file) == 0;
+}
+
+bool ExportFrameTimesCsv(const char *fileName)
+{
+    FILE *file = fopen(fileName, "w");
+    if (file == NULL) return false;
+
+    fprintf(file, "time_s");
+    for (int32_t s = 0; s < frameStats.seriesCount; s++) fprintf(file, ",%s_ms", frameStats.series[s].name);
+    fprintf(file, "\n");
+
+    // time at the end of each frame, from the start of the window
+    uint64_t time = 0;
+    for (int32_t i = 0; i < frameStats.count; i++)
+    {
+        const uint32_t *row = frameStats.frames[(frameStats.first + i)%FRAME_STATS_MAX_FRAMES];
+        time += row[FRAME_STATS_TOTAL];
+        fprintf(file, "%.6f", time/1e6);
+        for (int32_t s = 0; s < frameStats.seriesCount; s++) fprintf(file, ",%.3f", row[s]/1000.0);
+        fprintf(file, "\n");
+    }
+    return fclose(file) == 0;
+}
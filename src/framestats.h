@@ -0,0 +1,59 @@
+#ifndef FRAMESTATS_H
+#define FRAMESTATS_H
+
+#include "raylib.h"
+#include "text.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Frame time statistics over the last few seconds.
+// An averaged FPS hides the one long frame in a hundred players feel as a
+// stutter, so frame times go into a histogram with HDR style buckets (exact
+// to 64 us, then 32 buckets per power of two, within ~3% up to a minute)
+// and are summarized as percentiles. Frames older than the window leave the
+// histogram again, a ring keeps them until then.
+//
+// Systems are timed the same way, BeginFrameSystem("name") and
+// EndFrameSystem("name") around whatever the frame spends time on; a system
+// timed several times in one frame counts once with the sum. Frame time not
+// covered by any system shows up as "other".
+
+#define FRAME_STATS_WINDOW 10.0f        // seconds, default for InitFrameStats()
+#define FRAME_STATS_MAX_FRAMES 4096     // window cap, ~10 s at 400 FPS
+#define FRAME_STATS_MAX_SYSTEMS 8
+#define FRAME_STATS_TOTAL 0             // series of the whole frame, systems follow in first use order
+
+typedef struct {
+    const char *name;
+    int32_t frames;                 // in the window
+    float p50;                      // milliseconds
+    float p95;
+    float p99;
+    float p999;
+    float max;                      // exact, not bucketed
+    float mean;
+} FrameTimeSummary;
+
+void InitFrameStats(float window);  // <= 0 picks FRAME_STATS_WINDOW
+void CloseFrameStats(void);
+
+// Names are not copied, use string literals
+void BeginFrameSystem(const char *name);
+void EndFrameSystem(const char *name);
+
+// Once per frame with the time of the frame that just ended, closes its system times
+void UpdateFrameStats(float frameTime);
+
+int32_t GetFrameStatsSeriesCount(void);         // the total and every system seen so far
+FrameTimeSummary GetFrameTimeSummary(int32_t series);
+
+// Stacked per system bars of the recent frames with percentile lines, and a
+// table of every series below, inside bounds
+void DrawFrameStatsGraph(const TextRenderer *text, Rectangle bounds);
+
+// One row of percentiles per series
+bool ExportFrameStatsCsv(const char *fileName);
+// One row per frame in the window, a column per series
+bool ExportFrameTimesCsv(const char *fileName);
+
+#endif
@@ -0,0 +1,152 @@
+#include "grid.h"
+#include "memtrack.h"
+#include <math.h>
+#include <stdlib.h>
+
+OccupancyGrid LoadOccupancyGrid(const Color *pixels, int32_t width, int32_t height)
+{
+    OccupancyGrid grid = { 0 };
+    if (pixels == NULL || width <= 0 || height <= 0) return grid;
+
+    grid.solid = MemAllocTagged(MEM_TAG_PHYSICS, (size_t)width*height);
+    if (grid.solid == NULL) return grid;
+    grid.width = width;
+    grid.height = height;
+
+    for (int32_t i = 0; i < width*height; i++)
+    {
+        Color c = pixels[i];
+        grid.solid[i] = (c.r == 255 && c.g == 255 && c.b == 255 && c.a == 255);
+    }
+
+    return grid;
+}
+
+void UnloadOccupancyGrid(OccupancyGrid *grid)
+{
+    MemFreeTagged(grid->solid);
+    *grid = (OccupancyGrid){ 0 };
+}
+
+bool GridIsSolid(const OccupancyGrid *grid, int32_t x, int32_t z)
+{
+    if (x < 0 || z < 0 || x >= grid->width || z >= grid->height) return true;
+    return grid->solid[z*grid->width + x] != 0;
+}
+
+bool GridCellFromWorld(const OccupancyGrid *grid, Vector3 mapPosition, Vector3 position, int32_t *x, int32_t *z)
+{
+    int32_t cx = (int32_t)floorf(position.x - mapPosition.x + 0.5f);
+    int32_t cz = (int32_t)floorf(position.z - mapPosition.z + 0.5f);
+    if (cx < 0 || cz < 0 || cx >= grid->width || cz >= grid->height) return false;
+
+    *x = cx;
+    *z = cz;
+    return true;
+}
+
+bool GridLineOfSight(const OccupancyGrid *grid, float x0, float z0, float x1, float z1)
+{
+    // shift so cell (x, z) spans [x, x + 1) for the walk
+    x0 += 0.5f; z0 += 0.5f; x1 += 0.5f; z1 += 0.5f;
+
+    int32_t cx = (int32_t)floorf(x0);
+    int32_t cz = (int32_t)floorf(z0);
+    int32_t ex = (int32_t)floorf(x1);
+    int32_t ez = (int32_t)floorf(z1);
+
+    float dx = x1 - x0;
+    float dz = z1 - z0;
+    int32_t stepX = (dx > 0.0f) ? 1 : -1;
+    int32_t stepZ = (dz > 0.0f) ? 1 : -1;
+    float deltaX = (dx != 0.0f) ? fabsf(1.0f/dx) : INFINITY;
+    float deltaZ = (dz != 0.0f) ? fabsf(1.0f/dz) : INFINITY;
+    float maxX = (dx > 0.0f) ? (cx + 1 - x0)*deltaX : (x0 - cx)*deltaX;
+    float maxZ = (dz > 0.0f) ? (cz + 1 - z0)*deltaZ : (z0 - cz)*deltaZ;
+
+    int32_t steps = abs(ex - cx) + abs(ez - cz);
+    for (int32_t i = 0; i <= steps; i++)
+    {
+        if (GridIsSolid(grid, cx, cz)) return false;
+        if (maxX < maxZ)
+        {
+            maxX += deltaX;
+            cx += stepX;
+        }
+        else
+        {
+            maxZ += deltaZ;
+            cz += stepZ;
+        }
+    }
+
+    return true;
+}
+
+RayCollision GridRaycast(const OccupancyGrid *grid, Vector3 mapPosition, Ray ray, float maxDistance)
+{
+    RayCollision hit = { .hit = false, .distance = maxDistance };
+    const float top = mapPosition.y + GRID_WALL_HEIGHT;
+    const float bottom = mapPosition.y;
+
+    // cell space shifted so cell (x, z) spans [x, x + 1), as in GridLineOfSight()
+    float x0 = ray.position.x - mapPosition.x + 0.5f;
+    float z0 = ray.position.z - mapPosition.z + 0.5f;
+    Vector3 d = ray.direction;
+    int32_t cx = (int32_t)floorf(x0);
+    int32_t cz = (int32_t)floorf(z0);
+    int32_t stepX = (d.x > 0.0f) ? 1 : -1;
+    int32_t stepZ = (d.z > 0.0f) ? 1 : -1;
+    float deltaX = (d.x != 0.0f) ? fabsf(1.0f/d.x) : INFINITY;
+    float deltaZ = (d.z != 0.0f) ? fabsf(1.0f/d.z) : INFINITY;
+    float maxX = (d.x > 0.0f) ? (cx + 1 - x0)*deltaX : (d.x < 0.0f) ? (x0 - cx)*deltaX : INFINITY;
+    float maxZ = (d.z > 0.0f) ? (cz + 1 - z0)*deltaZ : (d.z < 0.0f) ? (z0 - cz)*deltaZ : INFINITY;
+
+    // t along the ray where the current cell was entered, and through which face
+    float enter = 0.0f;
+    Vector3 face = { 0 };
+    while (enter <= maxDistance)
+    {
+        float leave = fminf(fminf(maxX, maxZ), maxDistance);
+        bool onMap = (cx >= 0 && cz >= 0 && cx < grid->width && cz < grid->height);
+        if (onMap && grid->solid[cz*grid->width + cx])
+        {
+            float yEnter = ray.position.y + d.y*enter;
+            float yLeave = ray.position.y + d.y*leave;
+            float t = -1.0f;
+            Vector3 normal = face;
+            // a ray starting inside a wall only hits its top
+            if (enter > 0.0f && yEnter >= bottom && yEnter <= top) t = enter;
+            else if (yEnter > top && yLeave <= top)
+            {
+                t = (top - ray.position.y)/d.y;
+                normal = (Vector3){ 0.0f, 1.0f, 0.0f };
+            }
+            if (t >= 0.0f)
+            {
+                hit.hit = true;
+                hit.distance = t;
+                hit.point = (Vector3){ ray.position.x + d.x*t, ray.position.y + d.y*t, ray.position.z + d.z*t };
+                hit.normal = normal;
+                return hit;
+            }
+        }
+
+        if (maxX < maxZ)
+        {
+            enter = maxX;
+            maxX += deltaX;
+            cx += stepX;
+            face = (Vector3){ (float)-stepX, 0.0f, 0.0f };
+        }
+        else
+        {
+            enter = maxZ;
+            maxZ += deltaZ;
+            cz += stepZ;
+            face = (Vector3){ 0.0f, 0.0f, (float)-stepZ };
+        }
+    }
+
+    return hit;
+}
@@ -0,0 +1,37 @@
+#ifndef GRID_H
+#define GRID_H
+
+#include "raylib.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Occupancy grid of a cubicmap level, one byte per cell.
+// Same rule as GenMeshCubicmap(): a WHITE pixel is a solid cube, anything else is open floor.
+// Cell (x, z) covers [x - 0.5, x + 0.5] x [z - 0.5, z + 0.5] in model space.
+
+#define GRID_WALL_HEIGHT 1.0f       // solid cells are cubes from the map origin up
+
+typedef struct {
+    int32_t width;
+    int32_t height;
+    uint8_t *solid;
+} OccupancyGrid;
+
+OccupancyGrid LoadOccupancyGrid(const Color *pixels, int32_t width, int32_t height);
+void UnloadOccupancyGrid(OccupancyGrid *grid);
+
+// cells outside the map count as solid
+bool GridIsSolid(const OccupancyGrid *grid, int32_t x, int32_t z);
+
+// cell under a world position for a map drawn at mapPosition, false when off the map
+bool GridCellFromWorld(const OccupancyGrid *grid, Vector3 mapPosition, Vector3 position, int32_t *x, int32_t *z);
+
+// 2D line of sight in cell space (DDA walk), endpoints in cell coordinates
+bool GridLineOfSight(const OccupancyGrid *grid, float x0, float z0, float x1, float z1);
+
+// First wall face (side or top) a world space ray hits within maxDistance, for
+// a map drawn at mapPosition. Same DDA walk in 2D, the ray's height is checked
+// against the walls in every solid cell it crosses. Off the map is open.
+RayCollision GridRaycast(const OccupancyGrid *grid, Vector3 mapPosition, Ray ray, float maxDistance);
+
+#endif
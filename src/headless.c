@@ -0,0 +1,297 @@
+#include "headless.h"
+#include "raylib.h"
+#include "rlgl.h"
+#include <stdint.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#define HEADLESS_GLAPI __stdcall
+#else
+#define HEADLESS_GLAPI
+#endif
+#define HEADLESS_GL_VERSION 0x1F02
+#define HEADLESS_GL_EXTENSIONS 0x1F03
+#define HEADLESS_GL_SHADING_LANGUAGE_VERSION 0x8B8C
+#define HEADLESS_GL_COMPILE_STATUS 0x8B81
+#define HEADLESS_GL_LINK_STATUS 0x8B82
+#define HEADLESS_GL_FRAMEBUFFER_COMPLETE 0x8CD5
+#define HEADLESS_MAX_NAMES 128
+#define HEADLESS_SEED 1
+
+// rtext.c, InitWindow() and CloseWindow() call them, raylib.h does not declare them
+extern void LoadFontDefault(void);
+extern void UnloadFontDefault(void);
+
+void __real_BeginDrawing(void);
+int __real_GetScreenWidth(void);
+int __real_GetScreenHeight(void);
+
+typedef void (*HeadlessProc)(void);
+
+typedef struct {
+    const char *name;
+    HeadlessProc proc;
+} HeadlessEntry;
+
+// uniform and attribute names seen so far, a name's location is its slot
+typedef struct {
+    char names[HEADLESS_MAX_NAMES][64];
+    int locations[HEADLESS_MAX_NAMES];
+    int count;
+} HeadlessNames;
+
+static struct {
+    int width;
+    int height;
+    bool active;
+    unsigned int textures;          // last name handed out, per object type like GL
+    unsigned int buffers;
+    unsigned int vertexArrays;
+    unsigned int framebuffers;
+    unsigned int renderbuffers;
+    unsigned int objects;           // shaders and programs share theirs
+    HeadlessNames uniforms;
+    HeadlessNames attributes;
+} headless = { 0 };
+
+static int HeadlessFindName(const HeadlessNames *table, const char *name)
+{
+    for (int i = 0; i < table->count; i++)
+    {
+        if (strcmp(table->names[i], name) == 0) return i;
+    }
+    return -1;
+}
+
+static void HeadlessSetName(HeadlessNames *table, const char *name, int location)
+{
+    int slot = HeadlessFindName(table, name);
+    if (slot < 0 && table->count < HEADLESS_MAX_NAMES && strlen(name) < sizeof(table->names[0])) slot = table->count++;
+    if (slot < 0) return;
+    strcpy(table->names[slot], name);
+    table->locations[slot] = location;
+}
+
+static void HeadlessGenNames(unsigned int *counter, int n, unsigned int *names)
+{
+    for (int i = 0; i < n; i++) names[i] = ++*counter;
+}
+
+// Null GL
+//----------------------------------------------------------------------------------
+// Every entry point without a stub of its own lands here, called with the
+// arguments of the real one, which the C calling conventions we build for
+// leave to the caller. Enables, binds, uploads and draws all do nothing.
+static uintptr_t HEADLESS_GLAPI NullGLProc(void)
+{
+    return 0;
+}
+
+static const unsigned char *HEADLESS_GLAPI NullGetString(unsigned int name)
+{
+    // glad reads the version out of this, rlgl only logs the rest
+    if (name == HEADLESS_GL_VERSION) return (const unsigned char *)"3.3 headless";
+    if (name == HEADLESS_GL_SHADING_LANGUAGE_VERSION) return (const unsigned char *)"3.30";
+    if (name == HEADLESS_GL_EXTENSIONS) return (const unsigned char *)"";
+    return (const unsigned char *)"headless";
+}
+
+static const unsigned char *HEADLESS_GLAPI NullGetStringi(unsigned int name, unsigned int index)
+{
+    (void)name;
+    (void)index;
+    return (const unsigned char *)"";
+}
+
+// no extensions, no limits; only the first value of a multi value query is written
+static void HEADLESS_GLAPI NullGetIntegerv(unsigned int pname, int *data)
+{
+    (void)pname;
+    data[0] = 0;
+}
+
+static void HEADLESS_GLAPI NullGetFloatv(unsigned int pname, float *data)
+{
+    (void)pname;
+    data[0] = 0.0f;
+}
+
+static void HEADLESS_GLAPI NullGetShaderiv(unsigned int shader, unsigned int pname, int *params)
+{
+    (void)shader;
+    params[0] = (pname == HEADLESS_GL_COMPILE_STATUS) ? 1 : 0;
+}
+
+static void HEADLESS_GLAPI NullGetProgramiv(unsigned int program, unsigned int pname, int *params)
+{
+    (void)program;
+    params[0] = (pname == HEADLESS_GL_LINK_STATUS) ? 1 : 0;
+}
+
+static unsigned int HEADLESS_GLAPI NullCreateObject(void)
+{
+    return ++headless.objects;
+}
+
+static unsigned int HEADLESS_GLAPI NullCreateShader(unsigned int type)
+{
+    (void)type;
+    return ++headless.objects;
+}
+
+static void HEADLESS_GLAPI NullGenTextures(int n, unsigned int *names)
+{
+    HeadlessGenNames(&headless.textures, n, names);
+}
+
+static void HEADLESS_GLAPI NullGenBuffers(int n, unsigned int *names)
+{
+    HeadlessGenNames(&headless.buffers, n, names);
+}
+
+static void HEADLESS_GLAPI NullGenVertexArrays(int n, unsigned int *names)
+{
+    HeadlessGenNames(&headless.vertexArrays, n, names);
+}
+
+static void HEADLESS_GLAPI NullGenFramebuffers(int n, unsigned int *names)
+{
+    HeadlessGenNames(&headless.framebuffers, n, names);
+}
+
+static void HEADLESS_GLAPI NullGenRenderbuffers(int n, unsigned int *names)
+{
+    HeadlessGenNames(&headless.renderbuffers, n, names);
+}
+
+static unsigned int HEADLESS_GLAPI NullCheckFramebufferStatus(unsigned int target)
+{
+    (void)target;
+    return HEADLESS_GL_FRAMEBUFFER_COMPLETE;
+}
+
+// rlgl binds raylib's attribute names before linking, the modules here use layout
+// qualifiers and never ask; anything else reads as inactive
+static void HEADLESS_GLAPI NullBindAttribLocation(unsigned int program, unsigned int index, const char *name)
+{
+    (void)program;
+    HeadlessSetName(&headless.attributes, name, (int)index);
+}
+
+static int HEADLESS_GLAPI NullGetAttribLocation(unsigned int program, const char *name)
+{
+    (void)program;
+    int slot = HeadlessFindName(&headless.attributes, name);
+    return (slot >= 0) ? headless.attributes.locations[slot] : -1;
+}
+
+// one location per name across programs, so the draw stream's uniform slots stay apart
+static int HEADLESS_GLAPI NullGetUniformLocation(unsigned int program, const char *name)
+{
+    (void)program;
+    if (HeadlessFindName(&headless.uniforms, name) < 0) HeadlessSetName(&headless.uniforms, name, headless.uniforms.count);
+    int slot = HeadlessFindName(&headless.uniforms, name);
+    return (slot >= 0) ? headless.uniforms.locations[slot] : -1;
+}
+
+static const HeadlessEntry headlessProcs[] = {
+    { "glGetString", (HeadlessProc)NullGetString },
+    { "glGetStringi", (HeadlessProc)NullGetStringi },
+    { "glGetIntegerv", (HeadlessProc)NullGetIntegerv },
+    { "glGetFloatv", (HeadlessProc)NullGetFloatv },
+    { "glGetShaderiv", (HeadlessProc)NullGetShaderiv },
+    { "glGetProgramiv", (HeadlessProc)NullGetProgramiv },
+    { "glCreateShader", (HeadlessProc)NullCreateShader },
+    { "glCreateProgram", (HeadlessProc)NullCreateObject },
+    { "glGenTextures", (HeadlessProc)NullGenTextures },
+    { "glGenBuffers", (HeadlessProc)NullGenBuffers },
+    { "glGenVertexArrays", (HeadlessProc)NullGenVertexArrays },
+    { "glGenFramebuffers", (HeadlessProc)NullGenFramebuffers },
+    { "glGenRenderbuffers", (HeadlessProc)NullGenRenderbuffers },
+    { "glCheckFramebufferStatus", (HeadlessProc)NullCheckFramebufferStatus },
+    { "glBindAttribLocation", (HeadlessProc)NullBindAttribLocation },
+    { "glGetAttribLocation", (HeadlessProc)NullGetAttribLocation },
+    { "glGetUniformLocation", (HeadlessProc)NullGetUniformLocation },
+};
+
+// What rlLoadExtensions() hands glad in place of glfwGetProcAddress()
+static HeadlessProc HeadlessGetProcAddress(const char *name)
+{
+    for (size_t i = 0; i < sizeof(headlessProcs)/sizeof(headlessProcs[0]); i++)
+    {
+        if (strcmp(headlessProcs[i].name, name) == 0) return headlessProcs[i].proc;
+    }
+    return (HeadlessProc)NullGLProc;
+}
+
+// Window replacements
+//----------------------------------------------------------------------------------
+static void HeadlessSetupViewport(void)
+{
+    rlViewport(0, 0, headless.width, headless.height);
+    rlSetFramebufferWidth(headless.width);
+    rlSetFramebufferHeight(headless.height);
+    rlMatrixMode(RL_PROJECTION);
+    rlLoadIdentity();
+    rlOrtho(0, headless.width, headless.height, 0, 0.0f, 1.0f);
+    rlMatrixMode(RL_MODELVIEW);
+    rlLoadIdentity();
+}
+
+bool InitHeadless(int width, int height)
+{
+    if (headless.active) return true;
+    if (width <= 0 || height <= 0) return false;
+
+    headless.width = width;
+    headless.height = height;
+    rlLoadExtensions((void *)HeadlessGetProcAddress);
+    rlglInit(width, height);
+    headless.active = true;
+
+    // the rest of what InitWindow() does once the context is up
+    HeadlessSetupViewport();
+    LoadFontDefault();
+    Rectangle rec = GetFontDefault().recs[95];
+    SetShapesTexture(GetFontDefault().texture, (Rectangle){ rec.x + 1, rec.y + 1, rec.width - 2, rec.height - 2 });
+    SetRandomSeed(HEADLESS_SEED);
+    TraceLog(LOG_INFO, "HEADLESS: %dx%d, rlgl over a null GL", width, height);
+    return true;
+}
+
+void CloseHeadless(void)
+{
+    if (!headless.active) return;
+    UnloadFontDefault();
+    rlglClose();
+    headless.active = false;
+}
+
+bool IsHeadless(void)
+{
+    return headless.active;
+}
+
+void HeadlessEndTextureMode(void)
+{
+    rlDrawRenderBatchActive();
+    rlDisableFramebuffer();
+    HeadlessSetupViewport();
+}
+
+// rcore's BeginDrawing() scales by a screen matrix InitWindow() never set up here
+void __wrap_BeginDrawing(void)
+{
+    if (headless.active) rlLoadIdentity();
+    else __real_BeginDrawing();
+}
+
+int __wrap_GetScreenWidth(void)
+{
+    return headless.active ? headless.width : __real_GetScreenWidth();
+}
+
+int __wrap_GetScreenHeight(void)
+{
+    return headless.active ? headless.height : __real_GetScreenHeight();
+}
@@ -0,0 +1,25 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include <stdbool.h>
+
+// Headless runs (--headless): raylib without a window or a GL context.
+// rlgl is brought up over a null GL, every GL entry point is a stub that
+// hands out names and reports success, so raylib's shape, texture, model and
+// text modules run unchanged and what they draw still reaches the draw stream
+// (rlstats.c), where the soft backend rasterizes it.
+// The rcore calls that need a window are replaced while headless:
+// BeginDrawing(), GetScreenWidth() and GetScreenHeight() are wrapped here
+// (HEADLESS_WRAP in the Makefile), EndDrawing() and EndTextureMode() by
+// rlstats.c. Nothing else that talks to the window (cursor, window size,
+// WindowShouldClose(), CloseWindow(), frame capture readback) may be called.
+
+// In place of InitWindow(), with a fixed random seed so runs draw the same frames
+bool InitHeadless(int width, int height);
+void CloseHeadless(void);
+bool IsHeadless(void);
+
+// What EndTextureMode() does without a window, for the wrapper in rlstats.c
+void HeadlessEndTextureMode(void);
+
+#endif
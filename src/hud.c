@@ -0,0 +1,172 @@
+#include "hud.h"
+#include "rlgl.h"
+#include <math.h>
+#include <string.h>
+
+typedef struct {
+    Rectangle bounds;
+    Color fill;
+    Color border;
+} HudPanel;
+
+static const HudPanel hudPanels[] = {
+    { { 5, 5, 330, 100 }, { 102, 191, 255, 127 }, BLUE },      // Camera controls, Fade(SKYBLUE, 0.5f)
+    { { 600, 5, 195, 100 }, { 102, 191, 255, 127 }, BLUE },    // Camera status
+};
+
+typedef struct {
+    const char *text;
+    int x;
+    int y;
+    int fontSize;
+} HudLabel;
+
+static const HudLabel hudLabels[] = {
+    { "Camera controls:", 15, 15, 10 },
+    { "- Move keys: W, A, S, D, Space, Left-Ctrl", 15, 30, 10 },
+    { "- Look around: arrow keys or mouse", 15, 45, 10 },
+    { "- Camera mode keys: 1, 2, 3, 4", 15, 60, 10 },
+    { "- Zoom keys: num-plus, num-minus or mouse scroll", 15, 75, 10 },
+    { "- Camera projection key: P", 15, 90, 10 },
+    { "Camera status:", 610, 15, 10 },
+};
+
+// panel drawn underneath each field, -1 for none
+static const int hudFieldPanel[HUD_FIELD_COUNT] = { -1, 1, 1, 1, 1, 1 };
+
+static HudField HudFieldAt(int x, int y, int fontSize)
+{
+    // fields run to the right edge so long values are not clipped earlier than before
+    return (HudField){ .bounds = { x - 9, y - 2, HUD_WIDTH - (x - 9), fontSize + 3 }, .fontSize = fontSize };
+}
+
+HudLayer LoadHudLayer(const TextRenderer *text)
+{
+    HudLayer hud = { 0 };
+    hud.target = LoadRenderTexture(HUD_WIDTH, HUD_HEIGHT);
+    hud.text = text;
+    hud.fields[HUD_FIELD_FRAME_TIME] = HudFieldAt(15, 115, 20);
+    hud.fields[HUD_FIELD_MODE] = HudFieldAt(610, 30, 10);
+    hud.fields[HUD_FIELD_PROJECTION] = HudFieldAt(610, 45, 10);
+    hud.fields[HUD_FIELD_POSITION] = HudFieldAt(610, 60, 10);
+    hud.fields[HUD_FIELD_TARGET] = HudFieldAt(610, 75, 10);
+    hud.fields[HUD_FIELD_UP] = HudFieldAt(610, 90, 10);
+    hud.staticDirty = true;
+    return hud;
+}
+
+void UnloadHudLayer(HudLayer *hud)
+{
+    UnloadRenderTexture(hud->target);
+    *hud = (HudLayer){ 0 };
+}
+
+static void HudDrawPanel(const HudPanel *panel)
+{
+    DrawRectangleRec(panel->bounds, panel->fill);
+    DrawRectangleLines((int)panel->bounds.x, (int)panel->bounds.y, (int)panel->bounds.width, (int)panel->bounds.height, panel->border);
+}
+
+// stores the new values and reports whether the field has to be redrawn
+static bool HudFieldChangedValues(HudField *field, const float *values, int count)
+{
+    if (field->valid && memcmp(field->values, values, sizeof(float)*count) == 0) return false;
+    memcpy(field->values, values, sizeof(float)*count);
+    field->valid = true;
+    return true;
+}
+
+static bool HudFieldChanged(HudField *field, float a, float b, float c)
+{
+    return HudFieldChangedValues(field, (float[]){ a, b, c }, 3);
+}
+
+// values are compared at the precision they are printed with
+static bool HudFieldChangedVector(HudField *field, Vector3 v)
+{
+    return HudFieldChanged(field, roundf(v.x*1000.0f), roundf(v.y*1000.0f), roundf(v.z*1000.0f));
+}
+
+static void HudRedrawField(HudLayer *hud, HudFieldId id, const char *text)
+{
+    const HudField *field = &hud->fields[id];
+    BeginScissorMode((int)field->bounds.x, (int)field->bounds.y, (int)field->bounds.width, (int)field->bounds.height);
+    ClearBackground(BLANK);
+    if (hudFieldPanel[id] >= 0) HudDrawPanel(&hudPanels[hudFieldPanel[id]]);
+    BeginText(hud->text);
+    DrawTextSdf(hud->text, text, (int)field->bounds.x + 9, (int)field->bounds.y + 2, field->fontSize, BLACK);
+    EndText();
+    EndScissorMode();
+    hud->redraws++;
+}
+
+static const char *HudModeName(int cameraMode)
+{
+    return (cameraMode == CAMERA_FREE) ? "FREE" :
+           (cameraMode == CAMERA_FIRST_PERSON) ? "FIRST_PERSON" :
+           (cameraMode == CAMERA_THIRD_PERSON) ? "THIRD_PERSON" :
+           (cameraMode == CAMERA_ORBITAL) ? "ORBITAL" : "CUSTOM";
+}
+
+void UpdateHudLayer(HudLayer *hud, const Camera *camera, int cameraMode)
+{
+    HudField *fields = hud->fields;
+    hud->redraws = 0;
+
+    if (hud->staticDirty)
+    {
+        for (int i = 0; i < HUD_FIELD_COUNT; i++) fields[i].valid = false;
+    }
+
+    // percentiles instead of an average FPS, which hides exactly the stutters that get noticed
+    FrameTimeSummary frames = GetFrameTimeSummary(FRAME_STATS_TOTAL);
+    float frameTimes[HUD_FIELD_VALUES] = { roundf(frames.p50*10.0f), roundf(frames.p95*10.0f), roundf(frames.p99*10.0f),
+                                           roundf(frames.p999*10.0f), roundf(frames.max*10.0f) };
+    bool frameTime = HudFieldChangedValues(&fields[HUD_FIELD_FRAME_TIME], frameTimes, HUD_FIELD_VALUES);
+    bool mode = HudFieldChanged(&fields[HUD_FIELD_MODE], (float)cameraMode, 0.0f, 0.0f);
+    bool projection = HudFieldChanged(&fields[HUD_FIELD_PROJECTION], (float)camera->projection, 0.0f, 0.0f);
+    bool position = HudFieldChangedVector(&fields[HUD_FIELD_POSITION], camera->position);
+    bool target = HudFieldChangedVector(&fields[HUD_FIELD_TARGET], camera->target);
+    bool up = HudFieldChangedVector(&fields[HUD_FIELD_UP], camera->up);
+
+    if (!hud->staticDirty && !(frameTime || mode || projection || position || target || up)) return;
+
+    BeginTextureMode(hud->target);
+    // keep straight alpha out of the color channels so the composite can be premultiplied
+    rlSetBlendFactorsSeparate(RL_SRC_ALPHA, RL_ONE_MINUS_SRC_ALPHA, RL_ONE, RL_ONE_MINUS_SRC_ALPHA, RL_FUNC_ADD, RL_FUNC_ADD);
+    BeginBlendMode(BLEND_CUSTOM_SEPARATE);
+
+    if (hud->staticDirty)
+    {
+        ClearBackground(BLANK);
+        for (int i = 0; i < (int)(sizeof(hudPanels)/sizeof(hudPanels[0])); i++) HudDrawPanel(&hudPanels[i]);
+        // panels first, the SDF shader is only meant for glyphs
+        BeginText(hud->text);
+        for (int i = 0; i < (int)(sizeof(hudLabels)/sizeof(hudLabels[0])); i++)
+        {
+            DrawTextSdf(hud->text, hudLabels[i].text, hudLabels[i].x, hudLabels[i].y, hudLabels[i].fontSize, BLACK);
+        }
+        EndText();
+        hud->staticDirty = false;
+    }
+
+    if (frameTime) HudRedrawField(hud, HUD_FIELD_FRAME_TIME, TextFormat("p50 %.1f  p95 %.1f  p99 %.1f  p99.9 %.1f  max %.1f ms",
+                                                                        frames.p50, frames.p95, frames.p99, frames.p999, frames.max));
+    if (mode) HudRedrawField(hud, HUD_FIELD_MODE, TextFormat("- Mode: %s", HudModeName(cameraMode)));
+    if (projection) HudRedrawField(hud, HUD_FIELD_PROJECTION, TextFormat("- Projection: %s", (camera->projection == CAMERA_PERSPECTIVE) ? "PERSPECTIVE" :
+                                                                                             (camera->projection == CAMERA_ORTHOGRAPHIC) ? "ORTHOGRAPHIC" : "CUSTOM"));
+    if (position) HudRedrawField(hud, HUD_FIELD_POSITION, TextFormat("- Position: (%06.3f, %06.3f, %06.3f)", camera->position.x, camera->position.y, camera->position.z));
+    if (target) HudRedrawField(hud, HUD_FIELD_TARGET, TextFormat("- Target: (%06.3f, %06.3f, %06.3f)", camera->target.x, camera->target.y, camera->target.z));
+    if (up) HudRedrawField(hud, HUD_FIELD_UP, TextFormat("- Up: (%06.3f, %06.3f, %06.3f)", camera->up.x, camera->up.y, camera->up.z));
+
+    EndBlendMode();
+    EndTextureMode();
+}
+
+void DrawHudLayer(const HudLayer *hud)
+{
+    BeginBlendMode(BLEND_ALPHA_PREMULTIPLY);
+    // render textures are stored upside down
+    DrawTextureRec(hud->target.texture, (Rectangle){ 0, 0, HUD_WIDTH, -HUD_HEIGHT }, (Vector2){ 0, 0 }, WHITE);
+    EndBlendMode();
+}
@@ -0,0 +1,52 @@
+#ifndef HUD_H
+#define HUD_H
+
+#include "framestats.h"
+#include "raylib.h"
+#include "text.h"
+#include <stdbool.h>
+
+// Retained HUD layer.
+// The info panels live in one RenderTexture: the static parts are drawn once,
+// dynamic fields remember the values they were last drawn with and only get
+// formatted and redrawn (inside their own scissor rect) when a value changes.
+// Drawing the HUD each frame is a single textured quad.
+
+#define HUD_WIDTH 800
+#define HUD_HEIGHT 150
+#define HUD_FIELD_VALUES 5
+
+typedef enum {
+    HUD_FIELD_FRAME_TIME = 0,   // frame time percentiles, GetFrameTimeSummary()
+    HUD_FIELD_MODE,
+    HUD_FIELD_PROJECTION,
+    HUD_FIELD_POSITION,
+    HUD_FIELD_TARGET,
+    HUD_FIELD_UP,
+    HUD_FIELD_COUNT
+} HudFieldId;
+
+typedef struct {
+    Rectangle bounds;       // area cleared and redrawn when the field changes
+    int fontSize;
+    float values[HUD_FIELD_VALUES];     // raw values the text was formatted from
+    bool valid;
+} HudField;
+
+typedef struct {
+    RenderTexture2D target;
+    const TextRenderer *text;   // not owned, must outlive the layer
+    HudField fields[HUD_FIELD_COUNT];
+    bool staticDirty;       // whole texture needs a rebuild (first use, context loss...)
+    int redraws;            // dynamic field redraws during the last update, for debugging
+} HudLayer;
+
+HudLayer LoadHudLayer(const TextRenderer *text);
+void UnloadHudLayer(HudLayer *hud);
+
+// Refreshes whatever changed, call before DrawHudLayer(); it only switches
+// framebuffers so calling it between BeginDrawing()/EndDrawing() is fine
+void UpdateHudLayer(HudLayer *hud, const Camera *camera, int cameraMode);
+void DrawHudLayer(const HudLayer *hud);
+
+#endif
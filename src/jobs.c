@@ -0,0 +1,224 @@
+#include "jobs.h"
+#include "memtrack.h"
+#include "profiler.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#define JOBS_MAX_WORKERS 64
+#define JOBS_QUEUE_SIZE 1024
+
+typedef struct {
+    JobFunc fn;
+    void *user;
+} Job;
+
+// one ParallelFor call. Helpers may sit in the queue behind long unrelated jobs
+// (streaming, decoding), so the batch is on the heap and the caller only waits
+// for the ranges in flight; a helper that starts late finds nothing left and
+// drops its reference, the last one out frees the batch.
+typedef struct {
+    JobRangeFunc fn;
+    void *user;
+    int32_t count;
+    int32_t grain;
+    int32_t next;
+    int32_t running;                // ranges taken and not finished yet
+    int32_t refs;                   // caller + helpers not yet returned
+    pthread_mutex_t lock;
+    pthread_cond_t done;
+} JobBatch;
+
+static struct {
+    pthread_t threads[JOBS_MAX_WORKERS];
+    int32_t workerCount;
+    Job queue[JOBS_QUEUE_SIZE];
+    int32_t head;
+    int32_t tail;
+    bool quit;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t space;
+} jobs = { .workerCount = 0 };
+
+static void *JobsWorker(void *arg)
+{
+    char name[PROFILER_NAME_LENGTH];
+    snprintf(name, sizeof(name), "worker %d", (int)(intptr_t)arg);
+    ProfilerSetThreadName(name);
+    for (;;)
+    {
+        pthread_mutex_lock(&jobs.lock);
+        while (jobs.head == jobs.tail && !jobs.quit) pthread_cond_wait(&jobs.wake, &jobs.lock);
+        if (jobs.head == jobs.tail && jobs.quit)
+        {
+            pthread_mutex_unlock(&jobs.lock);
+            return NULL;
+        }
+        Job job = jobs.queue[jobs.head % JOBS_QUEUE_SIZE];
+        jobs.head++;
+        pthread_cond_signal(&jobs.space);
+        pthread_mutex_unlock(&jobs.lock);
+
+        PROFILE_BEGIN(zone, "job");
+        job.fn(job.user);
+        PROFILE_END(zone);
+    }
+}
+
+int32_t JobsCoreCount(void)
+{
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int32_t)info.dwNumberOfProcessors;
+#else
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return (cores > 0) ? (int32_t)cores : 1;
+#endif
+}
+
+void JobsInit(int32_t workerCount)
+{
+    if (jobs.workerCount > 0) return;
+    if (workerCount <= 0) workerCount = JobsCoreCount() - 1;
+    if (workerCount > JOBS_MAX_WORKERS) workerCount = JOBS_MAX_WORKERS;
+
+    pthread_mutex_init(&jobs.lock, NULL);
+    pthread_cond_init(&jobs.wake, NULL);
+    pthread_cond_init(&jobs.space, NULL);
+    jobs.head = jobs.tail = 0;
+    jobs.quit = false;
+
+    for (int32_t i = 0; i < workerCount; i++)
+    {
+        if (pthread_create(&jobs.threads[i], NULL, JobsWorker, (void *)(intptr_t)i) != 0) break;
+        jobs.workerCount++;
+    }
+}
+
+void JobsShutdown(void)
+{
+    if (jobs.workerCount == 0) return;
+
+    pthread_mutex_lock(&jobs.lock);
+    jobs.quit = true;
+    pthread_cond_broadcast(&jobs.wake);
+    pthread_mutex_unlock(&jobs.lock);
+
+    for (int32_t i = 0; i < jobs.workerCount; i++) pthread_join(jobs.threads[i], NULL);
+    jobs.workerCount = 0;
+
+    pthread_cond_destroy(&jobs.space);
+    pthread_cond_destroy(&jobs.wake);
+    pthread_mutex_destroy(&jobs.lock);
+}
+
+int32_t JobsWorkerCount(void)
+{
+    return jobs.workerCount;
+}
+
+void JobsSubmit(JobFunc fn, void *user)
+{
+    if (jobs.workerCount == 0)
+    {
+        fn(user);
+        return;
+    }
+
+    pthread_mutex_lock(&jobs.lock);
+    while (jobs.tail - jobs.head >= JOBS_QUEUE_SIZE) pthread_cond_wait(&jobs.space, &jobs.lock);
+    jobs.queue[jobs.tail % JOBS_QUEUE_SIZE] = (Job){ fn, user };
+    jobs.tail++;
+    pthread_cond_signal(&jobs.wake);
+    pthread_mutex_unlock(&jobs.lock);
+}
+
+// pulls ranges until the batch is drained, returns false once nothing is left
+static bool JobBatchRun(JobBatch *batch)
+{
+    pthread_mutex_lock(&batch->lock);
+    int32_t begin = batch->next;
+    if (begin >= batch->count)
+    {
+        pthread_mutex_unlock(&batch->lock);
+        return false;
+    }
+    int32_t end = begin + batch->grain;
+    if (end > batch->count) end = batch->count;
+    batch->next = end;
+    batch->running++;
+    pthread_mutex_unlock(&batch->lock);
+
+    batch->fn(begin, end, batch->user);
+
+    pthread_mutex_lock(&batch->lock);
+    batch->running--;
+    if (batch->running == 0 && batch->next >= batch->count) pthread_cond_signal(&batch->done);
+    pthread_mutex_unlock(&batch->lock);
+    return true;
+}
+
+static void JobBatchRelease(JobBatch *batch)
+{
+    pthread_mutex_lock(&batch->lock);
+    bool last = (--batch->refs == 0);
+    pthread_mutex_unlock(&batch->lock);
+    if (!last) return;
+
+    pthread_cond_destroy(&batch->done);
+    pthread_mutex_destroy(&batch->lock);
+    MemFreeTagged(batch);
+}
+
+static void JobBatchHelper(void *user)
+{
+    JobBatch *batch = user;
+    while (JobBatchRun(batch)) { }
+    JobBatchRelease(batch);
+}
+
+void JobsParallelFor(int32_t count, int32_t grain, JobRangeFunc fn, void *user)
+{
+    if (count <= 0) return;
+    if (grain <= 0) grain = 1;
+
+    int32_t ranges = (count + grain - 1)/grain;
+    int32_t helpers = ranges - 1;
+    if (helpers > jobs.workerCount) helpers = jobs.workerCount;
+
+    JobBatch *batch = (helpers > 0) ? MemAllocTagged(MEM_TAG_OTHER, sizeof(JobBatch)) : NULL;
+    if (batch == NULL)
+    {
+        fn(0, count, user);
+        return;
+    }
+
+    *batch = (JobBatch){
+        .fn = fn,
+        .user = user,
+        .count = count,
+        .grain = grain,
+        .next = 0,
+        .running = 0,
+        .refs = helpers + 1
+    };
+    pthread_mutex_init(&batch->lock, NULL);
+    pthread_cond_init(&batch->done, NULL);
+
+    for (int32_t i = 0; i < helpers; i++) JobsSubmit(JobBatchHelper, batch);
+    while (JobBatchRun(batch)) { }
+
+    // every range is taken by now, only the ones still running are waited on
+    pthread_mutex_lock(&batch->lock);
+    while (batch->running > 0) pthread_cond_wait(&batch->done, &batch->lock);
+    pthread_mutex_unlock(&batch->lock);
+    JobBatchRelease(batch);
+}
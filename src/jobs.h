@@ -0,0 +1,25 @@
+#ifndef JOBS_H
+#define JOBS_H
+
+#include <stdint.h>
+
+// Small fixed pool of worker threads shared by every system that wants to
+// spread CPU work across cores (bakers, particle updates, asset decoding...)
+
+typedef void (*JobFunc)(void *user);
+typedef void (*JobRangeFunc)(int32_t begin, int32_t end, void *user);
+
+void JobsInit(int32_t workerCount);      // workerCount <= 0 picks (cores - 1)
+void JobsShutdown(void);
+int32_t JobsWorkerCount(void);           // 0 when running single threaded
+int32_t JobsCoreCount(void);
+
+// Fire and forget, fn runs on a worker (or inline when there are no workers)
+void JobsSubmit(JobFunc fn, void *user);
+
+// Splits [0, count) into ranges of at most grain items and blocks until all
+// ranges are done. The calling thread helps out instead of idling, and does
+// not wait on helpers still queued behind other jobs: it runs their ranges.
+void JobsParallelFor(int32_t count, int32_t grain, JobRangeFunc fn, void *user);
+
+#endif
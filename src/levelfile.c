@@ -0,0 +1,387 @@
+#include "levelfile.h"
+#include "bundle.h"
+#include "memtrack.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define LEVEL_FILE_BYTE_ORDER 0x01020304u
+#define LEVEL_FILE_MAX_CELLS (1 << 24)
+
+static uint64_t LevelFileAlign(uint64_t offset)
+{
+    return (offset + LEVEL_FILE_ALIGNMENT - 1) & ~(uint64_t)(LEVEL_FILE_ALIGNMENT - 1);
+}
+
+static int32_t LevelFileCeilDiv(int32_t value, int32_t divisor)
+{
+    return (value + divisor - 1)/divisor;
+}
+
+// Compiler
+//----------------------------------------------------------------------------------
+bool CompileLevelFile(const OccupancyGrid *grid, const LevelMesh *mesh, const PVS *pvs, const char *fileName)
+{
+    // the format is little endian and written as it sits in memory
+    const uint32_t probe = 1;
+    if (*(const uint8_t *)&probe != 1) return false;
+    if (grid->solid == NULL || mesh->chunks == NULL) return false;
+
+    const bool hasPVS = (pvs != NULL) && IsPVSReady(pvs);
+    if (hasPVS && (pvs->clustersX != LevelFileCeilDiv(grid->width, PVS_CLUSTER_SIZE) ||
+                   pvs->clustersZ != LevelFileCeilDiv(grid->height, PVS_CLUSTER_SIZE))) return false;
+
+    LevelFileChunk *chunks = MemCallocTagged(MEM_TAG_ASSETS, mesh->chunkCount, sizeof(LevelFileChunk));
+    if (chunks == NULL) return false;
+    uint32_t vertexCount = 0, indexCount = 0;
+    for (int32_t i = 0; i < mesh->chunkCount; i++)
+    {
+        const LevelChunk *chunk = &mesh->chunks[i];
+        if (chunk->mesh.vertexCount > 0 && chunk->packed.vertices == NULL)
+        {
+            // unpacked or packing failed, the runtime could not draw it
+            MemFreeTagged(chunks);
+            return false;
+        }
+        chunks[i] = (LevelFileChunk){
+            .x = chunk->x,
+            .z = chunk->z,
+            .firstVertex = vertexCount,
+            .vertexCount = chunk->packed.vertexCount,
+            .firstIndex = indexCount,
+            .indexCount = chunk->packed.indexCount,
+            .offset = { chunk->packed.offset.x, chunk->packed.offset.y, chunk->packed.offset.z },
+            .scale = chunk->packed.scale
+        };
+        vertexCount += chunk->packed.vertexCount;
+        indexCount += chunk->packed.indexCount;
+    }
+
+    LevelFileHeader header = {
+        .magic = { 'L', 'V', 'L', ' ' },
+        .version = LEVEL_FILE_VERSION,
+        .byteOrder = LEVEL_FILE_BYTE_ORDER,
+        .width = grid->width,
+        .height = grid->height,
+        .chunksX = mesh->chunksX,
+        .chunksZ = mesh->chunksZ,
+        .pvsClustersX = hasPVS ? pvs->clustersX : 0,
+        .pvsClustersZ = hasPVS ? pvs->clustersZ : 0,
+        .pvsRowWords = hasPVS ? pvs->rowWords : 0,
+        .pvsRowCount = hasPVS ? pvs->rowCount : 0
+    };
+    const void *payloads[LEVEL_SECTION_COUNT] = { 0 };
+    header.sections[LEVEL_SECTION_GRID].size = (uint64_t)grid->width*grid->height;
+    payloads[LEVEL_SECTION_GRID] = grid->solid;
+    header.sections[LEVEL_SECTION_CHUNKS].size = sizeof(LevelFileChunk)*(uint64_t)mesh->chunkCount;
+    payloads[LEVEL_SECTION_CHUNKS] = chunks;
+    header.sections[LEVEL_SECTION_VERTICES].size = sizeof(PackedVertex)*(uint64_t)vertexCount;
+    header.sections[LEVEL_SECTION_INDICES].size = sizeof(unsigned short)*(uint64_t)indexCount;
+    if (hasPVS)
+    {
+        header.sections[LEVEL_SECTION_PVS_INDEX].size = sizeof(uint32_t)*(uint64_t)pvs->clusterCount;
+        payloads[LEVEL_SECTION_PVS_INDEX] = pvs->rowIndex;
+        header.sections[LEVEL_SECTION_PVS_ROWS].size = sizeof(uint64_t)*(uint64_t)pvs->rowCount*pvs->rowWords;
+        payloads[LEVEL_SECTION_PVS_ROWS] = pvs->rows;
+    }
+
+    uint64_t cursor = sizeof(LevelFileHeader);
+    for (int s = 0; s < LEVEL_SECTION_COUNT; s++)
+    {
+        header.sections[s].offset = LevelFileAlign(cursor);
+        cursor = header.sections[s].offset + header.sections[s].size;
+    }
+    header.fileSize = cursor;
+
+    // written next to it and renamed over, a running game may have the old one mapped
+    char tempName[1024];
+    snprintf(tempName, sizeof(tempName), "%s.tmp", fileName);
+    FILE *file = fopen(tempName, "wb");
+    if (file == NULL)
+    {
+        MemFreeTagged(chunks);
+        return false;
+    }
+
+    static const uint8_t padding[LEVEL_FILE_ALIGNMENT] = { 0 };
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    cursor = sizeof(header);
+    for (int s = 0; ok && s < LEVEL_SECTION_COUNT; s++)
+    {
+        const LevelFileSection *section = &header.sections[s];
+        size_t pad = (size_t)(section->offset - cursor);
+        ok = (pad == 0 || fwrite(padding, pad, 1, file) == 1);
+
+        if (s == LEVEL_SECTION_VERTICES || s == LEVEL_SECTION_INDICES)
+        {
+            // chunk arrays back to back, in chunk order
+            for (int32_t i = 0; ok && i < mesh->chunkCount; i++)
+            {
+                const PackedMesh *packed = &mesh->chunks[i].packed;
+                if (s == LEVEL_SECTION_VERTICES) ok = fwrite(packed->vertices, sizeof(PackedVertex), packed->vertexCount, file) == (size_t)packed->vertexCount;
+                else ok = fwrite(packed->indices, sizeof(unsigned short), packed->indexCount, file) == (size_t)packed->indexCount;
+            }
+        }
+        else if (section->size > 0) ok = ok && fwrite(payloads[s], section->size, 1, file) == 1;
+        cursor = section->offset + section->size;
+    }
+    ok = (fclose(file) == 0) && ok;
+    MemFreeTagged(chunks);
+
+#if defined(_WIN32)
+    // rename() does not replace there, and the game reads the file instead of mapping it
+    if (ok) remove(fileName);
+#endif
+    ok = ok && (rename(tempName, fileName) == 0);
+    if (!ok) remove(tempName);
+    return ok;
+}
+
+// Runtime
+//----------------------------------------------------------------------------------
+static const void *LevelFileSectionData(const LevelFile *file, LevelFileSectionType type)
+{
+    const LevelFileHeader *header = file->data;
+    return (const uint8_t *)file->data + header->sections[type].offset;
+}
+
+// Structure checks only, all O(chunks + clusters), the arrays themselves are trusted build output
+static bool LevelFileValid(const void *data, size_t size)
+{
+    if (size < sizeof(LevelFileHeader)) return false;
+    const LevelFileHeader *header = data;
+    if (memcmp(header->magic, "LVL ", 4) != 0 || header->version != LEVEL_FILE_VERSION ||
+        header->byteOrder != LEVEL_FILE_BYTE_ORDER || header->fileSize != size) return false;
+
+    if (header->width <= 0 || header->height <= 0 || (int64_t)header->width*header->height > LEVEL_FILE_MAX_CELLS ||
+        header->chunksX != LevelFileCeilDiv(header->width, LEVEL_CHUNK_SIZE) ||
+        header->chunksZ != LevelFileCeilDiv(header->height, LEVEL_CHUNK_SIZE)) return false;
+
+    for (int s = 0; s < LEVEL_SECTION_COUNT; s++)
+    {
+        const LevelFileSection *section = &header->sections[s];
+        if (section->offset%LEVEL_FILE_ALIGNMENT != 0 || section->offset < sizeof(LevelFileHeader) ||
+            section->offset > size || section->size > size - section->offset) return false;
+    }
+
+    const int32_t chunkCount = header->chunksX*header->chunksZ;
+    const uint64_t vertexCount = header->sections[LEVEL_SECTION_VERTICES].size/sizeof(PackedVertex);
+    const uint64_t indexCount = header->sections[LEVEL_SECTION_INDICES].size/sizeof(unsigned short);
+    if (header->sections[LEVEL_SECTION_GRID].size != (uint64_t)header->width*header->height ||
+        header->sections[LEVEL_SECTION_CHUNKS].size != sizeof(LevelFileChunk)*(uint64_t)chunkCount ||
+        header->sections[LEVEL_SECTION_VERTICES].size%sizeof(PackedVertex) != 0 ||
+        header->sections[LEVEL_SECTION_INDICES].size%sizeof(unsigned short) != 0) return false;
+
+    const LevelFileChunk *chunks = (const LevelFileChunk *)((const uint8_t *)data + header->sections[LEVEL_SECTION_CHUNKS].offset);
+    for (int32_t i = 0; i < chunkCount; i++)
+    {
+        const LevelFileChunk *chunk = &chunks[i];
+        if (chunk->x != i%header->chunksX || chunk->z != i/header->chunksX ||
+            chunk->vertexCount < 0 || chunk->vertexCount > 65536 || chunk->indexCount < 0 || chunk->indexCount%3 != 0 ||
+            chunk->firstVertex + (uint64_t)chunk->vertexCount > vertexCount ||
+            chunk->firstIndex + (uint64_t)chunk->indexCount > indexCount) return false;
+    }
+
+    if (header->pvsClustersX == 0) return header->sections[LEVEL_SECTION_PVS_INDEX].size == 0 && header->sections[LEVEL_SECTION_PVS_ROWS].size == 0;
+
+    const int32_t clusterCount = header->pvsClustersX*header->pvsClustersZ;
+    if (header->pvsClustersX != LevelFileCeilDiv(header->width, PVS_CLUSTER_SIZE) ||
+        header->pvsClustersZ != LevelFileCeilDiv(header->height, PVS_CLUSTER_SIZE) ||
+        header->pvsRowWords != (clusterCount + 63)/64 || header->pvsRowCount <= 0 ||
+        header->sections[LEVEL_SECTION_PVS_INDEX].size != sizeof(uint32_t)*(uint64_t)clusterCount ||
+        header->sections[LEVEL_SECTION_PVS_ROWS].size != sizeof(uint64_t)*(uint64_t)header->pvsRowCount*header->pvsRowWords) return false;
+
+    const uint32_t *rowIndex = (const uint32_t *)((const uint8_t *)data + header->sections[LEVEL_SECTION_PVS_INDEX].offset);
+    for (int32_t c = 0; c < clusterCount; c++)
+    {
+        if (rowIndex[c] >= (uint32_t)header->pvsRowCount) return false;
+    }
+    return true;
+}
+
+// The bundle keeps its files BUNDLE_ALIGNMENT aligned, as good as a mapping
+static LevelFile LevelFileFromBundle(const char *fileName)
+{
+    LevelFile file = { 0 };
+    size_t size = 0;
+    const void *data = GetBundleFile(fileName, &size);
+    if (data == NULL || !LevelFileValid(data, size)) return file;
+
+    file.data = (void *)data;
+    file.size = size;
+    file.bundled = true;
+    return file;
+}
+
+LevelFile LoadLevelFile(const char *fileName)
+{
+    LevelFile file = { 0 };
+#if defined(_WIN32)
+    // plain read, malloc alignment covers every element type in the file
+    FILE *f = fopen(fileName, "rb");
+    if (f == NULL) return LevelFileFromBundle(fileName);
+    long size = (fseek(f, 0, SEEK_END) == 0) ? ftell(f) : -1;
+    if (size > 0 && fseek(f, 0, SEEK_SET) == 0)
+    {
+        file.data = MemAllocTagged(MEM_TAG_ASSETS, (size_t)size);
+        if (file.data != NULL && fread(file.data, (size_t)size, 1, f) == 1) file.size = (size_t)size;
+    }
+    fclose(f);
+    file.mapped = false;
+#else
+    int fd = open(fileName, O_RDONLY);
+    if (fd < 0) return LevelFileFromBundle(fileName);
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0)
+    {
+        void *data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED)
+        {
+            file.data = data;
+            file.size = (size_t)info.st_size;
+            file.mapped = true;
+        }
+    }
+    close(fd);
+#endif
+
+    if (file.data != NULL && !LevelFileValid(file.data, file.size)) UnloadLevelFile(&file);
+    return file;
+}
+
+bool IsLevelFileReady(const LevelFile *file)
+{
+    return file->data != NULL && file->size > 0;
+}
+
+void UnloadLevelFile(LevelFile *file)
+{
+    if (file->bundled)
+    {
+        *file = (LevelFile){ 0 };
+        return;
+    }
+#if !defined(_WIN32)
+    if (file->mapped && file->data != NULL) munmap(file->data, file->size);
+    else MemFreeTagged(file->data);
+#else
+    MemFreeTagged(file->data);
+#endif
+    *file = (LevelFile){ 0 };
+}
+
+OccupancyGrid GetLevelFileGrid(const LevelFile *file)
+{
+    if (!IsLevelFileReady(file)) return (OccupancyGrid){ 0 };
+
+    // the views are not const for the structs' sake, the pages are read only
+    const LevelFileHeader *header = file->data;
+    return (OccupancyGrid){
+        .width = header->width,
+        .height = header->height,
+        .solid = (uint8_t *)LevelFileSectionData(file, LEVEL_SECTION_GRID)
+    };
+}
+
+PVS GetLevelFilePVS(const LevelFile *file)
+{
+    if (!IsLevelFileReady(file)) return (PVS){ 0 };
+
+    const LevelFileHeader *header = file->data;
+    if (header->pvsClustersX == 0) return (PVS){ 0 };
+    return (PVS){
+        .clustersX = header->pvsClustersX,
+        .clustersZ = header->pvsClustersZ,
+        .clusterCount = header->pvsClustersX*header->pvsClustersZ,
+        .rowWords = header->pvsRowWords,
+        .rowCount = header->pvsRowCount,
+        .rowIndex = (uint32_t *)LevelFileSectionData(file, LEVEL_SECTION_PVS_INDEX),
+        .rows = (uint64_t *)LevelFileSectionData(file, LEVEL_SECTION_PVS_ROWS)
+    };
+}
+
+LevelMesh GetLevelFileMesh(const LevelFile *file)
+{
+    LevelMesh level = { 0 };
+    if (!IsLevelFileReady(file)) return level;
+
+    const LevelFileHeader *header = file->data;
+    level.chunksX = header->chunksX;
+    level.chunksZ = header->chunksZ;
+    level.chunkCount = header->chunksX*header->chunksZ;
+    level.chunks = MemCallocTagged(MEM_TAG_RENDER, level.chunkCount, sizeof(LevelChunk));
+    level.borrowed = true;
+    if (level.chunks == NULL) return (LevelMesh){ 0 };
+
+    const LevelFileChunk *chunks = LevelFileSectionData(file, LEVEL_SECTION_CHUNKS);
+    for (int32_t i = 0; i < level.chunkCount; i++)
+    {
+        level.chunks[i].x = chunks[i].x;
+        level.chunks[i].z = chunks[i].z;
+        level.chunks[i].packed = GetLevelFileChunk(file, i);
+    }
+
+    return level;
+}
+
+PackedMesh GetLevelFileChunk(const LevelFile *file, int32_t chunk)
+{
+    if (!IsLevelFileReady(file)) return (PackedMesh){ 0 };
+
+    const LevelFileHeader *header = file->data;
+    if (chunk < 0 || chunk >= header->chunksX*header->chunksZ) return (PackedMesh){ 0 };
+    const LevelFileChunk *source = (const LevelFileChunk *)LevelFileSectionData(file, LEVEL_SECTION_CHUNKS) + chunk;
+    if (source->vertexCount == 0) return (PackedMesh){ 0 };
+
+    PackedVertex *vertices = (PackedVertex *)LevelFileSectionData(file, LEVEL_SECTION_VERTICES);
+    unsigned short *indices = (unsigned short *)LevelFileSectionData(file, LEVEL_SECTION_INDICES);
+    return (PackedMesh){
+        .vertexCount = source->vertexCount,
+        .indexCount = source->indexCount,
+        .vertices = vertices + source->firstVertex,
+        .indices = indices + source->firstIndex,
+        .offset = { source->offset[0], source->offset[1], source->offset[2] },
+        .scale = source->scale
+    };
+}
+
+#if !defined(_WIN32)
+static void LevelFileAdvise(const LevelFile *file, const void *data, size_t size, int advice)
+{
+    // whole pages inside the range only, the neighbour chunks may still be in use
+    uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+    uintptr_t begin = ((uintptr_t)data + page - 1) & ~(page - 1);
+    uintptr_t end = ((uintptr_t)data + size) & ~(page - 1);
+    if (file->mapped && end > begin) madvise((void *)begin, end - begin, advice);
+}
+#endif
+
+void PageLevelFileChunk(const LevelFile *file, int32_t chunk, bool in)
+{
+    PackedMesh view = GetLevelFileChunk(file, chunk);
+    if (view.vertexCount == 0) return;
+
+    size_t vertexBytes = sizeof(PackedVertex)*(size_t)view.vertexCount;
+    size_t indexBytes = sizeof(unsigned short)*(size_t)view.indexCount;
+    if (in)
+    {
+        // one read per page faults the range in here instead of in the upload
+        volatile const uint8_t *bytes = (const uint8_t *)view.vertices;
+        for (size_t i = 0; i < vertexBytes; i += 4096) (void)bytes[i];
+        bytes = (const uint8_t *)view.indices;
+        for (size_t i = 0; i < indexBytes; i += 4096) (void)bytes[i];
+    }
+#if !defined(_WIN32)
+    else
+    {
+        LevelFileAdvise(file, view.vertices, vertexBytes, MADV_DONTNEED);
+        LevelFileAdvise(file, view.indices, indexBytes, MADV_DONTNEED);
+    }
+#endif
+}
@@ -0,0 +1,94 @@
+#ifndef LEVELFILE_H
+#define LEVELFILE_H
+
+#include "grid.h"
+#include "levelmesh.h"
+#include "pvs.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Compiled level: everything startup used to derive from the cubicmap image
+// (occupancy grid, lit and packed chunk meshes, PVS) baked into one file.
+// The file is little endian and every section starts on a
+// LEVEL_FILE_ALIGNMENT boundary, so at runtime it is memory mapped and the
+// grid, PVS and vertex arrays are used in place without any parsing.
+// The header's section table leaves room for more baked data (collision
+// BVH, nav) without changing the layout of what is already there.
+
+#define LEVEL_FILE_VERSION 2
+#define LEVEL_FILE_ALIGNMENT 64
+
+typedef enum {
+    LEVEL_SECTION_GRID = 0,         // uint8 solid[width*height]
+    LEVEL_SECTION_CHUNKS,           // LevelFileChunk[chunksX*chunksZ]
+    LEVEL_SECTION_VERTICES,         // PackedVertex, every chunk's range
+    LEVEL_SECTION_INDICES,          // uint16, every chunk's range
+    LEVEL_SECTION_PVS_INDEX,        // uint32 rowIndex[clusters], empty without PVS
+    LEVEL_SECTION_PVS_ROWS,         // uint64 rows[rowCount*rowWords]
+    LEVEL_SECTION_COUNT
+} LevelFileSectionType;
+
+typedef struct {
+    uint64_t offset;                // from the start of the file, LEVEL_FILE_ALIGNMENT aligned
+    uint64_t size;
+} LevelFileSection;
+
+typedef struct {
+    char magic[4];                  // "LVL "
+    uint32_t version;
+    uint32_t byteOrder;             // 0x01020304 as stored by a little endian writer
+    int32_t width;                  // cells
+    int32_t height;
+    int32_t chunksX;
+    int32_t chunksZ;
+    int32_t pvsClustersX;           // 0 when compiled without a PVS
+    int32_t pvsClustersZ;
+    int32_t pvsRowWords;
+    int32_t pvsRowCount;
+    uint32_t reserved;
+    uint64_t fileSize;
+    LevelFileSection sections[LEVEL_SECTION_COUNT];
+} LevelFileHeader;
+
+typedef struct {
+    int32_t x;                      // chunk coordinates
+    int32_t z;
+    uint32_t firstVertex;
+    int32_t vertexCount;
+    uint32_t firstIndex;
+    int32_t indexCount;
+    float offset[3];                // PackedMesh dequantization
+    float scale;
+} LevelFileChunk;
+
+typedef struct {
+    void *data;                     // the whole file, mapped read only
+    size_t size;
+    bool mapped;                    // false when it had to be read into memory instead
+    bool bundled;                   // in the bundle linked into the binary, nothing to release
+} LevelFile;
+
+// Offline, mesh must be packed (PackLevelMesh()), pvs may be NULL or not ready
+bool CompileLevelFile(const OccupancyGrid *grid, const LevelMesh *mesh, const PVS *pvs, const char *fileName);
+
+// Maps and validates, not ready when the file is missing, stale or from another version.
+// Without it on disk the bundled copy is used in place.
+LevelFile LoadLevelFile(const char *fileName);
+bool IsLevelFileReady(const LevelFile *file);
+void UnloadLevelFile(LevelFile *file);
+
+// Views into the file, valid until UnloadLevelFile() and never unloaded on
+// their own. Their arrays are read only.
+OccupancyGrid GetLevelFileGrid(const LevelFile *file);
+PVS GetLevelFilePVS(const LevelFile *file);         // not ready when compiled without one
+// Chunk list is allocated, vertex data stays in the file; UnloadLevelMesh() it as usual
+LevelMesh GetLevelFileMesh(const LevelFile *file);
+// One chunk's packed mesh in the file, empty when the chunk has no geometry
+PackedMesh GetLevelFileChunk(const LevelFile *file, int32_t chunk);
+// Streaming (levelstream.h): in touches every page of the chunk's vertices and
+// indices so uploading it does not fault, out lets the kernel drop the pages
+// again (mapped files only, the neighbour chunks' shared pages stay)
+void PageLevelFileChunk(const LevelFile *file, int32_t chunk, bool in);
+
+#endif
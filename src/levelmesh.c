@@ -0,0 +1,256 @@
+#include "levelmesh.h"
+#include "memtrack.h"
+#include "raymath.h"
+#include <stdlib.h>
+
+typedef struct {
+    Mesh *mesh;
+    int32_t vertex;
+} LevelMeshWriter;
+
+Color GetLevelAlbedo(Vector3 normal)
+{
+    return (normal.y > 0.5f) ? (Color){ 200, 200, 200, 255 } : (Color){ 130, 130, 140, 255 };
+}
+
+// Quad centered at c spanning +-u and +-v, cross(u, v) points along the normal
+static void LevelWriteQuad(LevelMeshWriter *w, Vector3 c, Vector3 u, Vector3 v, Vector3 n)
+{
+    Vector3 p[4] = {
+        Vector3Subtract(Vector3Subtract(c, u), v),
+        Vector3Subtract(Vector3Add(c, u), v),
+        Vector3Add(Vector3Add(c, u), v),
+        Vector3Add(Vector3Subtract(c, u), v)
+    };
+    static const float uv[4][2] = { { 0, 1 }, { 1, 1 }, { 1, 0 }, { 0, 0 } };
+    static const int order[6] = { 0, 1, 2, 0, 2, 3 };
+    Color albedo = GetLevelAlbedo(n);
+
+    for (int i = 0; i < 6; i++)
+    {
+        int k = order[i];
+        int32_t vi = w->vertex++;
+        w->mesh->vertices[vi*3 + 0] = p[k].x;
+        w->mesh->vertices[vi*3 + 1] = p[k].y;
+        w->mesh->vertices[vi*3 + 2] = p[k].z;
+        w->mesh->normals[vi*3 + 0] = n.x;
+        w->mesh->normals[vi*3 + 1] = n.y;
+        w->mesh->normals[vi*3 + 2] = n.z;
+        w->mesh->texcoords[vi*2 + 0] = uv[k][0];
+        w->mesh->texcoords[vi*2 + 1] = uv[k][1];
+        w->mesh->colors[vi*4 + 0] = albedo.r;
+        w->mesh->colors[vi*4 + 1] = albedo.g;
+        w->mesh->colors[vi*4 + 2] = albedo.b;
+        w->mesh->colors[vi*4 + 3] = 255;
+    }
+}
+
+// open neighbours of a solid cell get a side face, the map edge does not
+static bool LevelCellOpen(const OccupancyGrid *grid, int32_t x, int32_t z)
+{
+    if (x < 0 || z < 0 || x >= grid->width || z >= grid->height) return false;
+    return !grid->solid[z*grid->width + x];
+}
+
+static int32_t LevelChunkQuads(const OccupancyGrid *grid, int32_t x0, int32_t z0)
+{
+    int32_t quads = 0;
+    for (int32_t z = z0; z < z0 + LEVEL_CHUNK_SIZE && z < grid->height; z++)
+    {
+        for (int32_t x = x0; x < x0 + LEVEL_CHUNK_SIZE && x < grid->width; x++)
+        {
+            quads++;    // floor or wall top
+            if (!GridIsSolid(grid, x, z)) continue;
+            quads += LevelCellOpen(grid, x + 1, z) + LevelCellOpen(grid, x - 1, z) + LevelCellOpen(grid, x, z + 1) + LevelCellOpen(grid, x, z - 1);
+        }
+    }
+    return quads;
+}
+
+static Mesh LevelGenChunk(const OccupancyGrid *grid, int32_t x0, int32_t z0)
+{
+    Mesh mesh = { 0 };
+    int32_t quads = LevelChunkQuads(grid, x0, z0);
+    mesh.vertexCount = quads*6;
+    mesh.triangleCount = quads*2;
+    mesh.vertices = MemAlloc(sizeof(float)*3*mesh.vertexCount);
+    mesh.normals = MemAlloc(sizeof(float)*3*mesh.vertexCount);
+    mesh.texcoords = MemAlloc(sizeof(float)*2*mesh.vertexCount);
+    mesh.colors = MemAlloc(4*mesh.vertexCount);
+    MemChargeTagged(MEM_TAG_RENDER, GetMeshMemorySize(&mesh));
+
+    LevelMeshWriter w = { &mesh, 0 };
+    for (int32_t z = z0; z < z0 + LEVEL_CHUNK_SIZE && z < grid->height; z++)
+    {
+        for (int32_t x = x0; x < x0 + LEVEL_CHUNK_SIZE && x < grid->width; x++)
+        {
+            float fx = (float)x, fz = (float)z;
+            if (!GridIsSolid(grid, x, z))
+            {
+                LevelWriteQuad(&w, (Vector3){ fx, 0.0f, fz }, (Vector3){ 0, 0, 0.5f }, (Vector3){ 0.5f, 0, 0 }, (Vector3){ 0, 1, 0 });
+                continue;
+            }
+
+            LevelWriteQuad(&w, (Vector3){ fx, 1.0f, fz }, (Vector3){ 0, 0, 0.5f }, (Vector3){ 0.5f, 0, 0 }, (Vector3){ 0, 1, 0 });
+            if (LevelCellOpen(grid, x + 1, z)) LevelWriteQuad(&w, (Vector3){ fx + 0.5f, 0.5f, fz }, (Vector3){ 0, 0.5f, 0 }, (Vector3){ 0, 0, 0.5f }, (Vector3){ 1, 0, 0 });
+            if (LevelCellOpen(grid, x - 1, z)) LevelWriteQuad(&w, (Vector3){ fx - 0.5f, 0.5f, fz }, (Vector3){ 0, 0, 0.5f }, (Vector3){ 0, 0.5f, 0 }, (Vector3){ -1, 0, 0 });
+            if (LevelCellOpen(grid, x, z + 1)) LevelWriteQuad(&w, (Vector3){ fx, 0.5f, fz + 0.5f }, (Vector3){ 0.5f, 0, 0 }, (Vector3){ 0, 0.5f, 0 }, (Vector3){ 0, 0, 1 });
+            if (LevelCellOpen(grid, x, z - 1)) LevelWriteQuad(&w, (Vector3){ fx, 0.5f, fz - 0.5f }, (Vector3){ 0, 0.5f, 0 }, (Vector3){ 0.5f, 0, 0 }, (Vector3){ 0, 0, -1 });
+        }
+    }
+
+    return mesh;
+}
+
+LevelMesh GenLevelMeshLayout(const OccupancyGrid *grid)
+{
+    LevelMesh level = { 0 };
+    if (grid->solid == NULL) return level;
+
+    level.chunksX = (grid->width + LEVEL_CHUNK_SIZE - 1)/LEVEL_CHUNK_SIZE;
+    level.chunksZ = (grid->height + LEVEL_CHUNK_SIZE - 1)/LEVEL_CHUNK_SIZE;
+    level.chunkCount = level.chunksX*level.chunksZ;
+    level.chunks = MemCallocTagged(MEM_TAG_RENDER, level.chunkCount, sizeof(LevelChunk));
+    if (level.chunks == NULL) return (LevelMesh){ 0 };
+
+    for (int32_t i = 0; i < level.chunkCount; i++)
+    {
+        level.chunks[i].x = i%level.chunksX;
+        level.chunks[i].z = i/level.chunksX;
+    }
+    return level;
+}
+
+Mesh GenLevelChunkMesh(const OccupancyGrid *grid, int32_t cx, int32_t cz)
+{
+    return LevelGenChunk(grid, cx*LEVEL_CHUNK_SIZE, cz*LEVEL_CHUNK_SIZE);
+}
+
+LevelMesh GenLevelMesh(const OccupancyGrid *grid)
+{
+    LevelMesh level = GenLevelMeshLayout(grid);
+    for (int32_t i = 0; i < level.chunkCount; i++)
+    {
+        LevelChunk *chunk = &level.chunks[i];
+        chunk->mesh = GenLevelChunkMesh(grid, chunk->x, chunk->z);
+    }
+    return level;
+}
+
+void UnloadLevelChunkMesh(Mesh *mesh)
+{
+    MemReleaseTagged(MEM_TAG_RENDER, GetMeshMemorySize(mesh));
+    MemFree(mesh->vertices);
+    MemFree(mesh->normals);
+    MemFree(mesh->texcoords);
+    MemFree(mesh->colors);
+    *mesh = (Mesh){ 0 };
+}
+
+void PackLevelMesh(LevelMesh *level)
+{
+    // one summary line for the whole level, 625 chunk lines help nobody
+    MeshStats before = { 0 }, after = { 0 };
+    for (int32_t i = 0; i < level->chunkCount; i++)
+    {
+        LevelChunk *chunk = &level->chunks[i];
+        if (chunk->mesh.vertexCount == 0) continue;
+
+        MeshStats chunkBefore = GetMeshStats(&chunk->mesh);
+        chunk->packed = PackMesh(&chunk->mesh);
+        // packed chunks are all the renderer draws, one that does not pack is left out
+        if (chunk->packed.vertexCount == 0) TraceLog(LOG_WARNING, "LEVEL: chunk %d, %d does not pack, dropped", chunk->x, chunk->z);
+        MeshStats chunkAfter = GetPackedMeshStats(&chunk->packed);
+        before.vertexCount += chunkBefore.vertexCount;
+        before.triangleCount += chunkBefore.triangleCount;
+        before.bytes += chunkBefore.bytes;
+        before.cacheMisses += chunkBefore.cacheMisses;
+        after.vertexCount += chunkAfter.vertexCount;
+        after.triangleCount += chunkAfter.triangleCount;
+        after.bytes += chunkAfter.bytes;
+        after.cacheMisses += chunkAfter.cacheMisses;
+
+        UnloadLevelChunkMesh(&chunk->mesh);
+    }
+    if (before.vertexCount > 0) PrintMeshStats("level", before, after);
+}
+
+void UploadLevelMesh(LevelMesh *level)
+{
+    PackLevelMesh(level);
+    for (int32_t i = 0; i < level->chunkCount; i++)
+    {
+        if (level->borrowed) UploadPackedMeshView(&level->chunks[i].packed);
+        else UploadPackedMesh(&level->chunks[i].packed);
+    }
+
+    level->shader = LoadPackedMeshShader();
+    level->uploaded = true;
+}
+
+void UnloadLevelMesh(LevelMesh *level)
+{
+    for (int32_t i = 0; i < level->chunkCount; i++)
+    {
+        LevelChunk *chunk = &level->chunks[i];
+        if (level->borrowed)
+        {
+            chunk->packed.vertices = NULL;
+            chunk->packed.indices = NULL;
+        }
+        UnloadLevelChunkMesh(&chunk->mesh);
+        UnloadPackedMesh(&chunk->packed);
+    }
+    if (level->uploaded) UnloadPackedMeshShader(&level->shader);
+    MemFreeTagged(level->chunks);
+    *level = (LevelMesh){ 0 };
+}
+
+static bool LevelChunkVisible(const PVS *pvs, int32_t cameraCluster, int32_t cx, int32_t cz)
+{
+    // a chunk is a block of clusters, visible when any of them is
+    const int32_t span = LEVEL_CHUNK_SIZE/PVS_CLUSTER_SIZE;
+    for (int32_t z = cz*span; z < (cz + 1)*span && z < pvs->clustersZ; z++)
+    {
+        for (int32_t x = cx*span; x < (cx + 1)*span && x < pvs->clustersX; x++)
+        {
+            if (PVSClusterVisible(pvs, cameraCluster, z*pvs->clustersX + x)) return true;
+        }
+    }
+    return false;
+}
+
+void DrawLevelMesh(const LevelMesh *level, const OccupancyGrid *grid, const PVS *pvs, Vector3 position, Vector3 cameraPosition)
+{
+    if (!level->uploaded) return;
+
+    int32_t cellX, cellZ;
+    bool onMap = GridCellFromWorld(grid, position, cameraPosition, &cellX, &cellZ);
+    if (!onMap)
+    {
+        // off the map, clamp so the nearest edge still streams in
+        cellX = (int32_t)(cameraPosition.x - position.x + 0.5f);
+        cellZ = (int32_t)(cameraPosition.z - position.z + 0.5f);
+        cellX = (cellX < 0) ? 0 : (cellX >= grid->width) ? grid->width - 1 : cellX;
+        cellZ = (cellZ < 0) ? 0 : (cellZ >= grid->height) ? grid->height - 1 : cellZ;
+    }
+    bool usePvs = onMap && (pvs != NULL) && IsPVSReady(pvs) && PVSAppliesAt(cameraPosition.y - position.y);
+    int32_t cameraCluster = usePvs ? PVSClusterOfCell(pvs, cellX, cellZ) : 0;
+    int32_t ccx = cellX/LEVEL_CHUNK_SIZE;
+    int32_t ccz = cellZ/LEVEL_CHUNK_SIZE;
+    Matrix transform = MatrixTranslate(position.x, position.y, position.z);
+
+    for (int32_t cz = ccz - LEVEL_DRAW_DISTANCE; cz <= ccz + LEVEL_DRAW_DISTANCE; cz++)
+    {
+        if (cz < 0 || cz >= level->chunksZ) continue;
+        for (int32_t cx = ccx - LEVEL_DRAW_DISTANCE; cx <= ccx + LEVEL_DRAW_DISTANCE; cx++)
+        {
+            if (cx < 0 || cx >= level->chunksX) continue;
+            if (usePvs && !LevelChunkVisible(pvs, cameraCluster, cx, cz)) continue;
+
+            const LevelChunk *chunk = &level->chunks[cz*level->chunksX + cx];
+            // streamed levels only have the chunks near the camera uploaded
+            if (chunk->packed.indexCount > 0 && chunk->packed.vaoId > 0) DrawPackedMesh(&chunk->packed, &level->shader, transform);
+        }
+    }
+}
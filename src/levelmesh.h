@@ -0,0 +1,55 @@
+#ifndef LEVELMESH_H
+#define LEVELMESH_H
+
+#include "grid.h"
+#include "meshopt.h"
+#include "pvs.h"
+#include "raylib.h"
+#include <stdint.h>
+
+// Cubicmap level geometry split into LEVEL_CHUNK_SIZE x LEVEL_CHUNK_SIZE cell chunks.
+// Same layout as GenMeshCubicmap() (cube sides where a solid cell meets an open
+// one, wall tops, floors) minus the ceiling, with vertex colors carrying the
+// baked lighting. Chunks are drawn only when near the camera and PVS visible.
+// Packing welds, cache-orders and quantizes each chunk (meshopt.h), the
+// float meshes only live until then.
+
+#define LEVEL_CHUNK_SIZE 16         // multiple of PVS_CLUSTER_SIZE
+#define LEVEL_DRAW_DISTANCE 4       // in chunks around the camera
+
+typedef struct {
+    Mesh mesh;                      // float arrays, released by UploadLevelMesh()
+    PackedMesh packed;
+    int32_t x;                      // chunk coordinates
+    int32_t z;
+} LevelChunk;
+
+typedef struct {
+    LevelChunk *chunks;
+    int32_t chunksX;
+    int32_t chunksZ;
+    int32_t chunkCount;
+    PackedMeshShader shader;
+    bool uploaded;
+    bool borrowed;                  // packed chunk arrays point into a level file (levelfile.h)
+} LevelMesh;
+
+// CPU side only, safe to call without a window (bakers)
+LevelMesh GenLevelMesh(const OccupancyGrid *grid);
+// Chunk table only, every chunk empty, for levels meshed chunk by chunk as they stream in
+LevelMesh GenLevelMeshLayout(const OccupancyGrid *grid);
+// One chunk of GenLevelMesh(), CPU side, safe on a worker
+Mesh GenLevelChunkMesh(const OccupancyGrid *grid, int32_t cx, int32_t cz);
+void UnloadLevelChunkMesh(Mesh *mesh);
+// Welds, cache-orders and quantizes the chunks and drops the float meshes, CPU only
+void PackLevelMesh(LevelMesh *level);
+void UploadLevelMesh(LevelMesh *level);             // packs first when needed
+void UnloadLevelMesh(LevelMesh *level);
+
+// Surface color before lighting, picked from the face normal
+Color GetLevelAlbedo(Vector3 normal);
+
+// Call inside BeginMode3D(), pvs may be NULL or not ready
+void DrawLevelMesh(const LevelMesh *level, const OccupancyGrid *grid, const PVS *pvs, Vector3 position, Vector3 cameraPosition);
+
+#endif
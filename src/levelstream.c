@@ -0,0 +1,348 @@
+#include "levelstream.h"
+#include "jobs.h"
+#include "memtrack.h"
+#include "meshopt.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#define LEVEL_STREAM_SIDE (2*LEVEL_STREAM_RADIUS + 1)
+#define LEVEL_STREAM_MAX_WANTED (2*LEVEL_STREAM_SIDE*LEVEL_STREAM_SIDE)
+
+typedef enum {
+    STREAM_SLOT_FREE = 0,
+    STREAM_SLOT_LOADING,            // on a worker
+    STREAM_SLOT_LOADED,             // packed, waiting for an upload
+    STREAM_SLOT_RESIDENT
+} StreamSlotState;
+
+typedef struct {
+    LevelStream *stream;
+    int32_t chunk;                  // -1 when free
+    atomic_int state;               // StreamSlotState, LOADING -> LOADED is the worker's
+    uint32_t wanted;                // last frame the chunk was in range
+    PackedMesh packed;              // worker output until uploaded
+} LevelStreamSlot;
+
+struct LevelStream {
+    LevelStreamSlot slots[LEVEL_STREAM_MAX_CHUNKS];
+    int32_t *slotOfChunk;           // -1 when the chunk has no slot
+    int32_t chunksX;
+    int32_t chunksZ;
+    int32_t chunkCount;
+    // views, the arrays are the level's
+    OccupancyGrid grid;
+    LevelFile file;
+    LevelLighting lighting;
+    bool fromFile;
+    bool tracking;                  // lastCamera is valid
+    Vector3 lastCamera;
+    uint32_t frame;
+    LevelStreamStats stats;
+};
+
+typedef struct {
+    int32_t chunk;
+    int32_t priority;               // lower first
+} LevelStreamWant;
+
+static size_t LevelStreamBytes(const PackedMesh *packed)
+{
+    return sizeof(PackedVertex)*(size_t)packed->vertexCount + sizeof(unsigned short)*(size_t)packed->indexCount;
+}
+
+static void LevelStreamLoadJob(void *user)
+{
+    LevelStreamSlot *slot = user;
+    LevelStream *stream = slot->stream;
+    if (stream->fromFile)
+    {
+        PageLevelFileChunk(&stream->file, slot->chunk, true);
+        slot->packed = GetLevelFileChunk(&stream->file, slot->chunk);
+    }
+    else
+    {
+        Mesh mesh = GenLevelChunkMesh(&stream->grid, slot->chunk%stream->chunksX, slot->chunk/stream->chunksX);
+        ApplyLevelChunkLighting(&mesh, slot->chunk, &stream->lighting);
+        if (mesh.vertexCount > 0) slot->packed = PackMesh(&mesh);
+        if (mesh.vertexCount > 0 && slot->packed.vertexCount == 0) TraceLog(LOG_WARNING, "LEVEL: chunk %d does not pack, dropped", slot->chunk);
+        UnloadLevelChunkMesh(&mesh);
+    }
+    atomic_store_explicit(&slot->state, STREAM_SLOT_LOADED, memory_order_release);
+}
+
+static void LevelStreamLoadRange(int32_t begin, int32_t end, void *user)
+{
+    LevelStreamSlot **slots = user;
+    for (int32_t i = begin; i < end; i++) LevelStreamLoadJob(slots[i]);
+}
+
+static void LevelStreamUpload(LevelStream *stream, LevelMesh *mesh, LevelStreamSlot *slot)
+{
+    if (stream->fromFile) UploadPackedMeshView(&slot->packed);
+    else UploadPackedMesh(&slot->packed);
+    mesh->chunks[slot->chunk].packed = slot->packed;
+    slot->packed = (PackedMesh){ 0 };
+    stream->stats.bytes += LevelStreamBytes(&mesh->chunks[slot->chunk].packed);
+    atomic_store_explicit(&slot->state, STREAM_SLOT_RESIDENT, memory_order_relaxed);
+}
+
+static void LevelStreamEvict(LevelStream *stream, LevelMesh *mesh, LevelStreamSlot *slot)
+{
+    PackedMesh *packed = &mesh->chunks[slot->chunk].packed;
+    stream->stats.bytes -= LevelStreamBytes(packed);
+    // the arrays were released by the upload, only the GPU buffers are left
+    UnloadPackedMesh(packed);
+    if (stream->fromFile) PageLevelFileChunk(&stream->file, slot->chunk, false);
+    stream->slotOfChunk[slot->chunk] = -1;
+    slot->chunk = -1;
+    atomic_store_explicit(&slot->state, STREAM_SLOT_FREE, memory_order_relaxed);
+    stream->stats.evictions++;
+}
+
+// A free slot or the one holding the chunk that has been out of range the longest, NULL when every slot is busy or wanted
+static LevelStreamSlot *LevelStreamClaim(LevelStream *stream, LevelMesh *mesh, int32_t chunk)
+{
+    LevelStreamSlot *oldest = NULL;
+    for (int32_t i = 0; i < LEVEL_STREAM_MAX_CHUNKS; i++)
+    {
+        LevelStreamSlot *slot = &stream->slots[i];
+        int state = atomic_load_explicit(&slot->state, memory_order_acquire);
+        if (state == STREAM_SLOT_FREE)
+        {
+            oldest = slot;
+            break;
+        }
+        if (state != STREAM_SLOT_RESIDENT || slot->wanted == stream->frame) continue;
+        if (oldest == NULL || slot->wanted < oldest->wanted) oldest = slot;
+    }
+    if (oldest == NULL) return NULL;
+
+    if (oldest->chunk >= 0) LevelStreamEvict(stream, mesh, oldest);
+    oldest->chunk = chunk;
+    oldest->wanted = stream->frame;
+    stream->slotOfChunk[chunk] = (int32_t)(oldest - stream->slots);
+    atomic_store_explicit(&oldest->state, STREAM_SLOT_LOADING, memory_order_relaxed);
+    stream->stats.loads++;
+    return oldest;
+}
+
+// Chunk under a world position, clamped to the map so an edge still streams in from off it
+static void LevelStreamChunkAt(const LevelStream *stream, Vector3 position, Vector3 point, int32_t *cx, int32_t *cz)
+{
+    int32_t x = (int32_t)(point.x - position.x + 0.5f);
+    int32_t z = (int32_t)(point.z - position.z + 0.5f);
+    x = (x < 0) ? 0 : (x >= stream->grid.width) ? stream->grid.width - 1 : x;
+    z = (z < 0) ? 0 : (z >= stream->grid.height) ? stream->grid.height - 1 : z;
+    *cx = x/LEVEL_CHUNK_SIZE;
+    *cz = z/LEVEL_CHUNK_SIZE;
+}
+
+static int LevelStreamWantCompare(const void *a, const void *b)
+{
+    const LevelStreamWant *wa = a, *wb = b;
+    if (wa->priority != wb->priority) return (wa->priority > wb->priority) - (wa->priority < wb->priority);
+    return (wa->chunk > wb->chunk) - (wa->chunk < wb->chunk);
+}
+
+// Chunks within radius of the camera's chunk and of the predicted one, nearest
+// to the camera first; returns how many, without duplicates
+static int32_t LevelStreamWanted(const LevelStream *stream, int32_t ccx, int32_t ccz, int32_t pcx, int32_t pcz, int32_t radius, LevelStreamWant *wanted)
+{
+    int32_t count = 0;
+    const int32_t centers[2][2] = { { ccx, ccz }, { pcx, pcz } };
+    int32_t centerCount = (pcx == ccx && pcz == ccz) ? 1 : 2;
+    for (int32_t c = 0; c < centerCount; c++)
+    {
+        for (int32_t z = centers[c][1] - radius; z <= centers[c][1] + radius; z++)
+        {
+            if (z < 0 || z >= stream->chunksZ) continue;
+            for (int32_t x = centers[c][0] - radius; x <= centers[c][0] + radius; x++)
+            {
+                if (x < 0 || x >= stream->chunksX) continue;
+                // Chebyshev rings, the path ahead ranks one ring behind the same distance around the camera
+                int32_t near = abs(x - ccx) > abs(z - ccz) ? abs(x - ccx) : abs(z - ccz);
+                int32_t ahead = (abs(x - pcx) > abs(z - pcz) ? abs(x - pcx) : abs(z - pcz)) + 1;
+                wanted[count++] = (LevelStreamWant){ z*stream->chunksX + x, (near < ahead) ? near : ahead };
+            }
+        }
+    }
+    qsort(wanted, count, sizeof(LevelStreamWant), LevelStreamWantCompare);
+
+    int32_t unique = 0;
+    for (int32_t i = 0; i < count; i++)
+    {
+        if (unique == 0 || wanted[unique - 1].chunk != wanted[i].chunk) wanted[unique++] = wanted[i];
+    }
+    return unique;
+}
+
+static int32_t LevelStreamUploadLoaded(LevelStream *stream, LevelMesh *mesh, int32_t limit)
+{
+    int32_t uploads = 0;
+    for (int32_t i = 0; i < LEVEL_STREAM_MAX_CHUNKS && uploads < limit; i++)
+    {
+        LevelStreamSlot *slot = &stream->slots[i];
+        if (atomic_load_explicit(&slot->state, memory_order_acquire) != STREAM_SLOT_LOADED) continue;
+        LevelStreamUpload(stream, mesh, slot);
+        uploads++;
+    }
+    return uploads;
+}
+
+static void LevelStreamWaitIdle(LevelStream *stream)
+{
+    for (int32_t i = 0; i < LEVEL_STREAM_MAX_CHUNKS; i++)
+    {
+        while (atomic_load_explicit(&stream->slots[i].state, memory_order_acquire) == STREAM_SLOT_LOADING) WaitTime(0.001);
+    }
+}
+
+LevelStream *LoadLevelStream(LevelMesh *mesh, const OccupancyGrid *grid, const LevelFile *file, const LevelLighting *lighting)
+{
+    if (mesh->chunkCount == 0) return NULL;
+    LevelStream *stream = MemCallocTagged(MEM_TAG_RENDER, 1, sizeof(LevelStream));
+    if (stream == NULL) return NULL;
+    stream->slotOfChunk = MemAllocTagged(MEM_TAG_RENDER, sizeof(int32_t)*mesh->chunkCount);
+    if (stream->slotOfChunk == NULL)
+    {
+        MemFreeTagged(stream);
+        return NULL;
+    }
+
+    stream->chunksX = mesh->chunksX;
+    stream->chunksZ = mesh->chunksZ;
+    stream->chunkCount = mesh->chunkCount;
+    stream->grid = *grid;
+    stream->fromFile = mesh->borrowed;
+    if (stream->fromFile) stream->file = *file;
+    if (lighting != NULL) stream->lighting = *lighting;
+    for (int32_t i = 0; i < mesh->chunkCount; i++) stream->slotOfChunk[i] = -1;
+    for (int32_t i = 0; i < LEVEL_STREAM_MAX_CHUNKS; i++)
+    {
+        stream->slots[i].stream = stream;
+        stream->slots[i].chunk = -1;
+        atomic_init(&stream->slots[i].state, STREAM_SLOT_FREE);
+    }
+
+    // chunks only get buffers when they stream in, the file views come back from the file then
+    if (mesh->borrowed)
+    {
+        for (int32_t i = 0; i < mesh->chunkCount; i++) mesh->chunks[i].packed = (PackedMesh){ 0 };
+    }
+    mesh->shader = LoadPackedMeshShader();
+    mesh->uploaded = true;
+    return stream;
+}
+
+void UnloadLevelStream(LevelStream *stream)
+{
+    if (stream == NULL) return;
+
+    LevelStreamWaitIdle(stream);
+    for (int32_t i = 0; i < LEVEL_STREAM_MAX_CHUNKS; i++)
+    {
+        LevelStreamSlot *slot = &stream->slots[i];
+        if (atomic_load_explicit(&slot->state, memory_order_acquire) != STREAM_SLOT_LOADED) continue;
+        // never uploaded: meshed chunks own their arrays, file chunks are views
+        if (!stream->fromFile) UnloadPackedMesh(&slot->packed);
+    }
+    MemFreeTagged(stream->slotOfChunk);
+    MemFreeTagged(stream);
+}
+
+void FillLevelStream(LevelStream *stream, LevelMesh *mesh, Vector3 position, Vector3 cameraPosition)
+{
+    if (stream == NULL) return;
+
+    int32_t cx, cz;
+    LevelStreamChunkAt(stream, position, cameraPosition, &cx, &cz);
+    static LevelStreamWant wanted[LEVEL_STREAM_MAX_WANTED];
+    int32_t count = LevelStreamWanted(stream, cx, cz, cx, cz, LEVEL_DRAW_DISTANCE, wanted);
+
+    stream->frame++;
+    LevelStreamSlot *loads[LEVEL_STREAM_MAX_WANTED];
+    int32_t loadCount = 0;
+    for (int32_t i = 0; i < count; i++)
+    {
+        int32_t slot = stream->slotOfChunk[wanted[i].chunk];
+        if (slot >= 0) stream->slots[slot].wanted = stream->frame;
+    }
+    for (int32_t i = 0; i < count; i++)
+    {
+        if (stream->slotOfChunk[wanted[i].chunk] >= 0) continue;
+        LevelStreamSlot *slot = LevelStreamClaim(stream, mesh, wanted[i].chunk);
+        if (slot != NULL) loads[loadCount++] = slot;
+    }
+
+    // the caller helps the workers, then whatever was already in flight lands too
+    JobsParallelFor(loadCount, 1, LevelStreamLoadRange, loads);
+    LevelStreamWaitIdle(stream);
+    LevelStreamUploadLoaded(stream, mesh, LEVEL_STREAM_MAX_CHUNKS);
+}
+
+void UpdateLevelStream(LevelStream *stream, LevelMesh *mesh, Vector3 position, Vector3 cameraPosition, float dt)
+{
+    if (stream == NULL) return;
+    stream->frame++;
+
+    // smoothed over a quarter second, a teleport only skews a few frames of prefetch
+    if (stream->tracking && dt > 0.0f)
+    {
+        Vector3 velocity = {
+            (cameraPosition.x - stream->lastCamera.x)/dt, 0.0f, (cameraPosition.z - stream->lastCamera.z)/dt
+        };
+        float blend = (dt*4.0f < 1.0f) ? dt*4.0f : 1.0f;
+        stream->stats.velocity.x += (velocity.x - stream->stats.velocity.x)*blend;
+        stream->stats.velocity.z += (velocity.z - stream->stats.velocity.z)*blend;
+    }
+    stream->lastCamera = cameraPosition;
+    stream->tracking = true;
+
+    LevelStreamUploadLoaded(stream, mesh, LEVEL_STREAM_UPLOADS);
+
+    int32_t ccx, ccz, pcx, pcz;
+    Vector3 ahead = {
+        cameraPosition.x + stream->stats.velocity.x*LEVEL_STREAM_PREFETCH, cameraPosition.y,
+        cameraPosition.z + stream->stats.velocity.z*LEVEL_STREAM_PREFETCH
+    };
+    LevelStreamChunkAt(stream, position, cameraPosition, &ccx, &ccz);
+    LevelStreamChunkAt(stream, position, ahead, &pcx, &pcz);
+    static LevelStreamWant wanted[LEVEL_STREAM_MAX_WANTED];
+    int32_t count = LevelStreamWanted(stream, ccx, ccz, pcx, pcz, LEVEL_STREAM_RADIUS, wanted);
+
+    // mark everything in range first so no wanted chunk gets evicted for another
+    int32_t loading = 0;
+    for (int32_t i = 0; i < LEVEL_STREAM_MAX_CHUNKS; i++)
+    {
+        loading += atomic_load_explicit(&stream->slots[i].state, memory_order_relaxed) == STREAM_SLOT_LOADING;
+    }
+    for (int32_t i = 0; i < count; i++)
+    {
+        int32_t slot = stream->slotOfChunk[wanted[i].chunk];
+        if (slot >= 0) stream->slots[slot].wanted = stream->frame;
+    }
+    for (int32_t i = 0; i < count && loading < LEVEL_STREAM_MAX_LOADS; i++)
+    {
+        if (stream->slotOfChunk[wanted[i].chunk] >= 0) continue;
+        LevelStreamSlot *slot = LevelStreamClaim(stream, mesh, wanted[i].chunk);
+        // out of slots, the rest is further away than what is resident
+        if (slot == NULL) break;
+        loading++;
+        JobsSubmit(LevelStreamLoadJob, slot);
+    }
+}
+
+LevelStreamStats GetLevelStreamStats(const LevelStream *stream)
+{
+    if (stream == NULL) return (LevelStreamStats){ 0 };
+
+    LevelStreamStats stats = stream->stats;
+    for (int32_t i = 0; i < LEVEL_STREAM_MAX_CHUNKS; i++)
+    {
+        int state = atomic_load_explicit(&stream->slots[i].state, memory_order_relaxed);
+        stats.resident += state == STREAM_SLOT_RESIDENT;
+        stats.loading += state == STREAM_SLOT_LOADING;
+        stats.waiting += state == STREAM_SLOT_LOADED;
+    }
+    return stats;
+}
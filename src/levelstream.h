@@ -0,0 +1,60 @@
+#ifndef LEVELSTREAM_H
+#define LEVELSTREAM_H
+
+#include "grid.h"
+#include "levelfile.h"
+#include "levelmesh.h"
+#include "lightbake.h"
+#include "raylib.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Level chunks streamed in and out around the camera, so the map size is no
+// longer capped by what fits in GPU memory and startup time.
+// Only chunks near the camera, and near where it will be in
+// LEVEL_STREAM_PREFETCH seconds at its current velocity, are resident.
+// Missing chunks are produced on the job system: a compiled level's chunk
+// pages are faulted in off the main thread, a ye.png level's chunks are
+// meshed, lit and packed there. They are uploaded a few per frame.
+//
+// Residency is a fixed pool of LEVEL_STREAM_MAX_CHUNKS slots, the least
+// recently wanted chunk gives up its slot, so memory is bounded whatever
+// the map size. The occupancy grid and PVS stay resident, a byte and a
+// bit per cell are small next to the meshes.
+
+#define LEVEL_STREAM_RADIUS (LEVEL_DRAW_DISTANCE + 1)      // chunks around the camera, a ring past drawing
+#define LEVEL_STREAM_PREFETCH 1.5f      // seconds of camera travel loaded ahead
+#define LEVEL_STREAM_MAX_CHUNKS 256     // resident chunks, at least two streaming squares
+#define LEVEL_STREAM_MAX_LOADS 16       // chunks on workers at once
+#define LEVEL_STREAM_UPLOADS 4          // per frame
+
+typedef struct {
+    int32_t resident;               // uploaded
+    int32_t loading;                // on a worker
+    int32_t waiting;                // loaded, waiting for an upload
+    size_t bytes;                   // vertex and index buffers of the resident chunks
+    uint32_t loads;                 // since LoadLevelStream()
+    uint32_t evictions;
+    Vector3 velocity;               // smoothed camera velocity, world units per second
+} LevelStreamStats;
+
+typedef struct LevelStream LevelStream;
+
+// Takes over the level's chunks, nothing is drawn until chunks stream in.
+// A mesh borrowed from a level file is paged from it, any other is meshed
+// from the grid (GenLevelMeshLayout()) and lit from lighting, which may be
+// empty. The views are copied, the arrays behind them have to outlive the stream.
+LevelStream *LoadLevelStream(LevelMesh *mesh, const OccupancyGrid *grid, const LevelFile *file, const LevelLighting *lighting);
+// Waits for chunks on workers, uploaded chunks are left to UnloadLevelMesh()
+void UnloadLevelStream(LevelStream *stream);
+
+// Blocks until every chunk within LEVEL_DRAW_DISTANCE of cameraPosition is
+// uploaded, for startup and level swaps where nothing is on screen yet
+void FillLevelStream(LevelStream *stream, LevelMesh *mesh, Vector3 position, Vector3 cameraPosition);
+// Once per frame on the raylib thread, before drawing
+void UpdateLevelStream(LevelStream *stream, LevelMesh *mesh, Vector3 position, Vector3 cameraPosition, float dt);
+
+LevelStreamStats GetLevelStreamStats(const LevelStream *stream);
+
+#endif
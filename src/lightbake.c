@@ -0,0 +1,297 @@
+#include "lightbake.h"
+#include "jobs.h"
+#include "memtrack.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LIGHT_RAY_EPSILON 0.001f
+#define LIGHT_SHADOW_DISTANCE 64.0f
+
+typedef struct {
+    const LevelMesh *level;
+    const OccupancyGrid *grid;
+    LightBakeSettings settings;
+    LevelLighting *lighting;
+} LightBake;
+
+LightBakeSettings GetDefaultLightBakeSettings(void)
+{
+    return (LightBakeSettings){
+        .sunDirection = { 0.45f, 0.8f, 0.4f },
+        .sunColor = { 0.55f, 0.52f, 0.45f },
+        .skyColor = { 0.5f, 0.53f, 0.6f },
+        .aoSamples = 32,
+        .aoRadius = 1.5f
+    };
+}
+
+static bool LightCellSolid(const OccupancyGrid *grid, int32_t x, int32_t z)
+{
+    // outside the map is open sky, walls stop where the map does
+    if (x < 0 || z < 0 || x >= grid->width || z >= grid->height) return false;
+    return grid->solid[z*grid->width + x] != 0;
+}
+
+// 3D DDA through the voxel grid. Layer y < 0 is the ground, layer 0 holds
+// the unit high walls, everything above is empty.
+static bool LightRayBlocked(const OccupancyGrid *grid, Vector3 origin, Vector3 dir, float maxDistance)
+{
+    float p[3] = { origin.x + 0.5f, origin.y, origin.z + 0.5f };
+    float d[3] = { dir.x, dir.y, dir.z };
+    int32_t cell[3], step[3];
+    float tMax[3], tDelta[3];
+
+    for (int a = 0; a < 3; a++) cell[a] = (int32_t)floorf(p[a]);
+    // a floor vertex on a cell edge rounds into whichever cell is on its + side,
+    // when that is the wall start in the open cell its face belongs to instead
+    if (cell[1] == 0 && LightCellSolid(grid, cell[0], cell[2]))
+    {
+        for (int32_t i = 1; i < 4; i++)
+        {
+            int32_t dx = i & 1, dz = i >> 1;
+            if ((dx && p[0] - cell[0] > LIGHT_RAY_EPSILON) || (dz && p[2] - cell[2] > LIGHT_RAY_EPSILON)) continue;
+            if (LightCellSolid(grid, cell[0] - dx, cell[2] - dz)) continue;
+            if (dx) p[0] = cell[0]-- - LIGHT_RAY_EPSILON;
+            if (dz) p[2] = cell[2]-- - LIGHT_RAY_EPSILON;
+            break;
+        }
+    }
+
+    for (int a = 0; a < 3; a++)
+    {
+        step[a] = (d[a] > 0.0f) ? 1 : -1;
+        tDelta[a] = (d[a] != 0.0f) ? fabsf(1.0f/d[a]) : INFINITY;
+        tMax[a] = (d[a] > 0.0f) ? (cell[a] + 1 - p[a])*tDelta[a] : (d[a] < 0.0f) ? (p[a] - cell[a])*tDelta[a] : INFINITY;
+    }
+
+    float t = 0.0f;
+    while (t <= maxDistance)
+    {
+        if (cell[1] < 0) return true;
+        if (cell[1] == 0 && LightCellSolid(grid, cell[0], cell[2])) return true;
+        if (cell[1] >= 1 && d[1] >= 0.0f) return false;
+
+        int a = (tMax[0] < tMax[1]) ? ((tMax[0] < tMax[2]) ? 0 : 2) : ((tMax[1] < tMax[2]) ? 1 : 2);
+        t = tMax[a];
+        tMax[a] += tDelta[a];
+        cell[a] += step[a];
+    }
+
+    return false;
+}
+
+static uint32_t LightHash(uint32_t x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+static float LightRandom(uint32_t *state)
+{
+    *state = LightHash(*state + 0x9E3779B9u);
+    return (float)(*state >> 8)*(1.0f/16777216.0f);
+}
+
+static Vector3 LightNormalize(Vector3 v)
+{
+    float len = sqrtf(v.x*v.x + v.y*v.y + v.z*v.z);
+    return (len > 0.0f) ? (Vector3){ v.x/len, v.y/len, v.z/len } : v;
+}
+
+static float LightOcclusion(const LightBake *bake, Vector3 origin, Vector3 n, uint32_t seed)
+{
+    Vector3 helper = (fabsf(n.y) < 0.99f) ? (Vector3){ 0, 1, 0 } : (Vector3){ 1, 0, 0 };
+    Vector3 t = LightNormalize((Vector3){ helper.y*n.z - helper.z*n.y, helper.z*n.x - helper.x*n.z, helper.x*n.y - helper.y*n.x });
+    Vector3 b = { n.y*t.z - n.z*t.y, n.z*t.x - n.x*t.z, n.x*t.y - n.y*t.x };
+
+    int32_t blocked = 0;
+    for (int32_t s = 0; s < bake->settings.aoSamples; s++)
+    {
+        // cosine weighted hemisphere sample
+        float r1 = LightRandom(&seed), r2 = LightRandom(&seed);
+        float r = sqrtf(r1), phi = 2.0f*PI*r2;
+        float x = r*cosf(phi), y = r*sinf(phi), z = sqrtf(1.0f - r1);
+        Vector3 dir = {
+            t.x*x + b.x*y + n.x*z,
+            t.y*x + b.y*y + n.y*z,
+            t.z*x + b.z*y + n.z*z
+        };
+        blocked += LightRayBlocked(bake->grid, origin, dir, bake->settings.aoRadius);
+    }
+
+    return 1.0f - (float)blocked/bake->settings.aoSamples;
+}
+
+static unsigned char LightToByte(float v)
+{
+    return (unsigned char)((v < 0.0f) ? 0 : (v > 1.0f) ? 255 : v*255.0f + 0.5f);
+}
+
+static void LightBakeChunkJob(int32_t begin, int32_t end, void *user)
+{
+    const LightBake *bake = user;
+    const LightBakeSettings *s = &bake->settings;
+    Vector3 sun = LightNormalize(s->sunDirection);
+
+    for (int32_t c = begin; c < end; c++)
+    {
+        const Mesh *mesh = &bake->level->chunks[c].mesh;
+        Color *out = bake->lighting->light + bake->lighting->offsets[c];
+
+        for (int32_t v = 0; v < mesh->vertexCount; v++)
+        {
+            Vector3 n = { mesh->normals[v*3], mesh->normals[v*3 + 1], mesh->normals[v*3 + 2] };
+            Vector3 origin = {
+                mesh->vertices[v*3] + n.x*LIGHT_RAY_EPSILON,
+                mesh->vertices[v*3 + 1] + n.y*LIGHT_RAY_EPSILON,
+                mesh->vertices[v*3 + 2] + n.z*LIGHT_RAY_EPSILON
+            };
+
+            // seeded by position so the six copies of a shared corner agree
+            uint32_t seed = LightHash((uint32_t)(int32_t)(origin.x*64.0f) ^ LightHash((uint32_t)(int32_t)(origin.y*64.0f) ^
+                                      LightHash((uint32_t)(int32_t)(origin.z*64.0f))));
+            float ao = LightOcclusion(bake, origin, n, seed);
+            float ndotl = n.x*sun.x + n.y*sun.y + n.z*sun.z;
+            float direct = (ndotl > 0.0f && !LightRayBlocked(bake->grid, origin, sun, LIGHT_SHADOW_DISTANCE)) ? ndotl : 0.0f;
+
+            out[v] = (Color){
+                LightToByte(s->skyColor.x*ao + s->sunColor.x*direct),
+                LightToByte(s->skyColor.y*ao + s->sunColor.y*direct),
+                LightToByte(s->skyColor.z*ao + s->sunColor.z*direct),
+                255
+            };
+        }
+    }
+}
+
+static bool LightingAllocate(LevelLighting *lighting, int32_t chunkCount)
+{
+    lighting->chunkCount = chunkCount;
+    lighting->vertexCounts = MemCallocTagged(MEM_TAG_ASSETS, chunkCount, sizeof(int32_t));
+    lighting->offsets = MemCallocTagged(MEM_TAG_ASSETS, chunkCount, sizeof(int32_t));
+    return lighting->vertexCounts != NULL && lighting->offsets != NULL;
+}
+
+LevelLighting BakeLevelLighting(const LevelMesh *level, const OccupancyGrid *grid, LightBakeSettings settings)
+{
+    LevelLighting lighting = { 0 };
+    if (level->chunkCount == 0 || grid->solid == NULL) return lighting;
+    if (!LightingAllocate(&lighting, level->chunkCount))
+    {
+        UnloadLevelLighting(&lighting);
+        return lighting;
+    }
+
+    for (int32_t c = 0; c < level->chunkCount; c++)
+    {
+        lighting.vertexCounts[c] = level->chunks[c].mesh.vertexCount;
+        lighting.offsets[c] = lighting.totalVertices;
+        lighting.totalVertices += lighting.vertexCounts[c];
+    }
+    lighting.light = MemCallocTagged(MEM_TAG_ASSETS, (lighting.totalVertices > 0) ? lighting.totalVertices : 1, sizeof(Color));
+    if (lighting.light == NULL)
+    {
+        UnloadLevelLighting(&lighting);
+        return lighting;
+    }
+
+    LightBake bake = { level, grid, settings, &lighting };
+    if (bake.settings.aoSamples < 1) bake.settings.aoSamples = 1;
+    // chunks are independent and similar in cost, one per range keeps every core busy
+    JobsParallelFor(level->chunkCount, 1, LightBakeChunkJob, &bake);
+
+    return lighting;
+}
+
+typedef struct {
+    char magic[4];
+    int32_t version;
+    int32_t chunkCount;
+    int32_t totalVertices;
+} LightingFileHeader;
+
+bool SaveLevelLighting(const LevelLighting *lighting, const char *fileName)
+{
+    if (lighting->light == NULL) return false;
+
+    FILE *file = fopen(fileName, "wb");
+    if (file == NULL) return false;
+
+    LightingFileHeader header = { { 'L', 'G', 'T', ' ' }, LIGHTING_FILE_VERSION, lighting->chunkCount, lighting->totalVertices };
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = ok && fwrite(lighting->vertexCounts, sizeof(int32_t), lighting->chunkCount, file) == (size_t)lighting->chunkCount;
+    ok = ok && fwrite(lighting->light, sizeof(Color), lighting->totalVertices, file) == (size_t)lighting->totalVertices;
+    fclose(file);
+
+    return ok;
+}
+
+LevelLighting LoadLevelLighting(const char *fileName)
+{
+    LevelLighting lighting = { 0 };
+    FILE *file = fopen(fileName, "rb");
+    if (file == NULL) return lighting;
+
+    LightingFileHeader header;
+    bool ok = fread(&header, sizeof(header), 1, file) == 1 && memcmp(header.magic, "LGT ", 4) == 0 &&
+              header.version == LIGHTING_FILE_VERSION && header.chunkCount > 0 && header.totalVertices >= 0;
+    ok = ok && LightingAllocate(&lighting, header.chunkCount);
+    ok = ok && fread(lighting.vertexCounts, sizeof(int32_t), header.chunkCount, file) == (size_t)header.chunkCount;
+
+    for (int32_t c = 0; ok && c < lighting.chunkCount; c++)
+    {
+        ok = lighting.vertexCounts[c] >= 0;
+        lighting.offsets[c] = lighting.totalVertices;
+        lighting.totalVertices += lighting.vertexCounts[c];
+    }
+    ok = ok && lighting.totalVertices == header.totalVertices;
+    if (ok) lighting.light = MemAllocTagged(MEM_TAG_ASSETS, sizeof(Color)*((header.totalVertices > 0) ? header.totalVertices : 1));
+    ok = ok && lighting.light != NULL && fread(lighting.light, sizeof(Color), header.totalVertices, file) == (size_t)header.totalVertices;
+    fclose(file);
+
+    if (!ok) UnloadLevelLighting(&lighting);
+    return lighting;
+}
+
+void UnloadLevelLighting(LevelLighting *lighting)
+{
+    MemFreeTagged(lighting->vertexCounts);
+    MemFreeTagged(lighting->offsets);
+    MemFreeTagged(lighting->light);
+    *lighting = (LevelLighting){ 0 };
+}
+
+bool ApplyLevelLighting(LevelMesh *level, const LevelLighting *lighting)
+{
+    if (lighting->light == NULL || lighting->chunkCount != level->chunkCount) return false;
+    for (int32_t c = 0; c < level->chunkCount; c++)
+    {
+        if (lighting->vertexCounts[c] != level->chunks[c].mesh.vertexCount) return false;
+    }
+
+    for (int32_t c = 0; c < level->chunkCount; c++) ApplyLevelChunkLighting(&level->chunks[c].mesh, c, lighting);
+    return true;
+}
+
+bool ApplyLevelChunkLighting(Mesh *mesh, int32_t chunk, const LevelLighting *lighting)
+{
+    if (lighting->light == NULL || chunk < 0 || chunk >= lighting->chunkCount) return false;
+    if (lighting->vertexCounts[chunk] != mesh->vertexCount) return false;
+
+    const Color *light = lighting->light + lighting->offsets[chunk];
+    for (int32_t v = 0; v < mesh->vertexCount; v++)
+    {
+        Color albedo = GetLevelAlbedo((Vector3){ mesh->normals[v*3], mesh->normals[v*3 + 1], mesh->normals[v*3 + 2] });
+        mesh->colors[v*4 + 0] = (unsigned char)(albedo.r*light[v].r/255);
+        mesh->colors[v*4 + 1] = (unsigned char)(albedo.g*light[v].g/255);
+        mesh->colors[v*4 + 2] = (unsigned char)(albedo.b*light[v].b/255);
+        mesh->colors[v*4 + 3] = 255;
+    }
+    return true;
+}
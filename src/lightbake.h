@@ -0,0 +1,45 @@
+#ifndef LIGHTBAKE_H
+#define LIGHTBAKE_H
+
+#include "grid.h"
+#include "levelmesh.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Offline per-vertex lighting for the level chunk meshes.
+// Every vertex traces cosine weighted hemisphere rays against the voxel grid
+// for ambient occlusion and one shadow ray towards the sun, chunks are baked
+// in parallel on the job system. The result is one RGBA8 light value per
+// vertex, the renderer just multiplies it into the vertex colors.
+
+#define LIGHTING_FILE_VERSION 1
+
+typedef struct {
+    Vector3 sunDirection;   // towards the sun
+    Vector3 sunColor;       // linear 0..1
+    Vector3 skyColor;
+    int32_t aoSamples;
+    float aoRadius;         // in cells
+} LightBakeSettings;
+
+typedef struct {
+    int32_t chunkCount;
+    int32_t *vertexCounts;  // per chunk, must match the mesh it gets applied to
+    int32_t *offsets;       // first light value of each chunk
+    int32_t totalVertices;
+    Color *light;
+} LevelLighting;
+
+LightBakeSettings GetDefaultLightBakeSettings(void);
+LevelLighting BakeLevelLighting(const LevelMesh *level, const OccupancyGrid *grid, LightBakeSettings settings);
+bool SaveLevelLighting(const LevelLighting *lighting, const char *fileName);
+LevelLighting LoadLevelLighting(const char *fileName);
+void UnloadLevelLighting(LevelLighting *lighting);
+
+// Writes albedo*light into the chunk vertex colors, call before UploadLevelMesh().
+// Returns false and leaves the mesh alone when the lighting was baked for different geometry.
+bool ApplyLevelLighting(LevelMesh *level, const LevelLighting *lighting);
+// Same for one chunk's mesh, for chunks meshed as they stream in
+bool ApplyLevelChunkLighting(Mesh *mesh, int32_t chunk, const LevelLighting *lighting);
+
+#endif
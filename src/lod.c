@@ -0,0 +1,300 @@
+#include "lod.h"
+#include "bundle.h"
+#include "memtrack.h"
+#include "meshopt.h"
+#include "simplify.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// projected bounding sphere diameter in pixels below which each level kicks in
+static const float lodDefaultScreenSizes[LOD_MAX_LEVELS] = { 0.0f, 240.0f, 120.0f, 48.0f };
+static const float lodDefaultRatios[LOD_MAX_LEVELS] = { 1.0f, 0.5f, 0.25f, 0.1f };
+
+// Every level's arrays, raylib's allocator owns them
+static size_t LodModelMemorySize(const LodModel *lod)
+{
+    size_t size = 0;
+    for (int32_t l = 0; l < lod->levelCount; l++) size += GetMeshMemorySize(&lod->meshes[l]);
+    return size;
+}
+
+LodModel BuildLodModel(const Mesh *mesh, int32_t levelCount, const float *ratios)
+{
+    LodModel lod = { 0 };
+    if (levelCount < 1) return lod;
+    if (levelCount > LOD_MAX_LEVELS) levelCount = LOD_MAX_LEVELS;
+    if (ratios == NULL) ratios = lodDefaultRatios;
+
+    // level 0 is the source welded and indexed, the others are simplified from it
+    lod.meshes[0] = SimplifyMesh(mesh, INT32_MAX);
+    if (lod.meshes[0].vertexCount == 0) return lod;
+    lod.levelCount = 1;
+
+    for (int32_t l = 1; l < levelCount; l++)
+    {
+        int32_t target = (int32_t)(lod.meshes[0].triangleCount*ratios[l]);
+        Mesh level = SimplifyMesh(&lod.meshes[0], (target > 1) ? target : 1);
+        if (level.vertexCount == 0) break;
+        lod.meshes[lod.levelCount++] = level;
+    }
+
+    // simplification leaves triangles in collapse order, reorder for the vertex cache
+    for (int32_t l = 0; l < lod.levelCount; l++)
+    {
+        MeshStats before = GetMeshStats(&lod.meshes[l]);
+        OptimizeMesh(&lod.meshes[l]);
+        PrintMeshStats(TextFormat("lod %d", l), before, GetMeshStats(&lod.meshes[l]));
+    }
+
+    for (int32_t i = 0; i < lod.meshes[0].vertexCount; i++)
+    {
+        const float *p = &lod.meshes[0].vertices[i*3];
+        float r = sqrtf(p[0]*p[0] + p[1]*p[1] + p[2]*p[2]);
+        if (r > lod.radius) lod.radius = r;
+    }
+    memcpy(lod.screenSizes, lodDefaultScreenSizes, sizeof(lod.screenSizes));
+    MemChargeTagged(MEM_TAG_ASSETS, LodModelMemorySize(&lod));
+
+    return lod;
+}
+
+typedef struct {
+    char magic[4];
+    int32_t version;
+    int32_t levelCount;
+    float radius;
+    float screenSizes[LOD_MAX_LEVELS];
+} LodFileHeader;
+
+typedef struct {
+    int32_t vertexCount;
+    int32_t triangleCount;
+    int32_t hasNormals;
+    int32_t hasTexcoords;
+} LodFileLevel;
+
+bool SaveLodModel(const LodModel *lod, const char *fileName)
+{
+    if (!IsLodModelReady(lod)) return false;
+
+    FILE *file = fopen(fileName, "wb");
+    if (file == NULL) return false;
+
+    LodFileHeader header = { { 'L', 'O', 'D', ' ' }, LOD_FILE_VERSION, lod->levelCount, lod->radius, { 0 } };
+    memcpy(header.screenSizes, lod->screenSizes, sizeof(header.screenSizes));
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+
+    for (int32_t l = 0; ok && l < lod->levelCount; l++)
+    {
+        const Mesh *mesh = &lod->meshes[l];
+        LodFileLevel level = { mesh->vertexCount, mesh->triangleCount, mesh->normals != NULL, mesh->texcoords != NULL };
+        ok = fwrite(&level, sizeof(level), 1, file) == 1;
+        ok = ok && fwrite(mesh->vertices, sizeof(float)*3, level.vertexCount, file) == (size_t)level.vertexCount;
+        if (level.hasNormals) ok = ok && fwrite(mesh->normals, sizeof(float)*3, level.vertexCount, file) == (size_t)level.vertexCount;
+        if (level.hasTexcoords) ok = ok && fwrite(mesh->texcoords, sizeof(float)*2, level.vertexCount, file) == (size_t)level.vertexCount;
+        ok = ok && fwrite(mesh->indices, sizeof(unsigned short)*3, level.triangleCount, file) == (size_t)level.triangleCount;
+    }
+    fclose(file);
+
+    return ok;
+}
+
+LodModel LoadLodModel(const char *fileName)
+{
+    LodModel lod = { 0 };
+    FILE *file = OpenAssetFile(fileName);
+    if (file == NULL) return lod;
+
+    LodFileHeader header;
+    bool ok = fread(&header, sizeof(header), 1, file) == 1 && memcmp(header.magic, "LOD ", 4) == 0 &&
+              header.version == LOD_FILE_VERSION && header.levelCount > 0 && header.levelCount <= LOD_MAX_LEVELS;
+    if (ok)
+    {
+        lod.radius = header.radius;
+        memcpy(lod.screenSizes, header.screenSizes, sizeof(lod.screenSizes));
+    }
+
+    for (int32_t l = 0; ok && l < header.levelCount; l++)
+    {
+        LodFileLevel level;
+        ok = fread(&level, sizeof(level), 1, file) == 1 && level.vertexCount > 0 && level.vertexCount <= 65535 && level.triangleCount > 0;
+        if (!ok) break;
+
+        Mesh *mesh = &lod.meshes[lod.levelCount++];
+        mesh->vertexCount = level.vertexCount;
+        mesh->triangleCount = level.triangleCount;
+        mesh->vertices = MemAlloc(sizeof(float)*3*level.vertexCount);
+        ok = fread(mesh->vertices, sizeof(float)*3, level.vertexCount, file) == (size_t)level.vertexCount;
+        if (ok && level.hasNormals)
+        {
+            mesh->normals = MemAlloc(sizeof(float)*3*level.vertexCount);
+            ok = fread(mesh->normals, sizeof(float)*3, level.vertexCount, file) == (size_t)level.vertexCount;
+        }
+        if (ok && level.hasTexcoords)
+        {
+            mesh->texcoords = MemAlloc(sizeof(float)*2*level.vertexCount);
+            ok = fread(mesh->texcoords, sizeof(float)*2, level.vertexCount, file) == (size_t)level.vertexCount;
+        }
+        mesh->indices = MemAlloc(sizeof(unsigned short)*3*level.triangleCount);
+        ok = ok && fread(mesh->indices, sizeof(unsigned short)*3, level.triangleCount, file) == (size_t)level.triangleCount;
+        for (int32_t i = 0; ok && i < level.triangleCount*3; i++) ok = mesh->indices[i] < level.vertexCount;
+    }
+    fclose(file);
+
+    MemChargeTagged(MEM_TAG_ASSETS, LodModelMemorySize(&lod));
+    if (!ok) UnloadLodModel(&lod);
+    return lod;
+}
+
+bool IsLodModelReady(const LodModel *lod)
+{
+    return lod->levelCount > 0;
+}
+
+void UploadLodModel(LodModel *lod)
+{
+    for (int32_t l = 0; l < lod->levelCount; l++) UploadMesh(&lod->meshes[l], false);
+    lod->uploaded = true;
+}
+
+void UnloadLodModel(LodModel *lod)
+{
+    MemReleaseTagged(MEM_TAG_ASSETS, LodModelMemorySize(lod));
+    for (int32_t l = 0; l < lod->levelCount; l++)
+    {
+        Mesh *mesh = &lod->meshes[l];
+        if (lod->uploaded) UnloadMesh(*mesh);
+        else
+        {
+            MemFree(mesh->vertices);
+            MemFree(mesh->normals);
+            MemFree(mesh->texcoords);
+            MemFree(mesh->indices);
+        }
+    }
+    *lod = (LodModel){ 0 };
+}
+
+LodInstances LoadLodInstances(int32_t capacity)
+{
+    LodInstances instances = { 0 };
+    instances.x = MemCallocTagged(MEM_TAG_RENDER, capacity, sizeof(float));
+    instances.y = MemCallocTagged(MEM_TAG_RENDER, capacity, sizeof(float));
+    instances.z = MemCallocTagged(MEM_TAG_RENDER, capacity, sizeof(float));
+    instances.scale = MemCallocTagged(MEM_TAG_RENDER, capacity, sizeof(float));
+    instances.level = MemCallocTagged(MEM_TAG_RENDER, capacity, sizeof(uint8_t));
+    instances.visible = MemCallocTagged(MEM_TAG_RENDER, capacity, sizeof(int32_t));
+    instances.size = MemCallocTagged(MEM_TAG_RENDER, capacity, sizeof(float));
+    instances.packedLevel = MemCallocTagged(MEM_TAG_RENDER, capacity, sizeof(uint8_t));
+    if (instances.x && instances.y && instances.z && instances.scale && instances.level && instances.visible && instances.size &&
+        instances.packedLevel)
+    {
+        instances.capacity = capacity;
+    }
+    return instances;
+}
+
+void UnloadLodInstances(LodInstances *instances)
+{
+    MemFreeTagged(instances->x);
+    MemFreeTagged(instances->y);
+    MemFreeTagged(instances->z);
+    MemFreeTagged(instances->scale);
+    MemFreeTagged(instances->level);
+    MemFreeTagged(instances->visible);
+    MemFreeTagged(instances->size);
+    MemFreeTagged(instances->packedLevel);
+    *instances = (LodInstances){ 0 };
+}
+
+int32_t AddLodInstance(LodInstances *instances, Vector3 position, float scale)
+{
+    if (instances->count >= instances->capacity) return -1;
+
+    int32_t id = instances->count++;
+    instances->x[id] = position.x;
+    instances->y[id] = position.y;
+    instances->z[id] = position.z;
+    instances->scale[id] = scale;
+    instances->level[id] = 0;
+    return id;
+}
+
+// Branchless level pick over packed arrays, vectorizes. lower/upper are the
+// thresholds shrunk and grown by the hysteresis band: an instance only
+// coarsens once it is clearly below a threshold and only refines once it is
+// clearly above it, otherwise it keeps its current level.
+static void LodSelectPacked(const float *restrict size, uint8_t *restrict level, int32_t count, const float *lower, const float *upper)
+{
+    for (int32_t i = 0; i < count; i++)
+    {
+        int32_t finest = 0, coarsest = 0;
+        for (int32_t l = 1; l < LOD_MAX_LEVELS; l++)
+        {
+            finest += size[i] < lower[l];
+            coarsest += size[i] < upper[l];
+        }
+        int32_t current = level[i];
+        current = (current < finest) ? finest : current;
+        current = (current > coarsest) ? coarsest : current;
+        level[i] = (uint8_t)current;
+    }
+}
+
+void SelectLodLevels(const LodModel *lod, LodInstances *instances, Camera camera, int screenHeight)
+{
+    const int32_t count = instances->visibleCount;
+    const int32_t *restrict visible = instances->visible;
+    const float *restrict x = instances->x;
+    const float *restrict y = instances->y;
+    const float *restrict z = instances->z;
+    const float *restrict scale = instances->scale;
+    float *restrict size = instances->size;
+    uint8_t *restrict packed = instances->packedLevel;
+
+    for (int32_t i = 0; i < count; i++) packed[i] = instances->level[visible[i]];
+    if (camera.projection == CAMERA_PERSPECTIVE)
+    {
+        const float diameter = 2.0f*lod->radius*screenHeight/(2.0f*tanf(camera.fovy*DEG2RAD*0.5f));
+        for (int32_t i = 0; i < count; i++)
+        {
+            const int32_t j = visible[i];
+            const float dx = x[j] - camera.position.x, dy = y[j] - camera.position.y, dz = z[j] - camera.position.z;
+            size[i] = diameter*scale[j]/sqrtf(dx*dx + dy*dy + dz*dz + 1e-6f);
+        }
+    }
+    else
+    {
+        // fovy is the view height in world units
+        const float diameter = 2.0f*lod->radius*screenHeight/camera.fovy;
+        for (int32_t i = 0; i < count; i++) size[i] = diameter*scale[visible[i]];
+    }
+
+    // levels the model does not have get a threshold nothing is below
+    float lower[LOD_MAX_LEVELS] = { 0 }, upper[LOD_MAX_LEVELS] = { 0 };
+    for (int32_t l = 1; l < lod->levelCount; l++)
+    {
+        lower[l] = lod->screenSizes[l]*(1.0f - LOD_HYSTERESIS);
+        upper[l] = lod->screenSizes[l]*(1.0f + LOD_HYSTERESIS);
+    }
+    LodSelectPacked(size, packed, count, lower, upper);
+    for (int32_t i = 0; i < count; i++) instances->level[visible[i]] = packed[i];
+}
+
+void DrawLodInstances(const LodModel *lod, const LodInstances *instances, Material material)
+{
+    for (int32_t i = 0; i < instances->visibleCount; i++)
+    {
+        const int32_t j = instances->visible[i];
+        const float s = instances->scale[j];
+        Matrix transform = {
+            s, 0.0f, 0.0f, instances->x[j],
+            0.0f, s, 0.0f, instances->y[j],
+            0.0f, 0.0f, s, instances->z[j],
+            0.0f, 0.0f, 0.0f, 1.0f
+        };
+        DrawMesh(lod->meshes[instances->level[j]], material, transform);
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef LOD_H
+#define LOD_H
+
+#include "raylib.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Distance based level of detail for props and player models.
+// A LodModel carries LOD_MAX_LEVELS meshes simplified offline (tools/lod_bake.c,
+// make lod) and the projected sizes at which each level takes over. Instances
+// are kept SoA; every frame the caller lists the visible ones and
+// SelectLodLevels() picks their levels in one pass over packed arrays, with
+// hysteresis so an instance sitting on a threshold does not pop back and forth.
+
+#define LOD_MAX_LEVELS 4
+#define LOD_HYSTERESIS 0.15f        // fraction of a threshold an instance must cross to switch
+#define LOD_FILE_VERSION 1
+
+typedef struct {
+    int32_t levelCount;
+    Mesh meshes[LOD_MAX_LEVELS];    // finest first, indexed
+    float radius;                   // bounding sphere around the model origin
+    float screenSizes[LOD_MAX_LEVELS];  // level l is used below screenSizes[l] pixels, [0] unused
+    bool uploaded;
+} LodModel;
+
+typedef struct {
+    int32_t capacity;
+    int32_t count;
+    float *x;
+    float *y;
+    float *z;
+    float *scale;
+    uint8_t *level;                 // current level, persistent for the hysteresis
+    int32_t visibleCount;
+    int32_t *visible;               // filled by the caller every frame
+    float *size;                    // scratch, projected diameter of each visible instance
+    uint8_t *packedLevel;           // scratch, levels of the visible instances gathered
+} LodInstances;
+
+// Simplifies mesh into levelCount levels (CPU side), ratios of the source triangle
+// count or NULL for 1, 1/2, 1/4, 1/10
+LodModel BuildLodModel(const Mesh *mesh, int32_t levelCount, const float *ratios);
+bool SaveLodModel(const LodModel *lod, const char *fileName);
+LodModel LoadLodModel(const char *fileName);
+bool IsLodModelReady(const LodModel *lod);
+void UploadLodModel(LodModel *lod);
+void UnloadLodModel(LodModel *lod);
+
+LodInstances LoadLodInstances(int32_t capacity);
+void UnloadLodInstances(LodInstances *instances);
+int32_t AddLodInstance(LodInstances *instances, Vector3 position, float scale);
+
+void SelectLodLevels(const LodModel *lod, LodInstances *instances, Camera camera, int screenHeight);
+// Call inside BeginMode3D() after SelectLodLevels()
+void DrawLodInstances(const LodModel *lod, const LodInstances *instances, Material material);
+
+#endif
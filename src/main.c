@@ -2,9 +2,37 @@
 #include "raylib.h"
 #define RCAMERA_IMPLEMENTATION
 #include "rcamera.h"
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <string.h>
+#include "assets.h"
+#include "atlas.h"
+#include "bundle.h"
+#include "decals.h"
+#include "dynres.h"
+#include "filewatch.h"
+#include "framecapture.h"
+#include "framestats.h"
+#include "grid.h"
+#include "headless.h"
+#include "hud.h"
+#include "jobs.h"
+#include "levelfile.h"
+#include "levelmesh.h"
+#include "levelstream.h"
+#include "lightbake.h"
+#include "lod.h"
+#include "memtrack.h"
+#include "particles.h"
+#include "profiler.h"
+#include "pvs.h"
+#include "rlstats.h"
+#include "softbackend.h"
+#include "spritebatch.h"
+#include "startup.h"
+#include "text.h"
 
 #define MAX_COLUMNS 12
 
@@ -14,6 +42,9 @@ typedef struct
 {
     char text[256];
     int32_t index;
+    bool showRenderStats;
+    bool showFrameGraph;
+    bool showMemoryStats;
 } DevConsole;
 
 typedef struct
@@ -31,27 +62,95 @@ typedef struct {
     int32_t height;
 } W_info; 
 
-void render_3d(Camera *camera, Texture2D *ye, Vector3 positions[MAX_COLUMNS], Color colors[MAX_COLUMNS], float heights[MAX_COLUMNS], int *cameraMode);
+// struct with the sprite atlas asset, the sprite ids resolved against its
+// live version and the batches every billboard and 2D quad of the frame goes through
+typedef struct {
+    int32_t atlas;                  // asset id
+    uint32_t atlasVersion;          // the ids below belong to this version
+    int32_t ye;
+    SpriteBatch world;
+    SpriteBatch screen;
+} Sprites;
+
+// struct with the level placement and data baked from the cubicmap
+typedef struct {
+    Vector3 position;
+    OccupancyGrid grid;
+    PVS pvs;
+    LevelMesh mesh;                 // chunks come and go with the stream
+    LevelFile file;                 // when ready grid, pvs and mesh point into it
+    LevelLighting lighting;         // ye.png levels, applied to chunks as they are meshed
+    LevelStream *stream;
+} LevelInfo;
+
+// struct with a level being rebuilt on a worker after its files changed,
+// swapped in at the start of a frame once ready
+typedef struct {
+    LevelInfo next;
+    bool busy;
+    bool again;                     // files changed again while busy
+    bool rebake;                    // ye.png changed: PVS and lighting are baked again, not dropped
+    bool rebakeAgain;               // for the reload after this one
+    long pvsWritten;                // what the last rebake wrote, no reason to reload again
+    long lightWritten;
+    bool ok;
+    atomic_bool done;               // set by the worker
+    double start;
+} LevelReload;
+
+// struct with the particle effects and the emitters the weapons use
+typedef struct {
+    ParticleSystem particles;
+    ParticleRenderer renderer;
+    int32_t muzzleFlash;
+    int32_t tracer;
+    int32_t impact;
+    DecalManager *decals;
+    int32_t decalPage;
+} Effects;
+
+// struct with the props sitting on the columns, drawn through the LOD system
+typedef struct {
+    int32_t model;              // asset id
+    LodInstances instances;     // one per column, same index
+    Material material;
+} Props;
+
+void render_3d(Camera *camera, Sprites *sprites, Vector3 positions[MAX_COLUMNS], Color colors[MAX_COLUMNS], float heights[MAX_COLUMNS], int *cameraMode, const LevelInfo *level, Effects *effects, Props *props);
 
-void pauseMenu(Camera *camera, L_KEYPRESSES *lkeys, Texture2D *ye, Vector3 positions[MAX_COLUMNS], Color colors[MAX_COLUMNS], float heights[MAX_COLUMNS], int *cameraMode) {
+void pauseMenu(Camera *camera, L_KEYPRESSES *lkeys, Sprites *sprites, Vector3 positions[MAX_COLUMNS], Color colors[MAX_COLUMNS], float heights[MAX_COLUMNS], int *cameraMode, const LevelInfo *level, Effects *effects, Props *props, DynamicResolution *dynres, const TextRenderer *text) {
+    PROFILE_ZONE("pauseMenu");
     if (!lkeys->cursorEnabled)
     {
         EnableCursor();
         lkeys->cursorEnabled = true;
     }
     
+    BeginDynamicResolution(dynres);
+    ClearBackground(WHITE);
+    render_3d(camera, sprites, positions, colors, heights, cameraMode, level, effects, props);
+    EndDynamicResolution(dynres);
+
     BeginDrawing();
     ClearBackground(WHITE);
-    render_3d(camera, ye, positions, colors, heights, cameraMode);
-    DrawRectangle(GetScreenWidth()/2-100, GetScreenHeight()/2-100, 200, 200, WHITE );
-    DrawText("Paused", 5, GetScreenHeight() - 25, 20, BLACK);
+    DrawDynamicResolution(dynres);
+    AddSpriteRectangle(&sprites->screen, (Rectangle){ GetScreenWidth()/2-100, GetScreenHeight()/2-100, 200, 200 }, WHITE);
+    DrawSpriteBatch(&sprites->screen);
+    BeginText(text);
+    DrawTextSdf(text, "Paused", 5, GetScreenHeight() - 25, 20, BLACK);
+    EndText();
+    UpdateFrameCapture();
     EndDrawing();
 }
 
-void render_3d(Camera *camera, Texture2D *ye, Vector3 positions[MAX_COLUMNS], Color colors[MAX_COLUMNS], float heights[MAX_COLUMNS], int *cameraMode) {
-    
+void render_3d(Camera *camera, Sprites *sprites, Vector3 positions[MAX_COLUMNS], Color colors[MAX_COLUMNS], float heights[MAX_COLUMNS], int *cameraMode, const LevelInfo *level, Effects *effects, Props *props) {
+    PROFILE_ZONE("render_3d");
+    BeginFrameSystem("render 3d");
+
     BeginMode3D(*camera);
 
+    DrawLevelMesh(&level->mesh, &level->grid, &level->pvs, level->position, camera->position);
+
     DrawPlane((Vector3){ 0.0f, 0.0f, 0.0f }, (Vector2){ 32.0f, 32.0f }, LIGHTGRAY); // Draw ground
     DrawCube((Vector3){ -16.0f, 2.5f, 0.0f }, 1.0f, 5.0f, 32.0f, BLUE);     // Draw a blue wall
     DrawCube((Vector3){ 16.0f, 2.5f, 0.0f }, 1.0f, 5.0f, 32.0f, LIME);      // Draw a green wall
@@ -59,22 +158,41 @@ void render_3d(Camera *camera, Texture2D *ye, Vector3 positions[MAX_COLUMNS], Co
 
     ///////////////////////////
 
-DrawTexturePro(*ye,
-    (Rectangle){ 0.0f, 0.0f, ye->width, ye->height }, // source rectangle
-    (Rectangle){ 2.0f, 2.0f, -ye->width / 25.0f, ye->height / 25.0f }, // destination rectangle scaled down by 100x
-    (Vector2){ ye->width / 200.0f, ye->height / 200.0f }, // origin
-    0.0f, // rotation angle
-    WHITE // tint
-);
+const SpriteAtlas *atlas = GetAssetSpriteAtlas(sprites->atlas);
+if (GetAssetVersion(sprites->atlas) != sprites->atlasVersion)
+{
+    // sprite ids only mean something in the atlas they came from
+    sprites->atlasVersion = GetAssetVersion(sprites->atlas);
+    sprites->ye = GetAtlasSpriteIndex(atlas, "ye");
+}
+if (sprites->ye >= 0)
+{
+    const AtlasSprite *ye = &atlas->sprites[sprites->ye];
+    AddSprite(&sprites->world, atlas->textures[ye->page], ye->source,
+        (Vector3){ -8.0f, 8.0f, 0.0f }, // center of the flat quad it replaces, x -16..0 and y 0..16
+        (Vector2){ ye->source.width / 25.0f, ye->source.height / 25.0f }, // scaled down by 25x
+        0.0f, WHITE);
+}
+else
+{
+    Texture2D placeholder = GetPlaceholderTexture();
+    AddSprite(&sprites->world, placeholder, (Rectangle){ 0, 0, placeholder.width, placeholder.height },
+        (Vector3){ -8.0f, 8.0f, 0.0f }, (Vector2){ 2.0f, 2.0f }, 0.0f, WHITE);
+}
 
 
     //////////////////////////
 
+    props->instances.visibleCount = 0;
     for (int i = 0; i < MAX_COLUMNS; i++)
     {
         DrawCube(positions[i], 2.0f, heights[i], 2.0f, colors[i]);
         // DrawCubeWires(positions[i], 2.0f, heights[i], 2.0f, MAROON);
+        props->instances.visible[props->instances.visibleCount++] = i;
     }
+    const LodModel *model = GetAssetLodModel(props->model);
+    SelectLodLevels(model, &props->instances, *camera, GetScreenHeight());
+    DrawLodInstances(model, &props->instances, props->material);
 
     // Draw player cube
     if (*cameraMode == CAMERA_THIRD_PERSON)
@@ -83,12 +201,352 @@ DrawTexturePro(*ye,
         DrawCubeWires(camera->target, 0.5f, 0.5f, 0.5f, DARKPURPLE);
     }
 
+    DrawDecals(effects->decals, &level->pvs, camera->position);
+    DrawSpriteBatch(&sprites->world);
+    DrawParticleSystem(&effects->renderer, &effects->particles);
+
     EndMode3D();
+    EndFrameSystem("render 3d");
+}
+
+Props load_props(Vector3 positions[MAX_COLUMNS], float heights[MAX_COLUMNS])
+{
+    Props props = { 0 };
+    // decoded on a worker, the placeholder cube stands in until it is uploaded
+    if (AssetFileExists("props.lod")) props.model = LoadLodModelAsync("props.lod");
+    else
+    {
+        printf("props.lod missing, simplifying at startup (make lod)\n");
+        Mesh sphere = GenMeshSphere(1.0f, 48, 48);
+        MemChargeTagged(MEM_TAG_ASSETS, GetMeshMemorySize(&sphere));
+        props.model = AddLodModelAsset("props.lod:sphere", BuildLodModel(&sphere, LOD_MAX_LEVELS, NULL));
+        MemReleaseTagged(MEM_TAG_ASSETS, GetMeshMemorySize(&sphere));
+        UnloadMesh(sphere);
+    }
+
+    props.material = LoadMaterialDefault();
+    props.material.maps[MATERIAL_MAP_DIFFUSE].color = GRAY;
+    props.instances = LoadLodInstances(MAX_COLUMNS);
+    for (int i = 0; i < MAX_COLUMNS; i++)
+    {
+        AddLodInstance(&props.instances, (Vector3){ positions[i].x, heights[i] + 0.75f, positions[i].z }, 0.75f);
+    }
+    return props;
+}
+
+void unload_props(Props *props)
+{
+    UnloadLodInstances(&props->instances);
+    UnloadMaterial(props->material);
+    ReleaseAsset(props->model);
+}
+
+// ye.png decoded into an occupancy grid, false when there is no ye.png
+bool load_map_grid(OccupancyGrid *grid)
+{
+    Image map = LoadImage("ye.png");
+    if (!IsImageReady(map)) return false;
+    ImageFlipVertical(&map);
+    Color *mapPixels = LoadImageColors(map);
+    size_t mapBytes = GetImageMemorySize(map) + sizeof(Color)*map.width*map.height;
+    MemChargeTagged(MEM_TAG_ASSETS, mapBytes);
+    *grid = LoadOccupancyGrid(mapPixels, map.width, map.height);
+    MemReleaseTagged(MEM_TAG_ASSETS, mapBytes);
+    UnloadImageColors(mapPixels);
+    UnloadImage(map);
+    return true;
+}
+
+// CPU side of the level, safe on a worker; stream_level() it on the raylib thread.
+// The compiled level (--bake-level) is mapped, or taken from the bundle, and used as is;
+// ye.png is only decoded without it, its chunks are meshed as they stream in.
+// The bundled ye.lvl has no date to check against ye.png, it is only used
+// while ye.png on disk (if any) is still the map it was compiled from.
+bool load_level(LevelInfo *level)
+{
+    *level = (LevelInfo){ .file = LoadLevelFile("ye.lvl") };
+    if (IsLevelFileReady(&level->file) && !level->file.bundled && GetFileModTime("ye.png") > GetFileModTime("ye.lvl"))
+    {
+        printf("ye.lvl is older than ye.png, run with --bake-level\n");
+        UnloadLevelFile(&level->file);
+    }
+
+    OccupancyGrid map = { 0 };
+    bool mapLoaded = (!IsLevelFileReady(&level->file) || level->file.bundled) && load_map_grid(&map);
+    if (IsLevelFileReady(&level->file) && mapLoaded)
+    {
+        OccupancyGrid bundled = GetLevelFileGrid(&level->file);
+        if (bundled.width != map.width || bundled.height != map.height ||
+            memcmp(bundled.solid, map.solid, (size_t)map.width*map.height) != 0)
+        {
+            printf("ye.png changed since the bundled ye.lvl was compiled, using ye.png\n");
+            UnloadLevelFile(&level->file);
+        }
+    }
+
+    if (IsLevelFileReady(&level->file))
+    {
+        if (mapLoaded) UnloadOccupancyGrid(&map);
+        level->grid = GetLevelFileGrid(&level->file);
+        level->pvs = GetLevelFilePVS(&level->file);
+        level->mesh = GetLevelFileMesh(&level->file);
+    }
+    else
+    {
+        if (!mapLoaded) return false;
+        level->grid = map;
+        // a PVS baked for an older map would cull chunks that are there now
+        if (GetFileModTime("ye.pvs") >= GetFileModTime("ye.png")) level->pvs = LoadPVS("ye.pvs");
+        if (IsPVSReady(&level->pvs) && !PVSMatchesGrid(&level->pvs, &level->grid))
+        {
+            printf("ye.pvs does not match ye.png, run with --bake-pvs\n");
+            UnloadPVS(&level->pvs);
+        }
+        level->mesh = GenLevelMeshLayout(&level->grid);
+        if (GetFileModTime("ye.light") >= GetFileModTime("ye.png")) level->lighting = LoadLevelLighting("ye.light");
+        if (level->lighting.chunkCount != level->mesh.chunkCount)
+        {
+            printf("No baked lighting for ye.png, run with --bake-light\n");
+            UnloadLevelLighting(&level->lighting);
+        }
+    }
+    // slightly sunk so the level floor does not z-fight with the arena ground
+    level->position = (Vector3){ -level->grid.width/2.0f, -0.01f, -level->grid.height/2.0f };
+    return true;
+}
+
+// GPU side, nothing is resident until the chunks around the camera are
+void stream_level(LevelInfo *level, Vector3 cameraPosition)
+{
+    level->stream = LoadLevelStream(&level->mesh, &level->grid, &level->file, &level->lighting);
+    FillLevelStream(level->stream, &level->mesh, level->position, cameraPosition);
+}
+
+void unload_level(LevelInfo *level)
+{
+    UnloadLevelStream(level->stream);
+    UnloadLevelMesh(&level->mesh);
+    UnloadLevelLighting(&level->lighting);
+    if (IsLevelFileReady(&level->file)) UnloadLevelFile(&level->file);
+    else
+    {
+        UnloadPVS(&level->pvs);
+        UnloadOccupancyGrid(&level->grid);
+    }
+}
+
+Effects load_effects(const LevelInfo *level)
+{
+    Effects effects = {
+        .particles = LoadParticleSystem(8192),
+        .renderer = LoadParticleRenderer(8192)
+    };
+
+    effects.muzzleFlash = AddParticleEmitter(&effects.particles, (ParticleEmitterDesc){
+        .speedMin = 0.5f, .speedMax = 2.0f, .spread = 0.6f,
+        .lifetimeMin = 0.04f, .lifetimeMax = 0.08f,
+        .sizeStart = 0.25f, .sizeEnd = 0.05f, .drag = 8.0f,
+        .colorStart = (Color){ 255, 230, 120, 255 }, .colorEnd = (Color){ 255, 120, 0, 0 }
+    }, 1024);
+    effects.tracer = AddParticleEmitter(&effects.particles, (ParticleEmitterDesc){
+        .speedMin = 0.0f, .speedMax = 0.1f, .spread = 0.0f,
+        .lifetimeMin = 0.05f, .lifetimeMax = 0.12f,
+        .sizeStart = 0.06f, .sizeEnd = 0.02f,
+        .colorStart = (Color){ 255, 255, 200, 220 }, .colorEnd = (Color){ 255, 200, 100, 0 }
+    }, 4096);
+    effects.impact = AddParticleEmitter(&effects.particles, (ParticleEmitterDesc){
+        .speedMin = 1.5f, .speedMax = 4.0f, .spread = 1.2f,
+        .lifetimeMin = 0.2f, .lifetimeMax = 0.5f,
+        .sizeStart = 0.08f, .sizeEnd = 0.02f, .gravity = 9.8f, .drag = 1.0f,
+        .colorStart = (Color){ 255, 200, 80, 255 }, .colorEnd = (Color){ 80, 80, 80, 0 }
+    }, 3072);
+
+    // decal atlas page: bullet hole on the left, scorch mark on the right
+    effects.decals = LoadDecalManager(level->grid.width, level->grid.height, level->position);
+    Image atlas = GenImageColor(128, 64, BLANK);
+    Image hole = GenImageGradientRadial(64, 64, 0.4f, BLACK, BLANK);
+    Image scorch = GenImageGradientRadial(64, 64, 0.0f, (Color){ 30, 30, 30, 200 }, BLANK);
+    size_t decalBytes = GetImageMemorySize(atlas) + GetImageMemorySize(hole) + GetImageMemorySize(scorch);
+    MemChargeTagged(MEM_TAG_RENDER, decalBytes);
+    ImageDraw(&atlas, hole, (Rectangle){ 0, 0, 64, 64 }, (Rectangle){ 0, 0, 64, 64 }, WHITE);
+    ImageDraw(&atlas, scorch, (Rectangle){ 0, 0, 64, 64 }, (Rectangle){ 64, 0, 64, 64 }, WHITE);
+    effects.decalPage = AddDecalPage(effects.decals, LoadTextureFromImage(atlas));
+    MemReleaseTagged(MEM_TAG_RENDER, decalBytes);
+    UnloadImage(scorch);
+    UnloadImage(hole);
+    UnloadImage(atlas);
+
+    return effects;
+}
+
+void unload_effects(Effects *effects)
+{
+    UnloadParticleRenderer(&effects->renderer);
+    UnloadParticleSystem(&effects->particles);
+    UnloadDecalManager(effects->decals);
+}
+
+// A changed ye.png leaves ye.pvs and ye.light stale, load_level() drops them.
+// Baked again here on the reload's worker, both written at the end so the
+// watcher sees them change together.
+void rebake_level(LevelInfo *level)
+{
+    if (IsLevelFileReady(&level->file)) return;
+
+    double start = GetTime();
+    bool bakePvs = !IsPVSReady(&level->pvs);
+    bool bakeLight = (level->lighting.chunkCount == 0);
+    if (bakePvs) level->pvs = BakePVS(&level->grid);
+    if (bakeLight)
+    {
+        // the bake wants every chunk meshed, the stream only meshes what is near
+        LevelMesh full = GenLevelMesh(&level->grid);
+        level->lighting = BakeLevelLighting(&full, &level->grid, GetDefaultLightBakeSettings());
+        UnloadLevelMesh(&full);
+    }
+    if (bakePvs && !SavePVS(&level->pvs, "ye.pvs")) printf("Level: cannot write ye.pvs\n");
+    if (bakeLight && !SaveLevelLighting(&level->lighting, "ye.light")) printf("Level: cannot write ye.light\n");
+    if (bakePvs || bakeLight) printf("Level: %s%s%s baked again in %.1f ms\n", bakePvs ? "ye.pvs" : "", (bakePvs && bakeLight) ? " and " : "",
+                                     bakeLight ? "ye.light" : "", (GetTime() - start)*1000.0);
+}
+
+void reload_level_job(void *user)
+{
+    LevelReload *reload = user;
+    reload->ok = load_level(&reload->next);
+    if (reload->ok && reload->rebake) rebake_level(&reload->next);
+    atomic_store(&reload->done, true);
+}
+
+void start_level_reload(LevelReload *reload, bool rebake)
+{
+    if (reload->busy)
+    {
+        reload->again = true;
+        reload->rebakeAgain = reload->rebakeAgain || rebake;
+        return;
+    }
+    reload->busy = true;
+    reload->again = false;
+    reload->rebake = rebake;
+    reload->rebakeAgain = false;
+    reload->start = GetTime();
+    atomic_store(&reload->done, false);
+    JobsSubmit(reload_level_job, reload);
+}
+
+// Hot reload: a debounced batch of changed files is decoded or re-baked on
+// workers, nothing the frame uses is touched until it is ready
+void hot_reload(const FileChangeBatch *changes, LevelReload *reload)
+{
+    for (int32_t i = 0; i < changes->count; i++)
+    {
+        int32_t assets = ReloadAssetFile(changes->files[i]);
+        if (assets > 0) printf("Reloading %s\n", changes->files[i]);
+    }
+    bool map = IsFileInBatch(changes, "ye.png");
+    bool pvs = IsFileInBatch(changes, "ye.pvs") && GetFileModTime("ye.pvs") != reload->pvsWritten;
+    bool light = IsFileInBatch(changes, "ye.light") && GetFileModTime("ye.light") != reload->lightWritten;
+    if (map || pvs || light || IsFileInBatch(changes, "ye.lvl")) start_level_reload(reload, map);
+}
+
+// Start of a frame, nothing holds on to the old level past this point
+void swap_level(LevelReload *reload, LevelInfo *level, Effects *effects)
+{
+    if (!reload->busy || !atomic_load(&reload->done)) return;
+
+    reload->busy = false;
+    if (reload->rebake)
+    {
+        reload->pvsWritten = GetFileModTime("ye.pvs");
+        reload->lightWritten = GetFileModTime("ye.light");
+    }
+    if (reload->ok)
+    {
+        // no FillLevelStream(), UpdateLevelStream() brings the chunks in over the next frames
+        reload->next.stream = LoadLevelStream(&reload->next.mesh, &reload->next.grid, &reload->next.file, &reload->next.lighting);
+        unload_level(level);
+        *level = reload->next;
+        // decals are bucketed by the grid of the old level
+        unload_effects(effects);
+        *effects = load_effects(level);
+        printf("Level: reloaded from %s in %.1f ms\n", IsLevelFileReady(&level->file) ? "ye.lvl" : "ye.png", (GetTime() - reload->start)*1000.0);
+    }
+    else printf("Level: reload failed, keeping the current one\n");
+    if (reload->again) start_level_reload(reload, reload->rebakeAgain);
+}
+
+// Hitscan from the camera against the arena and the level's walls, spawns muzzle flash, tracer and impact effects
+void fire_weapon(Camera *camera, const LevelInfo *level, Effects *effects, Vector3 positions[MAX_COLUMNS], float heights[MAX_COLUMNS])
+{
+    Ray ray = { camera->position, Vector3Normalize(Vector3Subtract(camera->target, camera->position)) };
+    RayCollision hit = { .hit = false, .distance = 100.0f };
+
+    if (ray.direction.y < 0.0f)
+    {
+        hit.distance = -ray.position.y/ray.direction.y;
+        hit.point = Vector3Add(ray.position, Vector3Scale(ray.direction, hit.distance));
+        hit.normal = (Vector3){ 0.0f, 1.0f, 0.0f };
+        hit.hit = true;
+    }
+
+    BoundingBox boxes[MAX_COLUMNS + 3] = {
+        { { -16.5f, 0.0f, -16.0f }, { -15.5f, 5.0f, 16.0f } },
+        { { 15.5f, 0.0f, -16.0f }, { 16.5f, 5.0f, 16.0f } },
+        { { -16.0f, 0.0f, 15.5f }, { 16.0f, 5.0f, 16.5f } }
+    };
+    for (int i = 0; i < MAX_COLUMNS; i++)
+    {
+        boxes[i + 3] = (BoundingBox){
+            { positions[i].x - 1.0f, positions[i].y - heights[i]/2.0f, positions[i].z - 1.0f },
+            { positions[i].x + 1.0f, positions[i].y + heights[i]/2.0f, positions[i].z + 1.0f }
+        };
+    }
+    for (int i = 0; i < MAX_COLUMNS + 3; i++)
+    {
+        RayCollision boxHit = GetRayCollisionBox(ray, boxes[i]);
+        if (boxHit.hit && boxHit.distance < hit.distance) hit = boxHit;
+    }
+    // only as far as the closest hit so far, the walk stops there
+    RayCollision wallHit = GridRaycast(&level->grid, level->position, ray, hit.distance);
+    if (wallHit.hit) hit = wallHit;
+
+    Vector3 muzzle = Vector3Add(ray.position, Vector3Scale(ray.direction, 0.5f));
+    muzzle.y -= 0.15f;
+    Vector3 end = hit.hit ? hit.point : Vector3Add(ray.position, Vector3Scale(ray.direction, hit.distance));
+    Vector3 trail = Vector3Subtract(end, muzzle);
+
+    EmitParticles(&effects->particles, effects->muzzleFlash, muzzle, ray.direction, 24);
+    // tracer is a line of nearly static particles, the emitter stretch covers the whole shot
+    effects->particles.emitters[effects->tracer].desc.stretch = Vector3Length(trail);
+    EmitParticles(&effects->particles, effects->tracer, muzzle, trail, (int32_t)(Vector3Length(trail)*8.0f) + 1);
+    if (hit.hit)
+    {
+        EmitParticles(&effects->particles, effects->impact, hit.point, hit.normal, 32);
+        // scorch marks on the floor, bullet holes everywhere else
+        bool floor = hit.normal.y > 0.5f;
+        AddDecal(effects->decals, effects->decalPage, (Rectangle){ floor ? 0.5f : 0.0f, 0.0f, 0.5f, 1.0f },
+            hit.point, hit.normal, floor ? 0.6f : 0.15f, (float)GetRandomValue(0, 359)*DEG2RAD, WHITE);
+    }
+}
+
+// Queues the next free screenshotNNN.png, encoded off the main thread unlike raylib's F12
+void take_screenshot(void)
+{
+    // disk is only asked once: the last shot may still be waiting for the encoder
+    static int shot = -1;
+    if (shot < 0)
+    {
+        shot = 0;
+        while (FileExists(TextFormat("screenshot%03d.png", shot))) shot++;
+    }
+    RequestScreenshot(TextFormat("screenshot%03d.png", shot++));
 }
 
 // Handles inputs for fullscreen toggle, pause menu, window exit, etc...
 void custom_keypress_controls(L_KEYPRESSES *lkeys, W_info *w_info) 
 {
+    PROFILE_ZONE("custom_keypress_controls");
     if (IsKeyPressed(KEY_GRAVE))
     {
         lkeys->devconsole = !lkeys->devconsole;
@@ -105,6 +563,11 @@ void custom_keypress_controls(L_KEYPRESSES *lkeys, W_info *w_info)
         lkeys->paused = !lkeys->paused;
     }
         
+    if (IsKeyPressed(KEY_PRINT_SCREEN))
+    {
+        take_screenshot();
+    }
+
     if (IsKeyPressed(KEY_F11))
  	{
         if (!lkeys->borderless)
@@ -120,8 +583,50 @@ void custom_keypress_controls(L_KEYPRESSES *lkeys, W_info *w_info)
  		}
 }
 
-void Game(Camera *camera, DevConsole *cons, L_KEYPRESSES *lkeys, int *cameraMode, Texture2D *ye, Mesh mesh, Model model, Color* mapPixels, Vector3 positions[MAX_COLUMNS], Color colors[MAX_COLUMNS], float heights[MAX_COLUMNS])
+// runs the line typed in the dev console, letters arrive upper case
+void run_console_command(DevConsole *cons)
+{
+    int frames = 0;
+    if (strcmp(cons->text, "STATS") == 0) cons->showRenderStats = !cons->showRenderStats;
+    else if (strcmp(cons->text, "CAPTURE") == 0 || sscanf(cons->text, "CAPTURE %d", &frames) == 1)
+    {
+        if (frames <= 0) frames = 60;
+        if (StartDrawCapture("capture.drw", frames)) printf("Capturing %d frames to capture.drw\n", frames);
+    }
+    else if (strcmp(cons->text, "SCREENSHOT") == 0) take_screenshot();
+    else if (strcmp(cons->text, "RECORD") == 0 || sscanf(cons->text, "RECORD %d", &frames) == 1)
+    {
+        // QOI keeps up with the frame rate where PNG would drop most frames
+        int clip = 0;
+        if (frames <= 0) frames = 300;
+        while (FileExists(TextFormat("clip%03d_0000.qoi", clip))) clip++;
+        StartFrameSequence(TextFormat("clip%03d_", clip), ".qoi", frames);
+        printf("Recording %d frames to clip%03d_*.qoi\n", frames, clip);
+    }
+    else if (strcmp(cons->text, "GRAPH") == 0) cons->showFrameGraph = !cons->showFrameGraph;
+    else if (strcmp(cons->text, "MEMORY") == 0) cons->showMemoryStats = !cons->showMemoryStats;
+    else if (strcmp(cons->text, "FRAMECSV") == 0)
+    {
+        int dump = 0;
+        while (FileExists(TextFormat("frametimes%03d.csv", dump))) dump++;
+        bool ok = ExportFrameTimesCsv(TextFormat("frametimes%03d.csv", dump));
+        ok = ExportFrameStatsCsv(TextFormat("framestats%03d.csv", dump)) && ok;
+        printf("%s frametimes%03d.csv and framestats%03d.csv\n", ok ? "Wrote" : "Could not write", dump, dump);
+    }
+    else if (strcmp(cons->text, "TRACE") == 0)
+    {
+        int trace = 0;
+        while (FileExists(TextFormat("trace%03d.json", trace))) trace++;
+        const char *fileName = TextFormat("trace%03d.json", trace);
+        if (ExportProfilerTrace(fileName)) printf("Wrote %s, open it in ui.perfetto.dev\n", fileName);
+        else printf("Could not write %s\n", fileName);
+    }
+    else printf("Unknown command: %s\n", cons->text);
+}
+
+void Game(Camera *camera, DevConsole *cons, L_KEYPRESSES *lkeys, int *cameraMode, Sprites *sprites, Vector3 positions[MAX_COLUMNS], Color colors[MAX_COLUMNS], float heights[MAX_COLUMNS], const LevelInfo *level, Effects *effects, Props *props, HudLayer *hud, DynamicResolution *dynres, const TextRenderer *text)
 {
+    PROFILE_ZONE("Game");
     // Define the target update rate for the camera (60 times per second)
     const double targetUpdateRate = 1.0 / 60.0;
     static double timeAccumulator = 0.0;
@@ -134,19 +639,34 @@ void Game(Camera *camera, DevConsole *cons, L_KEYPRESSES *lkeys, int *cameraMode
         DisableCursor();
         lkeys->cursorEnabled = false;
     }
+    // 3D pass at the dynamic resolution scale, everything 2D below stays native
+    BeginDynamicResolution(dynres);
+    ClearBackground(RAYWHITE);
+    render_3d(camera, sprites, positions, colors, heights, cameraMode, level, effects, props);
+    EndDynamicResolution(dynres);
+
     BeginDrawing();
     ClearBackground(RAYWHITE);
-    render_3d(camera, ye, positions, colors, heights, cameraMode);
+    DrawDynamicResolution(dynres);
 
     if (lkeys->devconsole)
     {
-        DrawRectangle(4,GetScreenHeight()-4-24, 400, 24, (Color){0,0,0,200});
+        AddSpriteRectangle(&sprites->screen, (Rectangle){4,GetScreenHeight()-4-24, 400, 24}, (Color){0,0,0,200});
         // DrawRectangleLines(3,GetScreenHeight()-5-24, 402, 25, BLACK);
 		float conslinewidth = 1.0f;
-		DrawRectangleLinesEx((Rectangle){3+(-1*(int)conslinewidth+1),GetScreenHeight()-5-24+(-1*(int)conslinewidth+1), 401+((int)conslinewidth), 25+((int)conslinewidth)}, conslinewidth, BLACK);
-        DrawText(TextFormat("%s", cons->text), 6, GetScreenHeight()-3-22, 22, WHITE);
+		AddSpriteRectangleLines(&sprites->screen, (Rectangle){3+(-1*(int)conslinewidth+1),GetScreenHeight()-5-24+(-1*(int)conslinewidth+1), 401+((int)conslinewidth), 25+((int)conslinewidth)}, conslinewidth, BLACK);
+        DrawSpriteBatch(&sprites->screen);
+        BeginText(text);
+        DrawTextSdf(text, cons->text, 6, GetScreenHeight()-3-22, 22, WHITE);
+        EndText();
         int key = GetKeyPressed();
-        if (key > 0 && cons->index < 63 && cons->index >= 0)
+        if (key == KEY_ENTER && cons->index > 0)
+        {
+            run_console_command(cons);
+            memset(&cons->text, 0, 256);
+            cons->index = 0;
+        }
+        else if (key > 0 && cons->index < 63 && cons->index >= 0)
         {
             if ((key >= KEY_APOSTROPHE && key <= 90) || key == KEY_SPACE)
             {
@@ -173,6 +693,14 @@ void Game(Camera *camera, DevConsole *cons, L_KEYPRESSES *lkeys, int *cameraMode
     
     
 
+    PROFILE_BEGIN(simulation, "simulation");
+    BeginFrameSystem("simulation");
+    if (!lkeys->devconsole && IsMouseButtonPressed(MOUSE_BUTTON_LEFT))
+    {
+        fire_weapon(camera, level, effects, positions, heights);
+    }
+    UpdateParticleSystem(&effects->particles, GetFrameTime());
+
     // Check if it's time to update the camera
     while (timeAccumulator >= targetUpdateRate)
     {
@@ -197,40 +725,67 @@ void Game(Camera *camera, DevConsole *cons, L_KEYPRESSES *lkeys, int *cameraMode
                 GetMouseDelta().y * 0.05f,                            // Rotation: pitch
                 0.0f                                                // Rotation: roll
             },0);  
+    EndFrameSystem("simulation");
+    PROFILE_END(simulation);
 
     // Draw
     //----------------------------------------------------------------------------------
-    // render_3d(camera, ye, positions, colors, heights, cameraMode);
+    // render_3d(camera, sprites, positions, colors, heights, cameraMode);
     // Draw info boxes
-    DrawRectangle(5, 5, 330, 100, Fade(SKYBLUE, 0.5f));
-    DrawRectangleLines(5, 5, 330, 100, BLUE);
-	DrawCircle(GetScreenWidth()/2,GetScreenHeight()/2,5.0f,YELLOW);
-	DrawCircle(GetScreenWidth()/2,GetScreenHeight()/2,1.0f,BLACK);
-
-    DrawText("Camera controls:", 15, 15, 10, BLACK);
-    DrawText("- Move keys: W, A, S, D, Space, Left-Ctrl", 15, 30, 10, BLACK);
-    DrawText("- Look around: arrow keys or mouse", 15, 45, 10, BLACK);
-    DrawText("- Camera mode keys: 1, 2, 3, 4", 15, 60, 10, BLACK);
-    DrawText("- Zoom keys: num-plus, num-minus or mouse scroll", 15, 75, 10, BLACK);
-    DrawText("- Camera projection key: P", 15, 90, 10, BLACK);
-    DrawText(TextFormat("%d FPS", GetFPS()), 15, 110, 32, BLACK);
-
-    DrawRectangle(600, 5, 195, 100, Fade(SKYBLUE, 0.5f));
-    DrawRectangleLines(600, 5, 195, 100, BLUE);
-    
-
-    DrawText("Camera status:", 610, 15, 10, BLACK);
-    DrawText(TextFormat("- Mode: %s", (*cameraMode == CAMERA_FREE) ? "FREE" :
-                                      (*cameraMode == CAMERA_FIRST_PERSON) ? "FIRST_PERSON" :
-                                      (*cameraMode == CAMERA_THIRD_PERSON) ? "THIRD_PERSON" :
-                                      (*cameraMode == CAMERA_ORBITAL) ? "ORBITAL" : "CUSTOM"), 610, 30, 10, BLACK);
-    DrawText(TextFormat("- Projection: %s", (camera->projection == CAMERA_PERSPECTIVE) ? "PERSPECTIVE" :
-                                            (camera->projection == CAMERA_ORTHOGRAPHIC) ? "ORTHOGRAPHIC" : "CUSTOM"), 610, 45, 10, BLACK);
-    DrawText(TextFormat("- Position: (%06.3f, %06.3f, %06.3f)", camera->position.x, camera->position.y, camera->position.z), 610, 60, 10, BLACK);
-    DrawText(TextFormat("- Target: (%06.3f, %06.3f, %06.3f)", camera->target.x, camera->target.y, camera->target.z), 610, 75, 10, BLACK);
-    DrawText(TextFormat("- Up: (%06.3f, %06.3f, %06.3f)", camera->up.x, camera->up.y, camera->up.z), 610, 90, 10, BLACK);
+    // Info boxes are retained in the HUD layer, only changed fields get redrawn
+    PROFILE_BEGIN(overlay, "hud");
+    BeginFrameSystem("hud");
+    UpdateHudLayer(hud, camera, *cameraMode);
+    DrawHudLayer(hud);
+    if (cons->showRenderStats)
+    {
+        DrawStats stats = GetRenderStats();
+        BeginText(text);
+        DrawTextSdf(text, TextFormat("batches %d  draws %d  vertices %d  binds %d  meshes %d", stats.batches, stats.drawCalls,
+                                     stats.vertices, stats.textureBinds, stats.meshDraws), 10, HUD_HEIGHT + 5, 20, BLACK);
+        FrameCaptureStats capture = GetFrameCaptureStats();
+        DrawTextSdf(text, TextFormat("capture queued %d  written %d  dropped %d  readback %.2f ms", capture.queued, capture.written,
+                                     capture.dropped, capture.readbackMs), 10, HUD_HEIGHT + 30, 20, BLACK);
+        AssetStats assets = GetAssetStats();
+        DrawTextSdf(text, TextFormat("assets decoding %d  uploading %d  ready %d  failed %d  upload %.2f ms", assets.decoding,
+                                     assets.uploading, assets.ready, assets.failed, assets.uploadMs), 10, HUD_HEIGHT + 55, 20, BLACK);
+        DrawTextSdf(text, TextFormat("referenced %d  cached %d  evicted %u  images %.1f  textures %.1f  meshes %.1f MB", assets.referenced,
+                                     assets.cached, assets.evictions, assets.bytes[ASSET_MEMORY_CPU_IMAGES]/1048576.0f,
+                                     assets.bytes[ASSET_MEMORY_GPU_TEXTURES]/1048576.0f, assets.bytes[ASSET_MEMORY_MESHES]/1048576.0f),
+                    10, HUD_HEIGHT + 80, 20, BLACK);
+        LevelStreamStats stream = GetLevelStreamStats(level->stream);
+        DrawTextSdf(text, TextFormat("level chunks %d/%d  loading %d  waiting %d  loaded %u  evicted %u  %.1f MB", stream.resident,
+                                     LEVEL_STREAM_MAX_CHUNKS, stream.loading, stream.waiting, stream.loads, stream.evictions,
+                                     stream.bytes/1048576.0f), 10, HUD_HEIGHT + 105, 20, BLACK);
+        EndText();
+    }
+    if (cons->showMemoryStats)
+    {
+        BeginText(text);
+        DrawTextSdf(text, TextFormat("%-8s %10s %10s %9s %9s", "memory", "live MB", "peak MB", "allocs/s", "MB/s"), 10, HUD_HEIGHT + 135, 20, BLACK);
+        for (int i = 0; i < MEM_TAG_COUNT; i++)
+        {
+            MemTagStats memory = GetMemoryTagStats((MemTag)i);
+            DrawTextSdf(text, TextFormat("%-8s %10.2f %10.2f %9.0f %9.2f", GetMemoryTagName((MemTag)i), memory.live/1048576.0f,
+                                         memory.peak/1048576.0f, memory.allocationsPerSecond, memory.bytesPerSecond/1048576.0f),
+                        10, HUD_HEIGHT + 160 + 25*i, 20, BLACK);
+        }
+        EndText();
+    }
+    if (cons->showFrameGraph) DrawFrameStatsGraph(text, (Rectangle){ GetScreenWidth() - 510, HUD_HEIGHT + 5, 500, 340 });
+	AddSpriteCircle(&sprites->screen, (Vector2){ GetScreenWidth()/2, GetScreenHeight()/2 }, 5.0f, YELLOW);
+	AddSpriteCircle(&sprites->screen, (Vector2){ GetScreenWidth()/2, GetScreenHeight()/2 }, 1.0f, BLACK);
+	DrawSpriteBatch(&sprites->screen);
+    EndFrameSystem("hud");
+    PROFILE_END(overlay);
 
+    UpdateFrameCapture();
+    // swap and the frame limiter's wait
+    PROFILE_BEGIN(present, "EndDrawing");
+    BeginFrameSystem("present");
     EndDrawing();
+    EndFrameSystem("present");
+    PROFILE_END(present);
 }
 
 
@@ -241,16 +796,244 @@ void Game(Camera *camera, DevConsole *cons, L_KEYPRESSES *lkeys, int *cameraMode
 //------------------------------------------------------------------------------------
 // Program main entry point
 //------------------------------------------------------------------------------------
-int main(void)
+// Offline bakes, write ye.pvs / ye.light / ye.lvl next to ye.png without opening a window.
+// The compiled level takes the PVS and lighting baked in the same run, or the ones on disk.
+int bake_level(bool bakePvs, bool bakeLight, bool compileLevel)
 {
+    Image mapImg = LoadImage("ye.png");
+    if (!IsImageReady(mapImg))
+    {
+        printf("ye.png not found, nothing to bake\n");
+        return 1;
+    }
+    ImageFlipVertical(&mapImg);
+    Color *pixels = LoadImageColors(mapImg);
+    size_t mapBytes = GetImageMemorySize(mapImg) + sizeof(Color)*mapImg.width*mapImg.height;
+    MemChargeTagged(MEM_TAG_ASSETS, mapBytes);
+    OccupancyGrid grid = LoadOccupancyGrid(pixels, mapImg.width, mapImg.height);
+    bool saved = true;
+    PVS pvs = { 0 };
+    LevelLighting lighting = { 0 };
+    LevelMesh levelMesh = GenLevelMesh(&grid);
+
+    if (bakePvs)
+    {
+        pvs = BakePVS(&grid);
+        printf("PVS: %d clusters, %d unique rows, %d threads\n", pvs.clusterCount, pvs.rowCount, JobsWorkerCount() + 1);
+        saved = SavePVS(&pvs, "ye.pvs") && saved;
+    }
+    else if (compileLevel) pvs = LoadPVS("ye.pvs");
+    if (!bakePvs && IsPVSReady(&pvs) && !PVSMatchesGrid(&pvs, &grid)) UnloadPVS(&pvs);
+
+    if (bakeLight)
+    {
+        lighting = BakeLevelLighting(&levelMesh, &grid, GetDefaultLightBakeSettings());
+        printf("Lighting: %d chunks, %d vertices, %d threads\n", lighting.chunkCount, lighting.totalVertices, JobsWorkerCount() + 1);
+        saved = SaveLevelLighting(&lighting, "ye.light") && saved;
+    }
+    else if (compileLevel) lighting = LoadLevelLighting("ye.light");
+
+    if (compileLevel)
+    {
+        if (!IsPVSReady(&pvs)) printf("Level: no PVS, run with --bake-pvs for culling\n");
+        if (!ApplyLevelLighting(&levelMesh, &lighting)) printf("Level: no baked lighting, run with --bake-light\n");
+        PackLevelMesh(&levelMesh);
+        bool compiled = CompileLevelFile(&grid, &levelMesh, &pvs, "ye.lvl");
+        if (compiled) printf("Level: %dx%d cells, %d chunks compiled to ye.lvl\n", grid.width, grid.height, levelMesh.chunkCount);
+        saved = compiled && saved;
+    }
+
+    UnloadLevelMesh(&levelMesh);
+    UnloadLevelLighting(&lighting);
+    UnloadPVS(&pvs);
+    UnloadOccupancyGrid(&grid);
+    MemReleaseTagged(MEM_TAG_ASSETS, mapBytes);
+    UnloadImageColors(pixels);
+    UnloadImage(mapImg);
+    return saved ? 0 : 1;
+}
+
+// struct with what the startup tasks bring up, they fill in main()'s locals
+typedef struct {
+    W_info *window;
+    bool headless;                  // no window, rlgl over a null GL (headless.h)
+    Camera *camera;
+    LevelInfo *level;
+    bool levelLoaded;
+    Sprites *sprites;
+    Vector3 *positions;
+    Color *colors;
+    float *heights;
+    TextRenderer *text;
+    HudLayer *hud;
+    Effects *effects;
+    Props *props;
+    DynamicResolution *dynres;
+} Startup;
+
+// Startup tasks, see main() for what runs where and what waits for what
+void startup_window(void *user)
+{
+    Startup *startup = user;
+    if (startup->headless)
+    {
+        InitHeadless(startup->window->width, startup->window->height);
+        return;
+    }
+    // SetConfigFlags(FLAG_MSAA_4X_HINT|FLAG_WINDOW_UNDECORATED);
+    InitWindow(startup->window->width, startup->window->height, "OpenGL Window");
+    SetExitKey(KEY_NULL);
+    SetTargetFPS(60);
+}
+
+void startup_frame_capture(void *user)
+{
+    (void)user;
+    InitFrameCapture(0);
+}
+
+void startup_assets(void *user)
+{
+    (void)user;
+    InitAssets();
+}
+
+// worker
+void startup_level(void *user)
+{
+    Startup *startup = user;
+    startup->levelLoaded = load_level(startup->level);
+}
+
+void startup_level_upload(void *user)
+{
+    Startup *startup = user;
+    if (!startup->levelLoaded)
+    {
+        printf("No level: ye.lvl and ye.png are missing and physim was built without a bundle (make bundle)\n");
+        exit(1);
+    }
+    stream_level(startup->level, startup->camera->position);
+    const LevelFile *file = &startup->level->file;
+    printf("Level: %s\n", !IsLevelFileReady(file) ? "built from ye.png" : file->bundled ? "ye.lvl bundled" : "ye.lvl mapped");
+}
+
+void startup_sprites(void *user)
+{
+    Sprites *sprites = ((Startup *)user)->sprites;
+    // prebuilt atlas comes from make atlas and loads in the background, without
+    // one pack the sprites we have now
+    bool atlasFile = AssetFileExists("sprites.atlas");
+    if (atlasFile) sprites->atlas = LoadSpriteAtlasAsync("sprites.atlas");
+    else
+    {
+        int32_t yeImage = LoadImageAsync("ye.png");
+        WaitForAsset(yeImage);
+        const char *spriteNames[] = { "ye" };
+        sprites->atlas = AddSpriteAtlasAsset("ye.png:atlas", BuildSpriteAtlas(GetAssetImage(yeImage), spriteNames, 1));
+        ReleaseAsset(yeImage);
+    }
+    sprites->world = LoadSpriteBatch(SPRITE_SPACE_WORLD, 1024);
+    sprites->screen = LoadSpriteBatch(SPRITE_SPACE_SCREEN, 1024);
+}
+
+// worker
+void startup_file_watch(void *user)
+{
+    (void)user;
+    // designers edit the map and bake while the game runs
+    if (InitFileWatch())
+    {
+        const char *watched[] = { "ye.png", "ye.lvl", "ye.pvs", "ye.light", "sprites.atlas", "props.lod" };
+        for (int i = 0; i < (int)(sizeof(watched)/sizeof(watched[0])); i++) WatchFile(watched[i]);
+    }
+}
+
+// after the window, raylib seeds its random generator there
+void startup_columns(void *user)
+{
+    Startup *startup = user;
+    // Generates some random columns
+    for (int i = 0; i < MAX_COLUMNS; i++)
+    {
+        startup->heights[i] = (float)GetRandomValue(1, 12);
+        startup->positions[i] = (Vector3){ (float)-14+i*2, startup->heights[i]/2.0f, (float)-10 };
+        startup->colors[i] = (Color){ GetRandomValue(0, 255), GetRandomValue(0, 255), GetRandomValue(0,255), GetRandomValue(0,255) };
+    }
+}
+
+void startup_props(void *user)
+{
+    Startup *startup = user;
+    *startup->props = load_props(startup->positions, startup->heights);
+}
+
+// worker
+void startup_font(void *user)
+{
+    Startup *startup = user;
+    *startup->text = DecodeTextRenderer("font.sdf");
+}
+
+void startup_text(void *user)
+{
+    Startup *startup = user;
+    UploadTextRenderer(startup->text);
+    *startup->hud = LoadHudLayer(startup->text);
+}
+
+void startup_effects(void *user)
+{
+    Startup *startup = user;
+    *startup->effects = load_effects(startup->level);
+}
+
+void startup_dynres(void *user)
+{
+    Startup *startup = user;
+    *startup->dynres = LoadDynamicResolution(1.0f/60.0f);
+}
+
+int main(int argc, char **argv)
+{
+    bool bakePvs = false;
+    bool bakeLight = false;
+    bool compileLevel = false;
+    bool startupReport = false;
+    int captureFrames = 0;
+    bool softBackend = false;
+    int headlessFrames = 0;
+    const char *traceFile = NULL;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--bake-pvs") == 0) bakePvs = true;
+        if (strcmp(argv[i], "--bake-light") == 0) bakeLight = true;
+        if (strcmp(argv[i], "--bake-level") == 0) compileLevel = true;
+        if (strcmp(argv[i], "--startup-report") == 0) startupReport = true;
+        if (strcmp(argv[i], "--capture-draws") == 0) captureFrames = (i + 1 < argc) ? atoi(argv[++i]) : 60;
+        if (strcmp(argv[i], "--render-backend") == 0 && i + 1 < argc) softBackend = (strcmp(argv[++i], "soft") == 0);
+        if (strcmp(argv[i], "--headless") == 0) headlessFrames = (i + 1 < argc && argv[i + 1][0] != '-') ? atoi(argv[++i]) : 60;
+        if (strcmp(argv[i], "--memory-log") == 0) SetMemoryLogInterval((i + 1 < argc && argv[i + 1][0] != '-') ? (float)atof(argv[++i]) : 10.0f);
+        if (strcmp(argv[i], "--memory-samples") == 0) SetMemorySampling((i + 1 < argc) ? (uint32_t)atoi(argv[++i]) : 64);
+        if (strcmp(argv[i], "--trace") == 0) traceFile = (i + 1 < argc && argv[i + 1][0] != '-') ? argv[++i] : "trace.json";
+    }
+    ProfilerSetThreadName("main");
+    JobsInit(0);
+
+    if (bakePvs || bakeLight || compileLevel)
+    {
+        int result = bake_level(bakePvs, bakeLight, compileLevel);
+        JobsShutdown();
+        if (traceFile != NULL) ExportProfilerTrace(traceFile);
+        CloseProfiler();
+        LogMemoryLeaks();
+        return result;
+    }
+
     W_info w_info = {
         .width = 1366,
         .height = 768
     };
-    // SetConfigFlags(FLAG_MSAA_4X_HINT|FLAG_WINDOW_UNDECORATED);
-    
-    InitWindow(w_info.width,w_info.height, "OpenGL Window");
-    SetExitKey(KEY_NULL);
     DevConsole cons = { .text = "", .index = 0 };
     L_KEYPRESSES lkeys = {
         .exitWindow = false,
@@ -259,20 +1042,17 @@ int main(void)
         .cursorEnabled = true,
         .devconsole = false
     };
-    Image yeImg = LoadImage("ye.png");
-    if (!IsImageReady(yeImg))
-    {
-        printf("YE ERROR 111;");
-        exit(0);
-    }
-    ImageFlipVertical(&yeImg);
-    
-    Texture2D ye = LoadTextureFromImage(yeImg);
-    SetTextureFilter(ye, TEXTURE_FILTER_TRILINEAR);
-    Mesh mesh = GenMeshCubicmap(yeImg, (Vector3){ 1.0f, 1.0f, 1.0f });
-    Model model = LoadModelFromMesh(mesh);
-    Color *mapPixels = LoadImageColors(yeImg);
-    UnloadImage(yeImg);
+    LevelInfo level = { 0 };
+    Sprites sprites = { .atlas = -1, .ye = -1 };
+    LevelReload reload = { .busy = false };
+    float heights[MAX_COLUMNS] = { 0 };
+    Vector3 positions[MAX_COLUMNS] = { 0 };
+    Color colors[MAX_COLUMNS] = { 0 };
+    TextRenderer text = { 0 };
+    HudLayer hud = { 0 };
+    Effects effects = { 0 };
+    Props props = { 0 };
+    DynamicResolution dynres = { 0 };
 
     // Define the camera to look into our 3d world (position, target, up vector)
     Camera camera = { 0 };
@@ -284,37 +1064,77 @@ int main(void)
 
     int cameraMode = CAMERA_FIRST_PERSON;
 
-    // Generates some random columns
-    float heights[MAX_COLUMNS] = { 0 };
-    Vector3 positions[MAX_COLUMNS] = { 0 };
-    Color colors[MAX_COLUMNS] = { 0 };
-
-    for (int i = 0; i < MAX_COLUMNS; i++)
-    {
-        heights[i] = (float)GetRandomValue(1, 12);
-        positions[i] = (Vector3){ (float)-14+i*2, heights[i]/2.0f, (float)-10 };
-        colors[i] = (Color){ GetRandomValue(0, 255), GetRandomValue(0, 255), GetRandomValue(0,255), GetRandomValue(0,255) };
-    }
+    // decoding and meshing on the workers while the window and GL context come up
+    Startup startup = {
+        .window = &w_info, .headless = (headlessFrames > 0), .camera = &camera, .level = &level, .sprites = &sprites, .positions = positions, .colors = colors,
+        .heights = heights, .text = &text, .hud = &hud, .effects = &effects, .props = &props, .dynres = &dynres
+    };
+    StartupGraph graph = { 0 };
+    int32_t levelTask = AddStartupTask(&graph, "level", startup_level, &startup, false, 0);
+    int32_t fontTask = AddStartupTask(&graph, "font", startup_font, &startup, false, 0);
+    AddStartupTask(&graph, "file watch", startup_file_watch, &startup, false, 0);
+    int32_t windowTask = AddStartupTask(&graph, "window", startup_window, &startup, true, 0);
+    AddStartupTask(&graph, "frame capture", startup_frame_capture, &startup, true, STARTUP_AFTER(windowTask));
+    int32_t assetsTask = AddStartupTask(&graph, "assets", startup_assets, &startup, true, STARTUP_AFTER(windowTask));
+    AddStartupTask(&graph, "sprites", startup_sprites, &startup, true, STARTUP_AFTER(assetsTask));
+    int32_t columnsTask = AddStartupTask(&graph, "columns", startup_columns, &startup, true, STARTUP_AFTER(windowTask));
+    AddStartupTask(&graph, "props", startup_props, &startup, true, STARTUP_AFTER(assetsTask) | STARTUP_AFTER(columnsTask));
+    AddStartupTask(&graph, "dynamic resolution", startup_dynres, &startup, true, STARTUP_AFTER(windowTask));
+    AddStartupTask(&graph, "text", startup_text, &startup, true, STARTUP_AFTER(windowTask) | STARTUP_AFTER(fontTask));
+    int32_t levelUpload = AddStartupTask(&graph, "level upload", startup_level_upload, &startup, true,
+                                         STARTUP_AFTER(windowTask) | STARTUP_AFTER(levelTask));
+    AddStartupTask(&graph, "effects", startup_effects, &startup, true, STARTUP_AFTER(levelUpload));
+    // headless frames only exist as what the soft backend rasterizes
+    if (headlessFrames > 0) softBackend = true;
+    // captures and the soft backend replay vertex arrays, their buffers have to be seen loading
+    if (captureFrames > 0 || softBackend) TrackDrawResources();
+    RunStartupGraph(&graph);
+    if (startupReport) PrintStartupReport(&graph);
 
-    DisableCursor();
+    if (headlessFrames == 0) DisableCursor();
     lkeys.cursorEnabled = false;
 
-    SetTargetFPS(60);
+    if (captureFrames > 0) StartDrawCapture("capture.drw", captureFrames);
+    if (softBackend && !InitSoftBackend(headlessFrames == 0) && headlessFrames > 0) lkeys.exitWindow = true;
+    InitFrameStats(FRAME_STATS_WINDOW);
+    int frame = 0;
 
     // Main game loop
     while (!lkeys.exitWindow)
     {
+        PROFILE_COUNTER("frame ms", GetFrameTime()*1000.0f);
+        UpdateFrameStats(GetFrameTime());
+        UpdateMemoryStats(GetFrameTime());
+        BeginFrameSystem("input");
         custom_keypress_controls(&lkeys, &w_info);
+        EndFrameSystem("input");
+        PROFILE_BEGIN(streaming, "streaming");
+        BeginFrameSystem("streaming");
+        FileChangeBatch changes;
+        if (PollFileChanges(&changes)) hot_reload(&changes, &reload);
+        swap_level(&reload, &level, &effects);
+        UpdateLevelStream(level.stream, &level.mesh, level.position, camera.position, GetFrameTime());
+        UpdateAssets(ASSET_UPLOAD_BUDGET_MS);
+        EndFrameSystem("streaming");
+        PROFILE_END(streaming);
+        UpdateDynamicResolution(&dynres, GetFrameTime());
         if (!lkeys.paused) {
-            Game(&camera, &cons, &lkeys, &cameraMode, &ye, mesh, model, mapPixels, positions, colors, heights);
+            Game(&camera, &cons, &lkeys, &cameraMode, &sprites, positions, colors, heights, &level, &effects, &props, &hud, &dynres, &text);
         } 
         if (lkeys.paused) {
-            pauseMenu(&camera, &lkeys, &ye, positions, colors, heights, &cameraMode);
+            pauseMenu(&camera, &lkeys, &sprites, positions, colors, heights, &cameraMode, &level, &effects, &props, &dynres, &text);
+        }
+        if (headlessFrames > 0)
+        {
+            // the soft backend rasterizes from the second frame on
+            if (frame > 0 && !ExportSoftBackendFrame(TextFormat("headless%03d.png", frame - 1))) printf("Cannot write headless%03d.png\n", frame - 1);
+            if (frame++ >= headlessFrames) lkeys.exitWindow = true;
         }
-        if ((IsKeyDown(KEY_LEFT_CONTROL) && IsKeyPressed(KEY_Q)) || WindowShouldClose()) lkeys.exitWindow = true;
+        else if ((IsKeyDown(KEY_LEFT_CONTROL) && IsKeyPressed(KEY_Q)) || WindowShouldClose()) lkeys.exitWindow = true;
         
     }
-    if (lkeys.cursorEnabled == false)
+    if (headlessFrames > 0 && frame > 1) printf("Headless: %d frames written to headless000.png and on\n", frame - 1);
+    if (lkeys.cursorEnabled == false && headlessFrames == 0)
     {
         EnableCursor();
         lkeys.cursorEnabled = true;
@@ -322,7 +1142,31 @@ int main(void)
 
     // De-Initialization
     //--------------------------------------------------------------------------------------
-    CloseWindow();        // Close window and OpenGL context
+    CloseFileWatch();
+    CloseFrameStats();
+    // a reload still on a worker has to land before anything goes away
+    while (reload.busy && !atomic_load(&reload.done)) WaitTime(0.001);
+    if (reload.busy && reload.ok) unload_level(&reload.next);
+    unload_effects(&effects);
+    unload_props(&props);
+    UnloadDynamicResolution(&dynres);
+    UnloadHudLayer(&hud);
+    UnloadTextRenderer(&text);
+    unload_level(&level);
+    UnloadSpriteBatch(&sprites.screen);
+    UnloadSpriteBatch(&sprites.world);
+    ReleaseAsset(sprites.atlas);
+    CloseAssets();
+    CloseFrameCapture();
+    CloseSoftBackend();
+    CloseRenderStats();
+    if (headlessFrames > 0) CloseHeadless();
+    else CloseWindow();        // Close window and OpenGL context
+    JobsShutdown();
+    if (traceFile != NULL && ExportProfilerTrace(traceFile)) printf("Wrote %s\n", traceFile);
+    CloseProfiler();
+    // everything is unloaded, whatever a tag still holds leaked
+    LogMemoryLeaks();
     //--------------------------------------------------------------------------------------
 
     return 0;
@@ -0,0 +1,289 @@
+#include "memtrack.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__GLIBC__)
+#include <execinfo.h>
+#endif
+
+// 16 bytes keeps the block as aligned as malloc's
+typedef struct {
+    size_t size;
+    uint32_t tag;
+    uint32_t sample;                // slot + 1, 0 when not sampled
+} MemHeader;
+
+typedef struct {
+    void *frames[MEMORY_SAMPLE_FRAMES];
+    int32_t frameCount;
+    size_t size;
+    MemTag tag;
+    bool used;
+} MemSample;
+
+typedef struct {
+    _Atomic int64_t live;
+    _Atomic int64_t peak;
+    _Atomic uint64_t allocations;
+    _Atomic uint64_t frees;
+    _Atomic uint64_t allocated;     // bytes ever, for the rate
+    // main thread only, UpdateMemoryStats()
+    uint64_t lastAllocations;
+    uint64_t lastAllocated;
+    float allocationsPerSecond;
+    float bytesPerSecond;
+} MemTagCounters;
+
+static struct {
+    MemTagCounters tags[MEM_TAG_COUNT];
+    _Atomic uint32_t sampleEvery;
+    _Atomic uint32_t sampleCounter;
+    MemSample samples[MEMORY_MAX_SAMPLES];
+    int32_t nextSample;             // where the search for a free slot starts
+    pthread_mutex_t sampleLock;     // sampled allocations and their frees only
+    float logInterval;
+    float sinceLog;
+    float sinceRate;
+} memtrack = { .sampleLock = PTHREAD_MUTEX_INITIALIZER };
+
+static const char *memTagNames[MEM_TAG_COUNT] = { "other", "assets", "physics", "render", "ui" };
+
+static void MemTrackAdd(MemTag tag, int64_t bytes)
+{
+    MemTagCounters *counters = &memtrack.tags[tag];
+    int64_t live = atomic_fetch_add_explicit(&counters->live, bytes, memory_order_relaxed) + bytes;
+    int64_t peak = atomic_load_explicit(&counters->peak, memory_order_relaxed);
+    while (live > peak && !atomic_compare_exchange_weak_explicit(&counters->peak, &peak, live, memory_order_relaxed, memory_order_relaxed)) { }
+}
+
+static uint32_t MemTrackSample(MemTag tag, size_t size)
+{
+    uint32_t every = atomic_load_explicit(&memtrack.sampleEvery, memory_order_relaxed);
+    if (every == 0 || atomic_fetch_add_explicit(&memtrack.sampleCounter, 1, memory_order_relaxed)%every != 0) return 0;
+
+    void *frames[MEMORY_SAMPLE_FRAMES + 1];
+    int32_t frameCount = 0;
+#if defined(__GLIBC__)
+    // without this function, the allocation entry point is kept as inlining may have merged it
+    frameCount = backtrace(frames, MEMORY_SAMPLE_FRAMES + 1) - 1;
+    if (frameCount < 0) frameCount = 0;
+#endif
+
+    uint32_t result = 0;
+    pthread_mutex_lock(&memtrack.sampleLock);
+    for (int32_t i = 0; i < MEMORY_MAX_SAMPLES; i++)
+    {
+        int32_t slot = (memtrack.nextSample + i)%MEMORY_MAX_SAMPLES;
+        MemSample *sample = &memtrack.samples[slot];
+        if (sample->used) continue;
+        *sample = (MemSample){ .frameCount = frameCount, .size = size, .tag = tag, .used = true };
+        memcpy(sample->frames, frames + 1, sizeof(void *)*frameCount);
+        memtrack.nextSample = (slot + 1)%MEMORY_MAX_SAMPLES;
+        result = (uint32_t)slot + 1;
+        break;
+    }
+    pthread_mutex_unlock(&memtrack.sampleLock);
+    return result;
+}
+
+static void *MemTrackBlock(MemHeader *header, MemTag tag, size_t size)
+{
+    if (header == NULL) return NULL;
+    if ((uint32_t)tag >= MEM_TAG_COUNT) tag = MEM_TAG_OTHER;
+
+    *header = (MemHeader){ .size = size, .tag = tag, .sample = MemTrackSample(tag, size) };
+    MemTagCounters *counters = &memtrack.tags[tag];
+    atomic_fetch_add_explicit(&counters->allocations, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&counters->allocated, size, memory_order_relaxed);
+    MemTrackAdd(tag, (int64_t)size);
+    return header + 1;
+}
+
+void *MemAllocTagged(MemTag tag, size_t size)
+{
+    return MemTrackBlock(malloc(sizeof(MemHeader) + size), tag, size);
+}
+
+void *MemCallocTagged(MemTag tag, size_t count, size_t size)
+{
+    if (size != 0 && count > (SIZE_MAX - sizeof(MemHeader))/size) return NULL;
+    return MemTrackBlock(calloc(1, sizeof(MemHeader) + count*size), tag, count*size);
+}
+
+void *MemReallocTagged(MemTag tag, void *ptr, size_t size)
+{
+    if (ptr == NULL) return MemAllocTagged(tag, size);
+
+    MemHeader *header = (MemHeader *)ptr - 1;
+    MemHeader old = *header;
+    header = realloc(header, sizeof(MemHeader) + size);
+    if (header == NULL) return NULL;
+
+    header->size = size;
+    MemTagCounters *counters = &memtrack.tags[old.tag];
+    if (size > old.size) atomic_fetch_add_explicit(&counters->allocated, size - old.size, memory_order_relaxed);
+    MemTrackAdd((MemTag)old.tag, (int64_t)size - (int64_t)old.size);
+    if (old.sample != 0)
+    {
+        pthread_mutex_lock(&memtrack.sampleLock);
+        memtrack.samples[old.sample - 1].size = size;
+        pthread_mutex_unlock(&memtrack.sampleLock);
+    }
+    return header + 1;
+}
+
+void MemFreeTagged(void *ptr)
+{
+    if (ptr == NULL) return;
+
+    MemHeader *header = (MemHeader *)ptr - 1;
+    atomic_fetch_add_explicit(&memtrack.tags[header->tag].frees, 1, memory_order_relaxed);
+    MemTrackAdd((MemTag)header->tag, -(int64_t)header->size);
+    if (header->sample != 0)
+    {
+        pthread_mutex_lock(&memtrack.sampleLock);
+        memtrack.samples[header->sample - 1].used = false;
+        pthread_mutex_unlock(&memtrack.sampleLock);
+    }
+    free(header);
+}
+
+void MemChargeTagged(MemTag tag, size_t size)
+{
+    if ((uint32_t)tag >= MEM_TAG_COUNT) tag = MEM_TAG_OTHER;
+    MemTagCounters *counters = &memtrack.tags[tag];
+    atomic_fetch_add_explicit(&counters->allocations, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&counters->allocated, size, memory_order_relaxed);
+    MemTrackAdd(tag, (int64_t)size);
+}
+
+void MemReleaseTagged(MemTag tag, size_t size)
+{
+    if ((uint32_t)tag >= MEM_TAG_COUNT) tag = MEM_TAG_OTHER;
+    atomic_fetch_add_explicit(&memtrack.tags[tag].frees, 1, memory_order_relaxed);
+    MemTrackAdd(tag, -(int64_t)size);
+}
+
+size_t GetImageMemorySize(Image image)
+{
+    size_t size = 0;
+    int width = image.width, height = image.height;
+    for (int32_t m = 0; m < image.mipmaps; m++)
+    {
+        size += (size_t)GetPixelDataSize(width, height, image.format);
+        width = (width > 1) ? width/2 : 1;
+        height = (height > 1) ? height/2 : 1;
+    }
+    return size;
+}
+
+size_t GetMeshMemorySize(const Mesh *mesh)
+{
+    size_t size = 0;
+    if (mesh->vertices != NULL) size += (size_t)mesh->vertexCount*3*sizeof(float);
+    if (mesh->texcoords != NULL) size += (size_t)mesh->vertexCount*2*sizeof(float);
+    if (mesh->texcoords2 != NULL) size += (size_t)mesh->vertexCount*2*sizeof(float);
+    if (mesh->normals != NULL) size += (size_t)mesh->vertexCount*3*sizeof(float);
+    if (mesh->tangents != NULL) size += (size_t)mesh->vertexCount*4*sizeof(float);
+    if (mesh->colors != NULL) size += (size_t)mesh->vertexCount*4;
+    if (mesh->indices != NULL) size += (size_t)mesh->triangleCount*3*sizeof(unsigned short);
+    return size;
+}
+
+void SetMemorySampling(uint32_t every)
+{
+    atomic_store_explicit(&memtrack.sampleEvery, every, memory_order_relaxed);
+}
+
+void SetMemoryLogInterval(float seconds)
+{
+    memtrack.logInterval = seconds;
+    memtrack.sinceLog = 0.0f;
+}
+
+void UpdateMemoryStats(float dt)
+{
+    memtrack.sinceRate += dt;
+    if (memtrack.sinceRate >= 1.0f)
+    {
+        for (int32_t i = 0; i < MEM_TAG_COUNT; i++)
+        {
+            MemTagCounters *counters = &memtrack.tags[i];
+            uint64_t allocations = atomic_load_explicit(&counters->allocations, memory_order_relaxed);
+            uint64_t allocated = atomic_load_explicit(&counters->allocated, memory_order_relaxed);
+            counters->allocationsPerSecond = (allocations - counters->lastAllocations)/memtrack.sinceRate;
+            counters->bytesPerSecond = (allocated - counters->lastAllocated)/memtrack.sinceRate;
+            counters->lastAllocations = allocations;
+            counters->lastAllocated = allocated;
+        }
+        memtrack.sinceRate = 0.0f;
+    }
+
+    if (memtrack.logInterval <= 0.0f) return;
+    memtrack.sinceLog += dt;
+    if (memtrack.sinceLog >= memtrack.logInterval)
+    {
+        memtrack.sinceLog = 0.0f;
+        LogMemoryStats();
+    }
+}
+
+MemTagStats GetMemoryTagStats(MemTag tag)
+{
+    if ((uint32_t)tag >= MEM_TAG_COUNT) return (MemTagStats){ 0 };
+
+    const MemTagCounters *counters = &memtrack.tags[tag];
+    return (MemTagStats){
+        .live = atomic_load_explicit(&counters->live, memory_order_relaxed),
+        .peak = atomic_load_explicit(&counters->peak, memory_order_relaxed),
+        .allocations = atomic_load_explicit(&counters->allocations, memory_order_relaxed),
+        .frees = atomic_load_explicit(&counters->frees, memory_order_relaxed),
+        .allocationsPerSecond = counters->allocationsPerSecond,
+        .bytesPerSecond = counters->bytesPerSecond
+    };
+}
+
+const char *GetMemoryTagName(MemTag tag)
+{
+    return ((uint32_t)tag < MEM_TAG_COUNT) ? memTagNames[tag] : "?";
+}
+
+void LogMemoryStats(void)
+{
+    printf("MEMORY: %-8s %10s %10s %10s %8s %10s\n", "tag", "live KB", "peak KB", "blocks", "allocs/s", "KB/s");
+    for (int32_t i = 0; i < MEM_TAG_COUNT; i++)
+    {
+        MemTagStats stats = GetMemoryTagStats((MemTag)i);
+        printf("MEMORY: %-8s %10.1f %10.1f %10llu %8.0f %10.1f\n", memTagNames[i], stats.live/1024.0, stats.peak/1024.0,
+               (unsigned long long)(stats.allocations - stats.frees), stats.allocationsPerSecond, stats.bytesPerSecond/1024.0);
+    }
+}
+
+int64_t LogMemoryLeaks(void)
+{
+    int64_t leaked = 0;
+    for (int32_t i = 0; i < MEM_TAG_COUNT; i++)
+    {
+        MemTagStats stats = GetMemoryTagStats((MemTag)i);
+        if (stats.live == 0) continue;
+        printf("MEMORY: %s leaked %lld bytes in %llu blocks\n", memTagNames[i], (long long)stats.live,
+               (unsigned long long)(stats.allocations - stats.frees));
+        leaked += stats.live;
+    }
+
+    pthread_mutex_lock(&memtrack.sampleLock);
+    for (int32_t i = 0; i < MEMORY_MAX_SAMPLES; i++)
+    {
+        const MemSample *sample = &memtrack.samples[i];
+        if (!sample->used) continue;
+        printf("MEMORY: sampled %s block of %zu bytes still live, allocated at\n", memTagNames[sample->tag], sample->size);
+        fflush(stdout);
+#if defined(__GLIBC__)
+        backtrace_symbols_fd(sample->frames, sample->frameCount, fileno(stdout));
+#endif
+    }
+    pthread_mutex_unlock(&memtrack.sampleLock);
+    return leaked;
+}
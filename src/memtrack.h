@@ -0,0 +1,77 @@
+#ifndef MEMTRACK_H
+#define MEMTRACK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "raylib.h"
+
+// Tracking allocator with memory accounted per subsystem.
+// MemAllocTagged() and friends put a 16 byte header in front of every block
+// holding its size and tag, the counters are atomics so any thread may
+// allocate and free. Blocks have to go back through MemFreeTagged(), and
+// nothing handed to raylib (mesh arrays UnloadMesh() frees, images) can come
+// from here: raylib frees with its own allocator.
+//
+// That allocator (RL_MALLOC) is compiled into the prebuilt libraylib.a and
+// cannot be redirected here, so raylib's images, meshes and font tables are
+// only counted where the code loading them charges their size with
+// MemChargeTagged() and the code unloading them releases it. What raylib
+// allocates for itself (render batch, default font, file buffers, GLFW) is
+// not counted anywhere.
+//
+// With sampling on, every Nth allocation records its callstack until it is
+// freed, LogMemoryLeaks() prints the ones still live. Frames are addresses
+// (glibc backtrace()), addr2line -e physim turns them into lines.
+
+#define MEMORY_MAX_SAMPLES 4096         // live sampled blocks, more are not sampled
+#define MEMORY_SAMPLE_FRAMES 12
+
+typedef enum {
+    MEM_TAG_OTHER = 0,
+    MEM_TAG_ASSETS,                 // decoded and baked files: level files, lighting, PVS, atlases
+    MEM_TAG_PHYSICS,                // occupancy grid, particle simulation
+    MEM_TAG_RENDER,                 // chunk tables, streaming, batches, decals, instances, draw capture
+    MEM_TAG_UI,                     // fonts
+    MEM_TAG_COUNT
+} MemTag;
+
+typedef struct {
+    int64_t live;                   // bytes
+    int64_t peak;
+    uint64_t allocations;           // since startup
+    uint64_t frees;
+    float allocationsPerSecond;     // over the last second UpdateMemoryStats() saw
+    float bytesPerSecond;           // allocated, not net
+} MemTagStats;
+
+void *MemAllocTagged(MemTag tag, size_t size);
+void *MemCallocTagged(MemTag tag, size_t count, size_t size);
+void *MemReallocTagged(MemTag tag, void *ptr, size_t size);    // keeps the block's first tag
+void MemFreeTagged(void *ptr);
+
+// raylib owned memory, charged after loading and released before unloading;
+// counted as an allocation and a free but never sampled
+void MemChargeTagged(MemTag tag, size_t size);
+void MemReleaseTagged(MemTag tag, size_t size);
+size_t GetImageMemorySize(Image image);         // data, every mip level
+size_t GetMeshMemorySize(const Mesh *mesh);     // CPU side arrays, not the GPU buffers
+
+// Callstack of every Nth allocation, 0 stops sampling new ones
+void SetMemorySampling(uint32_t every);
+// Seconds between LogMemoryStats() from UpdateMemoryStats(), 0 for never
+void SetMemoryLogInterval(float seconds);
+
+// Once per frame, rates and the periodic log
+void UpdateMemoryStats(float dt);
+MemTagStats GetMemoryTagStats(MemTag tag);
+const char *GetMemoryTagName(MemTag tag);
+
+void LogMemoryStats(void);
+// Every tag still holding memory and the sampled callstacks still live, once
+// everything was unloaded that is what leaked. raylib data is only in there
+// where it was charged; a raylib allocation nobody charged leaks unseen.
+// Returns the live bytes.
+int64_t LogMemoryLeaks(void);
+
+#endif
@@ -0,0 +1,487 @@
+#include "meshopt.h"
+#include "memtrack.h"
+#include "raymath.h"
+#include "rlgl.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+// glVertexAttribPointer types rlgl has no names for
+#define MESHOPT_GL_BYTE 0x1400
+#define MESHOPT_GL_SHORT 0x1402
+#define MESHOPT_GL_HALF_FLOAT 0x140B
+
+typedef struct {
+    float position[3];
+    float normal[3];
+    float texcoord[2];
+    uint8_t color[4];
+} MeshOptVertex;                    // weld key, compared bytewise
+
+static const char *packedVertexShader =
+    "#version 330\n"
+    "layout(location = 0) in vec4 vertexPosition;\n"
+    "layout(location = 1) in vec2 vertexTexCoord;\n"
+    "layout(location = 2) in vec2 vertexNormal;\n"
+    "layout(location = 3) in vec4 vertexColor;\n"
+    "uniform mat4 mvp;\n"
+    "uniform vec3 meshOffset;\n"
+    "uniform float meshScale;\n"
+    "out vec2 fragTexCoord;\n"
+    "out vec3 fragNormal;\n"
+    "out vec4 fragColor;\n"
+    "vec3 OctahedralDecode(vec2 e)\n"
+    "{\n"
+    "    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));\n"
+    "    float t = max(-n.z, 0.0);\n"
+    "    n.xy += vec2((n.x >= 0.0) ? -t : t, (n.y >= 0.0) ? -t : t);\n"
+    "    return normalize(n);\n"
+    "}\n"
+    "void main()\n"
+    "{\n"
+    "    fragTexCoord = vertexTexCoord;\n"
+    "    fragNormal = OctahedralDecode(vertexNormal);\n"
+    "    fragColor = vertexColor;\n"
+    "    gl_Position = mvp*vec4(meshOffset + vertexPosition.xyz*meshScale, 1.0);\n"
+    "}\n";
+
+static const char *packedFragmentShader =
+    "#version 330\n"
+    "in vec4 fragColor;\n"
+    "out vec4 finalColor;\n"
+    "void main()\n"
+    "{\n"
+    "    finalColor = fragColor;\n"
+    "}\n";
+
+// Tipsify (Sander, Nehab, Barczak 2007): fan around a vertex, then continue
+// from the neighbour that is still in the cache and will stay there the
+// longest; dead ends fall back to recently used vertices, then to a scan
+void OptimizeVertexCache(unsigned short *indices, int32_t indexCount, int32_t vertexCount)
+{
+    if (indices == NULL || indexCount < 3 || vertexCount <= 0) return;
+
+    const int32_t triangleCount = indexCount/3;
+    int32_t *offsets = MemCallocTagged(MEM_TAG_RENDER, vertexCount + 1, sizeof(int32_t));
+    int32_t *adjacency = MemAllocTagged(MEM_TAG_RENDER, sizeof(int32_t)*indexCount);
+    int32_t *live = MemCallocTagged(MEM_TAG_RENDER, vertexCount, sizeof(int32_t));
+    int32_t *cacheTime = MemCallocTagged(MEM_TAG_RENDER, vertexCount, sizeof(int32_t));
+    int32_t *deadEnd = MemAllocTagged(MEM_TAG_RENDER, sizeof(int32_t)*indexCount);
+    int32_t *candidates = MemAllocTagged(MEM_TAG_RENDER, sizeof(int32_t)*indexCount);
+    bool *emitted = MemCallocTagged(MEM_TAG_RENDER, triangleCount, sizeof(bool));
+    unsigned short *out = MemAllocTagged(MEM_TAG_RENDER, sizeof(unsigned short)*indexCount);
+
+    if (offsets && adjacency && live && cacheTime && deadEnd && candidates && emitted && out)
+    {
+        for (int32_t i = 0; i < triangleCount*3; i++) live[indices[i]]++;
+        for (int32_t v = 0; v < vertexCount; v++) offsets[v + 1] = offsets[v] + live[v];
+        for (int32_t t = 0; t < triangleCount; t++)
+        {
+            // cacheTime doubles as the fill cursor, it is zeroed again below
+            for (int k = 0; k < 3; k++) adjacency[offsets[indices[t*3 + k]] + cacheTime[indices[t*3 + k]]++] = t;
+        }
+        memset(cacheTime, 0, sizeof(int32_t)*vertexCount);
+
+        int32_t time = MESHOPT_CACHE_SIZE + 1, cursor = 0, deadTop = 0, outCount = 0;
+        int32_t fan = indices[0];
+        while (fan >= 0)
+        {
+            int32_t candidateCount = 0;
+            for (int32_t a = offsets[fan]; a < offsets[fan + 1]; a++)
+            {
+                int32_t t = adjacency[a];
+                if (emitted[t]) continue;
+                emitted[t] = true;
+                for (int k = 0; k < 3; k++)
+                {
+                    int32_t v = indices[t*3 + k];
+                    out[outCount++] = (unsigned short)v;
+                    deadEnd[deadTop++] = v;
+                    candidates[candidateCount++] = v;
+                    live[v]--;
+                    if (time - cacheTime[v] > MESHOPT_CACHE_SIZE) cacheTime[v] = time++;
+                }
+            }
+
+            int32_t best = -1, bestPriority = -1;
+            for (int32_t c = 0; c < candidateCount; c++)
+            {
+                int32_t v = candidates[c];
+                if (live[v] <= 0) continue;
+                // still cached after emitting its remaining fan: prefer the oldest
+                int32_t priority = (time - cacheTime[v] + 2*live[v] <= MESHOPT_CACHE_SIZE) ? time - cacheTime[v] : 0;
+                if (priority > bestPriority)
+                {
+                    best = v;
+                    bestPriority = priority;
+                }
+            }
+            while (best < 0 && deadTop > 0)
+            {
+                int32_t v = deadEnd[--deadTop];
+                if (live[v] > 0) best = v;
+            }
+            while (best < 0 && cursor < vertexCount)
+            {
+                if (live[cursor] > 0) best = cursor;
+                cursor++;
+            }
+            fan = best;
+        }
+
+        memcpy(indices, out, sizeof(unsigned short)*outCount);
+    }
+
+    MemFreeTagged(out);
+    MemFreeTagged(emitted);
+    MemFreeTagged(candidates);
+    MemFreeTagged(deadEnd);
+    MemFreeTagged(cacheTime);
+    MemFreeTagged(live);
+    MemFreeTagged(adjacency);
+    MemFreeTagged(offsets);
+}
+
+int32_t GetVertexCacheMisses(const unsigned short *indices, int32_t indexCount, int32_t vertexCount)
+{
+    // without indices every vertex is its own, nothing can be reused
+    if (indices == NULL) return indexCount;
+
+    int32_t *cacheTime = MemCallocTagged(MEM_TAG_RENDER, (vertexCount > 0) ? vertexCount : 1, sizeof(int32_t));
+    if (cacheTime == NULL) return indexCount;
+
+    int32_t time = MESHOPT_CACHE_SIZE + 1, misses = 0;
+    for (int32_t i = 0; i < indexCount; i++)
+    {
+        if (time - cacheTime[indices[i]] <= MESHOPT_CACHE_SIZE) continue;
+        cacheTime[indices[i]] = time++;
+        misses++;
+    }
+
+    MemFreeTagged(cacheTime);
+    return misses;
+}
+
+// new vertex order is first use in the index buffer, unused vertices go last
+static int32_t *MeshOptFetchRemap(unsigned short *indices, int32_t indexCount, int32_t vertexCount)
+{
+    int32_t *remap = MemAllocTagged(MEM_TAG_RENDER, sizeof(int32_t)*vertexCount);
+    if (remap == NULL) return NULL;
+
+    int32_t next = 0;
+    for (int32_t v = 0; v < vertexCount; v++) remap[v] = -1;
+    for (int32_t i = 0; i < indexCount; i++)
+    {
+        if (remap[indices[i]] < 0) remap[indices[i]] = next++;
+        indices[i] = (unsigned short)remap[indices[i]];
+    }
+    for (int32_t v = 0; v < vertexCount; v++) if (remap[v] < 0) remap[v] = next++;
+
+    return remap;
+}
+
+static void MeshOptPermute(void *data, size_t stride, const int32_t *remap, int32_t vertexCount)
+{
+    if (data == NULL) return;
+    unsigned char *copy = MemAllocTagged(MEM_TAG_RENDER, stride*vertexCount);
+    if (copy == NULL) return;
+
+    memcpy(copy, data, stride*vertexCount);
+    for (int32_t v = 0; v < vertexCount; v++) memcpy((unsigned char *)data + remap[v]*stride, copy + v*stride, stride);
+    MemFreeTagged(copy);
+}
+
+void OptimizeMesh(Mesh *mesh)
+{
+    if (mesh->indices == NULL || mesh->vertexCount == 0) return;
+
+    const int32_t indexCount = mesh->triangleCount*3;
+    OptimizeVertexCache(mesh->indices, indexCount, mesh->vertexCount);
+    int32_t *remap = MeshOptFetchRemap(mesh->indices, indexCount, mesh->vertexCount);
+    if (remap == NULL) return;
+
+    MeshOptPermute(mesh->vertices, sizeof(float)*3, remap, mesh->vertexCount);
+    MeshOptPermute(mesh->normals, sizeof(float)*3, remap, mesh->vertexCount);
+    MeshOptPermute(mesh->texcoords, sizeof(float)*2, remap, mesh->vertexCount);
+    MeshOptPermute(mesh->texcoords2, sizeof(float)*2, remap, mesh->vertexCount);
+    MeshOptPermute(mesh->tangents, sizeof(float)*4, remap, mesh->vertexCount);
+    MeshOptPermute(mesh->colors, 4, remap, mesh->vertexCount);
+    MemFreeTagged(remap);
+}
+
+static uint32_t MeshOptHash(const MeshOptVertex *vertex)
+{
+    uint32_t words[sizeof(MeshOptVertex)/sizeof(uint32_t)];
+    memcpy(words, vertex, sizeof(words));
+
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < (int)(sizeof(words)/sizeof(words[0])); i++) hash = (hash ^ words[i])*16777619u;
+    return hash;
+}
+
+// Unique vertices of mesh and an index buffer into them, -1 when they do not fit 16 bits
+static int32_t MeshOptWeld(const Mesh *mesh, MeshOptVertex *unique, unsigned short *indices)
+{
+    const int32_t indexCount = mesh->triangleCount*3;
+    int32_t tableSize = 1;
+    while (tableSize < mesh->vertexCount*2) tableSize <<= 1;
+    int32_t *table = MemAllocTagged(MEM_TAG_RENDER, sizeof(int32_t)*tableSize);
+    if (table == NULL) return -1;
+    for (int32_t i = 0; i < tableSize; i++) table[i] = -1;
+
+    int32_t uniqueCount = 0;
+    for (int32_t i = 0; i < indexCount && uniqueCount >= 0; i++)
+    {
+        int32_t v = (mesh->indices != NULL) ? mesh->indices[i] : i;
+        MeshOptVertex vertex = { 0 };
+        memcpy(vertex.position, &mesh->vertices[v*3], sizeof(vertex.position));
+        if (mesh->normals != NULL) memcpy(vertex.normal, &mesh->normals[v*3], sizeof(vertex.normal));
+        if (mesh->texcoords != NULL) memcpy(vertex.texcoord, &mesh->texcoords[v*2], sizeof(vertex.texcoord));
+        if (mesh->colors != NULL) memcpy(vertex.color, &mesh->colors[v*4], sizeof(vertex.color));
+        else memset(vertex.color, 255, sizeof(vertex.color));
+
+        uint32_t slot = MeshOptHash(&vertex) & (tableSize - 1);
+        while (table[slot] >= 0 && memcmp(&unique[table[slot]], &vertex, sizeof(vertex)) != 0) slot = (slot + 1) & (tableSize - 1);
+        if (table[slot] < 0)
+        {
+            if (uniqueCount == 65535)
+            {
+                uniqueCount = -1;
+                break;
+            }
+            table[slot] = uniqueCount;
+            unique[uniqueCount++] = vertex;
+        }
+        indices[i] = (unsigned short)table[slot];
+    }
+
+    MemFreeTagged(table);
+    return uniqueCount;
+}
+
+static uint16_t MeshOptHalf(float value)
+{
+    uint32_t x;
+    memcpy(&x, &value, sizeof(x));
+    uint32_t sign = (x >> 16) & 0x8000;
+    int32_t exponent = (int32_t)((x >> 23) & 0xff) - 127 + 15;
+    uint32_t mantissa = x & 0x7fffff;
+
+    if (exponent >= 31) return (uint16_t)(sign | 0x7c00);
+    if (exponent <= 0)
+    {
+        // subnormal half, or zero when even that is too small
+        if (exponent < -10) return (uint16_t)sign;
+        mantissa |= 0x800000;
+        int shift = 14 - exponent;
+        uint32_t half = mantissa >> shift;
+        if ((mantissa >> (shift - 1)) & 1) half++;
+        return (uint16_t)(sign | half);
+    }
+
+    // rounding carries into the exponent on its own
+    uint32_t half = sign | ((uint32_t)exponent << 10) | (mantissa >> 13);
+    if (mantissa & 0x1000) half++;
+    return (uint16_t)half;
+}
+
+static void MeshOptOctahedral(const float *n, int8_t *out)
+{
+    float l1 = fabsf(n[0]) + fabsf(n[1]) + fabsf(n[2]);
+    float x = (l1 > 0.0f) ? n[0]/l1 : 0.0f;
+    float y = (l1 > 0.0f) ? n[1]/l1 : 0.0f;
+    if (n[2] < 0.0f)
+    {
+        // fold the lower hemisphere over the diagonals
+        float fx = (1.0f - fabsf(y))*((x >= 0.0f) ? 1.0f : -1.0f);
+        float fy = (1.0f - fabsf(x))*((y >= 0.0f) ? 1.0f : -1.0f);
+        x = fx;
+        y = fy;
+    }
+    out[0] = (int8_t)lroundf(Clamp(x, -1.0f, 1.0f)*127.0f);
+    out[1] = (int8_t)lroundf(Clamp(y, -1.0f, 1.0f)*127.0f);
+}
+
+PackedMesh PackMesh(const Mesh *mesh)
+{
+    PackedMesh packed = { 0 };
+    const int32_t indexCount = mesh->triangleCount*3;
+    if (mesh->vertices == NULL || indexCount == 0) return packed;
+
+    MeshOptVertex *unique = MemAllocTagged(MEM_TAG_RENDER, sizeof(MeshOptVertex)*indexCount);
+    unsigned short *indices = MemAllocTagged(MEM_TAG_RENDER, sizeof(unsigned short)*indexCount);
+    int32_t uniqueCount = (unique && indices) ? MeshOptWeld(mesh, unique, indices) : -1;
+    if (uniqueCount <= 0)
+    {
+        TraceLog(LOG_WARNING, "MESHOPT: mesh does not fit 16 bit indices, not packed");
+        MemFreeTagged(indices);
+        MemFreeTagged(unique);
+        return packed;
+    }
+
+    OptimizeVertexCache(indices, indexCount, uniqueCount);
+    int32_t *remap = MeshOptFetchRemap(indices, indexCount, uniqueCount);
+    if (remap != NULL) MeshOptPermute(unique, sizeof(MeshOptVertex), remap, uniqueCount);
+    MemFreeTagged(remap);
+
+    Vector3 min = { INFINITY, INFINITY, INFINITY }, max = { -INFINITY, -INFINITY, -INFINITY };
+    for (int32_t v = 0; v < uniqueCount; v++)
+    {
+        Vector3 p = { unique[v].position[0], unique[v].position[1], unique[v].position[2] };
+        min = Vector3Min(min, p);
+        max = Vector3Max(max, p);
+    }
+    Vector3 half = Vector3Scale(Vector3Subtract(max, min), 0.5f);
+    float extent = fmaxf(half.x, fmaxf(half.y, half.z));
+    // power of two step, a margin of one step covers rounding the offset
+    packed.scale = 1.0f/65536.0f;
+    while (extent + packed.scale > 32767.0f*packed.scale) packed.scale *= 2.0f;
+    Vector3 center = Vector3Scale(Vector3Add(min, max), 0.5f);
+    packed.offset = (Vector3){
+        roundf(center.x/packed.scale)*packed.scale,
+        roundf(center.y/packed.scale)*packed.scale,
+        roundf(center.z/packed.scale)*packed.scale
+    };
+
+    packed.vertexCount = uniqueCount;
+    packed.indexCount = indexCount;
+    packed.indices = indices;
+    packed.vertices = MemCallocTagged(MEM_TAG_RENDER, uniqueCount, sizeof(PackedVertex));
+    if (packed.vertices == NULL)
+    {
+        MemFreeTagged(indices);
+        MemFreeTagged(unique);
+        return (PackedMesh){ 0 };
+    }
+
+    const float offset[3] = { packed.offset.x, packed.offset.y, packed.offset.z };
+    for (int32_t v = 0; v < uniqueCount; v++)
+    {
+        PackedVertex *out = &packed.vertices[v];
+        for (int a = 0; a < 3; a++) out->position[a] = (int16_t)Clamp(roundf((unique[v].position[a] - offset[a])/packed.scale), -32767.0f, 32767.0f);
+        MeshOptOctahedral(unique[v].normal, out->normal);
+        out->texcoord[0] = MeshOptHalf(unique[v].texcoord[0]);
+        out->texcoord[1] = MeshOptHalf(unique[v].texcoord[1]);
+        memcpy(out->color, unique[v].color, sizeof(out->color));
+    }
+
+    MemFreeTagged(unique);
+    return packed;
+}
+
+MeshStats GetMeshStats(const Mesh *mesh)
+{
+    size_t vertexSize = sizeof(float)*3 + ((mesh->normals != NULL) ? sizeof(float)*3 : 0) +
+                        ((mesh->texcoords != NULL) ? sizeof(float)*2 : 0) + ((mesh->texcoords2 != NULL) ? sizeof(float)*2 : 0) +
+                        ((mesh->tangents != NULL) ? sizeof(float)*4 : 0) + ((mesh->colors != NULL) ? 4 : 0);
+    int32_t indexCount = mesh->triangleCount*3;
+
+    return (MeshStats){
+        .vertexCount = mesh->vertexCount,
+        .triangleCount = mesh->triangleCount,
+        .bytes = vertexSize*mesh->vertexCount + ((mesh->indices != NULL) ? sizeof(unsigned short)*indexCount : 0),
+        .cacheMisses = GetVertexCacheMisses(mesh->indices, indexCount, mesh->vertexCount)
+    };
+}
+
+MeshStats GetPackedMeshStats(const PackedMesh *mesh)
+{
+    return (MeshStats){
+        .vertexCount = mesh->vertexCount,
+        .triangleCount = mesh->indexCount/3,
+        .bytes = sizeof(PackedVertex)*mesh->vertexCount + sizeof(unsigned short)*mesh->indexCount,
+        .cacheMisses = GetVertexCacheMisses(mesh->indices, mesh->indexCount, mesh->vertexCount)
+    };
+}
+
+void PrintMeshStats(const char *name, MeshStats before, MeshStats after)
+{
+    float acmrBefore = (before.triangleCount > 0) ? (float)before.cacheMisses/before.triangleCount : 0.0f;
+    float acmrAfter = (after.triangleCount > 0) ? (float)after.cacheMisses/after.triangleCount : 0.0f;
+    TraceLog(LOG_INFO, "MESHOPT: %s: %d -> %d vertices, %.1f -> %.1f KiB, ACMR %.3f -> %.3f", name,
+             before.vertexCount, after.vertexCount, before.bytes/1024.0f, after.bytes/1024.0f, acmrBefore, acmrAfter);
+}
+
+static void MeshOptUpload(PackedMesh *mesh)
+{
+    mesh->vaoId = rlLoadVertexArray();
+    rlEnableVertexArray(mesh->vaoId);
+    mesh->vboId = rlLoadVertexBuffer(mesh->vertices, (int)sizeof(PackedVertex)*mesh->vertexCount, false);
+    rlSetVertexAttribute(0, 4, MESHOPT_GL_SHORT, false, sizeof(PackedVertex), (void *)offsetof(PackedVertex, position));
+    rlEnableVertexAttribute(0);
+    rlSetVertexAttribute(1, 2, MESHOPT_GL_HALF_FLOAT, false, sizeof(PackedVertex), (void *)offsetof(PackedVertex, texcoord));
+    rlEnableVertexAttribute(1);
+    rlSetVertexAttribute(2, 2, MESHOPT_GL_BYTE, true, sizeof(PackedVertex), (void *)offsetof(PackedVertex, normal));
+    rlEnableVertexAttribute(2);
+    rlSetVertexAttribute(3, 4, RL_UNSIGNED_BYTE, true, sizeof(PackedVertex), (void *)offsetof(PackedVertex, color));
+    rlEnableVertexAttribute(3);
+    mesh->eboId = rlLoadVertexBufferElement(mesh->indices, (int)sizeof(unsigned short)*mesh->indexCount, false);
+    rlDisableVertexArray();
+}
+
+void UploadPackedMesh(PackedMesh *mesh)
+{
+    if (mesh->vertices == NULL) return;
+
+    MeshOptUpload(mesh);
+    MemFreeTagged(mesh->vertices);
+    MemFreeTagged(mesh->indices);
+    mesh->vertices = NULL;
+    mesh->indices = NULL;
+}
+
+void UploadPackedMeshView(PackedMesh *mesh)
+{
+    if (mesh->vertices == NULL) return;
+
+    MeshOptUpload(mesh);
+    mesh->vertices = NULL;
+    mesh->indices = NULL;
+}
+
+void UnloadPackedMesh(PackedMesh *mesh)
+{
+    if (mesh->vaoId > 0)
+    {
+        rlUnloadVertexArray(mesh->vaoId);
+        rlUnloadVertexBuffer(mesh->vboId);
+        rlUnloadVertexBuffer(mesh->eboId);
+    }
+    MemFreeTagged(mesh->vertices);
+    MemFreeTagged(mesh->indices);
+    *mesh = (PackedMesh){ 0 };
+}
+
+PackedMeshShader LoadPackedMeshShader(void)
+{
+    PackedMeshShader shader = { 0 };
+    shader.shader = LoadShaderFromMemory(packedVertexShader, packedFragmentShader);
+    shader.offsetLoc = GetShaderLocation(shader.shader, "meshOffset");
+    shader.scaleLoc = GetShaderLocation(shader.shader, "meshScale");
+    return shader;
+}
+
+void UnloadPackedMeshShader(PackedMeshShader *shader)
+{
+    UnloadShader(shader->shader);
+    *shader = (PackedMeshShader){ 0 };
+}
+
+void DrawPackedMesh(const PackedMesh *mesh, const PackedMeshShader *shader, Matrix transform)
+{
+    if (mesh->vaoId == 0) return;
+
+    // whatever raylib batched so far has to land before our own draw
+    rlDrawRenderBatchActive();
+
+    Matrix mvp = MatrixMultiply(MatrixMultiply(transform, rlGetMatrixModelview()), rlGetMatrixProjection());
+    rlEnableShader(shader->shader.id);
+    rlSetUniformMatrix(shader->shader.locs[SHADER_LOC_MATRIX_MVP], mvp);
+    rlSetUniform(shader->offsetLoc, &mesh->offset, RL_SHADER_UNIFORM_VEC3, 1);
+    rlSetUniform(shader->scaleLoc, &mesh->scale, RL_SHADER_UNIFORM_FLOAT, 1);
+    rlEnableVertexArray(mesh->vaoId);
+    rlDrawVertexArrayElements(0, mesh->indexCount, 0);
+    rlDisableVertexArray();
+    rlDisableShader();
+}
@@ -0,0 +1,77 @@
+#ifndef MESHOPT_H
+#define MESHOPT_H
+
+#include "raylib.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Mesh processing for static geometry: weld duplicate vertices, reorder
+// triangles for the post-transform vertex cache (Tipsify) and vertices for
+// fetch locality, then quantize into a 20 byte vertex:
+//   position   int16 x4, p = offset + q*scale with scale a power of two, so
+//              vertices on a 1/2^n grid stay exact and chunk seams do not crack
+//   normal     octahedral snorm8 x2
+//   texcoord   half float x2
+//   color      unorm8 x4
+// Packed meshes are drawn with their own small shader, DrawMesh() only knows
+// float attributes.
+
+#define MESHOPT_CACHE_SIZE 16       // FIFO entries assumed for ordering and ACMR
+
+typedef struct {
+    int16_t position[4];
+    int8_t normal[2];
+    uint8_t padding[2];
+    uint16_t texcoord[2];
+    uint8_t color[4];
+} PackedVertex;
+
+typedef struct {
+    int32_t vertexCount;
+    int32_t indexCount;
+    PackedVertex *vertices;         // CPU copies, released by UploadPackedMesh()
+    unsigned short *indices;
+    Vector3 offset;
+    float scale;
+    unsigned int vaoId;
+    unsigned int vboId;
+    unsigned int eboId;
+} PackedMesh;
+
+typedef struct {
+    Shader shader;
+    int offsetLoc;
+    int scaleLoc;
+} PackedMeshShader;
+
+typedef struct {
+    int32_t vertexCount;
+    int32_t triangleCount;
+    size_t bytes;                   // vertex and index buffers as uploaded
+    int32_t cacheMisses;            // simulated over MESHOPT_CACHE_SIZE entries
+} MeshStats;
+
+// indices may be NULL for non-indexed meshes
+void OptimizeVertexCache(unsigned short *indices, int32_t indexCount, int32_t vertexCount);
+int32_t GetVertexCacheMisses(const unsigned short *indices, int32_t indexCount, int32_t vertexCount);
+
+// Reorders an indexed raylib mesh in place (CPU side, before UploadMesh())
+void OptimizeMesh(Mesh *mesh);
+// Empty when the welded mesh does not fit 16 bit indices, the caller keeps or drops the float mesh
+PackedMesh PackMesh(const Mesh *mesh);
+
+MeshStats GetMeshStats(const Mesh *mesh);
+MeshStats GetPackedMeshStats(const PackedMesh *mesh);
+void PrintMeshStats(const char *name, MeshStats before, MeshStats after);
+
+void UploadPackedMesh(PackedMesh *mesh);
+// For arrays the mesh does not own (a mapped level file), they are only dropped
+void UploadPackedMeshView(PackedMesh *mesh);
+void UnloadPackedMesh(PackedMesh *mesh);
+
+PackedMeshShader LoadPackedMeshShader(void);
+void UnloadPackedMeshShader(PackedMeshShader *shader);
+// Call inside BeginMode3D()
+void DrawPackedMesh(const PackedMesh *mesh, const PackedMeshShader *shader, Matrix transform);
+
+#endif
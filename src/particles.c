@@ -0,0 +1,192 @@
+#include "particles.h"
+#include "jobs.h"
+#include "memtrack.h"
+#include <math.h>
+#include <stdlib.h>
+
+ParticleSystem LoadParticleSystem(int32_t capacity)
+{
+    ParticleSystem system = { 0 };
+    if (capacity <= 0) return system;
+
+    // one block, each stream 64 byte aligned so the kernels start on a cache line
+    int32_t stride = (capacity + 15) & ~15;
+    system.memory = MemAllocTagged(MEM_TAG_PHYSICS, sizeof(float)*stride*8 + 64);
+    if (system.memory == NULL) return system;
+    float *block = (float *)(((uintptr_t)system.memory + 63) & ~(uintptr_t)63);
+
+    system.capacity = capacity;
+    system.posX = block + stride*0;
+    system.posY = block + stride*1;
+    system.posZ = block + stride*2;
+    system.velX = block + stride*3;
+    system.velY = block + stride*4;
+    system.velZ = block + stride*5;
+    system.age = block + stride*6;
+    system.invLifetime = block + stride*7;
+    return system;
+}
+
+void UnloadParticleSystem(ParticleSystem *system)
+{
+    MemFreeTagged(system->memory);
+    *system = (ParticleSystem){ 0 };
+}
+
+int32_t AddParticleEmitter(ParticleSystem *system, ParticleEmitterDesc desc, int32_t capacity)
+{
+    if (system->emitterCount >= PARTICLE_MAX_EMITTERS || capacity <= 0) return -1;
+    if (system->used + capacity > system->capacity) return -1;
+
+    int32_t id = system->emitterCount++;
+    system->emitters[id] = (ParticleEmitter){
+        .desc = desc,
+        .first = system->used,
+        .capacity = capacity,
+        .seed = 0x9E3779B9u*(uint32_t)(id + 1)
+    };
+    system->used += capacity;
+    return id;
+}
+
+void EmitParticles(ParticleSystem *system, int32_t emitter, Vector3 position, Vector3 direction, int32_t count)
+{
+    if (emitter < 0 || emitter >= system->emitterCount || count <= 0) return;
+
+    ParticleEmitter *e = &system->emitters[emitter];
+    if (e->burstCount >= PARTICLE_MAX_BURSTS) return;
+    e->bursts[e->burstCount++] = (ParticleBurst){ position, direction, count };
+}
+
+int32_t GetParticleCount(const ParticleSystem *system)
+{
+    int32_t count = 0;
+    for (int32_t i = 0; i < system->emitterCount; i++) count += system->emitters[i].count;
+    return count;
+}
+
+// xorshift32, emitters carry their own state so jobs never share an RNG
+static float ParticleRandom(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return (float)(x >> 8)*(1.0f/16777216.0f);
+}
+
+static void ParticleSpawnBurst(ParticleSystem *system, ParticleEmitter *e, const ParticleBurst *burst)
+{
+    const ParticleEmitterDesc *d = &e->desc;
+    Vector3 dir = burst->direction;
+    float len = sqrtf(dir.x*dir.x + dir.y*dir.y + dir.z*dir.z);
+    dir = (len > 0.0f) ? (Vector3){ dir.x/len, dir.y/len, dir.z/len } : (Vector3){ 0.0f, 1.0f, 0.0f };
+
+    // basis around the burst direction for the spread cone
+    Vector3 helper = (fabsf(dir.y) < 0.99f) ? (Vector3){ 0.0f, 1.0f, 0.0f } : (Vector3){ 1.0f, 0.0f, 0.0f };
+    Vector3 t = { helper.y*dir.z - helper.z*dir.y, helper.z*dir.x - helper.x*dir.z, helper.x*dir.y - helper.y*dir.x };
+    float tl = sqrtf(t.x*t.x + t.y*t.y + t.z*t.z);
+    t = (Vector3){ t.x/tl, t.y/tl, t.z/tl };
+    Vector3 b = { dir.y*t.z - dir.z*t.y, dir.z*t.x - dir.x*t.z, dir.x*t.y - dir.y*t.x };
+    float cosSpread = cosf(d->spread);
+
+    int32_t count = burst->count;
+    if (count > e->capacity - e->count) count = e->capacity - e->count;
+
+    for (int32_t n = 0; n < count; n++)
+    {
+        int32_t i = e->first + e->count++;
+        float cosTheta = 1.0f - ParticleRandom(&e->seed)*(1.0f - cosSpread);
+        float sinTheta = sqrtf(1.0f - cosTheta*cosTheta);
+        float phi = ParticleRandom(&e->seed)*2.0f*PI;
+        float cx = cosf(phi)*sinTheta, cy = sinf(phi)*sinTheta;
+        float speed = d->speedMin + (d->speedMax - d->speedMin)*ParticleRandom(&e->seed);
+        float along = d->stretch*ParticleRandom(&e->seed);
+        float lifetime = d->lifetimeMin + (d->lifetimeMax - d->lifetimeMin)*ParticleRandom(&e->seed);
+
+        system->posX[i] = burst->position.x + dir.x*along;
+        system->posY[i] = burst->position.y + dir.y*along;
+        system->posZ[i] = burst->position.z + dir.z*along;
+        system->velX[i] = (dir.x*cosTheta + t.x*cx + b.x*cy)*speed;
+        system->velY[i] = (dir.y*cosTheta + t.y*cx + b.y*cy)*speed;
+        system->velZ[i] = (dir.z*cosTheta + t.z*cx + b.z*cy)*speed;
+        system->age[i] = 0.0f;
+        system->invLifetime[i] = 1.0f/((lifetime > 0.001f) ? lifetime : 0.001f);
+    }
+}
+
+// Branch free over contiguous streams so the compiler vectorizes it
+static void ParticleIntegrate(float *restrict px, float *restrict py, float *restrict pz,
+                              float *restrict vx, float *restrict vy, float *restrict vz,
+                              float *restrict age, int32_t count, float dt, float damping, float gravity)
+{
+    for (int32_t i = 0; i < count; i++)
+    {
+        vx[i] = vx[i]*damping;
+        vy[i] = vy[i]*damping - gravity*dt;
+        vz[i] = vz[i]*damping;
+        px[i] += vx[i]*dt;
+        py[i] += vy[i]*dt;
+        pz[i] += vz[i]*dt;
+        age[i] += dt;
+    }
+}
+
+// swap-remove dead particles, keeps the emitter slice dense
+static void ParticleCompact(ParticleSystem *system, ParticleEmitter *e)
+{
+    int32_t i = e->first;
+    int32_t end = e->first + e->count;
+    while (i < end)
+    {
+        if (system->age[i]*system->invLifetime[i] < 1.0f)
+        {
+            i++;
+            continue;
+        }
+
+        end--;
+        system->posX[i] = system->posX[end];
+        system->posY[i] = system->posY[end];
+        system->posZ[i] = system->posZ[end];
+        system->velX[i] = system->velX[end];
+        system->velY[i] = system->velY[end];
+        system->velZ[i] = system->velZ[end];
+        system->age[i] = system->age[end];
+        system->invLifetime[i] = system->invLifetime[end];
+    }
+    e->count = end - e->first;
+}
+
+static void ParticleEmitterJob(int32_t begin, int32_t end, void *user)
+{
+    ParticleSystem *system = user;
+    float dt = system->frameTime;
+
+    for (int32_t id = begin; id < end; id++)
+    {
+        ParticleEmitter *e = &system->emitters[id];
+
+        if (e->count > 0)
+        {
+            float damping = 1.0f - e->desc.drag*dt;
+            if (damping < 0.0f) damping = 0.0f;
+            int32_t f = e->first;
+            ParticleIntegrate(system->posX + f, system->posY + f, system->posZ + f,
+                              system->velX + f, system->velY + f, system->velZ + f,
+                              system->age + f, e->count, dt, damping, e->desc.gravity);
+            ParticleCompact(system, e);
+        }
+
+        // new particles start at age 0 and get integrated from the next update on
+        for (int32_t b = 0; b < e->burstCount; b++) ParticleSpawnBurst(system, e, &e->bursts[b]);
+        e->burstCount = 0;
+    }
+}
+
+void UpdateParticleSystem(ParticleSystem *system, float frameTime)
+{
+    system->frameTime = frameTime;
+    JobsParallelFor(system->emitterCount, 1, ParticleEmitterJob, system);
+}
@@ -0,0 +1,92 @@
+#ifndef PARTICLES_H
+#define PARTICLES_H
+
+#include "raylib.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// SoA particle engine for short lived effects (muzzle flashes, tracers, impacts).
+// Every emitter owns a fixed slice of the particle arrays, so the per emitter
+// update (spawn bursts, integrate, compact) touches nothing shared and emitters
+// are updated in parallel on the job system.
+// The simulation side has no GL dependency and runs headless, drawing lives in
+// particles_draw.c.
+
+#define PARTICLE_MAX_EMITTERS 32
+#define PARTICLE_MAX_BURSTS 64      // pending bursts per emitter between updates
+
+typedef struct {
+    float speedMin;
+    float speedMax;
+    float spread;           // cone half angle around the burst direction, radians
+    float lifetimeMin;
+    float lifetimeMax;
+    float sizeStart;
+    float sizeEnd;
+    float gravity;          // units/s^2 along -Y
+    float drag;             // fraction of velocity lost per second
+    float stretch;          // spawn particles along the burst direction over this distance (tracers)
+    Color colorStart;
+    Color colorEnd;         // alpha fades towards colorEnd.a over the lifetime
+} ParticleEmitterDesc;
+
+typedef struct {
+    Vector3 position;
+    Vector3 direction;
+    int32_t count;
+} ParticleBurst;
+
+typedef struct {
+    ParticleEmitterDesc desc;
+    int32_t first;          // slice of the particle arrays owned by this emitter
+    int32_t capacity;
+    int32_t count;
+    ParticleBurst bursts[PARTICLE_MAX_BURSTS];
+    int32_t burstCount;
+    uint32_t seed;
+} ParticleEmitter;
+
+typedef struct {
+    int32_t capacity;
+    int32_t used;           // particles slots handed out to emitters
+    float *posX, *posY, *posZ;
+    float *velX, *velY, *velZ;
+    float *age;
+    float *invLifetime;     // 1/lifetime, so normalized age is a multiply
+    void *memory;           // single allocation behind all the streams
+    ParticleEmitter emitters[PARTICLE_MAX_EMITTERS];
+    int32_t emitterCount;
+    float frameTime;        // dt of the update in flight, read by the jobs
+} ParticleSystem;
+
+ParticleSystem LoadParticleSystem(int32_t capacity);
+void UnloadParticleSystem(ParticleSystem *system);
+
+// Reserves capacity particles for a new emitter, returns its id or -1 when full
+int32_t AddParticleEmitter(ParticleSystem *system, ParticleEmitterDesc desc, int32_t capacity);
+
+// Queues a burst, particles appear on the next update. Not thread safe.
+void EmitParticles(ParticleSystem *system, int32_t emitter, Vector3 position, Vector3 direction, int32_t count);
+
+void UpdateParticleSystem(ParticleSystem *system, float frameTime);
+int32_t GetParticleCount(const ParticleSystem *system);
+
+// Instanced billboard renderer, see particles_draw.c
+typedef struct {
+    Shader shader;
+    unsigned int vao;
+    unsigned int cornerBuffer;
+    unsigned int instanceBuffer;
+    int32_t capacity;
+    void *instances;        // CPU staging copy of the instance buffer
+    int cameraRightLoc;
+    int cameraUpLoc;
+} ParticleRenderer;
+
+ParticleRenderer LoadParticleRenderer(int32_t capacity);
+void UnloadParticleRenderer(ParticleRenderer *renderer);
+
+// One instanced draw for every live particle, call inside BeginMode3D()
+void DrawParticleSystem(ParticleRenderer *renderer, const ParticleSystem *system);
+
+#endif
@@ -0,0 +1,143 @@
+#include "particles.h"
+#include "memtrack.h"
+#include "raymath.h"
+#include "rlgl.h"
+#include <stdlib.h>
+
+// Instanced billboards: a static 6 vertex quad, per instance position/size and
+// color. Quads are expanded towards the camera in the vertex shader so the CPU
+// only writes 20 bytes per particle.
+
+typedef struct {
+    float x, y, z, size;
+    unsigned char r, g, b, a;
+} ParticleInstance;
+
+static const char *particleVertexShader =
+    "#version 330\n"
+    "layout(location = 0) in vec2 corner;\n"
+    "layout(location = 1) in vec4 instancePositionSize;\n"
+    "layout(location = 2) in vec4 instanceColor;\n"
+    "uniform mat4 mvp;\n"
+    "uniform vec3 cameraRight;\n"
+    "uniform vec3 cameraUp;\n"
+    "out vec2 fragCorner;\n"
+    "out vec4 fragColor;\n"
+    "void main()\n"
+    "{\n"
+    "    vec3 position = instancePositionSize.xyz + (cameraRight*corner.x + cameraUp*corner.y)*instancePositionSize.w;\n"
+    "    fragCorner = corner*2.0;\n"
+    "    fragColor = instanceColor;\n"
+    "    gl_Position = mvp*vec4(position, 1.0);\n"
+    "}\n";
+
+static const char *particleFragmentShader =
+    "#version 330\n"
+    "in vec2 fragCorner;\n"
+    "in vec4 fragColor;\n"
+    "out vec4 finalColor;\n"
+    "void main()\n"
+    "{\n"
+    "    float d = dot(fragCorner, fragCorner);\n"
+    "    if (d > 1.0) discard;\n"
+    "    finalColor = vec4(fragColor.rgb, fragColor.a*(1.0 - d));\n"
+    "}\n";
+
+ParticleRenderer LoadParticleRenderer(int32_t capacity)
+{
+    ParticleRenderer renderer = { 0 };
+    static const float corners[12] = {
+        -0.5f, -0.5f,  0.5f, -0.5f,  0.5f, 0.5f,
+        -0.5f, -0.5f,  0.5f, 0.5f,  -0.5f, 0.5f
+    };
+
+    renderer.shader = LoadShaderFromMemory(particleVertexShader, particleFragmentShader);
+    renderer.cameraRightLoc = GetShaderLocation(renderer.shader, "cameraRight");
+    renderer.cameraUpLoc = GetShaderLocation(renderer.shader, "cameraUp");
+    renderer.capacity = capacity;
+    renderer.instances = MemAllocTagged(MEM_TAG_RENDER, sizeof(ParticleInstance)*capacity);
+
+    renderer.vao = rlLoadVertexArray();
+    rlEnableVertexArray(renderer.vao);
+    renderer.cornerBuffer = rlLoadVertexBuffer(corners, sizeof(corners), false);
+    rlSetVertexAttribute(0, 2, RL_FLOAT, false, 0, 0);
+    rlEnableVertexAttribute(0);
+
+    renderer.instanceBuffer = rlLoadVertexBuffer(NULL, (int)sizeof(ParticleInstance)*capacity, true);
+    rlSetVertexAttribute(1, 4, RL_FLOAT, false, sizeof(ParticleInstance), 0);
+    rlEnableVertexAttribute(1);
+    rlSetVertexAttributeDivisor(1, 1);
+    rlSetVertexAttribute(2, 4, RL_UNSIGNED_BYTE, true, sizeof(ParticleInstance), (void *)(uintptr_t)(4*sizeof(float)));
+    rlEnableVertexAttribute(2);
+    rlSetVertexAttributeDivisor(2, 1);
+    rlDisableVertexArray();
+
+    return renderer;
+}
+
+void UnloadParticleRenderer(ParticleRenderer *renderer)
+{
+    rlUnloadVertexArray(renderer->vao);
+    rlUnloadVertexBuffer(renderer->cornerBuffer);
+    rlUnloadVertexBuffer(renderer->instanceBuffer);
+    UnloadShader(renderer->shader);
+    MemFreeTagged(renderer->instances);
+    *renderer = (ParticleRenderer){ 0 };
+}
+
+static int32_t ParticlePackEmitter(const ParticleSystem *system, const ParticleEmitter *e, ParticleInstance *out)
+{
+    const ParticleEmitterDesc *d = &e->desc;
+    for (int32_t n = 0; n < e->count; n++)
+    {
+        int32_t i = e->first + n;
+        float t = system->age[i]*system->invLifetime[i];
+        out[n] = (ParticleInstance){
+            .x = system->posX[i],
+            .y = system->posY[i],
+            .z = system->posZ[i],
+            .size = d->sizeStart + (d->sizeEnd - d->sizeStart)*t,
+            .r = (unsigned char)(d->colorStart.r + (d->colorEnd.r - d->colorStart.r)*t),
+            .g = (unsigned char)(d->colorStart.g + (d->colorEnd.g - d->colorStart.g)*t),
+            .b = (unsigned char)(d->colorStart.b + (d->colorEnd.b - d->colorStart.b)*t),
+            .a = (unsigned char)(d->colorStart.a + (d->colorEnd.a - d->colorStart.a)*t)
+        };
+    }
+    return e->count;
+}
+
+void DrawParticleSystem(ParticleRenderer *renderer, const ParticleSystem *system)
+{
+    ParticleInstance *instances = renderer->instances;
+    int32_t count = 0;
+    for (int32_t id = 0; id < system->emitterCount; id++)
+    {
+        const ParticleEmitter *e = &system->emitters[id];
+        if (count + e->count > renderer->capacity) break;
+        count += ParticlePackEmitter(system, e, instances + count);
+    }
+    if (count == 0) return;
+
+    // whatever raylib batched so far has to land before our own draw
+    rlDrawRenderBatchActive();
+
+    Matrix view = rlGetMatrixModelview();
+    Matrix mvp = MatrixMultiply(view, rlGetMatrixProjection());
+    Vector3 right = { view.m0, view.m4, view.m8 };
+    Vector3 up = { view.m1, view.m5, view.m9 };
+
+    rlUpdateVertexBuffer(renderer->instanceBuffer, instances, (int)sizeof(ParticleInstance)*count, 0);
+
+    rlDisableDepthMask();
+    rlDisableBackfaceCulling();
+    rlEnableShader(renderer->shader.id);
+    rlSetUniformMatrix(renderer->shader.locs[SHADER_LOC_MATRIX_MVP], mvp);
+    rlSetUniform(renderer->cameraRightLoc, &right, RL_SHADER_UNIFORM_VEC3, 1);
+    rlSetUniform(renderer->cameraUpLoc, &up, RL_SHADER_UNIFORM_VEC3, 1);
+    rlEnableVertexArray(renderer->vao);
+    rlDrawVertexArrayInstanced(0, 6, count);
+    rlDisableVertexArray();
+    rlDisableShader();
+    rlEnableBackfaceCulling();
+    rlEnableDepthMask();
+}
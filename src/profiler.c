@@ -0,0 +1,212 @@
+#include "profiler.h"
+#include "memtrack.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef enum {
+    PROFILE_EVENT_ZONE = 0,
+    PROFILE_EVENT_COUNTER
+} ProfileEventType;
+
+typedef struct {
+    const char *name;
+    uint64_t start;
+    uint64_t data;                  // end ticks for zones, the value's bits for counters
+    uint32_t type;
+} ProfileEvent;
+
+// Relaxed atomics so the exporter may read a slot the thread is rewriting,
+// they are plain moves on x86 and ARM; the head check throws torn slots away
+typedef struct {
+    _Atomic(const char *) name;
+    _Atomic uint64_t start;
+    _Atomic uint64_t data;
+    _Atomic uint32_t type;
+} ProfileSlot;
+
+typedef struct {
+    ProfileSlot events[PROFILER_RING_SIZE];
+    _Atomic uint64_t head;          // events ever written, only the owning thread moves it
+    int32_t id;
+    char name[PROFILER_NAME_LENGTH];
+} ProfilerThread;
+
+static struct {
+    ProfilerThread *threads[PROFILER_MAX_THREADS];
+    atomic_int threadCount;
+    uint64_t origin;                // ticks at trace time 0, the first thread's first event
+    uint64_t originNs;              // CLOCK_MONOTONIC then, to measure the tick rate against
+    double ticksPerUs;              // set by ExportProfilerTrace()
+    pthread_mutex_t lock;           // registration and names only, never taken to record
+} profiler = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+static _Thread_local ProfilerThread *profilerThread = NULL;
+static _Thread_local bool profilerThreadFull = false;
+
+static uint64_t ProfilerNanoseconds(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec*1000000000u + (uint64_t)now.tv_nsec;
+}
+
+static ProfilerThread *ProfilerRegister(void)
+{
+    if (profilerThreadFull) return NULL;
+
+    pthread_mutex_lock(&profiler.lock);
+    int count = atomic_load_explicit(&profiler.threadCount, memory_order_relaxed);
+    ProfilerThread *thread = (count < PROFILER_MAX_THREADS) ? MemCallocTagged(MEM_TAG_OTHER, 1, sizeof(ProfilerThread)) : NULL;
+    if (thread != NULL)
+    {
+        if (count == 0)
+        {
+            profiler.origin = ProfilerTicks();
+            profiler.originNs = ProfilerNanoseconds();
+        }
+        thread->id = count;
+        snprintf(thread->name, PROFILER_NAME_LENGTH, "thread %d", count);
+        profiler.threads[count] = thread;
+        atomic_store_explicit(&profiler.threadCount, count + 1, memory_order_release);
+    }
+    pthread_mutex_unlock(&profiler.lock);
+
+    profilerThread = thread;
+    profilerThreadFull = (thread == NULL);
+    return thread;
+}
+
+static inline void ProfilerPush(ProfileEvent event)
+{
+    ProfilerThread *thread = profilerThread;
+    if (thread == NULL && (thread = ProfilerRegister()) == NULL) return;
+
+    uint64_t head = atomic_load_explicit(&thread->head, memory_order_relaxed);
+    ProfileSlot *slot = &thread->events[head & (PROFILER_RING_SIZE - 1)];
+    atomic_store_explicit(&slot->name, event.name, memory_order_relaxed);
+    atomic_store_explicit(&slot->start, event.start, memory_order_relaxed);
+    atomic_store_explicit(&slot->data, event.data, memory_order_relaxed);
+    atomic_store_explicit(&slot->type, event.type, memory_order_relaxed);
+    atomic_store_explicit(&thread->head, head + 1, memory_order_release);
+}
+
+void ProfileEnd(ProfileZone *zone)
+{
+    ProfilerPush((ProfileEvent){ .name = zone->name, .start = zone->start, .data = ProfilerTicks(), .type = PROFILE_EVENT_ZONE });
+}
+
+void ProfileCounter(const char *name, double value)
+{
+    ProfileEvent event = { .name = name, .start = ProfilerTicks(), .type = PROFILE_EVENT_COUNTER };
+    memcpy(&event.data, &value, sizeof(value));
+    ProfilerPush(event);
+}
+
+void ProfilerSetThreadName(const char *name)
+{
+    ProfilerThread *thread = profilerThread;
+    if (thread == NULL && (thread = ProfilerRegister()) == NULL) return;
+
+    pthread_mutex_lock(&profiler.lock);
+    snprintf(thread->name, PROFILER_NAME_LENGTH, "%s", name);
+    pthread_mutex_unlock(&profiler.lock);
+}
+
+static void ProfilerWriteString(FILE *file, const char *string)
+{
+    fputc('"', file);
+    for (const unsigned char *c = (const unsigned char *)string; *c != '\0'; c++)
+    {
+        if (*c == '"' || *c == '\\') fprintf(file, "\\%c", *c);
+        else if (*c < 0x20) fprintf(file, "\\u%04x", *c);
+        else fputc(*c, file);
+    }
+    fputc('"', file);
+}
+
+// microseconds since the origin, events from before it come out negative
+static double ProfilerMicroseconds(uint64_t ticks)
+{
+    return (double)(int64_t)(ticks - profiler.origin)/profiler.ticksPerUs;
+}
+
+bool ExportProfilerTrace(const char *fileName)
+{
+    ProfileEvent *copy = MemAllocTagged(MEM_TAG_OTHER, sizeof(ProfileEvent)*PROFILER_RING_SIZE);
+    FILE *file = (copy != NULL) ? fopen(fileName, "w") : NULL;
+    if (file == NULL)
+    {
+        MemFreeTagged(copy);
+        return false;
+    }
+
+    // the tick rate over everything recorded so far, exact enough after a few milliseconds
+    uint64_t elapsedNs = ProfilerNanoseconds() - profiler.originNs;
+    uint64_t elapsedTicks = ProfilerTicks() - profiler.origin;
+    profiler.ticksPerUs = (elapsedNs > 0) ? (double)elapsedTicks*1000.0/(double)elapsedNs : 1.0;
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    int count = atomic_load_explicit(&profiler.threadCount, memory_order_acquire);
+    for (int t = 0; t < count; t++)
+    {
+        ProfilerThread *thread = profiler.threads[t];
+        pthread_mutex_lock(&profiler.lock);
+        fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":", (t == 0) ? "" : ",\n", thread->id);
+        ProfilerWriteString(file, thread->name);
+        fprintf(file, "}}");
+        pthread_mutex_unlock(&profiler.lock);
+
+        uint64_t head = atomic_load_explicit(&thread->head, memory_order_acquire);
+        uint64_t first = (head > PROFILER_RING_SIZE) ? head - PROFILER_RING_SIZE : 0;
+        for (uint64_t i = first; i < head; i++)
+        {
+            const ProfileSlot *slot = &thread->events[i & (PROFILER_RING_SIZE - 1)];
+            copy[i & (PROFILER_RING_SIZE - 1)] = (ProfileEvent){
+                atomic_load_explicit(&slot->name, memory_order_relaxed), atomic_load_explicit(&slot->start, memory_order_relaxed),
+                atomic_load_explicit(&slot->data, memory_order_relaxed), atomic_load_explicit(&slot->type, memory_order_relaxed)
+            };
+        }
+        // the thread kept recording during the copy, slots it reached since may be torn
+        uint64_t after = atomic_load_explicit(&thread->head, memory_order_acquire);
+        if (after >= PROFILER_RING_SIZE && after - PROFILER_RING_SIZE + 1 > first) first = after - PROFILER_RING_SIZE + 1;
+
+        for (uint64_t i = first; i < head; i++)
+        {
+            const ProfileEvent *event = &copy[i & (PROFILER_RING_SIZE - 1)];
+            fprintf(file, ",\n{\"name\":");
+            ProfilerWriteString(file, event->name);
+            if (event->type == PROFILE_EVENT_ZONE)
+            {
+                fprintf(file, ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", thread->id,
+                        ProfilerMicroseconds(event->start), (double)(event->data - event->start)/profiler.ticksPerUs);
+            }
+            else
+            {
+                double value;
+                memcpy(&value, &event->data, sizeof(value));
+                fprintf(file, ",\"ph\":\"C\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"args\":{\"value\":%.6g}}", thread->id,
+                        ProfilerMicroseconds(event->start), value);
+            }
+        }
+    }
+    fprintf(file, "\n]}\n");
+    MemFreeTagged(copy);
+    return fclose(file) == 0;
+}
+
+void CloseProfiler(void)
+{
+    pthread_mutex_lock(&profiler.lock);
+    int count = atomic_load_explicit(&profiler.threadCount, memory_order_relaxed);
+    for (int t = 0; t < count; t++)
+    {
+        MemFreeTagged(profiler.threads[t]);
+        profiler.threads[t] = NULL;
+    }
+    atomic_store_explicit(&profiler.threadCount, 0, memory_order_relaxed);
+    pthread_mutex_unlock(&profiler.lock);
+    profilerThread = NULL;
+}
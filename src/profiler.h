@@ -0,0 +1,84 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+// Scoped zone profiler.
+// Every thread records into its own ring of PROFILER_RING_SIZE events, the
+// thread is the only writer so recording takes no lock: beginning a zone
+// reads the clock, ending it reads the clock again and appends one event.
+// On x86 the clock is the TSC (invariant on anything from the last decade),
+// converted to time only when exporting; elsewhere CLOCK_MONOTONIC.
+// Rings wrap, only the most recent events of each thread are kept.
+// ExportProfilerTrace() writes them as Chrome trace JSON, which
+// chrome://tracing and ui.perfetto.dev open.
+//
+//     void UpdateThing(void)
+//     {
+//         PROFILE_ZONE("UpdateThing");        // ends with the enclosing scope
+//         ...
+//         PROFILE_BEGIN(upload, "upload");    // or explicitly
+//         ...
+//         PROFILE_END(upload);
+//         PROFILE_COUNTER("things", count);
+//     }
+//
+// Zone and counter names are not copied, use string literals.
+// Build with -DPROFILER_DISABLED to compile every macro out.
+
+#define PROFILER_RING_SIZE (1 << 15)    // events per thread, power of two
+#define PROFILER_MAX_THREADS 64
+#define PROFILER_NAME_LENGTH 32
+
+typedef struct {
+    const char *name;
+    uint64_t start;                 // ProfilerTicks()
+} ProfileZone;
+
+static inline uint64_t ProfilerTicks(void)
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    return __builtin_ia32_rdtsc();
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec*1000000000u + (uint64_t)now.tv_nsec;
+#endif
+}
+
+static inline ProfileZone ProfileBegin(const char *name)
+{
+    return (ProfileZone){ name, ProfilerTicks() };
+}
+void ProfileEnd(ProfileZone *zone);
+void ProfileCounter(const char *name, double value);
+
+// Names the calling thread in the trace, threads are "thread N" otherwise
+void ProfilerSetThreadName(const char *name);
+
+// Every thread's ring as it is now, threads keep recording meanwhile
+bool ExportProfilerTrace(const char *fileName);
+void CloseProfiler(void);           // after every recording thread stopped
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+#if !defined(PROFILER_DISABLED)
+#define PROFILE_BEGIN(zone, name) ProfileZone zone = ProfileBegin(name)
+#define PROFILE_END(zone) ProfileEnd(&(zone))
+#define PROFILE_COUNTER(name, value) ProfileCounter((name), (double)(value))
+#if defined(__GNUC__)
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__) __attribute__((cleanup(ProfileEnd))) = ProfileBegin(name)
+#else
+#define PROFILE_ZONE(name) ((void)0)
+#endif
+#else
+#define PROFILE_BEGIN(zone, name) ((void)0)
+#define PROFILE_END(zone) ((void)0)
+#define PROFILE_COUNTER(name, value) ((void)0)
+#define PROFILE_ZONE(name) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,269 @@
+#include "pvs.h"
+#include "jobs.h"
+#include "memtrack.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PVS_SAMPLES 4           // open cells per cluster used as ray endpoints
+#define PVS_MAX_CLUSTER_COUNT 65536
+
+typedef struct {
+    const OccupancyGrid *grid;
+    int32_t clustersX;
+    int32_t clusterCount;
+    int32_t rowWords;
+    int32_t *sampleCount;       // per cluster
+    float *samples;             // per cluster PVS_SAMPLES (x, z) pairs
+    uint64_t *matrix;           // dense clusterCount*rowWords
+} PVSBake;
+
+static void PVSGatherSamples(PVSBake *bake, int32_t cluster)
+{
+    const OccupancyGrid *grid = bake->grid;
+    int32_t x0 = (cluster % bake->clustersX)*PVS_CLUSTER_SIZE;
+    int32_t z0 = (cluster / bake->clustersX)*PVS_CLUSTER_SIZE;
+    int32_t open[PVS_CLUSTER_SIZE*PVS_CLUSTER_SIZE];
+    int32_t openCount = 0;
+
+    for (int32_t z = z0; z < z0 + PVS_CLUSTER_SIZE; z++)
+    {
+        for (int32_t x = x0; x < x0 + PVS_CLUSTER_SIZE; x++)
+        {
+            if (!GridIsSolid(grid, x, z)) open[openCount++] = (z - z0)*PVS_CLUSTER_SIZE + (x - x0);
+        }
+    }
+
+    int32_t count = (openCount < PVS_SAMPLES) ? openCount : PVS_SAMPLES;
+    float *out = bake->samples + cluster*PVS_SAMPLES*2;
+    for (int32_t i = 0; i < count; i++)
+    {
+        // spread picks over the open cells instead of taking the first few
+        int32_t cell = open[(i*openCount)/count + (openCount/count)/2];
+        out[i*2 + 0] = (float)(x0 + cell % PVS_CLUSTER_SIZE);
+        out[i*2 + 1] = (float)(z0 + cell / PVS_CLUSTER_SIZE);
+    }
+    bake->sampleCount[cluster] = count;
+}
+
+static bool PVSClustersSeeEachOther(const PVSBake *bake, int32_t a, int32_t b)
+{
+    int32_t ax = a % bake->clustersX, az = a / bake->clustersX;
+    int32_t bx = b % bake->clustersX, bz = b / bake->clustersX;
+
+    // neighbours are always visible, sampling could miss a corner peek
+    if (abs(ax - bx) <= 1 && abs(az - bz) <= 1) return true;
+
+    const float *sa = bake->samples + a*PVS_SAMPLES*2;
+    const float *sb = bake->samples + b*PVS_SAMPLES*2;
+    for (int32_t i = 0; i < bake->sampleCount[a]; i++)
+    {
+        for (int32_t j = 0; j < bake->sampleCount[b]; j++)
+        {
+            if (GridLineOfSight(bake->grid, sa[i*2], sa[i*2 + 1], sb[j*2], sb[j*2 + 1])) return true;
+        }
+    }
+
+    return false;
+}
+
+static void PVSSamplesJob(int32_t begin, int32_t end, void *user)
+{
+    for (int32_t c = begin; c < end; c++) PVSGatherSamples(user, c);
+}
+
+// each job only writes the rows of its own source clusters, upper triangle only
+static void PVSRowsJob(int32_t begin, int32_t end, void *user)
+{
+    PVSBake *bake = user;
+    for (int32_t a = begin; a < end; a++)
+    {
+        // solid clusters keep themselves and their neighbours too, the camera
+        // can still end up inside one (noclip, a spawn inside a wall)
+        uint64_t *row = bake->matrix + (size_t)a*bake->rowWords;
+        row[a >> 6] |= 1ull << (a & 63);
+
+        for (int32_t b = a + 1; b < bake->clusterCount; b++)
+        {
+            if (PVSClustersSeeEachOther(bake, a, b)) row[b >> 6] |= 1ull << (b & 63);
+        }
+    }
+}
+
+static uint64_t PVSHashRow(const uint64_t *row, int32_t words)
+{
+    uint64_t hash = 1469598103934665603ull;
+    for (int32_t i = 0; i < words; i++) hash = (hash ^ row[i])*1099511628211ull;
+    return hash;
+}
+
+// folds identical rows together, the matrix is reused as storage for the unique rows
+static void PVSCompress(PVS *pvs, uint64_t *matrix)
+{
+    int32_t tableSize = 1;
+    while (tableSize < pvs->clusterCount*2) tableSize <<= 1;
+    int32_t *table = MemAllocTagged(MEM_TAG_ASSETS, sizeof(int32_t)*tableSize);
+    memset(table, -1, sizeof(int32_t)*tableSize);
+
+    int32_t unique = 0;
+    size_t rowBytes = sizeof(uint64_t)*pvs->rowWords;
+    for (int32_t c = 0; c < pvs->clusterCount; c++)
+    {
+        const uint64_t *row = matrix + (size_t)c*pvs->rowWords;
+        int32_t slot = (int32_t)(PVSHashRow(row, pvs->rowWords) & (tableSize - 1));
+        while (table[slot] >= 0 && memcmp(matrix + (size_t)table[slot]*pvs->rowWords, row, rowBytes) != 0)
+        {
+            slot = (slot + 1) & (tableSize - 1);
+        }
+
+        if (table[slot] < 0)
+        {
+            // unique rows are compacted in place, never past the row being read
+            if (unique != c) memcpy(matrix + (size_t)unique*pvs->rowWords, row, rowBytes);
+            table[slot] = unique++;
+        }
+        pvs->rowIndex[c] = (uint32_t)table[slot];
+    }
+    MemFreeTagged(table);
+
+    pvs->rowCount = unique;
+    pvs->rows = MemAllocTagged(MEM_TAG_ASSETS, rowBytes*unique);
+    if (pvs->rows != NULL) memcpy(pvs->rows, matrix, rowBytes*unique);
+    MemFreeTagged(matrix);
+}
+
+PVS BakePVS(const OccupancyGrid *grid)
+{
+    PVS pvs = { 0 };
+    if (grid->solid == NULL) return pvs;
+
+    pvs.clustersX = (grid->width + PVS_CLUSTER_SIZE - 1)/PVS_CLUSTER_SIZE;
+    pvs.clustersZ = (grid->height + PVS_CLUSTER_SIZE - 1)/PVS_CLUSTER_SIZE;
+    pvs.clusterCount = pvs.clustersX*pvs.clustersZ;
+    pvs.rowWords = (pvs.clusterCount + 63)/64;
+    if (pvs.clusterCount > PVS_MAX_CLUSTER_COUNT) return (PVS){ 0 };
+
+    PVSBake bake = {
+        .grid = grid,
+        .clustersX = pvs.clustersX,
+        .clusterCount = pvs.clusterCount,
+        .rowWords = pvs.rowWords,
+        .sampleCount = MemCallocTagged(MEM_TAG_ASSETS, pvs.clusterCount, sizeof(int32_t)),
+        .samples = MemCallocTagged(MEM_TAG_ASSETS, (size_t)pvs.clusterCount*PVS_SAMPLES*2, sizeof(float)),
+        .matrix = MemCallocTagged(MEM_TAG_ASSETS, (size_t)pvs.clusterCount*pvs.rowWords, sizeof(uint64_t))
+    };
+    pvs.rowIndex = MemAllocTagged(MEM_TAG_ASSETS, sizeof(uint32_t)*pvs.clusterCount);
+
+    if (bake.sampleCount == NULL || bake.samples == NULL || bake.matrix == NULL || pvs.rowIndex == NULL)
+    {
+        MemFreeTagged(bake.sampleCount);
+        MemFreeTagged(bake.samples);
+        MemFreeTagged(bake.matrix);
+        MemFreeTagged(pvs.rowIndex);
+        return (PVS){ 0 };
+    }
+
+    JobsParallelFor(pvs.clusterCount, 64, PVSSamplesJob, &bake);
+    // rows near the top of the triangle are the longest, keep the grain small so cores stay busy
+    JobsParallelFor(pvs.clusterCount, 4, PVSRowsJob, &bake);
+
+    // mirror the upper triangle, visibility is symmetric
+    for (int32_t a = 0; a < pvs.clusterCount; a++)
+    {
+        const uint64_t *row = bake.matrix + (size_t)a*pvs.rowWords;
+        for (int32_t b = a + 1; b < pvs.clusterCount; b++)
+        {
+            if ((row[b >> 6] >> (b & 63)) & 1u) bake.matrix[(size_t)b*pvs.rowWords + (a >> 6)] |= 1ull << (a & 63);
+        }
+    }
+
+    PVSCompress(&pvs, bake.matrix);
+
+    MemFreeTagged(bake.sampleCount);
+    MemFreeTagged(bake.samples);
+    return pvs;
+}
+
+typedef struct {
+    char magic[4];
+    int32_t version;
+    int32_t clustersX;
+    int32_t clustersZ;
+    int32_t rowWords;
+    int32_t rowCount;
+} PVSFileHeader;
+
+bool SavePVS(const PVS *pvs, const char *fileName)
+{
+    if (!IsPVSReady(pvs)) return false;
+
+    FILE *file = fopen(fileName, "wb");
+    if (file == NULL) return false;
+
+    PVSFileHeader header = {
+        .magic = { 'P', 'V', 'S', ' ' },
+        .version = PVS_FILE_VERSION,
+        .clustersX = pvs->clustersX,
+        .clustersZ = pvs->clustersZ,
+        .rowWords = pvs->rowWords,
+        .rowCount = pvs->rowCount
+    };
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = ok && fwrite(pvs->rowIndex, sizeof(uint32_t), pvs->clusterCount, file) == (size_t)pvs->clusterCount;
+    ok = ok && fwrite(pvs->rows, sizeof(uint64_t)*pvs->rowWords, pvs->rowCount, file) == (size_t)pvs->rowCount;
+    fclose(file);
+
+    return ok;
+}
+
+PVS LoadPVS(const char *fileName)
+{
+    PVS pvs = { 0 };
+    FILE *file = fopen(fileName, "rb");
+    if (file == NULL) return pvs;
+
+    PVSFileHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, "PVS ", 4) != 0 ||
+        header.version != PVS_FILE_VERSION || header.clustersX <= 0 || header.clustersZ <= 0 ||
+        header.clustersX*header.clustersZ > PVS_MAX_CLUSTER_COUNT || header.rowCount <= 0 ||
+        header.rowWords != (header.clustersX*header.clustersZ + 63)/64)
+    {
+        fclose(file);
+        return pvs;
+    }
+
+    pvs.clustersX = header.clustersX;
+    pvs.clustersZ = header.clustersZ;
+    pvs.clusterCount = header.clustersX*header.clustersZ;
+    pvs.rowWords = header.rowWords;
+    pvs.rowCount = header.rowCount;
+    pvs.rowIndex = MemAllocTagged(MEM_TAG_ASSETS, sizeof(uint32_t)*pvs.clusterCount);
+    pvs.rows = MemAllocTagged(MEM_TAG_ASSETS, sizeof(uint64_t)*pvs.rowWords*pvs.rowCount);
+
+    bool ok = pvs.rowIndex != NULL && pvs.rows != NULL;
+    ok = ok && fread(pvs.rowIndex, sizeof(uint32_t), pvs.clusterCount, file) == (size_t)pvs.clusterCount;
+    ok = ok && fread(pvs.rows, sizeof(uint64_t)*pvs.rowWords, pvs.rowCount, file) == (size_t)pvs.rowCount;
+    for (int32_t c = 0; ok && c < pvs.clusterCount; c++) ok = pvs.rowIndex[c] < (uint32_t)pvs.rowCount;
+    fclose(file);
+
+    if (!ok) UnloadPVS(&pvs);
+    return pvs;
+}
+
+bool IsPVSReady(const PVS *pvs)
+{
+    return pvs->rowIndex != NULL && pvs->rows != NULL && pvs->clusterCount > 0;
+}
+
+bool PVSMatchesGrid(const PVS *pvs, const OccupancyGrid *grid)
+{
+    return IsPVSReady(pvs) && pvs->clustersX == (grid->width + PVS_CLUSTER_SIZE - 1)/PVS_CLUSTER_SIZE &&
+           pvs->clustersZ == (grid->height + PVS_CLUSTER_SIZE - 1)/PVS_CLUSTER_SIZE;
+}
+
+void UnloadPVS(PVS *pvs)
+{
+    MemFreeTagged(pvs->rowIndex);
+    MemFreeTagged(pvs->rows);
+    *pvs = (PVS){ 0 };
+}
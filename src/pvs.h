@@ -0,0 +1,59 @@
+#ifndef PVS_H
+#define PVS_H
+
+#include "grid.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Potentially visible sets for cubicmap levels.
+// Cells are grouped into PVS_CLUSTER_SIZE x PVS_CLUSTER_SIZE clusters, a full
+// cell-to-cell matrix of a 400x400 map would be 3.2GB of bits.
+// Each cluster owns one visibility bitset row, identical rows are stored once
+// and clusters point at them through rowIndex, so lookups stay O(1).
+// The bake is 2D, it only holds while the eye is below the wall tops.
+
+#define PVS_CLUSTER_SIZE 8
+#define PVS_FILE_VERSION 2
+
+typedef struct {
+    int32_t clustersX;
+    int32_t clustersZ;
+    int32_t clusterCount;
+    int32_t rowWords;       // uint64_t words per bitset row
+    int32_t rowCount;       // unique rows after deduplication
+    uint32_t *rowIndex;     // clusterCount entries
+    uint64_t *rows;         // rowCount*rowWords words
+} PVS;
+
+PVS BakePVS(const OccupancyGrid *grid);     // runs on the job system
+bool SavePVS(const PVS *pvs, const char *fileName);
+PVS LoadPVS(const char *fileName);
+bool IsPVSReady(const PVS *pvs);
+// A file baked for another map would index out of its clusters, check before use
+bool PVSMatchesGrid(const PVS *pvs, const OccupancyGrid *grid);
+void UnloadPVS(PVS *pvs);
+
+// Over the walls everything in range can be seen, callers skip the PVS there
+static inline bool PVSAppliesAt(float eyeHeight)
+{
+    return eyeHeight <= GRID_WALL_HEIGHT;
+}
+
+static inline int32_t PVSClusterOfCell(const PVS *pvs, int32_t x, int32_t z)
+{
+    return (z/PVS_CLUSTER_SIZE)*pvs->clustersX + x/PVS_CLUSTER_SIZE;
+}
+
+static inline bool PVSClusterVisible(const PVS *pvs, int32_t from, int32_t to)
+{
+    const uint64_t *row = pvs->rows + (size_t)pvs->rowIndex[from]*pvs->rowWords;
+    return (row[to >> 6] >> (to & 63)) & 1u;
+}
+
+static inline bool PVSCellVisible(const PVS *pvs, int32_t fromX, int32_t fromZ, int32_t toX, int32_t toZ)
+{
+    return PVSClusterVisible(pvs, PVSClusterOfCell(pvs, fromX, fromZ), PVSClusterOfCell(pvs, toX, toZ));
+}
+
+#endif
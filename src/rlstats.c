@@ -0,0 +1,1030 @@
+#include "rlstats.h"
+#include "headless.h"
+#include "memtrack.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define RLSTATS_MAX_PROGRAMS 32
+
+// Originals, resolved by the linker's --wrap
+void __real_rlBegin(int mode);
+void __real_rlEnd(void);
+void __real_rlVertex2f(float x, float y);
+void __real_rlVertex3f(float x, float y, float z);
+void __real_rlTexCoord2f(float x, float y);
+void __real_rlNormal3f(float x, float y, float z);
+void __real_rlColor4ub(unsigned char r, unsigned char g, unsigned char b, unsigned char a);
+void __real_rlSetTexture(unsigned int id);
+void __real_rlEnableTexture(unsigned int id);
+void __real_rlPushMatrix(void);
+void __real_rlPopMatrix(void);
+void __real_rlLoadIdentity(void);
+void __real_rlTranslatef(float x, float y, float z);
+void __real_rlRotatef(float angle, float x, float y, float z);
+void __real_rlScalef(float x, float y, float z);
+void __real_rlMultMatrixf(const float *matf);
+void __real_rlDrawVertexArray(int offset, int count);
+void __real_rlDrawVertexArrayElements(int offset, int count, const void *buffer);
+void __real_rlDrawVertexArrayInstanced(int offset, int count, int instances);
+void __real_rlDrawVertexArrayElementsInstanced(int offset, int count, const void *buffer, int instances);
+void __real_rlDrawRenderBatchActive(void);
+void __real_rlMatrixMode(int mode);
+void __real_rlFrustum(double left, double right, double bottom, double top, double znear, double zfar);
+void __real_rlOrtho(double left, double right, double bottom, double top, double znear, double zfar);
+void __real_rlEnableDepthTest(void);
+void __real_rlDisableDepthTest(void);
+void __real_rlEnableBackfaceCulling(void);
+void __real_rlDisableBackfaceCulling(void);
+void __real_ClearBackground(Color color);
+void __real_BeginMode3D(Camera3D camera);
+void __real_EndMode3D(void);
+void __real_BeginTextureMode(RenderTexture2D target);
+void __real_EndTextureMode(void);
+void __real_BeginShaderMode(Shader shader);
+void __real_EndShaderMode(void);
+void __real_BeginBlendMode(int mode);
+void __real_EndBlendMode(void);
+void __real_BeginScissorMode(int x, int y, int width, int height);
+void __real_EndScissorMode(void);
+void __real_EndDrawing(void);
+void __real_rlEnableDepthMask(void);
+void __real_rlDisableDepthMask(void);
+unsigned int __real_rlLoadVertexBuffer(const void *buffer, int size, bool dynamic);
+unsigned int __real_rlLoadVertexBufferElement(const void *buffer, int size, bool dynamic);
+void __real_rlUpdateVertexBuffer(unsigned int id, const void *data, int dataSize, int offset);
+void __real_rlUpdateVertexBufferElements(unsigned int id, const void *data, int dataSize, int offset);
+void __real_rlUnloadVertexBuffer(unsigned int vboId);
+unsigned int __real_rlLoadVertexArray(void);
+void __real_rlUnloadVertexArray(unsigned int vaoId);
+bool __real_rlEnableVertexArray(unsigned int vaoId);
+void __real_rlDisableVertexArray(void);
+void __real_rlEnableVertexBuffer(unsigned int id);
+void __real_rlDisableVertexBuffer(void);
+void __real_rlSetVertexAttribute(unsigned int index, int compSize, int type, bool normalized, int stride, const void *pointer);
+void __real_rlSetVertexAttributeDivisor(unsigned int index, int divisor);
+void __real_rlEnableVertexAttribute(unsigned int index);
+void __real_rlDisableVertexAttribute(unsigned int index);
+unsigned int __real_rlLoadTexture(const void *data, int width, int height, int format, int mipmapCount);
+void __real_rlUpdateTexture(unsigned int id, int offsetX, int offsetY, int width, int height, int format, const void *data);
+void __real_rlUnloadTexture(unsigned int id);
+Shader __real_LoadShaderFromMemory(const char *vsCode, const char *fsCode);
+void __real_rlEnableShader(unsigned int id);
+void __real_rlDisableShader(void);
+void __real_rlSetUniform(int locIndex, const void *value, int uniformType, int count);
+void __real_rlSetUniformMatrix(int locIndex, Matrix mat);
+
+// CPU copies of what rlgl loaded, kept while resources are tracked
+typedef struct {
+    uint8_t *data;
+    uint32_t size;
+} ShadowBuffer;
+
+typedef struct {
+    uint8_t *pixels;                // RGBA8, NULL for render targets and formats we cannot read
+    int32_t width;
+    int32_t height;
+} ShadowTexture;
+
+typedef struct {
+    DrawAttribute attributes[DRAW_MAX_ATTRIBUTES];
+    uint32_t elementBuffer;
+    bool loaded;
+} ShadowVertexArray;
+
+typedef struct {
+    uint32_t id;
+    int32_t kind;                   // DrawProgram
+    int locs[DRAW_UNIFORM_COUNT];
+} ShadowProgram;
+
+static struct {
+    DrawStreamTracker tracker;
+    DrawStats lastFrame;
+    DrawStreamBuffer capture;
+    const char *captureFile;
+    int32_t captureFrames;          // frames left to record
+    bool captureArmed;              // starts with the next frame
+    bool capturing;
+
+    DrawStreamBuffer frame;         // the frame in flight for the hook
+    DrawFrameHook hook;
+    void *hookUser;
+    bool hookArmed;
+    bool hooked;
+    bool suspended;                 // the hook is drawing
+
+    bool tracking;
+    ShadowBuffer *buffers;          // indexed by GL id
+    int32_t bufferCapacity;
+    ShadowTexture *textures;
+    int32_t textureCapacity;
+    ShadowVertexArray *arrays;
+    int32_t arrayCapacity;
+    ShadowProgram programs[RLSTATS_MAX_PROGRAMS];
+    int32_t programCount;
+    uint32_t vertexArray;           // bound, attribute changes land in it
+    uint32_t arrayBuffer;           // bound, attributes read from it
+    uint32_t program;               // bound with rlEnableShader()
+
+    rlRenderBatch batch;            // rlgl's active batch from the end of the first frame on
+    bool batchLoaded;
+    int32_t seenDraws;              // batch state at the last wrapped call
+    int32_t seenVertices;           // in the batch's current draw
+    DrawStats flushed;              // batches and their draws the frame so far, as seen in the batch
+} rlStats = { .tracker = { .mode = RL_QUADS } };
+
+// rlgl also flushes from inside rcore.o, where the wrappers never see it:
+// rlCheckRenderBatchLimit() once the batch is full, a draw or texture switch
+// past RL_DEFAULT_BATCH_DRAWCALLS, BeginMode3D() and the other mode changes.
+// A flush leaves the batch with one empty draw, and between two wrapped calls
+// the batch only ever grows, so whenever its draw count or the current draw's
+// vertices went down since the last look, what was seen then went to the GPU.
+static void ObserveBatch(void)
+{
+    if (!rlStats.batchLoaded) return;
+
+    int32_t draws = rlStats.batch.drawCounter;
+    int32_t vertices = rlStats.batch.draws[draws - 1].vertexCount;
+    bool flushed = draws < rlStats.seenDraws || (draws == rlStats.seenDraws && vertices < rlStats.seenVertices);
+    if (flushed && !rlStats.suspended)
+    {
+        // every draw but the current one was closed with vertices in it
+        rlStats.flushed.batches++;
+        rlStats.flushed.drawCalls += rlStats.seenDraws - ((rlStats.seenVertices > 0) ? 0 : 1);
+    }
+    rlStats.seenDraws = draws;
+    rlStats.seenVertices = vertices;
+}
+
+// rlgl has no way to read its own batch, rlstats hands it one it can read
+static void LoadObservedBatch(void)
+{
+    rlStats.batch = rlLoadRenderBatch(RL_DEFAULT_BATCH_BUFFERS, RL_DEFAULT_BATCH_BUFFER_ELEMENTS);
+    rlSetRenderBatchActive(&rlStats.batch);
+    rlStats.batchLoaded = true;
+    rlStats.seenDraws = 1;
+    rlStats.seenVertices = 0;
+}
+
+void CloseRenderStats(void)
+{
+    if (!rlStats.batchLoaded) return;
+    rlSetRenderBatchActive(NULL);
+    rlUnloadRenderBatch(rlStats.batch);
+    rlStats.batchLoaded = false;
+}
+
+static void RecordOpData(DrawOp op, const void *payload, const void *data, uint32_t size)
+{
+    ObserveBatch();
+    if (rlStats.suspended) return;
+    if (rlStats.capturing && !WriteDrawOpData(&rlStats.capture, op, payload, data, size))
+    {
+        TraceLog(LOG_WARNING, "RLSTATS: out of memory, capture to %s dropped", rlStats.captureFile);
+        UnloadDrawStream(&rlStats.capture);
+        rlStats.capturing = false;
+    }
+    if (rlStats.hooked && !WriteDrawOpData(&rlStats.frame, op, payload, data, size))
+    {
+        TraceLog(LOG_WARNING, "RLSTATS: out of memory, frame hook stopped");
+        UnloadDrawStream(&rlStats.frame);
+        rlStats.hooked = false;
+        rlStats.hook = NULL;
+    }
+}
+
+static void RecordOp(DrawOp op, const void *payload)
+{
+    RecordOpData(op, payload, NULL, 0);
+}
+
+// Resource ops only mean something to a replay that saw the resources load
+static bool RecordingResources(void)
+{
+    return rlStats.tracking && !rlStats.suspended && (rlStats.capturing || rlStats.hooked);
+}
+
+static void RecordFlush(void)
+{
+    DrawTrackFlush(&rlStats.tracker);
+    RecordOp(DRAW_OP_FLUSH, NULL);
+}
+
+DrawStats GetRenderStats(void)
+{
+    return rlStats.lastFrame;
+}
+
+bool StartDrawCapture(const char *fileName, int32_t frames)
+{
+    if (rlStats.capturing || rlStats.captureArmed || frames <= 0) return false;
+    if (!rlStats.tracking) TraceLog(LOG_WARNING, "RLSTATS: resources are not tracked, %s will have no vertex arrays or textures", fileName);
+    rlStats.captureFile = fileName;
+    rlStats.captureFrames = frames;
+    rlStats.captureArmed = true;
+    return true;
+}
+
+bool IsDrawCaptureActive(void)
+{
+    return rlStats.capturing || rlStats.captureArmed;
+}
+
+void TrackDrawResources(void)
+{
+    rlStats.tracking = true;
+}
+
+void SetDrawFrameHook(DrawFrameHook hook, void *user)
+{
+    rlStats.hook = hook;
+    rlStats.hookUser = user;
+    rlStats.hookArmed = (hook != NULL);
+    if (hook == NULL)
+    {
+        UnloadDrawStream(&rlStats.frame);
+        rlStats.hooked = false;
+    }
+}
+
+// Shadow copies
+//----------------------------------------------------------------------------------
+static ShadowBuffer *ShadowGetBuffer(uint32_t id)
+{
+    return (id > 0) ? GetDrawTableEntry((void **)&rlStats.buffers, &rlStats.bufferCapacity, sizeof(ShadowBuffer), id) : NULL;
+}
+
+static ShadowVertexArray *ShadowGetVertexArray(uint32_t id)
+{
+    return (id > 0) ? GetDrawTableEntry((void **)&rlStats.arrays, &rlStats.arrayCapacity, sizeof(ShadowVertexArray), id) : NULL;
+}
+
+static ShadowTexture *ShadowGetTexture(uint32_t id)
+{
+    return (id > 0) ? GetDrawTableEntry((void **)&rlStats.textures, &rlStats.textureCapacity, sizeof(ShadowTexture), id) : NULL;
+}
+
+static ShadowProgram *ShadowFindProgram(uint32_t id)
+{
+    for (int32_t i = 0; i < rlStats.programCount; i++)
+    {
+        if (rlStats.programs[i].id == id) return &rlStats.programs[i];
+    }
+    return NULL;
+}
+
+static ShadowProgram *ShadowAddProgram(uint32_t id, int32_t kind)
+{
+    ShadowProgram *program = ShadowFindProgram(id);
+    if (program == NULL && rlStats.programCount < RLSTATS_MAX_PROGRAMS) program = &rlStats.programs[rlStats.programCount++];
+    if (program == NULL) return NULL;
+    *program = (ShadowProgram){ .id = id, .kind = kind, .locs = { -1, -1, -1, -1 } };
+    return program;
+}
+
+// the default shader is loaded inside rlglInit(), out of reach of the wrappers
+static void ShadowAddDefaultProgram(void)
+{
+    if (ShadowFindProgram(rlGetShaderIdDefault()) != NULL) return;
+    ShadowProgram *program = ShadowAddProgram(rlGetShaderIdDefault(), DRAW_PROGRAM_DEFAULT);
+    if (program == NULL) return;
+    program->locs[DRAW_UNIFORM_MVP] = rlGetShaderLocsDefault()[SHADER_LOC_MATRIX_MVP];
+    program->locs[DRAW_UNIFORM_COLOR] = rlGetShaderLocsDefault()[SHADER_LOC_COLOR_DIFFUSE];
+}
+
+static int32_t ShadowProgramKind(const char *vsCode, const char *fsCode)
+{
+    if (vsCode != NULL && strstr(vsCode, "meshOffset") != NULL) return DRAW_PROGRAM_PACKED;
+    if (vsCode != NULL && strstr(vsCode, "instancePositionSize") != NULL) return DRAW_PROGRAM_PARTICLE;
+    if (vsCode != NULL && strstr(vsCode, "instanceAxisX") != NULL) return DRAW_PROGRAM_SPRITE;
+    if (vsCode == NULL && fsCode != NULL && strstr(fsCode, "dFdx(distance)") != NULL) return DRAW_PROGRAM_SDF;
+    return DRAW_PROGRAM_DEFAULT;
+}
+
+// RGBA8 the way shaders read it, GL swizzles the gray formats to (g, g, g, a)
+static bool ShadowConvertPixels(uint8_t *out, const uint8_t *in, int32_t count, int format)
+{
+    switch (format)
+    {
+        case RL_PIXELFORMAT_UNCOMPRESSED_GRAYSCALE:
+        {
+            for (int32_t i = 0; i < count; i++) out[i*4] = out[i*4 + 1] = out[i*4 + 2] = in[i], out[i*4 + 3] = 255;
+        } break;
+        case RL_PIXELFORMAT_UNCOMPRESSED_GRAY_ALPHA:
+        {
+            for (int32_t i = 0; i < count; i++) out[i*4] = out[i*4 + 1] = out[i*4 + 2] = in[i*2], out[i*4 + 3] = in[i*2 + 1];
+        } break;
+        case RL_PIXELFORMAT_UNCOMPRESSED_R8G8B8:
+        {
+            for (int32_t i = 0; i < count; i++) memcpy(out + i*4, in + i*3, 3), out[i*4 + 3] = 255;
+        } break;
+        case RL_PIXELFORMAT_UNCOMPRESSED_R8G8B8A8: memcpy(out, in, (size_t)count*4); break;
+        default: return false;
+    }
+    return true;
+}
+
+static void AttributePayload(uint8_t *payload, uint32_t array, uint32_t location, const DrawAttribute *attribute)
+{
+    memcpy(payload, (uint32_t[]){ array, location }, 8);
+    memcpy(payload + 8, attribute, sizeof(DrawAttribute));
+}
+
+// Where a replay starts from: screen size, the matrices between frames and,
+// when tracked, every live resource. Uniforms set before this are not known,
+// the renderers here set theirs before every draw.
+static bool RecordBegin(DrawStreamBuffer *buffer)
+{
+    uint8_t state[136];
+    Matrix projection = rlGetMatrixProjection(), modelview = rlGetMatrixModelview();
+    memcpy(state, (int32_t[]){ rlGetFramebufferWidth(), rlGetFramebufferHeight() }, 8);
+    memcpy(state + 8, &projection, sizeof(Matrix));
+    memcpy(state + 72, &modelview, sizeof(Matrix));
+    bool ok = WriteDrawOp(buffer, DRAW_OP_STATE, state);
+    if (!rlStats.tracking) return ok;
+
+    ShadowAddDefaultProgram();
+    for (int32_t i = 0; ok && i < rlStats.programCount; i++)
+    {
+        ok = WriteDrawOp(buffer, DRAW_OP_PROGRAM, (uint32_t[]){ rlStats.programs[i].id, (uint32_t)rlStats.programs[i].kind });
+    }
+    for (int32_t id = 1; ok && id < rlStats.bufferCapacity; id++)
+    {
+        const ShadowBuffer *b = &rlStats.buffers[id];
+        if (b->data == NULL) continue;
+        ok = WriteDrawOp(buffer, DRAW_OP_BUFFER, (uint32_t[]){ id, b->size }) &&
+             WriteDrawOpData(buffer, DRAW_OP_BUFFER_DATA, (uint32_t[]){ id, 0, b->size }, b->data, b->size);
+    }
+    for (int32_t id = 1; ok && id < rlStats.arrayCapacity; id++)
+    {
+        const ShadowVertexArray *array = &rlStats.arrays[id];
+        if (!array->loaded) continue;
+        ok = WriteDrawOp(buffer, DRAW_OP_VERTEX_ARRAY, &(uint32_t){ id });
+        for (uint32_t location = 0; ok && location < DRAW_MAX_ATTRIBUTES; location++)
+        {
+            uint8_t payload[8 + sizeof(DrawAttribute)];
+            AttributePayload(payload, id, location, &array->attributes[location]);
+            ok = WriteDrawOp(buffer, DRAW_OP_ATTRIBUTE, payload);
+        }
+        if (ok && array->elementBuffer != 0) ok = WriteDrawOp(buffer, DRAW_OP_ELEMENT_BUFFER, (uint32_t[]){ id, array->elementBuffer });
+    }
+    for (int32_t id = 1; ok && id < rlStats.textureCapacity; id++)
+    {
+        const ShadowTexture *t = &rlStats.textures[id];
+        if (t->width == 0) continue;
+        ok = WriteDrawOp(buffer, DRAW_OP_TEXTURE, (int32_t[]){ id, t->width, t->height });
+        uint32_t size = (uint32_t)t->width*t->height*4;
+        if (ok && t->pixels != NULL) ok = WriteDrawOpData(buffer, DRAW_OP_TEXTURE_DATA, (int32_t[]){ id, 0, 0, t->width, t->height, (int32_t)size }, t->pixels, size);
+    }
+    return ok;
+}
+
+// Immediate mode
+//----------------------------------------------------------------------------------
+void __wrap_rlBegin(int mode)
+{
+    DrawTrackBegin(&rlStats.tracker, mode);
+    RecordOp(DRAW_OP_BEGIN, &(int32_t){ mode });
+    __real_rlBegin(mode);
+}
+
+void __wrap_rlEnd(void)
+{
+    RecordOp(DRAW_OP_END, NULL);
+    __real_rlEnd();
+}
+
+void __wrap_rlVertex2f(float x, float y)
+{
+    DrawTrackVertex(&rlStats.tracker);
+    RecordOp(DRAW_OP_VERTEX2, (float[]){ x, y });
+    __real_rlVertex2f(x, y);
+}
+
+void __wrap_rlVertex3f(float x, float y, float z)
+{
+    DrawTrackVertex(&rlStats.tracker);
+    RecordOp(DRAW_OP_VERTEX3, (float[]){ x, y, z });
+    __real_rlVertex3f(x, y, z);
+}
+
+void __wrap_rlTexCoord2f(float x, float y)
+{
+    RecordOp(DRAW_OP_TEXCOORD, (float[]){ x, y });
+    __real_rlTexCoord2f(x, y);
+}
+
+void __wrap_rlNormal3f(float x, float y, float z)
+{
+    RecordOp(DRAW_OP_NORMAL, (float[]){ x, y, z });
+    __real_rlNormal3f(x, y, z);
+}
+
+void __wrap_rlColor4ub(unsigned char r, unsigned char g, unsigned char b, unsigned char a)
+{
+    RecordOp(DRAW_OP_COLOR, (uint8_t[]){ r, g, b, a });
+    __real_rlColor4ub(r, g, b, a);
+}
+
+void __wrap_rlSetTexture(unsigned int id)
+{
+    // rlSetTexture(0) keeps the draw's texture, only real switches are recorded
+    if (id != 0)
+    {
+        uint32_t recorded = (id == rlGetTextureIdDefault()) ? 0 : id;
+        DrawTrackSetTexture(&rlStats.tracker, recorded);
+        RecordOp(DRAW_OP_SET_TEXTURE, &recorded);
+    }
+    __real_rlSetTexture(id);
+}
+
+// Matrix stack
+//----------------------------------------------------------------------------------
+void __wrap_rlPushMatrix(void)
+{
+    RecordOp(DRAW_OP_PUSH_MATRIX, NULL);
+    __real_rlPushMatrix();
+}
+
+void __wrap_rlPopMatrix(void)
+{
+    RecordOp(DRAW_OP_POP_MATRIX, NULL);
+    __real_rlPopMatrix();
+}
+
+void __wrap_rlLoadIdentity(void)
+{
+    RecordOp(DRAW_OP_LOAD_IDENTITY, NULL);
+    __real_rlLoadIdentity();
+}
+
+void __wrap_rlTranslatef(float x, float y, float z)
+{
+    RecordOp(DRAW_OP_TRANSLATE, (float[]){ x, y, z });
+    __real_rlTranslatef(x, y, z);
+}
+
+void __wrap_rlRotatef(float angle, float x, float y, float z)
+{
+    RecordOp(DRAW_OP_ROTATE, (float[]){ angle, x, y, z });
+    __real_rlRotatef(angle, x, y, z);
+}
+
+void __wrap_rlScalef(float x, float y, float z)
+{
+    RecordOp(DRAW_OP_SCALE, (float[]){ x, y, z });
+    __real_rlScalef(x, y, z);
+}
+
+void __wrap_rlMultMatrixf(const float *matf)
+{
+    RecordOp(DRAW_OP_MULT_MATRIX, matf);
+    __real_rlMultMatrixf(matf);
+}
+
+void __wrap_rlMatrixMode(int mode)
+{
+    RecordOp(DRAW_OP_MATRIX_MODE, &(int32_t){ mode });
+    __real_rlMatrixMode(mode);
+}
+
+void __wrap_rlFrustum(double left, double right, double bottom, double top, double znear, double zfar)
+{
+    RecordOp(DRAW_OP_FRUSTUM, (float[]){ left, right, bottom, top, znear, zfar });
+    __real_rlFrustum(left, right, bottom, top, znear, zfar);
+}
+
+void __wrap_rlOrtho(double left, double right, double bottom, double top, double znear, double zfar)
+{
+    RecordOp(DRAW_OP_ORTHO, (float[]){ left, right, bottom, top, znear, zfar });
+    __real_rlOrtho(left, right, bottom, top, znear, zfar);
+}
+
+// State a replay needs to rasterize the stream
+//----------------------------------------------------------------------------------
+void __wrap_rlEnableDepthTest(void)
+{
+    RecordOp(DRAW_OP_DEPTH_TEST, &(uint8_t){ 1 });
+    __real_rlEnableDepthTest();
+}
+
+void __wrap_rlDisableDepthTest(void)
+{
+    RecordOp(DRAW_OP_DEPTH_TEST, &(uint8_t){ 0 });
+    __real_rlDisableDepthTest();
+}
+
+void __wrap_rlEnableBackfaceCulling(void)
+{
+    RecordOp(DRAW_OP_CULL_FACE, &(uint8_t){ 1 });
+    __real_rlEnableBackfaceCulling();
+}
+
+void __wrap_rlDisableBackfaceCulling(void)
+{
+    RecordOp(DRAW_OP_CULL_FACE, &(uint8_t){ 0 });
+    __real_rlDisableBackfaceCulling();
+}
+
+void __wrap_rlEnableDepthMask(void)
+{
+    RecordOp(DRAW_OP_DEPTH_MASK, &(uint8_t){ 1 });
+    __real_rlEnableDepthMask();
+}
+
+void __wrap_rlDisableDepthMask(void)
+{
+    RecordOp(DRAW_OP_DEPTH_MASK, &(uint8_t){ 0 });
+    __real_rlDisableDepthMask();
+}
+
+void __wrap_ClearBackground(Color color)
+{
+    RecordOp(DRAW_OP_CLEAR, (uint8_t[]){ color.r, color.g, color.b, color.a });
+    __real_ClearBackground(color);
+}
+
+// Vertex arrays, DrawMesh() and our own instanced renderers
+//----------------------------------------------------------------------------------
+void __wrap_rlEnableTexture(unsigned int id)
+{
+    DrawTrackEnableTexture(&rlStats.tracker);
+    RecordOp(DRAW_OP_ENABLE_TEXTURE, &(uint32_t){ (id == rlGetTextureIdDefault()) ? 0 : id });
+    __real_rlEnableTexture(id);
+}
+
+void __wrap_rlDrawVertexArray(int offset, int count)
+{
+    DrawTrackVertexArray(&rlStats.tracker, count, 1);
+    RecordOp(DRAW_OP_DRAW_ARRAYS, (int32_t[]){ offset, count, 1 });
+    __real_rlDrawVertexArray(offset, count);
+}
+
+void __wrap_rlDrawVertexArrayElements(int offset, int count, const void *buffer)
+{
+    DrawTrackVertexArray(&rlStats.tracker, count, 1);
+    RecordOp(DRAW_OP_DRAW_ELEMENTS, (int32_t[]){ offset, count, 1 });
+    __real_rlDrawVertexArrayElements(offset, count, buffer);
+}
+
+void __wrap_rlDrawVertexArrayInstanced(int offset, int count, int instances)
+{
+    // rlgl draws instanced arrays from the first vertex whatever offset says
+    DrawTrackVertexArray(&rlStats.tracker, count, instances);
+    RecordOp(DRAW_OP_DRAW_ARRAYS, (int32_t[]){ 0, count, instances });
+    __real_rlDrawVertexArrayInstanced(offset, count, instances);
+}
+
+void __wrap_rlDrawVertexArrayElementsInstanced(int offset, int count, const void *buffer, int instances)
+{
+    DrawTrackVertexArray(&rlStats.tracker, count, instances);
+    RecordOp(DRAW_OP_DRAW_ELEMENTS, (int32_t[]){ offset, count, instances });
+    __real_rlDrawVertexArrayElementsInstanced(offset, count, buffer, instances);
+}
+
+// Resources vertex array draws read, shadowed while tracked
+//----------------------------------------------------------------------------------
+static void ShadowLoadBuffer(uint32_t id, const void *data, int size)
+{
+    ShadowBuffer *b = rlStats.tracking ? ShadowGetBuffer(id) : NULL;
+    if (b == NULL || size <= 0) return;
+    MemFreeTagged(b->data);
+    b->data = MemCallocTagged(MEM_TAG_RENDER, 1, size);
+    b->size = (b->data != NULL) ? (uint32_t)size : 0;
+    if (b->data != NULL && data != NULL) memcpy(b->data, data, size);
+
+    if (!RecordingResources()) return;
+    RecordOp(DRAW_OP_BUFFER, (uint32_t[]){ id, b->size });
+    if (data != NULL) RecordOpData(DRAW_OP_BUFFER_DATA, (uint32_t[]){ id, 0, b->size }, b->data, b->size);
+}
+
+static void ShadowUpdateBuffer(uint32_t id, const void *data, int size, int offset)
+{
+    ShadowBuffer *b = rlStats.tracking ? ShadowGetBuffer(id) : NULL;
+    if (b == NULL || b->data == NULL || data == NULL || offset < 0 || size <= 0 || (uint32_t)offset + (uint32_t)size > b->size) return;
+    memcpy(b->data + offset, data, size);
+    if (RecordingResources()) RecordOpData(DRAW_OP_BUFFER_DATA, (uint32_t[]){ id, offset, size }, data, size);
+}
+
+static void ShadowAttributeChanged(uint32_t location)
+{
+    ShadowVertexArray *array = rlStats.tracking ? ShadowGetVertexArray(rlStats.vertexArray) : NULL;
+    if (array == NULL || location >= DRAW_MAX_ATTRIBUTES || !RecordingResources()) return;
+    uint8_t payload[8 + sizeof(DrawAttribute)];
+    AttributePayload(payload, rlStats.vertexArray, location, &array->attributes[location]);
+    RecordOp(DRAW_OP_ATTRIBUTE, payload);
+}
+
+static DrawAttribute *ShadowAttribute(uint32_t location)
+{
+    ShadowVertexArray *array = rlStats.tracking ? ShadowGetVertexArray(rlStats.vertexArray) : NULL;
+    return (array != NULL && location < DRAW_MAX_ATTRIBUTES) ? &array->attributes[location] : NULL;
+}
+
+unsigned int __wrap_rlLoadVertexBuffer(const void *buffer, int size, bool dynamic)
+{
+    unsigned int id = __real_rlLoadVertexBuffer(buffer, size, dynamic);
+    rlStats.arrayBuffer = id;
+    ShadowLoadBuffer(id, buffer, size);
+    return id;
+}
+
+unsigned int __wrap_rlLoadVertexBufferElement(const void *buffer, int size, bool dynamic)
+{
+    unsigned int id = __real_rlLoadVertexBufferElement(buffer, size, dynamic);
+    ShadowLoadBuffer(id, buffer, size);
+
+    // binding it is what attaches it to the bound vertex array
+    ShadowVertexArray *array = rlStats.tracking ? ShadowGetVertexArray(rlStats.vertexArray) : NULL;
+    if (array != NULL)
+    {
+        array->elementBuffer = id;
+        if (RecordingResources()) RecordOp(DRAW_OP_ELEMENT_BUFFER, (uint32_t[]){ rlStats.vertexArray, id });
+    }
+    return id;
+}
+
+void __wrap_rlUpdateVertexBuffer(unsigned int id, const void *data, int dataSize, int offset)
+{
+    __real_rlUpdateVertexBuffer(id, data, dataSize, offset);
+    rlStats.arrayBuffer = id;
+    ShadowUpdateBuffer(id, data, dataSize, offset);
+}
+
+void __wrap_rlUpdateVertexBufferElements(unsigned int id, const void *data, int dataSize, int offset)
+{
+    __real_rlUpdateVertexBufferElements(id, data, dataSize, offset);
+    ShadowUpdateBuffer(id, data, dataSize, offset);
+}
+
+void __wrap_rlUnloadVertexBuffer(unsigned int vboId)
+{
+    ShadowBuffer *b = rlStats.tracking ? ShadowGetBuffer(vboId) : NULL;
+    if (b != NULL && b->data != NULL)
+    {
+        MemFreeTagged(b->data);
+        *b = (ShadowBuffer){ 0 };
+        if (RecordingResources()) RecordOp(DRAW_OP_BUFFER, (uint32_t[]){ vboId, 0 });
+    }
+    __real_rlUnloadVertexBuffer(vboId);
+}
+
+unsigned int __wrap_rlLoadVertexArray(void)
+{
+    unsigned int id = __real_rlLoadVertexArray();
+    ShadowVertexArray *array = rlStats.tracking ? ShadowGetVertexArray(id) : NULL;
+    if (array != NULL)
+    {
+        *array = (ShadowVertexArray){ .loaded = true };
+        if (RecordingResources()) RecordOp(DRAW_OP_VERTEX_ARRAY, &(uint32_t){ id });
+    }
+    return id;
+}
+
+void __wrap_rlUnloadVertexArray(unsigned int vaoId)
+{
+    ShadowVertexArray *array = rlStats.tracking ? ShadowGetVertexArray(vaoId) : NULL;
+    if (array != NULL && array->loaded)
+    {
+        *array = (ShadowVertexArray){ 0 };
+        if (RecordingResources()) RecordOp(DRAW_OP_VERTEX_ARRAY, &(uint32_t){ vaoId });
+    }
+    if (rlStats.vertexArray == vaoId) rlStats.vertexArray = 0;
+    __real_rlUnloadVertexArray(vaoId);
+}
+
+bool __wrap_rlEnableVertexArray(unsigned int vaoId)
+{
+    bool result = __real_rlEnableVertexArray(vaoId);
+    rlStats.vertexArray = result ? vaoId : 0;
+    if (RecordingResources()) RecordOp(DRAW_OP_BIND_VERTEX_ARRAY, &rlStats.vertexArray);
+    return result;
+}
+
+void __wrap_rlDisableVertexArray(void)
+{
+    __real_rlDisableVertexArray();
+    rlStats.vertexArray = 0;
+    if (RecordingResources()) RecordOp(DRAW_OP_BIND_VERTEX_ARRAY, &rlStats.vertexArray);
+}
+
+void __wrap_rlEnableVertexBuffer(unsigned int id)
+{
+    __real_rlEnableVertexBuffer(id);
+    rlStats.arrayBuffer = id;
+}
+
+void __wrap_rlDisableVertexBuffer(void)
+{
+    __real_rlDisableVertexBuffer();
+    rlStats.arrayBuffer = 0;
+}
+
+void __wrap_rlSetVertexAttribute(unsigned int index, int compSize, int type, bool normalized, int stride, const void *pointer)
+{
+    __real_rlSetVertexAttribute(index, compSize, type, normalized, stride, pointer);
+    DrawAttribute *attribute = ShadowAttribute(index);
+    if (attribute == NULL) return;
+    attribute->buffer = rlStats.arrayBuffer;
+    attribute->components = compSize;
+    attribute->type = type;
+    attribute->normalized = normalized;
+    attribute->stride = stride;
+    attribute->offset = (int32_t)(uintptr_t)pointer;
+    ShadowAttributeChanged(index);
+}
+
+void __wrap_rlSetVertexAttributeDivisor(unsigned int index, int divisor)
+{
+    __real_rlSetVertexAttributeDivisor(index, divisor);
+    DrawAttribute *attribute = ShadowAttribute(index);
+    if (attribute == NULL) return;
+    attribute->divisor = divisor;
+    ShadowAttributeChanged(index);
+}
+
+void __wrap_rlEnableVertexAttribute(unsigned int index)
+{
+    __real_rlEnableVertexAttribute(index);
+    DrawAttribute *attribute = ShadowAttribute(index);
+    if (attribute == NULL) return;
+    attribute->enabled = 1;
+    ShadowAttributeChanged(index);
+}
+
+void __wrap_rlDisableVertexAttribute(unsigned int index)
+{
+    __real_rlDisableVertexAttribute(index);
+    DrawAttribute *attribute = ShadowAttribute(index);
+    if (attribute == NULL) return;
+    attribute->enabled = 0;
+    ShadowAttributeChanged(index);
+}
+
+unsigned int __wrap_rlLoadTexture(const void *data, int width, int height, int format, int mipmapCount)
+{
+    unsigned int id = __real_rlLoadTexture(data, width, height, format, mipmapCount);
+    ShadowTexture *t = (rlStats.tracking && !rlStats.suspended) ? ShadowGetTexture(id) : NULL;
+    if (t == NULL || width <= 0 || height <= 0) return id;
+
+    // level 0 only, the replay samples without mipmaps
+    MemFreeTagged(t->pixels);
+    *t = (ShadowTexture){ .width = width, .height = height };
+    if (data != NULL)
+    {
+        t->pixels = MemAllocTagged(MEM_TAG_RENDER, (size_t)width*height*4);
+        if (t->pixels != NULL && !ShadowConvertPixels(t->pixels, data, width*height, format))
+        {
+            MemFreeTagged(t->pixels);
+            t->pixels = NULL;
+        }
+    }
+
+    if (!RecordingResources()) return id;
+    uint32_t size = (uint32_t)width*height*4;
+    RecordOp(DRAW_OP_TEXTURE, (int32_t[]){ id, width, height });
+    if (t->pixels != NULL) RecordOpData(DRAW_OP_TEXTURE_DATA, (int32_t[]){ id, 0, 0, width, height, (int32_t)size }, t->pixels, size);
+    return id;
+}
+
+void __wrap_rlUpdateTexture(unsigned int id, int offsetX, int offsetY, int width, int height, int format, const void *data)
+{
+    __real_rlUpdateTexture(id, offsetX, offsetY, width, height, format, data);
+    ShadowTexture *t = (rlStats.tracking && !rlStats.suspended) ? ShadowGetTexture(id) : NULL;
+    if (t == NULL || t->pixels == NULL || data == NULL || offsetX < 0 || offsetY < 0 || width <= 0 || height <= 0 ||
+        offsetX + width > t->width || offsetY + height > t->height) return;
+
+    uint32_t size = (uint32_t)width*height*4;
+    uint8_t *rect = MemAllocTagged(MEM_TAG_RENDER, size);
+    if (rect == NULL) return;
+    if (ShadowConvertPixels(rect, data, width*height, format))
+    {
+        for (int y = 0; y < height; y++) memcpy(t->pixels + ((size_t)(offsetY + y)*t->width + offsetX)*4, rect + (size_t)y*width*4, (size_t)width*4);
+        if (RecordingResources()) RecordOpData(DRAW_OP_TEXTURE_DATA, (int32_t[]){ id, offsetX, offsetY, width, height, (int32_t)size }, rect, size);
+    }
+    MemFreeTagged(rect);
+}
+
+void __wrap_rlUnloadTexture(unsigned int id)
+{
+    ShadowTexture *t = rlStats.tracking ? ShadowGetTexture(id) : NULL;
+    if (t != NULL && t->width > 0)
+    {
+        MemFreeTagged(t->pixels);
+        *t = (ShadowTexture){ 0 };
+        if (RecordingResources()) RecordOp(DRAW_OP_TEXTURE, (int32_t[]){ id, 0, 0 });
+    }
+    __real_rlUnloadTexture(id);
+}
+
+// Shaders and the uniforms a replay needs
+//----------------------------------------------------------------------------------
+Shader __wrap_LoadShaderFromMemory(const char *vsCode, const char *fsCode)
+{
+    Shader shader = __real_LoadShaderFromMemory(vsCode, fsCode);
+    if (!rlStats.tracking || shader.id == rlGetShaderIdDefault()) return shader;
+
+    int32_t kind = ShadowProgramKind(vsCode, fsCode);
+    ShadowProgram *program = ShadowAddProgram(shader.id, kind);
+    if (program == NULL) return shader;
+    program->locs[DRAW_UNIFORM_MVP] = shader.locs[SHADER_LOC_MATRIX_MVP];
+    program->locs[DRAW_UNIFORM_COLOR] = shader.locs[SHADER_LOC_COLOR_DIFFUSE];
+    if (kind == DRAW_PROGRAM_PACKED)
+    {
+        program->locs[DRAW_UNIFORM_PARAM0] = GetShaderLocation(shader, "meshOffset");
+        program->locs[DRAW_UNIFORM_PARAM1] = GetShaderLocation(shader, "meshScale");
+    }
+    else if (kind == DRAW_PROGRAM_PARTICLE)
+    {
+        program->locs[DRAW_UNIFORM_PARAM0] = GetShaderLocation(shader, "cameraRight");
+        program->locs[DRAW_UNIFORM_PARAM1] = GetShaderLocation(shader, "cameraUp");
+    }
+    if (RecordingResources()) RecordOp(DRAW_OP_PROGRAM, (uint32_t[]){ shader.id, (uint32_t)kind });
+    return shader;
+}
+
+void __wrap_rlEnableShader(unsigned int id)
+{
+    __real_rlEnableShader(id);
+    rlStats.program = id;
+    if (RecordingResources()) RecordOp(DRAW_OP_BIND_PROGRAM, &rlStats.program);
+}
+
+void __wrap_rlDisableShader(void)
+{
+    __real_rlDisableShader();
+    rlStats.program = 0;
+    if (RecordingResources()) RecordOp(DRAW_OP_BIND_PROGRAM, &rlStats.program);
+}
+
+static void RecordUniform(int location, const float *value, int count)
+{
+    const ShadowProgram *program = ShadowFindProgram(rlStats.program);
+    if (program == NULL || location < 0 || !RecordingResources()) return;
+    for (int32_t slot = 0; slot < DRAW_UNIFORM_COUNT; slot++)
+    {
+        if (program->locs[slot] != location) continue;
+        uint8_t payload[72] = { 0 };
+        memcpy(payload, (uint32_t[]){ program->id, (uint32_t)slot }, 8);
+        memcpy(payload + 8, value, sizeof(float)*count);
+        RecordOp(DRAW_OP_UNIFORM, payload);
+    }
+}
+
+void __wrap_rlSetUniform(int locIndex, const void *value, int uniformType, int count)
+{
+    __real_rlSetUniform(locIndex, value, uniformType, count);
+    // float and vec2..vec4 are all the replay reads, one element of them
+    if (uniformType >= RL_SHADER_UNIFORM_FLOAT && uniformType <= RL_SHADER_UNIFORM_VEC4 && count >= 1)
+    {
+        RecordUniform(locIndex, value, uniformType - RL_SHADER_UNIFORM_FLOAT + 1);
+    }
+}
+
+void __wrap_rlSetUniformMatrix(int locIndex, Matrix mat)
+{
+    __real_rlSetUniformMatrix(locIndex, mat);
+    RecordUniform(locIndex, (const float *)&mat, 16);
+}
+
+// Everything that draws the render batch. Shader and blend changes only
+// flush when the state really changes, counting them always is close enough:
+// a flush of an empty batch is not counted as a batch.
+//----------------------------------------------------------------------------------
+void __wrap_rlDrawRenderBatchActive(void)
+{
+    RecordFlush();
+    __real_rlDrawRenderBatchActive();
+}
+
+void __wrap_BeginMode3D(Camera3D camera)
+{
+    RecordFlush();
+    __real_BeginMode3D(camera);
+}
+
+void __wrap_EndMode3D(void)
+{
+    RecordFlush();
+    __real_EndMode3D();
+}
+
+void __wrap_BeginTextureMode(RenderTexture2D target)
+{
+    RecordFlush();
+    RecordOp(DRAW_OP_TARGET, (int32_t[]){ (int32_t)target.texture.id, target.texture.width, target.texture.height });
+    __real_BeginTextureMode(target);
+}
+
+void __wrap_EndTextureMode(void)
+{
+    RecordFlush();
+    if (IsHeadless()) HeadlessEndTextureMode();
+    else __real_EndTextureMode();
+    // the screen's size, only known once the target's is gone
+    RecordOp(DRAW_OP_TARGET, (int32_t[]){ 0, rlGetFramebufferWidth(), rlGetFramebufferHeight() });
+}
+
+void __wrap_BeginShaderMode(Shader shader)
+{
+    RecordFlush();
+    if (RecordingResources()) RecordOp(DRAW_OP_BATCH_PROGRAM, &(uint32_t){ shader.id });
+    __real_BeginShaderMode(shader);
+}
+
+void __wrap_EndShaderMode(void)
+{
+    RecordFlush();
+    if (RecordingResources()) RecordOp(DRAW_OP_BATCH_PROGRAM, &(uint32_t){ rlGetShaderIdDefault() });
+    __real_EndShaderMode();
+}
+
+void __wrap_BeginBlendMode(int mode)
+{
+    RecordFlush();
+    __real_BeginBlendMode(mode);
+}
+
+void __wrap_EndBlendMode(void)
+{
+    RecordFlush();
+    __real_EndBlendMode();
+}
+
+void __wrap_BeginScissorMode(int x, int y, int width, int height)
+{
+    RecordFlush();
+    __real_BeginScissorMode(x, y, width, height);
+}
+
+void __wrap_EndScissorMode(void)
+{
+    RecordFlush();
+    __real_EndScissorMode();
+}
+
+void __wrap_EndDrawing(void)
+{
+    RecordFlush();
+    if (rlStats.hooked)
+    {
+        // what the hook draws goes to the screen, not into streams or counters;
+        // the frame's batch goes out first so the hook's draws are not in it
+        __real_rlDrawRenderBatchActive();
+        ObserveBatch();
+        DrawStreamTracker tracker = rlStats.tracker;
+        rlStats.suspended = true;
+        rlStats.hook(rlStats.frame.data, rlStats.frame.size, rlStats.hookUser);
+        rlStats.tracker = tracker;
+    }
+    // without a window there is nothing to swap, the batch still has to go out
+    if (IsHeadless()) __real_rlDrawRenderBatchActive();
+    else __real_EndDrawing();
+    ObserveBatch();
+    rlStats.suspended = false;
+
+    RecordOp(DRAW_OP_FRAME, NULL);
+    rlStats.frame.size = 0;
+    rlStats.lastFrame = rlStats.tracker.stats;
+    // the stream's own batch count only knows the flushes that were wrapped
+    if (rlStats.batchLoaded)
+    {
+        rlStats.lastFrame.batches = rlStats.flushed.batches;
+        rlStats.lastFrame.drawCalls = rlStats.flushed.drawCalls + rlStats.tracker.stats.meshDraws;
+    }
+    else LoadObservedBatch();
+    rlStats.tracker.stats = (DrawStats){ 0 };
+    rlStats.flushed = (DrawStats){ 0 };
+
+    if (rlStats.capturing && --rlStats.captureFrames == 0)
+    {
+        if (SaveDrawStream(&rlStats.capture, rlStats.captureFile))
+        {
+            TraceLog(LOG_INFO, "RLSTATS: %d frames, %zu bytes captured to %s", rlStats.capture.frameCount, rlStats.capture.size, rlStats.captureFile);
+        }
+        else TraceLog(LOG_WARNING, "RLSTATS: cannot write %s", rlStats.captureFile);
+        UnloadDrawStream(&rlStats.capture);
+        rlStats.capturing = false;
+    }
+    if (rlStats.captureArmed)
+    {
+        rlStats.captureArmed = false;
+        rlStats.capturing = RecordBegin(&rlStats.capture);
+        if (!rlStats.capturing)
+        {
+            TraceLog(LOG_WARNING, "RLSTATS: out of memory, capture to %s dropped", rlStats.captureFile);
+            UnloadDrawStream(&rlStats.capture);
+        }
+    }
+    if (rlStats.hookArmed)
+    {
+        rlStats.hookArmed = false;
+        rlStats.hooked = RecordBegin(&rlStats.frame);
+        if (!rlStats.hooked)
+        {
+            TraceLog(LOG_WARNING, "RLSTATS: out of memory, frame hook stopped");
+            UnloadDrawStream(&rlStats.frame);
+            rlStats.hook = NULL;
+        }
+    }
+}
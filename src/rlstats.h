@@ -0,0 +1,48 @@
+#ifndef RLSTATS_H
+#define RLSTATS_H
+
+#include "drawstream.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Per frame render counters and draw stream capture at the rlgl layer.
+// The rlgl entry points raylib's shape, texture, text and model modules call
+// are interposed with the linker's --wrap (RLGL_WRAP in the Makefile), so
+// every DrawCube(), DrawTexturePro() or DrawMesh() is seen without touching
+// raylib. This needs raylib linked statically: calls inside a shared
+// libraylib never reach the wrappers and the counters stay at zero.
+//
+// Frames end at EndDrawing().
+//
+// Batches and batch draw calls are not taken from the wrapped calls: rlgl
+// flushes from inside rcore.o too, which --wrap cannot reach. After the first
+// frame rlstats makes a render batch of its own rlgl's active one and counts
+// the flushes it sees happen to it, wherever they came from; the first frame
+// only has the wrapped ones. CloseRenderStats() gives rlgl its batch back.
+//
+// Vertex array draws read GPU buffers the stream cannot see, so with
+// TrackDrawResources() the loads and updates of vertex buffers, vertex array
+// layouts, textures and shaders are wrapped too and a CPU copy of each is
+// kept; captures then open with all of them and replay with geometry.
+
+// Counters of the last finished frame
+DrawStats GetRenderStats(void);
+// Before CloseWindow()
+void CloseRenderStats(void);
+
+// Records the next frames into fileName, written when the last one ends
+bool StartDrawCapture(const char *fileName, int32_t frames);
+bool IsDrawCaptureActive(void);
+
+// Before InitWindow(), raylib uploads its default font there. Costs a CPU
+// copy of every vertex buffer and texture (RGBA8) for the rest of the run.
+void TrackDrawResources(void);
+
+// ops/size is the frame so far, up to the last render batch flush; the first
+// frame opens with the STATE op and the tracked resources
+typedef void (*DrawFrameHook)(const uint8_t *ops, size_t size, void *user);
+// hook runs at every EndDrawing() from the next frame on, before the buffers
+// swap; what it draws is not recorded or counted. NULL stops it.
+void SetDrawFrameHook(DrawFrameHook hook, void *user);
+
+#endif
@@ -0,0 +1,371 @@
+#include "simplify.h"
+#include "memtrack.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SIMPLIFY_MAX_ITERATIONS 100
+#define SIMPLIFY_MAX_VALENCE 64
+#define SIMPLIFY_FLIP_LIMIT 0.2f    // min cosine between a face normal before and after a collapse
+
+typedef struct {
+    float position[3];
+    float normal[3];
+    float texcoord[2];
+} SimplifyAttributes;               // weld key, compared bytewise
+
+typedef struct {
+    SimplifyAttributes attr;
+    double q[10];                   // symmetric 4x4 quadric, upper triangle
+    int32_t refStart;
+    int32_t refCount;
+    bool border;
+} SimplifyVertex;
+
+typedef struct {
+    int32_t v[3];
+    bool deleted;
+    bool dirty;                     // touched by a collapse this pass, adjacency is stale
+} SimplifyTriangle;
+
+typedef struct {
+    SimplifyVertex *vertices;
+    int32_t vertexCount;
+    SimplifyTriangle *triangles;
+    int32_t triangleCount;
+    int32_t liveTriangles;
+    int32_t *refs;                  // triangles around each vertex, rebuilt every pass
+} Simplifier;
+
+static uint32_t SimplifyHash(const SimplifyAttributes *attr)
+{
+    uint32_t words[sizeof(SimplifyAttributes)/sizeof(uint32_t)];
+    memcpy(words, attr, sizeof(words));
+
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < (int)(sizeof(words)/sizeof(words[0])); i++) hash = (hash ^ words[i])*16777619u;
+    return hash;
+}
+
+static bool SimplifyWeld(Simplifier *s, const Mesh *mesh)
+{
+    int32_t tableSize = 1;
+    while (tableSize < mesh->vertexCount*2) tableSize <<= 1;
+    int32_t *table = MemAllocTagged(MEM_TAG_ASSETS, sizeof(int32_t)*tableSize);
+    int32_t *remap = MemAllocTagged(MEM_TAG_ASSETS, sizeof(int32_t)*mesh->vertexCount);
+    s->vertices = MemCallocTagged(MEM_TAG_ASSETS, mesh->vertexCount, sizeof(SimplifyVertex));
+    s->triangles = MemCallocTagged(MEM_TAG_ASSETS, mesh->triangleCount, sizeof(SimplifyTriangle));
+    s->refs = MemAllocTagged(MEM_TAG_ASSETS, sizeof(int32_t)*3*mesh->triangleCount);
+    bool ok = table != NULL && remap != NULL && s->vertices != NULL && s->triangles != NULL && s->refs != NULL;
+
+    for (int32_t i = 0; ok && i < tableSize; i++) table[i] = -1;
+    for (int32_t i = 0; ok && i < mesh->vertexCount; i++)
+    {
+        SimplifyAttributes attr = { 0 };
+        memcpy(attr.position, &mesh->vertices[i*3], sizeof(attr.position));
+        if (mesh->normals != NULL) memcpy(attr.normal, &mesh->normals[i*3], sizeof(attr.normal));
+        if (mesh->texcoords != NULL) memcpy(attr.texcoord, &mesh->texcoords[i*2], sizeof(attr.texcoord));
+
+        uint32_t slot = SimplifyHash(&attr) & (tableSize - 1);
+        while (table[slot] >= 0 && memcmp(&s->vertices[table[slot]].attr, &attr, sizeof(attr)) != 0) slot = (slot + 1) & (tableSize - 1);
+        if (table[slot] < 0)
+        {
+            table[slot] = s->vertexCount;
+            s->vertices[s->vertexCount++].attr = attr;
+        }
+        remap[i] = table[slot];
+    }
+
+    for (int32_t t = 0; ok && t < mesh->triangleCount; t++)
+    {
+        SimplifyTriangle tri = { 0 };
+        for (int k = 0; k < 3; k++) tri.v[k] = remap[(mesh->indices != NULL) ? mesh->indices[t*3 + k] : t*3 + k];
+        // degenerate after welding, nothing to keep
+        if (tri.v[0] == tri.v[1] || tri.v[1] == tri.v[2] || tri.v[0] == tri.v[2]) continue;
+        s->triangles[s->triangleCount++] = tri;
+    }
+    s->liveTriangles = s->triangleCount;
+
+    MemFreeTagged(remap);
+    MemFreeTagged(table);
+    return ok;
+}
+
+static void SimplifyBuildRefs(Simplifier *s)
+{
+    for (int32_t i = 0; i < s->vertexCount; i++) s->vertices[i].refCount = 0;
+    for (int32_t t = 0; t < s->triangleCount; t++)
+    {
+        SimplifyTriangle *tri = &s->triangles[t];
+        tri->dirty = false;
+        if (tri->deleted) continue;
+        for (int k = 0; k < 3; k++) s->vertices[tri->v[k]].refCount++;
+    }
+
+    int32_t start = 0;
+    for (int32_t i = 0; i < s->vertexCount; i++)
+    {
+        s->vertices[i].refStart = start;
+        start += s->vertices[i].refCount;
+        s->vertices[i].refCount = 0;
+    }
+
+    for (int32_t t = 0; t < s->triangleCount; t++)
+    {
+        if (s->triangles[t].deleted) continue;
+        for (int k = 0; k < 3; k++)
+        {
+            SimplifyVertex *v = &s->vertices[s->triangles[t].v[k]];
+            s->refs[v->refStart + v->refCount++] = t;
+        }
+    }
+}
+
+static bool SimplifyHasVertex(const SimplifyTriangle *tri, int32_t v)
+{
+    return tri->v[0] == v || tri->v[1] == v || tri->v[2] == v;
+}
+
+static Vector3 SimplifyFaceNormal(const float *p0, const float *p1, const float *p2)
+{
+    Vector3 e1 = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+    Vector3 e2 = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+    return (Vector3){ e1.y*e2.z - e1.z*e2.y, e1.z*e2.x - e1.x*e2.z, e1.x*e2.y - e1.y*e2.x };
+}
+
+// edges that belong to a single triangle stay, it keeps borders and seams closed
+static void SimplifyMarkBorders(Simplifier *s)
+{
+    for (int32_t v = 0; v < s->vertexCount; v++)
+    {
+        const SimplifyVertex *vertex = &s->vertices[v];
+        for (int32_t i = 0; i < vertex->refCount; i++)
+        {
+            const SimplifyTriangle *tri = &s->triangles[s->refs[vertex->refStart + i]];
+            for (int k = 0; k < 3; k++)
+            {
+                int32_t other = tri->v[k];
+                if (other == v) continue;
+
+                int32_t shared = 0;
+                for (int32_t j = 0; j < vertex->refCount; j++) shared += SimplifyHasVertex(&s->triangles[s->refs[vertex->refStart + j]], other);
+                if (shared == 1) s->vertices[v].border = s->vertices[other].border = true;
+            }
+        }
+    }
+}
+
+static void SimplifyPlaneQuadrics(Simplifier *s)
+{
+    for (int32_t t = 0; t < s->triangleCount; t++)
+    {
+        const int32_t *v = s->triangles[t].v;
+        const float *p0 = s->vertices[v[0]].attr.position;
+        Vector3 n = SimplifyFaceNormal(p0, s->vertices[v[1]].attr.position, s->vertices[v[2]].attr.position);
+        double len = sqrt((double)n.x*n.x + (double)n.y*n.y + (double)n.z*n.z);
+        if (len <= 0.0) continue;
+
+        double a = n.x/len, b = n.y/len, c = n.z/len;
+        double d = -(a*p0[0] + b*p0[1] + c*p0[2]);
+        double plane[10] = { a*a, a*b, a*c, a*d, b*b, b*c, b*d, c*c, c*d, d*d };
+        for (int k = 0; k < 3; k++)
+        {
+            for (int i = 0; i < 10; i++) s->vertices[v[k]].q[i] += plane[i];
+        }
+    }
+}
+
+static double SimplifyError(const double *q, const float *p)
+{
+    double x = p[0], y = p[1], z = p[2];
+    return q[0]*x*x + 2*q[1]*x*y + 2*q[2]*x*z + 2*q[3]*x + q[4]*y*y + 2*q[5]*y*z + 2*q[6]*y + q[7]*z*z + 2*q[8]*z + q[9];
+}
+
+// collapsing must not pinch the surface: the two fans may only share the two
+// vertices opposite the edge
+static bool SimplifyLinkCondition(const Simplifier *s, int32_t a, int32_t b)
+{
+    int32_t neighbors[SIMPLIFY_MAX_VALENCE];
+    bool common[SIMPLIFY_MAX_VALENCE] = { 0 };
+    int32_t neighborCount = 0, shared = 0, commonCount = 0;
+
+    const SimplifyVertex *va = &s->vertices[a];
+    for (int32_t i = 0; i < va->refCount; i++)
+    {
+        const SimplifyTriangle *tri = &s->triangles[s->refs[va->refStart + i]];
+        if (tri->deleted) continue;
+        shared += SimplifyHasVertex(tri, b);
+        for (int k = 0; k < 3; k++)
+        {
+            int32_t x = tri->v[k], n = 0;
+            if (x == a || x == b) continue;
+            while (n < neighborCount && neighbors[n] != x) n++;
+            if (n < neighborCount) continue;
+            if (neighborCount == SIMPLIFY_MAX_VALENCE) return false;
+            neighbors[neighborCount++] = x;
+        }
+    }
+
+    const SimplifyVertex *vb = &s->vertices[b];
+    for (int32_t i = 0; i < vb->refCount; i++)
+    {
+        const SimplifyTriangle *tri = &s->triangles[s->refs[vb->refStart + i]];
+        if (tri->deleted) continue;
+        for (int k = 0; k < 3; k++)
+        {
+            for (int32_t n = 0; n < neighborCount; n++)
+            {
+                if (neighbors[n] != tri->v[k] || common[n]) continue;
+                common[n] = true;
+                commonCount++;
+            }
+        }
+    }
+
+    return shared == 2 && commonCount == 2;
+}
+
+// remove moves onto keep, only the triangles around remove change shape
+static bool SimplifyCollapseFlips(const Simplifier *s, int32_t remove, int32_t keep)
+{
+    const SimplifyVertex *r = &s->vertices[remove];
+    for (int32_t i = 0; i < r->refCount; i++)
+    {
+        const SimplifyTriangle *tri = &s->triangles[s->refs[r->refStart + i]];
+        if (tri->deleted || SimplifyHasVertex(tri, keep)) continue;
+
+        const float *before[3], *after[3];
+        for (int k = 0; k < 3; k++)
+        {
+            before[k] = s->vertices[tri->v[k]].attr.position;
+            after[k] = (tri->v[k] == remove) ? s->vertices[keep].attr.position : before[k];
+        }
+        Vector3 n0 = SimplifyFaceNormal(before[0], before[1], before[2]);
+        Vector3 n1 = SimplifyFaceNormal(after[0], after[1], after[2]);
+        float len0 = sqrtf(n0.x*n0.x + n0.y*n0.y + n0.z*n0.z);
+        float len1 = sqrtf(n1.x*n1.x + n1.y*n1.y + n1.z*n1.z);
+        if (len1 <= 1e-12f) return true;
+        if (len0 > 0.0f && (n0.x*n1.x + n0.y*n1.y + n0.z*n1.z) < SIMPLIFY_FLIP_LIMIT*len0*len1) return true;
+    }
+
+    return false;
+}
+
+static void SimplifyCollapse(Simplifier *s, int32_t remove, int32_t keep)
+{
+    const SimplifyVertex *r = &s->vertices[remove];
+    for (int32_t i = 0; i < r->refCount; i++)
+    {
+        SimplifyTriangle *tri = &s->triangles[s->refs[r->refStart + i]];
+        if (tri->deleted) continue;
+        if (SimplifyHasVertex(tri, keep))
+        {
+            tri->deleted = true;
+            s->liveTriangles--;
+            continue;
+        }
+        for (int k = 0; k < 3; k++) if (tri->v[k] == remove) tri->v[k] = keep;
+        tri->dirty = true;
+    }
+
+    const SimplifyVertex *k = &s->vertices[keep];
+    for (int32_t i = 0; i < k->refCount; i++) s->triangles[s->refs[k->refStart + i]].dirty = true;
+    for (int i = 0; i < 10; i++) s->vertices[keep].q[i] += r->q[i];
+}
+
+static Mesh SimplifyExport(const Simplifier *s, const Mesh *source)
+{
+    Mesh mesh = { 0 };
+    int32_t *remap = MemAllocTagged(MEM_TAG_ASSETS, sizeof(int32_t)*((s->vertexCount > 0) ? s->vertexCount : 1));
+    if (remap == NULL) return mesh;
+
+    int32_t used = 0;
+    for (int32_t i = 0; i < s->vertexCount; i++) remap[i] = -1;
+    for (int32_t t = 0; t < s->triangleCount; t++)
+    {
+        if (s->triangles[t].deleted) continue;
+        for (int k = 0; k < 3; k++) if (remap[s->triangles[t].v[k]] < 0) remap[s->triangles[t].v[k]] = used++;
+    }
+
+    if (used > 0 && used <= 65535)
+    {
+        mesh.vertexCount = used;
+        mesh.triangleCount = s->liveTriangles;
+        mesh.vertices = MemAlloc(sizeof(float)*3*used);
+        if (source->normals != NULL) mesh.normals = MemAlloc(sizeof(float)*3*used);
+        if (source->texcoords != NULL) mesh.texcoords = MemAlloc(sizeof(float)*2*used);
+        mesh.indices = MemAlloc(sizeof(unsigned short)*3*mesh.triangleCount);
+
+        for (int32_t i = 0; i < s->vertexCount; i++)
+        {
+            if (remap[i] < 0) continue;
+            const SimplifyAttributes *attr = &s->vertices[i].attr;
+            memcpy(&mesh.vertices[remap[i]*3], attr->position, sizeof(attr->position));
+            if (mesh.normals != NULL) memcpy(&mesh.normals[remap[i]*3], attr->normal, sizeof(attr->normal));
+            if (mesh.texcoords != NULL) memcpy(&mesh.texcoords[remap[i]*2], attr->texcoord, sizeof(attr->texcoord));
+        }
+
+        int32_t index = 0;
+        for (int32_t t = 0; t < s->triangleCount; t++)
+        {
+            if (s->triangles[t].deleted) continue;
+            for (int k = 0; k < 3; k++) mesh.indices[index++] = (unsigned short)remap[s->triangles[t].v[k]];
+        }
+    }
+
+    MemFreeTagged(remap);
+    return mesh;
+}
+
+Mesh SimplifyMesh(const Mesh *mesh, int32_t targetTriangles)
+{
+    Simplifier s = { 0 };
+    Mesh result = { 0 };
+
+    if (mesh->vertices != NULL && mesh->vertexCount > 0 && mesh->triangleCount > 0 && SimplifyWeld(&s, mesh))
+    {
+        SimplifyBuildRefs(&s);
+        SimplifyMarkBorders(&s);
+        SimplifyPlaneQuadrics(&s);
+
+        // cheapest collapses first: every pass only accepts errors below a
+        // growing threshold, avoids keeping a sorted edge heap up to date
+        for (int iteration = 0; iteration < SIMPLIFY_MAX_ITERATIONS && s.liveTriangles > targetTriangles; iteration++)
+        {
+            if (iteration > 0) SimplifyBuildRefs(&s);
+            double threshold = 1e-9*pow(iteration + 3, 7.0);
+
+            for (int32_t t = 0; t < s.triangleCount && s.liveTriangles > targetTriangles; t++)
+            {
+                const SimplifyTriangle *tri = &s.triangles[t];
+                if (tri->deleted || tri->dirty) continue;
+
+                for (int j = 0; j < 3; j++)
+                {
+                    int32_t a = tri->v[j], b = tri->v[(j + 1)%3];
+                    if (s.vertices[a].border || s.vertices[b].border) continue;
+
+                    double q[10];
+                    for (int i = 0; i < 10; i++) q[i] = s.vertices[a].q[i] + s.vertices[b].q[i];
+                    double errorA = SimplifyError(q, s.vertices[a].attr.position);
+                    double errorB = SimplifyError(q, s.vertices[b].attr.position);
+                    int32_t keep = (errorA <= errorB) ? a : b;
+                    int32_t remove = (keep == a) ? b : a;
+                    if (fmin(errorA, errorB) > threshold) continue;
+                    if (!SimplifyLinkCondition(&s, a, b) || SimplifyCollapseFlips(&s, remove, keep)) continue;
+
+                    SimplifyCollapse(&s, remove, keep);
+                    break;
+                }
+            }
+        }
+
+        result = SimplifyExport(&s, mesh);
+    }
+
+    MemFreeTagged(s.refs);
+    MemFreeTagged(s.triangles);
+    MemFreeTagged(s.vertices);
+    return result;
+}
@@ -0,0 +1,19 @@
+#ifndef SIMPLIFY_H
+#define SIMPLIFY_H
+
+#include "raylib.h"
+#include <stdint.h>
+
+// Quadric error metric mesh simplification (Garland & Heckbert), meant for
+// offline LOD baking. Vertices with equal position, normal and texcoord are
+// welded first; the collapses are half-edge collapses onto the endpoint with
+// the lower error, so surviving vertices keep their original attributes.
+// Open edges (mesh borders and UV seams) are left in place.
+
+// Returns an indexed CPU only mesh with at most targetTriangles triangles when
+// that is reachable without flipping faces; empty mesh on failure or when the
+// result would not fit 16 bit indices. Reads vertices, normals, texcoords and
+// indices when present.
+Mesh SimplifyMesh(const Mesh *mesh, int32_t targetTriangles);
+
+#endif
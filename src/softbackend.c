@@ -0,0 +1,83 @@
+#include "softbackend.h"
+#include "raylib.h"
+#include "rlstats.h"
+#include "softrender.h"
+
+static struct {
+    DrawStreamState state;          // carried over from frame to frame, like rlgl's
+    SoftRenderer renderer;
+    Texture2D present;
+    bool presenting;                // drawn over GL's frame, off when headless
+    int32_t frames;                 // rasterized so far
+    bool active;
+} softBackend = { 0 };
+
+static void SoftBackendFrame(const uint8_t *ops, size_t size, void *user)
+{
+    (void)user;
+    for (size_t at = 0; at < size; at += GetDrawOpSize(ops + at))
+    {
+        ApplyDrawStateOp(&softBackend.state, ops[at], ops + at + 1);
+        SoftApplyOp(&softBackend.renderer, ops + at);
+    }
+
+    softBackend.frames++;
+    const SoftTarget *screen = GetSoftTarget(&softBackend.renderer, 0);
+    if (screen == NULL || !softBackend.presenting) return;
+    if (softBackend.present.width != screen->width || softBackend.present.height != screen->height)
+    {
+        if (softBackend.present.id != 0) UnloadTexture(softBackend.present);
+        Image image = {
+            .data = screen->color,
+            .width = screen->width,
+            .height = screen->height,
+            .mipmaps = 1,
+            .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8
+        };
+        softBackend.present = LoadTextureFromImage(image);
+    }
+    else UpdateTexture(softBackend.present, screen->color);
+
+    // bottom row first like GL, so the source is flipped
+    Rectangle source = { 0.0f, 0.0f, (float)screen->width, -(float)screen->height };
+    Rectangle dest = { 0.0f, 0.0f, (float)GetScreenWidth(), (float)GetScreenHeight() };
+    DrawTexturePro(softBackend.present, source, dest, (Vector2){ 0.0f, 0.0f }, 0.0f, WHITE);
+}
+
+bool InitSoftBackend(bool present)
+{
+    if (softBackend.active) return true;
+
+    softBackend.presenting = present;
+    softBackend.frames = 0;
+    ResetDrawState(&softBackend.state, GetScreenWidth(), GetScreenHeight());
+    softBackend.renderer = LoadSoftRenderer(&softBackend.state);
+    if (softBackend.renderer.positions == NULL || softBackend.renderer.colors == NULL)
+    {
+        UnloadSoftRenderer(&softBackend.renderer);
+        TraceLog(LOG_WARNING, "SOFT: out of memory, drawing with GL only");
+        return false;
+    }
+    SetDrawFrameHook(SoftBackendFrame, NULL);
+    softBackend.active = true;
+    TraceLog(LOG_INFO, "SOFT: frames are rasterized on the CPU from the next one on");
+    return true;
+}
+
+void CloseSoftBackend(void)
+{
+    if (!softBackend.active) return;
+
+    SetDrawFrameHook(NULL, NULL);
+    if (softBackend.present.id != 0) UnloadTexture(softBackend.present);
+    UnloadSoftRenderer(&softBackend.renderer);
+    softBackend.present = (Texture2D){ 0 };
+    softBackend.active = false;
+}
+
+bool ExportSoftBackendFrame(const char *fileName)
+{
+    const SoftTarget *screen = softBackend.active ? GetSoftTarget(&softBackend.renderer, 0) : NULL;
+    if (screen == NULL || softBackend.frames == 0) return false;
+    return ExportSoftTarget(screen, fileName);
+}
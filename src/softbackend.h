@@ -0,0 +1,21 @@
+#ifndef SOFTBACKEND_H
+#define SOFTBACKEND_H
+
+#include <stdbool.h>
+
+// --render-backend soft: every frame's draw stream goes through the software
+// rasterizer (softrender.c) and its picture is what the window shows, so a
+// live scene checks the soft path against what the replays would produce.
+// raylib still opens the window and presents through its GL context, so GL
+// keeps drawing the frame underneath; the soft frame is uploaded and drawn
+// over it right before the buffers swap.
+// Needs TrackDrawResources() before InitWindow() and the job system.
+// Headless runs (headless.h) have nothing to present on, they rasterize
+// without presenting and export the frames instead.
+
+bool InitSoftBackend(bool present);
+void CloseSoftBackend(void);
+// Last rasterized frame as a PNG, false before the first one
+bool ExportSoftBackendFrame(const char *fileName);
+
+#endif
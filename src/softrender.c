@@ -0,0 +1,1093 @@
+#include "softrender.h"
+#include "jobs.h"
+#include "memtrack.h"
+#define RAYMATH_STATIC_INLINE       // replay tools link without raylib
+#include "raymath.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SOFT_CLIP_VERTICES 8        // a triangle clipped by the near and far planes
+#define SOFT_ATTRIBUTES 8           // u, v, r, g, b, a, corner x, y
+#define SOFT_MAX_TEXTURE_SIZE 16384
+#define SOFT_LOCATION_COLOR 3       // raylib binds vertex colors here, white while disabled
+
+// GL types vertex attributes come in, rlgl.h only names two of them
+#define SOFT_GL_BYTE 0x1400
+#define SOFT_GL_UNSIGNED_BYTE 0x1401
+#define SOFT_GL_SHORT 0x1402
+#define SOFT_GL_UNSIGNED_SHORT 0x1403
+#define SOFT_GL_FLOAT 0x1406
+#define SOFT_GL_HALF_FLOAT 0x140B
+
+// What the fragment shader of the draw does besides texture*color
+typedef enum {
+    SOFT_SHAPE_NONE = 0,
+    SOFT_SHAPE_QUAD,                // sprite quad, transparent fragments are discarded
+    SOFT_SHAPE_DISC,                // sprite disc, the rim smoothed over a pixel
+    SOFT_SHAPE_PARTICLE,            // alpha falls off towards the rim, no texture
+    SOFT_SHAPE_SDF                  // glyph distance in the texture alpha, edge at 0.5
+} SoftShape;
+
+typedef struct {
+    const uint8_t *texels;          // RGBA8, NULL samples rlgl's white default
+    int32_t width;
+    int32_t height;
+    int32_t shape;                  // SoftShape
+    float color[4];                 // colDiffuse
+} SoftShading;
+
+typedef struct {
+    float x, y, z, w;
+    float attr[SOFT_ATTRIBUTES];
+} SoftClipVertex;
+
+typedef struct {
+    float edge[3][3];               // barycentric of vertex i at (x, y) is a*x + b*y + c
+    bool inclusive[3];              // top-left rule, edge opposite vertex i owns its pixels
+    float z[3];                     // window depth, linear in screen space
+    float invW[3];
+    float attr[3][SOFT_ATTRIBUTES]; // attributes over w, for perspective correction
+    float gradient[2][4];           // screen x and y steps of u, v, corner x, y, for the shapes
+    int32_t minX, minY, maxX, maxY; // covered pixel centers, clamped to the target
+    SoftShading shading;
+} SoftTriangle;
+
+SoftRenderer LoadSoftRenderer(const DrawStreamState *state)
+{
+    SoftRenderer renderer = { .state = state, .color = WHITE };
+    renderer.positions = MemAllocTagged(MEM_TAG_RENDER, sizeof(Vector3)*DRAW_STREAM_BATCH_VERTICES);
+    renderer.texcoords = MemAllocTagged(MEM_TAG_RENDER, sizeof(Vector2)*DRAW_STREAM_BATCH_VERTICES);
+    renderer.colors = MemAllocTagged(MEM_TAG_RENDER, sizeof(Color)*DRAW_STREAM_BATCH_VERTICES);
+    renderer.draws[0] = (SoftDraw){ .mode = RL_QUADS };
+    renderer.drawCount = 1;
+    SoftSetTarget(&renderer, 0, state->screenWidth, state->screenHeight);
+    return renderer;
+}
+
+void UnloadSoftRenderer(SoftRenderer *renderer)
+{
+    for (int32_t i = 0; i < renderer->targetCount; i++)
+    {
+        MemFreeTagged(renderer->targets[i].color);
+        MemFreeTagged(renderer->targets[i].depth);
+    }
+    for (int32_t i = 0; i < renderer->bufferCapacity; i++) MemFreeTagged(renderer->buffers[i].data);
+    for (int32_t i = 0; i < renderer->textureCapacity; i++) MemFreeTagged(renderer->textures[i].color);
+    MemFreeTagged(renderer->buffers);
+    MemFreeTagged(renderer->arrays);
+    MemFreeTagged(renderer->textures);
+    MemFreeTagged(renderer->vertices);
+    MemFreeTagged(renderer->positions);
+    MemFreeTagged(renderer->texcoords);
+    MemFreeTagged(renderer->colors);
+    MemFreeTagged(renderer->triangles);
+    MemFreeTagged(renderer->tileOffsets);
+    MemFreeTagged(renderer->tileTriangles);
+    *renderer = (SoftRenderer){ 0 };
+}
+
+static int32_t SoftFindTarget(const SoftRenderer *renderer, uint32_t texture)
+{
+    for (int32_t i = 0; i < renderer->targetCount; i++)
+    {
+        if (renderer->targets[i].texture == texture) return i;
+    }
+    return -1;
+}
+
+void SoftSetTarget(SoftRenderer *renderer, uint32_t texture, int32_t width, int32_t height)
+{
+    if (renderer->vertexCount > 0) SoftFlush(renderer);
+
+    int32_t index = SoftFindTarget(renderer, texture);
+    if (index < 0)
+    {
+        // out of slots, keep drawing into the last one rather than dropping frames
+        if (renderer->targetCount == SOFT_MAX_TARGETS) index = SOFT_MAX_TARGETS - 1;
+        else index = renderer->targetCount++;
+        renderer->targets[index].texture = texture;
+    }
+
+    SoftTarget *target = &renderer->targets[index];
+    if (target->width != width || target->height != height)
+    {
+        MemFreeTagged(target->color);
+        MemFreeTagged(target->depth);
+        target->width = (width > 0) ? width : 1;
+        target->height = (height > 0) ? height : 1;
+        target->color = MemCallocTagged(MEM_TAG_RENDER, (size_t)target->width*target->height, 4);
+        target->depth = MemAllocTagged(MEM_TAG_RENDER, sizeof(float)*target->width*target->height);
+        for (int32_t i = 0; i < target->width*target->height; i++) target->depth[i] = 1.0f;
+    }
+    renderer->current = index;
+}
+
+// a texture id loaded or unloaded again is not that render target any more
+static void SoftDropTarget(SoftRenderer *renderer, uint32_t texture)
+{
+    int32_t index = SoftFindTarget(renderer, texture);
+    if (texture == 0 || index < 0 || index == renderer->current) return;
+
+    MemFreeTagged(renderer->targets[index].color);
+    MemFreeTagged(renderer->targets[index].depth);
+    int32_t last = --renderer->targetCount;
+    renderer->targets[index] = renderer->targets[last];
+    renderer->targets[last] = (SoftTarget){ 0 };
+    if (renderer->current == last) renderer->current = index;
+}
+
+void SoftClear(SoftRenderer *renderer, Color color)
+{
+    SoftTarget *target = &renderer->targets[renderer->current];
+    const int32_t pixels = target->width*target->height;
+    for (int32_t i = 0; i < pixels; i++)
+    {
+        memcpy(target->color + i*4, &color, 4);
+        target->depth[i] = 1.0f;
+    }
+}
+
+// Draw grouping follows rlBegin()/rlSetTexture(): a new draw when the mode or
+// texture changes after vertices went into the current one
+static void SoftNextDraw(SoftRenderer *renderer, int mode, uint32_t texture)
+{
+    SoftDraw *draw = &renderer->draws[renderer->drawCount - 1];
+    if (draw->count > 0)
+    {
+        if (renderer->drawCount == SOFT_MAX_DRAWS) SoftFlush(renderer);
+        else renderer->drawCount++;
+        draw = &renderer->draws[renderer->drawCount - 1];
+    }
+    *draw = (SoftDraw){ .mode = mode, .texture = texture, .first = renderer->vertexCount };
+}
+
+void SoftBegin(SoftRenderer *renderer, int mode)
+{
+    if (renderer->draws[renderer->drawCount - 1].mode != mode) SoftNextDraw(renderer, mode, 0);
+}
+
+void SoftSetTexture(SoftRenderer *renderer, uint32_t texture)
+{
+    SoftDraw *draw = &renderer->draws[renderer->drawCount - 1];
+    if (texture == draw->texture) return;
+    SoftNextDraw(renderer, draw->mode, texture);
+}
+
+void SoftTexCoord(SoftRenderer *renderer, float u, float v)
+{
+    renderer->texcoord = (Vector2){ u, v };
+}
+
+void SoftColor(SoftRenderer *renderer, Color color)
+{
+    renderer->color = color;
+}
+
+void SoftVertex(SoftRenderer *renderer, float x, float y, float z)
+{
+    if (renderer->vertexCount >= DRAW_STREAM_BATCH_VERTICES)
+    {
+        // carry the open draw over into the fresh batch
+        SoftDraw open = renderer->draws[renderer->drawCount - 1];
+        SoftFlush(renderer);
+        renderer->draws[0].mode = open.mode;
+        renderer->draws[0].texture = open.texture;
+    }
+
+    int32_t i = renderer->vertexCount++;
+    renderer->positions[i] = DrawStateVertex(renderer->state, x, y, z);
+    renderer->texcoords[i] = renderer->texcoord;
+    renderer->colors[i] = renderer->color;
+    renderer->draws[renderer->drawCount - 1].count++;
+}
+
+// Sutherland-Hodgman against d(v) >= 0 for one plane of the clip volume
+static int32_t SoftClipPlane(const SoftClipVertex *in, int32_t count, SoftClipVertex *out, float sz, float sw)
+{
+    int32_t outCount = 0;
+    for (int32_t i = 0; i < count; i++)
+    {
+        const SoftClipVertex *a = &in[i], *b = &in[(i + 1)%count];
+        float da = sz*a->z + sw*a->w, db = sz*b->z + sw*b->w;
+        if (da >= 0.0f) out[outCount++] = *a;
+        if ((da >= 0.0f) != (db >= 0.0f))
+        {
+            float t = da/(da - db);
+            SoftClipVertex *v = &out[outCount++];
+            v->x = a->x + (b->x - a->x)*t;
+            v->y = a->y + (b->y - a->y)*t;
+            v->z = a->z + (b->z - a->z)*t;
+            v->w = a->w + (b->w - a->w)*t;
+            for (int k = 0; k < SOFT_ATTRIBUTES; k++) v->attr[k] = a->attr[k] + (b->attr[k] - a->attr[k])*t;
+        }
+    }
+    return outCount;
+}
+
+static void SoftSetupTriangle(SoftRenderer *renderer, const SoftClipVertex *v0, const SoftClipVertex *v1, const SoftClipVertex *v2, const SoftShading *shading, bool cull)
+{
+    const SoftTarget *target = &renderer->targets[renderer->current];
+    const SoftClipVertex *v[3] = { v0, v1, v2 };
+    float x[3], y[3];
+    for (int i = 0; i < 3; i++)
+    {
+        x[i] = (v[i]->x/v[i]->w*0.5f + 0.5f)*target->width;
+        y[i] = (v[i]->y/v[i]->w*0.5f + 0.5f)*target->height;
+    }
+
+    // counter clockwise is front facing, as GL's default
+    float area = (x[1] - x[0])*(y[2] - y[0]) - (x[2] - x[0])*(y[1] - y[0]);
+    if (area == 0.0f || (cull && area < 0.0f))
+    {
+        renderer->stats.culled++;
+        return;
+    }
+    if (area < 0.0f)
+    {
+        const SoftClipVertex *t = v[1];
+        v[1] = v[2];
+        v[2] = t;
+        float tx = x[1], ty = y[1];
+        x[1] = x[2], y[1] = y[2];
+        x[2] = tx, y[2] = ty;
+        area = -area;
+    }
+
+    float minX = fminf(x[0], fminf(x[1], x[2])), maxX = fmaxf(x[0], fmaxf(x[1], x[2]));
+    float minY = fminf(y[0], fminf(y[1], y[2])), maxY = fmaxf(y[0], fmaxf(y[1], y[2]));
+    SoftTriangle t = {
+        .minX = (int32_t)fmaxf(ceilf(minX - 0.5f), 0.0f),
+        .minY = (int32_t)fmaxf(ceilf(minY - 0.5f), 0.0f),
+        .maxX = (int32_t)fminf(floorf(maxX - 0.5f), target->width - 1.0f),
+        .maxY = (int32_t)fminf(floorf(maxY - 0.5f), target->height - 1.0f),
+        .shading = *shading
+    };
+    if (t.minX > t.maxX || t.minY > t.maxY)
+    {
+        renderer->stats.culled++;
+        return;
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        // edge from a to b, opposite vertex i
+        int a = (i + 1)%3, b = (i + 2)%3;
+        float dx = x[b] - x[a], dy = y[b] - y[a];
+        t.edge[i][0] = -dy/area;
+        t.edge[i][1] = dx/area;
+        t.edge[i][2] = (dy*x[a] - dx*y[a])/area;
+        // a shared edge runs the other way in the neighbour, exactly one of them owns it
+        t.inclusive[i] = (dy > 0.0f) || (dy == 0.0f && dx < 0.0f);
+
+        t.invW[i] = 1.0f/v[i]->w;
+        t.z[i] = v[i]->z*t.invW[i]*0.5f + 0.5f;
+        for (int k = 0; k < SOFT_ATTRIBUTES; k++) t.attr[i][k] = v[i]->attr[k]*t.invW[i];
+    }
+
+    // affine steps stand in for dFdx()/dFdy(), close enough for the one pixel smoothing
+    static const int gradientAttr[4] = { 0, 1, 6, 7 };
+    for (int j = 0; j < 4; j++)
+    {
+        int k = gradientAttr[j];
+        for (int axis = 0; axis < 2; axis++)
+        {
+            t.gradient[axis][j] = t.edge[0][axis]*v[0]->attr[k] + t.edge[1][axis]*v[1]->attr[k] + t.edge[2][axis]*v[2]->attr[k];
+        }
+    }
+
+    if (renderer->triangleCount == renderer->triangleCapacity)
+    {
+        int32_t capacity = (renderer->triangleCapacity > 0) ? renderer->triangleCapacity*2 : 4096;
+        SoftTriangle *triangles = MemReallocTagged(MEM_TAG_RENDER, renderer->triangles, sizeof(SoftTriangle)*capacity);
+        if (triangles == NULL) return;
+        renderer->triangles = triangles;
+        renderer->triangleCapacity = capacity;
+    }
+    ((SoftTriangle *)renderer->triangles)[renderer->triangleCount++] = t;
+}
+
+static void SoftClipTriangle(SoftRenderer *renderer, const SoftClipVertex *v0, const SoftClipVertex *v1, const SoftClipVertex *v2, const SoftShading *shading, bool cull)
+{
+    SoftClipVertex a[SOFT_CLIP_VERTICES] = { *v0, *v1, *v2 }, b[SOFT_CLIP_VERTICES];
+
+    // near (z + w >= 0) and far (w - z >= 0), x and y are handled by the bounding box
+    int32_t count = SoftClipPlane(a, 3, b, 1.0f, 1.0f);
+    count = SoftClipPlane(b, count, a, -1.0f, 1.0f);
+    if (count < 3)
+    {
+        renderer->stats.culled++;
+        return;
+    }
+    for (int32_t i = 1; i + 1 < count; i++) SoftSetupTriangle(renderer, &a[0], &a[i], &a[i + 1], shading, cull);
+}
+
+static SoftClipVertex SoftClipPosition(Matrix mvp, Vector3 p)
+{
+    return (SoftClipVertex){
+        .x = mvp.m0*p.x + mvp.m4*p.y + mvp.m8*p.z + mvp.m12,
+        .y = mvp.m1*p.x + mvp.m5*p.y + mvp.m9*p.z + mvp.m13,
+        .z = mvp.m2*p.x + mvp.m6*p.y + mvp.m10*p.z + mvp.m14,
+        .w = mvp.m3*p.x + mvp.m7*p.y + mvp.m11*p.z + mvp.m15
+    };
+}
+
+static SoftClipVertex SoftBatchVertex(const SoftRenderer *renderer, Matrix mvp, int32_t index)
+{
+    Color c = renderer->colors[index];
+    SoftClipVertex v = SoftClipPosition(mvp, renderer->positions[index]);
+    v.attr[0] = renderer->texcoords[index].x;
+    v.attr[1] = renderer->texcoords[index].y;
+    v.attr[2] = c.r/255.0f;
+    v.attr[3] = c.g/255.0f;
+    v.attr[4] = c.b/255.0f;
+    v.attr[5] = c.a/255.0f;
+    return v;
+}
+
+static void SoftEmitTriangle(SoftRenderer *renderer, Matrix mvp, int32_t i0, int32_t i1, int32_t i2, const SoftShading *shading, bool cull)
+{
+    SoftClipVertex v0 = SoftBatchVertex(renderer, mvp, i0), v1 = SoftBatchVertex(renderer, mvp, i1), v2 = SoftBatchVertex(renderer, mvp, i2);
+    SoftClipTriangle(renderer, &v0, &v1, &v2, shading, cull);
+}
+
+static void SoftSample(const SoftShading *texture, float u, float v, float *out)
+{
+    // nearest with repeat, raylib's default texture parameters
+    int32_t x = (int32_t)floorf(u*texture->width) % texture->width;
+    int32_t y = (int32_t)floorf(v*texture->height) % texture->height;
+    if (x < 0) x += texture->width;
+    if (y < 0) y += texture->height;
+    const uint8_t *texel = texture->texels + ((size_t)y*texture->width + x)*4;
+    for (int k = 0; k < 4; k++) out[k] = texel[k]/255.0f;
+}
+
+// distance fields are drawn bilinear, nearest would step the glyph edges
+static float SoftSampleAlphaBilinear(const SoftShading *texture, float u, float v)
+{
+    float fx = u*texture->width - 0.5f, fy = v*texture->height - 0.5f;
+    float x0 = floorf(fx), y0 = floorf(fy);
+    float tx = fx - x0, ty = fy - y0;
+    float a[4];
+    for (int i = 0; i < 4; i++)
+    {
+        int32_t x = ((int32_t)x0 + (i & 1)) % texture->width, y = ((int32_t)y0 + (i >> 1)) % texture->height;
+        if (x < 0) x += texture->width;
+        if (y < 0) y += texture->height;
+        a[i] = texture->texels[((size_t)y*texture->width + x)*4 + 3]/255.0f;
+    }
+    return (a[0]*(1.0f - tx) + a[1]*tx)*(1.0f - ty) + (a[2]*(1.0f - tx) + a[3]*tx)*ty;
+}
+
+static float SoftSmoothstep(float edge0, float edge1, float x)
+{
+    float t = fminf(fmaxf((x - edge0)/(edge1 - edge0), 0.0f), 1.0f);
+    return t*t*(3.0f - 2.0f*t);
+}
+
+// The fragment shaders, false when the fragment is discarded
+static bool SoftShade(const SoftTriangle *t, const float *attr, float *out)
+{
+    const SoftShading *s = &t->shading;
+    float texel[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    float alpha = 1.0f;
+
+    if (s->shape == SOFT_SHAPE_SDF && s->texels != NULL)
+    {
+        float d = SoftSampleAlphaBilinear(s, attr[0], attr[1]) - 0.5f;
+        float dx = SoftSampleAlphaBilinear(s, attr[0] + t->gradient[0][0], attr[1] + t->gradient[0][1]) - 0.5f - d;
+        float dy = SoftSampleAlphaBilinear(s, attr[0] + t->gradient[1][0], attr[1] + t->gradient[1][1]) - 0.5f - d;
+        float width = fmaxf(sqrtf(dx*dx + dy*dy), 0.0001f);
+        alpha = SoftSmoothstep(-width, width, d);
+    }
+    else if (s->shape == SOFT_SHAPE_PARTICLE)
+    {
+        float d = attr[6]*attr[6] + attr[7]*attr[7];
+        if (d > 1.0f) return false;
+        alpha = 1.0f - d;
+    }
+    else if (s->texels != NULL) SoftSample(s, attr[0], attr[1], texel);
+
+    for (int k = 0; k < 4; k++) out[k] = attr[2 + k]*texel[k]*s->color[k];
+    out[3] *= alpha;
+
+    if (s->shape == SOFT_SHAPE_DISC)
+    {
+        // fwidth(length(corner)) from the corner's screen steps
+        float d = sqrtf(attr[6]*attr[6] + attr[7]*attr[7]);
+        float ddx = (attr[6]*t->gradient[0][2] + attr[7]*t->gradient[0][3])/fmaxf(d, 0.000001f);
+        float ddy = (attr[6]*t->gradient[1][2] + attr[7]*t->gradient[1][3])/fmaxf(d, 0.000001f);
+        float width = fmaxf(fabsf(ddx) + fabsf(ddy), 0.0001f);
+        out[3] *= 1.0f - SoftSmoothstep(1.0f - width, 1.0f, d);
+    }
+    return !((s->shape == SOFT_SHAPE_QUAD || s->shape == SOFT_SHAPE_DISC) && out[3] <= 0.0f);
+}
+
+static void SoftTileJob(int32_t begin, int32_t end, void *user)
+{
+    SoftRenderer *renderer = user;
+    SoftTarget *target = &renderer->targets[renderer->current];
+    const SoftTriangle *triangles = renderer->triangles;
+    const int32_t tilesX = (target->width + SOFT_TILE_SIZE - 1)/SOFT_TILE_SIZE;
+
+    for (int32_t tile = begin; tile < end; tile++)
+    {
+        const int32_t tx0 = (tile%tilesX)*SOFT_TILE_SIZE, ty0 = (tile/tilesX)*SOFT_TILE_SIZE;
+        const int32_t tx1 = tx0 + SOFT_TILE_SIZE - 1, ty1 = ty0 + SOFT_TILE_SIZE - 1;
+
+        for (int32_t n = renderer->tileOffsets[tile]; n < renderer->tileOffsets[tile + 1]; n++)
+        {
+            const SoftTriangle *t = &triangles[renderer->tileTriangles[n]];
+            const int32_t x0 = (t->minX > tx0) ? t->minX : tx0, x1 = (t->maxX < tx1) ? t->maxX : tx1;
+            const int32_t y0 = (t->minY > ty0) ? t->minY : ty0, y1 = (t->maxY < ty1) ? t->maxY : ty1;
+
+            for (int32_t y = y0; y <= y1; y++)
+            {
+                const float py = y + 0.5f;
+                for (int32_t x = x0; x <= x1; x++)
+                {
+                    const float px = x + 0.5f;
+                    float l[3];
+                    bool inside = true;
+                    for (int i = 0; i < 3; i++)
+                    {
+                        l[i] = t->edge[i][0]*px + t->edge[i][1]*py + t->edge[i][2];
+                        inside = inside && (l[i] > 0.0f || (l[i] == 0.0f && t->inclusive[i]));
+                    }
+                    if (!inside) continue;
+
+                    // GL_LEQUAL like rlgl sets up
+                    const size_t pixel = (size_t)y*target->width + x;
+                    float z = l[0]*t->z[0] + l[1]*t->z[1] + l[2]*t->z[2];
+                    if (renderer->depthTest && z > target->depth[pixel]) continue;
+
+                    float w = 1.0f/(l[0]*t->invW[0] + l[1]*t->invW[1] + l[2]*t->invW[2]);
+                    float attr[SOFT_ATTRIBUTES];
+                    for (int k = 0; k < SOFT_ATTRIBUTES; k++) attr[k] = (l[0]*t->attr[0][k] + l[1]*t->attr[1][k] + l[2]*t->attr[2][k])*w;
+
+                    float src[4];
+                    if (!SoftShade(t, attr, src)) continue;
+                    if (renderer->depthTest && renderer->depthMask) target->depth[pixel] = z;
+
+                    // BLEND_ALPHA: src*a + dst*(1 - a) on every channel
+                    uint8_t *dst = target->color + pixel*4;
+                    float a = fminf(fmaxf(src[3], 0.0f), 1.0f);
+                    for (int k = 0; k < 4; k++)
+                    {
+                        float value = src[k]*a + dst[k]/255.0f*(1.0f - a);
+                        dst[k] = (uint8_t)(fminf(fmaxf(value, 0.0f), 1.0f)*255.0f + 0.5f);
+                    }
+                }
+            }
+        }
+    }
+}
+
+static bool SoftBinTriangles(SoftRenderer *renderer, int32_t tilesX, int32_t tileCount)
+{
+    const SoftTriangle *triangles = renderer->triangles;
+    int32_t *offsets = MemCallocTagged(MEM_TAG_RENDER, tileCount + 1, sizeof(int32_t));
+    if (offsets == NULL) return false;
+    MemFreeTagged(renderer->tileOffsets);
+    renderer->tileOffsets = offsets;
+
+    // count, prefix sum, then fill in submission order
+    int32_t total = 0;
+    for (int32_t i = 0; i < renderer->triangleCount; i++)
+    {
+        const SoftTriangle *t = &triangles[i];
+        for (int32_t ty = t->minY/SOFT_TILE_SIZE; ty <= t->maxY/SOFT_TILE_SIZE; ty++)
+        {
+            for (int32_t tx = t->minX/SOFT_TILE_SIZE; tx <= t->maxX/SOFT_TILE_SIZE; tx++) offsets[ty*tilesX + tx + 1]++;
+        }
+    }
+    for (int32_t tile = 0; tile < tileCount; tile++)
+    {
+        total += offsets[tile + 1];
+        offsets[tile + 1] = total;
+    }
+
+    if (total > renderer->tileTriangleCapacity)
+    {
+        int32_t *list = MemReallocTagged(MEM_TAG_RENDER, renderer->tileTriangles, sizeof(int32_t)*total);
+        if (list == NULL) return false;
+        renderer->tileTriangles = list;
+        renderer->tileTriangleCapacity = total;
+    }
+
+    int32_t *cursor = MemAllocTagged(MEM_TAG_RENDER, sizeof(int32_t)*tileCount);
+    if (cursor == NULL) return false;
+    memcpy(cursor, offsets, sizeof(int32_t)*tileCount);
+    for (int32_t i = 0; i < renderer->triangleCount; i++)
+    {
+        const SoftTriangle *t = &triangles[i];
+        for (int32_t ty = t->minY/SOFT_TILE_SIZE; ty <= t->maxY/SOFT_TILE_SIZE; ty++)
+        {
+            for (int32_t tx = t->minX/SOFT_TILE_SIZE; tx <= t->maxX/SOFT_TILE_SIZE; tx++) renderer->tileTriangles[cursor[ty*tilesX + tx]++] = i;
+        }
+    }
+    MemFreeTagged(cursor);
+    return true;
+}
+
+// bins, then rasterizes the triangles set up so far into the bound target
+static void SoftRasterize(SoftRenderer *renderer)
+{
+    const DrawStreamState *state = renderer->state;
+    const SoftTarget *target = &renderer->targets[renderer->current];
+    const int32_t tilesX = (target->width + SOFT_TILE_SIZE - 1)/SOFT_TILE_SIZE;
+    const int32_t tileCount = tilesX*((target->height + SOFT_TILE_SIZE - 1)/SOFT_TILE_SIZE);
+    if (renderer->triangleCount > 0 && SoftBinTriangles(renderer, tilesX, tileCount))
+    {
+        renderer->depthTest = state->depthTest;
+        renderer->depthMask = state->depthMask;
+        renderer->stats.triangles += renderer->triangleCount;
+        JobsParallelFor(tileCount, 1, SoftTileJob, renderer);
+    }
+    renderer->triangleCount = 0;
+}
+
+static SoftProgram *SoftFindProgram(SoftRenderer *renderer, uint32_t id)
+{
+    for (int32_t i = 0; i < renderer->programCount; i++)
+    {
+        if (renderer->programs[i].id == id) return &renderer->programs[i];
+    }
+    return NULL;
+}
+
+// rlgl's white default for 0, a target rendered earlier, or what the stream
+// uploaded; false when there is nothing to sample (or it is the bound target)
+static bool SoftBindTexture(const SoftRenderer *renderer, uint32_t texture, SoftShading *shading)
+{
+    shading->texels = NULL;
+    if (texture == 0) return true;
+
+    int32_t index = SoftFindTarget(renderer, texture);
+    if (index >= 0)
+    {
+        if (index == renderer->current) return false;
+        shading->texels = renderer->targets[index].color;
+        shading->width = renderer->targets[index].width;
+        shading->height = renderer->targets[index].height;
+        return true;
+    }
+
+    const SoftTexture *uploaded = ((int32_t)texture < renderer->textureCapacity) ? &renderer->textures[texture] : NULL;
+    if (uploaded == NULL || uploaded->color == NULL) return false;
+    shading->texels = uploaded->color;
+    shading->width = uploaded->width;
+    shading->height = uploaded->height;
+    return true;
+}
+
+void SoftFlush(SoftRenderer *renderer)
+{
+    const DrawStreamState *state = renderer->state;
+    const Matrix mvp = GetDrawStateMVP(state);
+    const SoftProgram *program = SoftFindProgram(renderer, renderer->batchProgram);
+    renderer->triangleCount = 0;
+
+    // rlDrawRenderBatch() sets colDiffuse to white, only the shape comes from the shader
+    SoftShading shading = { .color = { 1.0f, 1.0f, 1.0f, 1.0f } };
+    if (program != NULL && program->kind == DRAW_PROGRAM_SDF) shading.shape = SOFT_SHAPE_SDF;
+
+    for (int32_t d = 0; d < renderer->drawCount; d++)
+    {
+        const SoftDraw *draw = &renderer->draws[d];
+        if (draw->count == 0) continue;
+
+        if (draw->mode == RL_LINES || !SoftBindTexture(renderer, draw->texture, &shading))
+        {
+            renderer->stats.skippedDraws++;
+            continue;
+        }
+
+        // rlgl draws quads as two triangles through its index buffer
+        if (draw->mode == RL_QUADS)
+        {
+            for (int32_t q = draw->first; q + 3 < draw->first + draw->count; q += 4)
+            {
+                SoftEmitTriangle(renderer, mvp, q, q + 1, q + 2, &shading, state->cullFace);
+                SoftEmitTriangle(renderer, mvp, q, q + 2, q + 3, &shading, state->cullFace);
+            }
+        }
+        else
+        {
+            for (int32_t t = draw->first; t + 2 < draw->first + draw->count; t += 3)
+            {
+                SoftEmitTriangle(renderer, mvp, t, t + 1, t + 2, &shading, state->cullFace);
+            }
+        }
+    }
+    SoftRasterize(renderer);
+
+    // fresh batch, rlgl resets to quads with the default texture
+    renderer->vertexCount = 0;
+    renderer->draws[0] = (SoftDraw){ .mode = RL_QUADS };
+    renderer->drawCount = 1;
+}
+
+// Vertex array draws
+//----------------------------------------------------------------------------------
+static float SoftHalfToFloat(uint16_t h)
+{
+    uint32_t sign = (uint32_t)(h & 0x8000) << 16, exponent = (h >> 10) & 0x1f, mantissa = h & 0x3ff;
+    uint32_t bits;
+    if (exponent == 0x1f) bits = sign | 0x7f800000 | (mantissa << 13);
+    else if (exponent != 0) bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    else if (mantissa == 0) bits = sign;
+    else
+    {
+        // subnormal half, normalize it
+        exponent = 113;
+        while ((mantissa & 0x400) == 0)
+        {
+            mantissa <<= 1;
+            exponent--;
+        }
+        bits = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+    }
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+static int32_t SoftTypeSize(int32_t type)
+{
+    switch (type)
+    {
+        case SOFT_GL_BYTE: case SOFT_GL_UNSIGNED_BYTE: return 1;
+        case SOFT_GL_SHORT: case SOFT_GL_UNSIGNED_SHORT: case SOFT_GL_HALF_FLOAT: return 2;
+        case SOFT_GL_FLOAT: return 4;
+        default: return 0;
+    }
+}
+
+static float SoftReadComponent(const uint8_t *p, int32_t type, bool normalized)
+{
+    switch (type)
+    {
+        case SOFT_GL_BYTE: { int8_t v = (int8_t)p[0]; return normalized ? fmaxf(v/127.0f, -1.0f) : v; }
+        case SOFT_GL_UNSIGNED_BYTE: return normalized ? p[0]/255.0f : p[0];
+        case SOFT_GL_SHORT: { int16_t v; memcpy(&v, p, 2); return normalized ? fmaxf(v/32767.0f, -1.0f) : v; }
+        case SOFT_GL_UNSIGNED_SHORT: { uint16_t v; memcpy(&v, p, 2); return normalized ? v/65535.0f : v; }
+        case SOFT_GL_HALF_FLOAT: { uint16_t v; memcpy(&v, p, 2); return SoftHalfToFloat(v); }
+        default: { float v; memcpy(&v, p, 4); return v; }
+    }
+}
+
+// Leaves out untouched (the attribute default) for disabled or broken layouts
+static void SoftFetch(const SoftRenderer *renderer, const DrawAttribute *a, int32_t vertex, int32_t instance, float *out)
+{
+    const int32_t size = SoftTypeSize(a->type);
+    if (!a->enabled || size == 0 || a->components < 1 || a->components > 4 || (int32_t)a->buffer >= renderer->bufferCapacity) return;
+
+    const SoftBuffer *buffer = &renderer->buffers[a->buffer];
+    const size_t stride = (a->stride > 0) ? (size_t)a->stride : (size_t)size*a->components;
+    const size_t at = (size_t)a->offset + stride*((a->divisor > 0) ? instance/a->divisor : vertex);
+    if (buffer->data == NULL || a->offset < 0 || at + (size_t)size*a->components > buffer->size) return;
+
+    for (int32_t c = 0; c < a->components; c++) out[c] = SoftReadComponent(buffer->data + at + c*size, a->type, a->normalized);
+}
+
+// The vertex shaders of DrawProgram, locations as raylib and the modules bind them
+static SoftClipVertex SoftRunVertex(const SoftRenderer *renderer, const SoftVertexArray *array, const SoftProgram *program, int32_t vertex, int32_t instance)
+{
+    float in[DRAW_MAX_ATTRIBUTES][4];
+    for (int32_t l = 0; l < DRAW_MAX_ATTRIBUTES; l++)
+    {
+        float value = (l == SOFT_LOCATION_COLOR) ? 1.0f : 0.0f;
+        in[l][0] = in[l][1] = in[l][2] = value;
+        in[l][3] = 1.0f;
+        SoftFetch(renderer, &array->attributes[l], vertex, instance, in[l]);
+    }
+
+    const float (*u)[16] = program->uniforms;
+    Vector3 p = { in[0][0], in[0][1], in[0][2] };
+    float uv[2] = { in[1][0], in[1][1] }, corner[2] = { 0.0f, 0.0f };
+    const float *color = in[SOFT_LOCATION_COLOR];
+
+    switch (program->kind)
+    {
+        case DRAW_PROGRAM_PACKED:
+        {
+            p = (Vector3){ u[DRAW_UNIFORM_PARAM0][0] + p.x*u[DRAW_UNIFORM_PARAM1][0],
+                           u[DRAW_UNIFORM_PARAM0][1] + p.y*u[DRAW_UNIFORM_PARAM1][0],
+                           u[DRAW_UNIFORM_PARAM0][2] + p.z*u[DRAW_UNIFORM_PARAM1][0] };
+        } break;
+        case DRAW_PROGRAM_PARTICLE:
+        {
+            // camera facing quad around the instance, corner in [-0.5, 0.5]
+            const float *right = u[DRAW_UNIFORM_PARAM0], *up = u[DRAW_UNIFORM_PARAM1], *center = in[1];
+            float cx = in[0][0], cy = in[0][1];
+            for (int k = 0; k < 3; k++) (&p.x)[k] = center[k] + (right[k]*cx + up[k]*cy)*center[3];
+            corner[0] = cx*2.0f;
+            corner[1] = cy*2.0f;
+            color = in[2];
+        } break;
+        case DRAW_PROGRAM_SPRITE:
+        {
+            const float *center = in[1], *axisX = in[2], *axisY = in[3], *tc = in[4];
+            float cx = in[0][0], cy = in[0][1];
+            for (int k = 0; k < 3; k++) (&p.x)[k] = center[k] + axisX[k]*cx + axisY[k]*cy;
+            uv[0] = tc[0] + (tc[2] - tc[0])*(cx + 0.5f);
+            uv[1] = tc[1] + (tc[3] - tc[1])*(0.5f - cy);
+            corner[0] = cx*2.0f;
+            corner[1] = cy*2.0f;
+            color = in[5];
+        } break;
+        default: break;
+    }
+
+    Matrix mvp;
+    memcpy(&mvp, u[DRAW_UNIFORM_MVP], sizeof(mvp));
+    SoftClipVertex v = SoftClipPosition(mvp, p);
+    v.attr[0] = uv[0];
+    v.attr[1] = uv[1];
+    for (int k = 0; k < 4; k++) v.attr[2 + k] = color[k];
+    v.attr[6] = corner[0];
+    v.attr[7] = corner[1];
+    return v;
+}
+
+static void SoftDrawVertexArray(SoftRenderer *renderer, int32_t offset, int32_t count, int32_t instances, bool indexed)
+{
+    const SoftVertexArray *array = ((int32_t)renderer->vertexArray < renderer->arrayCapacity) ? &renderer->arrays[renderer->vertexArray] : NULL;
+    const SoftProgram *program = SoftFindProgram(renderer, renderer->program);
+    const SoftBuffer *elements = NULL;
+    if (indexed && array != NULL && (int32_t)array->elementBuffer < renderer->bufferCapacity) elements = &renderer->buffers[array->elementBuffer];
+
+    SoftShading shading = { 0 };
+    bool valid = (renderer->vertexArray != 0) && (array != NULL) && (program != NULL) && (offset >= 0) && (count >= 3) && (instances >= 1);
+    if (valid && indexed) valid = (elements != NULL) && (elements->data != NULL) && ((size_t)(offset + count)*sizeof(uint16_t) <= elements->size);
+    if (valid && (program->kind == DRAW_PROGRAM_DEFAULT || program->kind == DRAW_PROGRAM_SPRITE)) valid = SoftBindTexture(renderer, renderer->texture, &shading);
+    if (!valid)
+    {
+        renderer->stats.skippedDraws++;
+        return;
+    }
+    memcpy(shading.color, program->uniforms[DRAW_UNIFORM_COLOR], sizeof(shading.color));
+    if (program->kind == DRAW_PROGRAM_PARTICLE) shading.shape = SOFT_SHAPE_PARTICLE;
+
+    // shade the vertex range the draw reads once per instance
+    const uint16_t *indices = indexed ? (const uint16_t *)elements->data + offset : NULL;
+    int32_t first = offset, last = offset + count;
+    if (indexed)
+    {
+        first = INT32_MAX;
+        last = 0;
+        for (int32_t i = 0; i < count; i++)
+        {
+            if (indices[i] < first) first = indices[i];
+            if (indices[i] + 1 > last) last = indices[i] + 1;
+        }
+    }
+    if (last - first > renderer->vertexCapacity)
+    {
+        SoftClipVertex *vertices = MemReallocTagged(MEM_TAG_RENDER, renderer->vertices, sizeof(SoftClipVertex)*(last - first));
+        if (vertices == NULL)
+        {
+            renderer->stats.skippedDraws++;
+            return;
+        }
+        renderer->vertices = vertices;
+        renderer->vertexCapacity = last - first;
+    }
+    SoftClipVertex *vertices = renderer->vertices;
+
+    renderer->triangleCount = 0;
+    for (int32_t instance = 0; instance < instances; instance++)
+    {
+        for (int32_t v = first; v < last; v++) vertices[v - first] = SoftRunVertex(renderer, array, program, v, instance);
+
+        if (program->kind == DRAW_PROGRAM_SPRITE)
+        {
+            // center.w picks the shape per instance
+            float center[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+            SoftFetch(renderer, &array->attributes[1], first, instance, center);
+            shading.shape = (center[3] > 0.5f) ? SOFT_SHAPE_DISC : SOFT_SHAPE_QUAD;
+        }
+
+        for (int32_t i = 0; i + 2 < count; i += 3)
+        {
+            int32_t a = indexed ? indices[i] : offset + i;
+            int32_t b = indexed ? indices[i + 1] : offset + i + 1;
+            int32_t c = indexed ? indices[i + 2] : offset + i + 2;
+            SoftClipTriangle(renderer, &vertices[a - first], &vertices[b - first], &vertices[c - first], &shading, renderer->state->cullFace);
+        }
+    }
+    renderer->stats.meshDraws++;
+    SoftRasterize(renderer);
+}
+
+// Resources
+//----------------------------------------------------------------------------------
+static void SoftLoadBuffer(SoftRenderer *renderer, uint32_t id, uint32_t size)
+{
+    SoftBuffer *buffer = GetDrawTableEntry((void **)&renderer->buffers, &renderer->bufferCapacity, sizeof(SoftBuffer), id);
+    if (buffer == NULL) return;
+    MemFreeTagged(buffer->data);
+    *buffer = (SoftBuffer){ 0 };
+    if (size == 0) return;
+    buffer->data = MemCallocTagged(MEM_TAG_RENDER, size, 1);
+    if (buffer->data != NULL) buffer->size = size;
+}
+
+static void SoftLoadTexture(SoftRenderer *renderer, uint32_t id, int32_t width, int32_t height)
+{
+    SoftDropTarget(renderer, id);
+    SoftTexture *texture = GetDrawTableEntry((void **)&renderer->textures, &renderer->textureCapacity, sizeof(SoftTexture), id);
+    if (texture == NULL) return;
+    MemFreeTagged(texture->color);
+    *texture = (SoftTexture){ 0 };
+    if (width <= 0 || height <= 0 || width > SOFT_MAX_TEXTURE_SIZE || height > SOFT_MAX_TEXTURE_SIZE) return;
+    texture->width = width;
+    texture->height = height;
+}
+
+static void SoftTextureData(SoftRenderer *renderer, const uint8_t *payload)
+{
+    int32_t rect[4];
+    uint32_t id, size;
+    memcpy(&id, payload, 4);
+    memcpy(rect, payload + 4, sizeof(rect));
+    memcpy(&size, payload + 20, 4);
+    if ((int32_t)id >= renderer->textureCapacity) return;
+
+    SoftTexture *texture = &renderer->textures[id];
+    const int32_t x = rect[0], y = rect[1], w = rect[2], h = rect[3];
+    if (texture->width == 0 || x < 0 || y < 0 || w <= 0 || h <= 0 || x + w > texture->width || y + h > texture->height) return;
+    if (size != (uint32_t)w*h*4) return;
+
+    // render textures get no data and are never sampled from here
+    if (texture->color == NULL) texture->color = MemCallocTagged(MEM_TAG_RENDER, (size_t)texture->width*texture->height, 4);
+    if (texture->color == NULL) return;
+    for (int32_t row = 0; row < h; row++)
+    {
+        memcpy(texture->color + ((size_t)(y + row)*texture->width + x)*4, payload + 24 + (size_t)row*w*4, (size_t)w*4);
+    }
+}
+
+static void SoftLoadProgram(SoftRenderer *renderer, uint32_t id, int32_t kind)
+{
+    SoftProgram *program = SoftFindProgram(renderer, id);
+    if (program == NULL)
+    {
+        if (renderer->programCount == SOFT_MAX_PROGRAMS) return;
+        program = &renderer->programs[renderer->programCount++];
+    }
+
+    // what the shaders see before the first upload: identity and white
+    *program = (SoftProgram){ .id = id, .kind = kind };
+    const Matrix identity = MatrixIdentity();
+    memcpy(program->uniforms[DRAW_UNIFORM_MVP], &identity, sizeof(identity));
+    for (int k = 0; k < 4; k++) program->uniforms[DRAW_UNIFORM_COLOR][k] = 1.0f;
+}
+
+bool SoftApplyOp(SoftRenderer *renderer, const uint8_t *op)
+{
+    const uint8_t *payload = op + 1;
+    uint32_t u[3];
+    int32_t i[3];
+
+    float f[3];
+
+    switch (op[0])
+    {
+        // targets switch with the state, the caller has applied it already
+        case DRAW_OP_TARGET:
+        case DRAW_OP_STATE: SoftSetTarget(renderer, renderer->state->target, renderer->state->width, renderer->state->height); break;
+        case DRAW_OP_FLUSH: SoftFlush(renderer); break;
+        case DRAW_OP_BEGIN: memcpy(i, payload, 4); SoftBegin(renderer, i[0]); break;
+        case DRAW_OP_VERTEX2: memcpy(f, payload, 8); SoftVertex(renderer, f[0], f[1], 0.0f); break;
+        case DRAW_OP_VERTEX3: memcpy(f, payload, 12); SoftVertex(renderer, f[0], f[1], f[2]); break;
+        case DRAW_OP_TEXCOORD: memcpy(f, payload, 8); SoftTexCoord(renderer, f[0], f[1]); break;
+        case DRAW_OP_COLOR: SoftColor(renderer, (Color){ payload[0], payload[1], payload[2], payload[3] }); break;
+        case DRAW_OP_SET_TEXTURE: memcpy(u, payload, 4); SoftSetTexture(renderer, u[0]); break;
+        case DRAW_OP_CLEAR: SoftClear(renderer, (Color){ payload[0], payload[1], payload[2], payload[3] }); break;
+        case DRAW_OP_BUFFER:
+        {
+            memcpy(u, payload, 8);
+            SoftLoadBuffer(renderer, u[0], u[1]);
+        } break;
+        case DRAW_OP_BUFFER_DATA:
+        {
+            // id, offset, size
+            memcpy(u, payload, 12);
+            if ((int32_t)u[0] >= renderer->bufferCapacity) break;
+            SoftBuffer *buffer = &renderer->buffers[u[0]];
+            if (buffer->data != NULL && u[1] <= buffer->size && u[2] <= buffer->size - u[1]) memcpy(buffer->data + u[1], payload + 12, u[2]);
+        } break;
+        case DRAW_OP_VERTEX_ARRAY:
+        {
+            memcpy(u, payload, 4);
+            SoftVertexArray *array = GetDrawTableEntry((void **)&renderer->arrays, &renderer->arrayCapacity, sizeof(SoftVertexArray), u[0]);
+            if (array != NULL) *array = (SoftVertexArray){ 0 };
+        } break;
+        case DRAW_OP_ATTRIBUTE:
+        {
+            memcpy(u, payload, 8);
+            SoftVertexArray *array = GetDrawTableEntry((void **)&renderer->arrays, &renderer->arrayCapacity, sizeof(SoftVertexArray), u[0]);
+            if (array != NULL && u[1] < DRAW_MAX_ATTRIBUTES) memcpy(&array->attributes[u[1]], payload + 8, sizeof(DrawAttribute));
+        } break;
+        case DRAW_OP_ELEMENT_BUFFER:
+        {
+            memcpy(u, payload, 8);
+            SoftVertexArray *array = GetDrawTableEntry((void **)&renderer->arrays, &renderer->arrayCapacity, sizeof(SoftVertexArray), u[0]);
+            if (array != NULL) array->elementBuffer = u[1];
+        } break;
+        case DRAW_OP_BIND_VERTEX_ARRAY: memcpy(&renderer->vertexArray, payload, 4); break;
+        case DRAW_OP_TEXTURE:
+        {
+            memcpy(u, payload, 4);
+            memcpy(i, payload + 4, 8);
+            SoftLoadTexture(renderer, u[0], i[0], i[1]);
+        } break;
+        case DRAW_OP_TEXTURE_DATA: SoftTextureData(renderer, payload); break;
+        case DRAW_OP_PROGRAM:
+        {
+            memcpy(u, payload, 4);
+            memcpy(i, payload + 4, 4);
+            SoftLoadProgram(renderer, u[0], i[0]);
+        } break;
+        case DRAW_OP_BIND_PROGRAM: memcpy(&renderer->program, payload, 4); break;
+        case DRAW_OP_BATCH_PROGRAM: memcpy(&renderer->batchProgram, payload, 4); break;
+        case DRAW_OP_UNIFORM:
+        {
+            memcpy(u, payload, 8);
+            SoftProgram *program = SoftFindProgram(renderer, u[0]);
+            if (program != NULL && u[1] < DRAW_UNIFORM_COUNT) memcpy(program->uniforms[u[1]], payload + 8, sizeof(float)*16);
+        } break;
+        case DRAW_OP_ENABLE_TEXTURE: memcpy(&renderer->texture, payload, 4); break;
+        case DRAW_OP_DRAW_ARRAYS:
+        case DRAW_OP_DRAW_ELEMENTS:
+        {
+            memcpy(i, payload, 12);
+            SoftDrawVertexArray(renderer, i[0], i[1], i[2], op[0] == DRAW_OP_DRAW_ELEMENTS);
+        } break;
+        default: return false;
+    }
+    return true;
+}
+
+const SoftTarget *GetSoftTarget(const SoftRenderer *renderer, uint32_t texture)
+{
+    int32_t index = SoftFindTarget(renderer, texture);
+    return (index >= 0) ? &renderer->targets[index] : NULL;
+}
+
+uint64_t GetSoftTargetHash(const SoftTarget *target)
+{
+    uint64_t hash = 14695981039346656037ull;
+    const size_t size = (size_t)target->width*target->height*4;
+    for (size_t i = 0; i < size; i++) hash = (hash ^ target->color[i])*1099511628211ull;
+    return hash;
+}
+
+// PNG writing: zlib stored blocks, golden images are compared by pixels not size
+//----------------------------------------------------------------------------------
+static uint32_t SoftCrc(uint32_t crc, const uint8_t *data, size_t size)
+{
+    static uint32_t table[256];
+    static bool tableReady = false;
+    if (!tableReady)
+    {
+        for (uint32_t n = 0; n < 256; n++)
+        {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++) c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            table[n] = c;
+        }
+        tableReady = true;
+    }
+
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    return ~crc;
+}
+
+static void SoftPutBE32(uint8_t *out, uint32_t value)
+{
+    out[0] = (uint8_t)(value >> 24);
+    out[1] = (uint8_t)(value >> 16);
+    out[2] = (uint8_t)(value >> 8);
+    out[3] = (uint8_t)value;
+}
+
+static bool SoftWriteChunk(FILE *file, const char *type, const uint8_t *data, uint32_t size)
+{
+    uint8_t head[8];
+    SoftPutBE32(head, size);
+    memcpy(head + 4, type, 4);
+    uint32_t crc = SoftCrc(SoftCrc(0, head + 4, 4), data, size);
+    uint8_t tail[4];
+    SoftPutBE32(tail, crc);
+
+    return fwrite(head, 8, 1, file) == 1 && (size == 0 || fwrite(data, size, 1, file) == 1) && fwrite(tail, 4, 1, file) == 1;
+}
+
+bool ExportSoftTarget(const SoftTarget *target, const char *fileName)
+{
+    // filter byte per row, rows top first
+    const size_t stride = (size_t)target->width*4 + 1;
+    const size_t rawSize = stride*target->height;
+    const size_t blocks = (rawSize + 65534)/65535;
+    uint8_t *raw = MemAllocTagged(MEM_TAG_RENDER, rawSize);
+    uint8_t *zlib = MemAllocTagged(MEM_TAG_RENDER, 2 + rawSize + blocks*5 + 4);
+    if (raw == NULL || zlib == NULL)
+    {
+        MemFreeTagged(raw);
+        MemFreeTagged(zlib);
+        return false;
+    }
+
+    for (int32_t y = 0; y < target->height; y++)
+    {
+        raw[y*stride] = 0;
+        memcpy(raw + y*stride + 1, target->color + (size_t)(target->height - 1 - y)*target->width*4, (size_t)target->width*4);
+    }
+
+    size_t at = 0;
+    zlib[at++] = 0x78;
+    zlib[at++] = 0x01;
+    for (size_t offset = 0; offset < rawSize; offset += 65535)
+    {
+        uint16_t size = (uint16_t)((rawSize - offset < 65535) ? rawSize - offset : 65535);
+        zlib[at++] = (offset + size == rawSize) ? 1 : 0;
+        zlib[at++] = (uint8_t)size;
+        zlib[at++] = (uint8_t)(size >> 8);
+        zlib[at++] = (uint8_t)~size;
+        zlib[at++] = (uint8_t)(~size >> 8);
+        memcpy(zlib + at, raw + offset, size);
+        at += size;
+    }
+    uint32_t s1 = 1, s2 = 0;
+    for (size_t i = 0; i < rawSize; i++)
+    {
+        s1 = (s1 + raw[i])%65521;
+        s2 = (s2 + s1)%65521;
+    }
+    SoftPutBE32(zlib + at, (s2 << 16) | s1);
+    at += 4;
+
+    uint8_t header[13];
+    SoftPutBE32(header, target->width);
+    SoftPutBE32(header + 4, target->height);
+    header[8] = 8;                  // bit depth
+    header[9] = 6;                  // RGBA
+    header[10] = header[11] = header[12] = 0;
+
+    FILE *file = fopen(fileName, "wb");
+    bool ok = file != NULL;
+    ok = ok && fwrite("\x89PNG\r\n\x1a\n", 8, 1, file) == 1;
+    ok = ok && SoftWriteChunk(file, "IHDR", header, sizeof(header));
+    ok = ok && SoftWriteChunk(file, "IDAT", zlib, (uint32_t)at);
+    ok = ok && SoftWriteChunk(file, "IEND", NULL, 0);
+    if (file != NULL) fclose(file);
+
+    MemFreeTagged(raw);
+    MemFreeTagged(zlib);
+    return ok;
+}
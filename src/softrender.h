@@ -0,0 +1,142 @@
+#ifndef SOFTRENDER_H
+#define SOFTRENDER_H
+
+#include "drawstream.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// CPU rasterizer for draw streams, no GL needed (CI and bench machines).
+// Vertices are batched exactly like rlgl batches them; a flush transforms,
+// near-clips, culls and sets up every triangle, bins them into
+// SOFT_TILE_SIZE tiles and rasterizes the tiles in parallel on the job
+// system. Tiles keep submission order, so output is identical for any
+// worker count.
+//
+// Render targets are kept per texture id, drawing a texture some target
+// rendered to samples it (dynamic resolution, retained HUD); other textures
+// sample what the stream uploaded (atlases, fonts). Vertex array draws
+// (DrawMesh, packed level chunks, sprites, particles) read the buffers and
+// layouts the stream loaded and run the matching shader on the CPU, see
+// DrawProgram. Lines, and draws whose texture or buffers the stream never
+// loaded (a capture without resource tracking), are skipped.
+// Sampling is nearest with repeat, distance field glyphs bilinear.
+// Color buffers are RGBA8 with the bottom row first, like GL.
+
+#define SOFT_TILE_SIZE 64
+#define SOFT_MAX_TARGETS 8
+#define SOFT_MAX_DRAWS RL_DEFAULT_BATCH_DRAWCALLS
+#define SOFT_MAX_PROGRAMS 32
+
+typedef struct {
+    uint32_t texture;               // texture id rendered to, 0 for the screen
+    int32_t width;
+    int32_t height;
+    uint8_t *color;
+    float *depth;
+} SoftTarget;
+
+typedef struct {
+    int32_t mode;
+    uint32_t texture;
+    int32_t first;
+    int32_t count;
+} SoftDraw;
+
+typedef struct {
+    uint32_t size;
+    uint8_t *data;
+} SoftBuffer;
+
+typedef struct {
+    DrawAttribute attributes[DRAW_MAX_ATTRIBUTES];
+    uint32_t elementBuffer;
+} SoftVertexArray;
+
+typedef struct {
+    int32_t width;
+    int32_t height;
+    uint8_t *color;                 // RGBA8, NULL until data arrives
+} SoftTexture;
+
+typedef struct {
+    uint32_t id;
+    int32_t kind;                   // DrawProgram
+    float uniforms[DRAW_UNIFORM_COUNT][16];
+} SoftProgram;
+
+typedef struct {
+    int32_t triangles;              // rasterized
+    int32_t culled;                 // back facing, degenerate or behind the camera
+    int32_t skippedDraws;           // lines, textures or buffers the stream never loaded
+    int32_t meshDraws;              // vertex array draws rasterized
+} SoftStats;
+
+typedef struct {
+    const DrawStreamState *state;   // matrices and depth/cull state flushes draw with
+    SoftTarget targets[SOFT_MAX_TARGETS];
+    int32_t targetCount;
+    int32_t current;                // index of the bound target
+
+    Vector3 *positions;             // the batch, as rlgl would hold it
+    Vector2 *texcoords;
+    Color *colors;
+    int32_t vertexCount;
+    Vector2 texcoord;
+    Color color;
+    SoftDraw draws[SOFT_MAX_DRAWS];
+    int32_t drawCount;
+
+    void *triangles;                // set up triangles of the flush in flight
+    int32_t triangleCount;
+    int32_t triangleCapacity;
+    int32_t *tileOffsets;           // per tile ranges into tileTriangles
+    int32_t *tileTriangles;
+    int32_t tileTriangleCapacity;
+    bool depthTest;                 // state of the flush in flight, read by the tile jobs
+    bool depthMask;
+
+    SoftBuffer *buffers;            // resources by GL id
+    int32_t bufferCapacity;
+    SoftVertexArray *arrays;
+    int32_t arrayCapacity;
+    SoftTexture *textures;
+    int32_t textureCapacity;
+    SoftProgram programs[SOFT_MAX_PROGRAMS];
+    int32_t programCount;
+    uint32_t vertexArray;           // bound for vertex array draws
+    uint32_t program;
+    uint32_t batchProgram;          // the render batch's, BeginShaderMode()
+    uint32_t texture;               // rlEnableTexture(), 0 for the default
+    void *vertices;                 // shaded vertices of the draw in flight
+    int32_t vertexCapacity;
+
+    SoftStats stats;
+} SoftRenderer;
+
+// state is the replay's, the screen target starts at its screen size
+SoftRenderer LoadSoftRenderer(const DrawStreamState *state);
+void UnloadSoftRenderer(SoftRenderer *renderer);
+
+// Binds the target for texture (0 = screen), created or resized on demand
+void SoftSetTarget(SoftRenderer *renderer, uint32_t texture, int32_t width, int32_t height);
+void SoftClear(SoftRenderer *renderer, Color color);
+
+void SoftBegin(SoftRenderer *renderer, int mode);
+void SoftSetTexture(SoftRenderer *renderer, uint32_t texture);
+void SoftTexCoord(SoftRenderer *renderer, float u, float v);
+void SoftColor(SoftRenderer *renderer, Color color);
+// Position as recorded, the pushed transform is applied like rlgl does
+void SoftVertex(SoftRenderer *renderer, float x, float y, float z);
+void SoftFlush(SoftRenderer *renderer);
+
+// Plays one op of the stream through the calls above and the resource and
+// vertex array ops; false for ops it has no use for (FRAME, NORMAL, matrices).
+// Apply the op to the state first, TARGET and STATE bind the target it names.
+// op points at the op byte, trailing data included.
+bool SoftApplyOp(SoftRenderer *renderer, const uint8_t *op);
+
+const SoftTarget *GetSoftTarget(const SoftRenderer *renderer, uint32_t texture);
+uint64_t GetSoftTargetHash(const SoftTarget *target);
+bool ExportSoftTarget(const SoftTarget *target, const char *fileName);   // PNG
+
+#endif
@@ -0,0 +1,263 @@
+#include "spritebatch.h"
+#include "memtrack.h"
+#include "raymath.h"
+#include "rlgl.h"
+#include <math.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+// Same scheme as the particle renderer: a static 6 vertex quad plus per
+// instance attributes, except the quad edges come from the CPU so rotated
+// sprites, screen quads and billboards share one shader.
+
+static const char *spriteVertexShader =
+    "#version 330\n"
+    "layout(location = 0) in vec2 corner;\n"
+    "layout(location = 1) in vec4 instanceCenter;\n"
+    "layout(location = 2) in vec3 instanceAxisX;\n"
+    "layout(location = 3) in vec3 instanceAxisY;\n"
+    "layout(location = 4) in vec4 instanceTexCoords;\n"
+    "layout(location = 5) in vec4 instanceColor;\n"
+    "uniform mat4 mvp;\n"
+    "out vec2 fragTexCoord;\n"
+    "out vec2 fragCorner;\n"
+    "out vec4 fragColor;\n"
+    "flat out float fragShape;\n"
+    "void main()\n"
+    "{\n"
+    "    vec3 position = instanceCenter.xyz + instanceAxisX*corner.x + instanceAxisY*corner.y;\n"
+    "    fragTexCoord = mix(instanceTexCoords.xy, instanceTexCoords.zw, vec2(corner.x + 0.5, 0.5 - corner.y));\n"
+    "    fragCorner = corner*2.0;\n"
+    "    fragColor = instanceColor;\n"
+    "    fragShape = instanceCenter.w;\n"
+    "    gl_Position = mvp*vec4(position, 1.0);\n"
+    "}\n";
+
+static const char *spriteFragmentShader =
+    "#version 330\n"
+    "in vec2 fragTexCoord;\n"
+    "in vec2 fragCorner;\n"
+    "in vec4 fragColor;\n"
+    "flat in float fragShape;\n"
+    "uniform sampler2D texture0;\n"
+    "out vec4 finalColor;\n"
+    "void main()\n"
+    "{\n"
+    "    vec4 color = texture(texture0, fragTexCoord)*fragColor;\n"
+    "    if (fragShape > 0.5)\n"
+    "    {\n"
+    "        float d = length(fragCorner);\n"
+    "        float width = max(fwidth(d), 0.0001);\n"
+    "        color.a *= 1.0 - smoothstep(1.0 - width, 1.0, d);\n"
+    "    }\n"
+    "    if (color.a <= 0.0) discard;\n"
+    "    finalColor = color;\n"
+    "}\n";
+
+SpriteBatch LoadSpriteBatch(SpriteSpace space, int32_t capacity)
+{
+    SpriteBatch batch = { .space = space };
+    static const float corners[12] = {
+        -0.5f, -0.5f,  0.5f, -0.5f,  0.5f, 0.5f,
+        -0.5f, -0.5f,  0.5f, 0.5f,  -0.5f, 0.5f
+    };
+
+    size_t perSprite = sizeof(SpriteInstance) + sizeof(unsigned int) + sizeof(float)*10;
+    batch.memory = MemAllocTagged(MEM_TAG_RENDER, perSprite*capacity);
+    if (batch.memory == NULL) return batch;
+    batch.capacity = capacity;
+    batch.instances = batch.memory;
+    batch.width = (float *)(batch.instances + capacity);
+    batch.height = batch.width + capacity;
+    batch.cosRotation = batch.height + capacity;
+    batch.sinRotation = batch.cosRotation + capacity;
+    batch.axes = batch.sinRotation + capacity;
+    batch.textures = (unsigned int *)(batch.axes + 6*capacity);
+
+    batch.shader = LoadShaderFromMemory(spriteVertexShader, spriteFragmentShader);
+
+    batch.vao = rlLoadVertexArray();
+    rlEnableVertexArray(batch.vao);
+    batch.cornerBuffer = rlLoadVertexBuffer(corners, sizeof(corners), false);
+    rlSetVertexAttribute(0, 2, RL_FLOAT, false, 0, 0);
+    rlEnableVertexAttribute(0);
+
+    // attribute pointers are set per draw, see SpriteBindInstances()
+    batch.instanceBuffer = rlLoadVertexBuffer(NULL, (int)sizeof(SpriteInstance)*capacity, true);
+    for (unsigned int location = 1; location <= 5; location++)
+    {
+        rlEnableVertexAttribute(location);
+        rlSetVertexAttributeDivisor(location, 1);
+    }
+    rlDisableVertexArray();
+
+    return batch;
+}
+
+void UnloadSpriteBatch(SpriteBatch *batch)
+{
+    if (batch->vao > 0)
+    {
+        rlUnloadVertexArray(batch->vao);
+        rlUnloadVertexBuffer(batch->cornerBuffer);
+        rlUnloadVertexBuffer(batch->instanceBuffer);
+        UnloadShader(batch->shader);
+    }
+    MemFreeTagged(batch->memory);
+    *batch = (SpriteBatch){ 0 };
+}
+
+static bool SpriteAppend(SpriteBatch *batch, unsigned int texture, Vector3 center, SpriteShape shape, Vector2 size, float rotation, const float *texcoords, Color color)
+{
+    if (batch->count >= batch->capacity) return false;
+
+    int32_t i = batch->count++;
+    batch->instances[i] = (SpriteInstance){
+        .center = { center.x, center.y, center.z, (float)shape },
+        .texcoords = { texcoords[0], texcoords[1], texcoords[2], texcoords[3] },
+        .color = { color.r, color.g, color.b, color.a }
+    };
+    batch->textures[i] = texture;
+    batch->width[i] = size.x;
+    batch->height[i] = size.y;
+    batch->cosRotation[i] = (rotation == 0.0f) ? 1.0f : cosf(rotation*DEG2RAD);
+    batch->sinRotation[i] = (rotation == 0.0f) ? 0.0f : sinf(rotation*DEG2RAD);
+    return true;
+}
+
+bool AddSprite(SpriteBatch *batch, Texture2D texture, Rectangle source, Vector3 center, Vector2 size, float rotation, Color tint)
+{
+    if (texture.id == 0 || texture.width == 0 || texture.height == 0) return false;
+
+    // like DrawTexturePro(): a negative extent flips the same source area
+    float u0 = source.x/texture.width, u1 = (source.x + fabsf(source.width))/texture.width;
+    float v0 = source.y/texture.height, v1 = (source.y + fabsf(source.height))/texture.height;
+    const float texcoords[4] = {
+        (source.width < 0.0f) ? u1 : u0, (source.height < 0.0f) ? v1 : v0,
+        (source.width < 0.0f) ? u0 : u1, (source.height < 0.0f) ? v0 : v1
+    };
+    return SpriteAppend(batch, texture.id, center, SPRITE_SHAPE_QUAD, size, rotation, texcoords, tint);
+}
+
+bool AddSpriteRectangle(SpriteBatch *batch, Rectangle rec, Color color)
+{
+    static const float texcoords[4] = { 0.0f, 0.0f, 1.0f, 1.0f };
+    Vector3 center = { rec.x + rec.width*0.5f, rec.y + rec.height*0.5f, 0.0f };
+    return SpriteAppend(batch, rlGetTextureIdDefault(), center, SPRITE_SHAPE_QUAD, (Vector2){ rec.width, rec.height }, 0.0f, texcoords, color);
+}
+
+bool AddSpriteRectangleLines(SpriteBatch *batch, Rectangle rec, float lineThick, Color color)
+{
+    // top and bottom span the full width, the sides fill in between
+    float t = fminf(lineThick, fminf(rec.width, rec.height)*0.5f);
+    return AddSpriteRectangle(batch, (Rectangle){ rec.x, rec.y, rec.width, t }, color) &&
+           AddSpriteRectangle(batch, (Rectangle){ rec.x, rec.y + rec.height - t, rec.width, t }, color) &&
+           AddSpriteRectangle(batch, (Rectangle){ rec.x, rec.y + t, t, rec.height - 2.0f*t }, color) &&
+           AddSpriteRectangle(batch, (Rectangle){ rec.x + rec.width - t, rec.y + t, t, rec.height - 2.0f*t }, color);
+}
+
+bool AddSpriteCircle(SpriteBatch *batch, Vector2 center, float radius, Color color)
+{
+    static const float texcoords[4] = { 0.0f, 0.0f, 1.0f, 1.0f };
+    return SpriteAppend(batch, rlGetTextureIdDefault(), (Vector3){ center.x, center.y, 0.0f }, SPRITE_SHAPE_DISC,
+                        (Vector2){ radius*2.0f, radius*2.0f }, 0.0f, texcoords, color);
+}
+
+// Quad edges for every sprite from the frame's right/up basis: flat streams
+// in and out, no branches, restrict parameters, so the compiler vectorizes it
+static void SpriteExpandAxes(int32_t n, Vector3 right, Vector3 up, const float *restrict width, const float *restrict height,
+                             const float *restrict c, const float *restrict s, float *restrict xx, float *restrict xy,
+                             float *restrict xz, float *restrict yx, float *restrict yy, float *restrict yz)
+{
+    const float rx = right.x, ry = right.y, rz = right.z;
+    const float ux = up.x, uy = up.y, uz = up.z;
+
+    // positive rotation turns clockwise on screen
+    for (int32_t i = 0; i < n; i++)
+    {
+        xx[i] = (rx*c[i] - ux*s[i])*width[i];
+        xy[i] = (ry*c[i] - uy*s[i])*width[i];
+        xz[i] = (rz*c[i] - uz*s[i])*width[i];
+        yx[i] = (ux*c[i] + rx*s[i])*height[i];
+        yy[i] = (uy*c[i] + ry*s[i])*height[i];
+        yz[i] = (uz*c[i] + rz*s[i])*height[i];
+    }
+}
+
+static void SpriteExpand(SpriteBatch *batch, Vector3 right, Vector3 up)
+{
+    const int32_t n = batch->count, capacity = batch->capacity;
+    float *axes[6];
+    for (int k = 0; k < 6; k++) axes[k] = batch->axes + k*capacity;
+    SpriteExpandAxes(n, right, up, batch->width, batch->height, batch->cosRotation, batch->sinRotation,
+                     axes[0], axes[1], axes[2], axes[3], axes[4], axes[5]);
+
+    // interleave into the instance layout
+    for (int32_t i = 0; i < n; i++)
+    {
+        SpriteInstance *instance = &batch->instances[i];
+        for (int k = 0; k < 3; k++)
+        {
+            instance->axisX[k] = axes[k][i];
+            instance->axisY[k] = axes[3 + k][i];
+        }
+    }
+}
+
+// GL 3.3 has no base instance, each draw points the attributes at its run
+static void SpriteBindInstances(const SpriteBatch *batch, int32_t first)
+{
+    const size_t base = sizeof(SpriteInstance)*first;
+    rlEnableVertexBuffer(batch->instanceBuffer);
+    rlSetVertexAttribute(1, 4, RL_FLOAT, false, sizeof(SpriteInstance), (void *)(uintptr_t)(base + offsetof(SpriteInstance, center)));
+    rlSetVertexAttribute(2, 3, RL_FLOAT, false, sizeof(SpriteInstance), (void *)(uintptr_t)(base + offsetof(SpriteInstance, axisX)));
+    rlSetVertexAttribute(3, 3, RL_FLOAT, false, sizeof(SpriteInstance), (void *)(uintptr_t)(base + offsetof(SpriteInstance, axisY)));
+    rlSetVertexAttribute(4, 4, RL_FLOAT, false, sizeof(SpriteInstance), (void *)(uintptr_t)(base + offsetof(SpriteInstance, texcoords)));
+    rlSetVertexAttribute(5, 4, RL_UNSIGNED_BYTE, true, sizeof(SpriteInstance), (void *)(uintptr_t)(base + offsetof(SpriteInstance, color)));
+}
+
+void DrawSpriteBatch(SpriteBatch *batch)
+{
+    const int32_t n = batch->count;
+    batch->draws = 0;
+    if (n == 0) return;
+
+    // whatever raylib batched so far has to land before our own draw
+    rlDrawRenderBatchActive();
+
+    Matrix view = rlGetMatrixModelview();
+    Matrix mvp = MatrixMultiply(view, rlGetMatrixProjection());
+    Vector3 right = { 1.0f, 0.0f, 0.0f };
+    Vector3 up = { 0.0f, -1.0f, 0.0f };
+    if (batch->space == SPRITE_SPACE_WORLD)
+    {
+        right = (Vector3){ view.m0, view.m4, view.m8 };
+        up = (Vector3){ view.m1, view.m5, view.m9 };
+    }
+    SpriteExpand(batch, right, up);
+    rlUpdateVertexBuffer(batch->instanceBuffer, batch->instances, (int)sizeof(SpriteInstance)*n, 0);
+
+    rlDisableBackfaceCulling();
+    rlEnableShader(batch->shader.id);
+    rlSetUniformMatrix(batch->shader.locs[SHADER_LOC_MATRIX_MVP], mvp);
+    rlEnableVertexArray(batch->vao);
+    rlActiveTextureSlot(0);
+
+    for (int32_t first = 0; first < n; )
+    {
+        int32_t end = first + 1;
+        while (end < n && batch->textures[end] == batch->textures[first]) end++;
+
+        rlEnableTexture(batch->textures[first]);
+        SpriteBindInstances(batch, first);
+        rlDrawVertexArrayInstanced(0, 6, end - first);
+        batch->draws++;
+        first = end;
+    }
+
+    rlDisableVertexArray();
+    rlDisableTexture();
+    rlDisableShader();
+    rlEnableBackfaceCulling();
+    batch->count = 0;
+}
@@ -0,0 +1,64 @@
+#ifndef SPRITEBATCH_H
+#define SPRITEBATCH_H
+
+#include "raylib.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Instanced sprite batcher for textured quads, rectangles and discs.
+// Callers append sprites (center, size, atlas rect, rotation, tint) during
+// the frame; DrawSpriteBatch() expands every quad's two edge vectors in one
+// branch free SoA loop (camera facing for world batches, screen aligned for
+// screen batches), uploads them and issues one instanced draw per run of
+// sprites sharing a texture. Submission order is kept, nothing is sorted.
+
+typedef enum {
+    SPRITE_SPACE_WORLD = 0,         // billboards, draw inside BeginMode3D()
+    SPRITE_SPACE_SCREEN             // pixels, y down, draw between BeginDrawing()/EndDrawing()
+} SpriteSpace;
+
+typedef enum {
+    SPRITE_SHAPE_QUAD = 0,
+    SPRITE_SHAPE_DISC               // antialiased circle inscribed in the quad
+} SpriteShape;
+
+typedef struct {
+    float center[4];                // xyz, w = SpriteShape
+    float axisX[3];                 // full quad edges, filled at draw time
+    float axisY[3];
+    float texcoords[4];             // u0, v0 (top left), u1, v1
+    unsigned char color[4];
+} SpriteInstance;
+
+typedef struct {
+    SpriteSpace space;
+    int32_t capacity;
+    int32_t count;
+    SpriteInstance *instances;      // CPU staging copy of the instance buffer
+    unsigned int *textures;         // per sprite, runs become draws
+    float *width, *height;          // inputs of the expand loop
+    float *cosRotation, *sinRotation;
+    float *axes;                    // expand loop output, 6 streams of capacity
+    void *memory;                   // single allocation behind all the streams
+    Shader shader;
+    unsigned int vao;
+    unsigned int cornerBuffer;
+    unsigned int instanceBuffer;
+    int32_t draws;                  // instanced draws issued by the last DrawSpriteBatch()
+} SpriteBatch;
+
+SpriteBatch LoadSpriteBatch(SpriteSpace space, int32_t capacity);
+void UnloadSpriteBatch(SpriteBatch *batch);
+
+// source is in texture pixels, negative width/height flip like DrawTexturePro();
+// rotation in degrees. All return false when the batch is full.
+bool AddSprite(SpriteBatch *batch, Texture2D texture, Rectangle source, Vector3 center, Vector2 size, float rotation, Color tint);
+// Untextured shapes for screen batches, same arguments as the raylib shapes
+bool AddSpriteRectangle(SpriteBatch *batch, Rectangle rec, Color color);
+bool AddSpriteRectangleLines(SpriteBatch *batch, Rectangle rec, float lineThick, Color color);
+bool AddSpriteCircle(SpriteBatch *batch, Vector2 center, float radius, Color color);
+
+// Draws and clears everything appended since the last call
+void DrawSpriteBatch(SpriteBatch *batch);
+
+#endif
@@ -0,0 +1,163 @@
+#include "startup.h"
+#include "jobs.h"
+#include "profiler.h"
+#include "raylib.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <time.h>
+
+// one graph runs at a time, startup only
+static struct {
+    StartupGraph *graph;
+    uint32_t done;                  // bit per finished task
+    double origin;
+    pthread_mutex_t lock;
+    pthread_cond_t finished;
+} startup = { .graph = NULL, .lock = PTHREAD_MUTEX_INITIALIZER, .finished = PTHREAD_COND_INITIALIZER };
+
+// Own clock, tasks time themselves on workers and before there is a window
+static double StartupNow(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec*1e-9;
+}
+
+int32_t AddStartupTask(StartupGraph *graph, const char *name, StartupFunc fn, void *user, bool mainThread, uint32_t after)
+{
+    if (graph->taskCount >= STARTUP_MAX_TASKS) return -1;
+
+    int32_t id = graph->taskCount++;
+    uint32_t earlier = STARTUP_AFTER(id) - 1;
+    if ((after & ~earlier) != 0) TraceLog(LOG_WARNING, "STARTUP: [%s] can only wait for tasks added before it", name);
+    graph->tasks[id] = (StartupTask){ .name = name, .fn = fn, .user = user, .after = after & earlier,
+                                      .mainThread = mainThread, .previous = -1 };
+    return id;
+}
+
+static void StartupRun(StartupTask *task)
+{
+    task->start = StartupNow() - startup.origin;
+    PROFILE_BEGIN(zone, task->name);
+    task->fn(task->user);
+    PROFILE_END(zone);
+    task->end = StartupNow() - startup.origin;
+}
+
+static void StartupWorkerTask(void *user)
+{
+    StartupTask *task = user;
+    StartupRun(task);
+
+    pthread_mutex_lock(&startup.lock);
+    startup.done |= STARTUP_AFTER(task - startup.graph->tasks);
+    pthread_cond_signal(&startup.finished);
+    pthread_mutex_unlock(&startup.lock);
+}
+
+void RunStartupGraph(StartupGraph *graph)
+{
+    startup.graph = graph;
+    startup.done = 0;
+    startup.origin = StartupNow();
+
+    uint32_t all = STARTUP_AFTER(graph->taskCount) - 1;
+    uint32_t started = 0;
+    int32_t lastMain = -1;
+    pthread_mutex_lock(&startup.lock);
+    while (startup.done != all)
+    {
+        // workers first so they get going before the main thread is busy
+        uint32_t done = startup.done;
+        pthread_mutex_unlock(&startup.lock);
+        int32_t next = -1;
+        for (int32_t i = 0; i < graph->taskCount; i++)
+        {
+            StartupTask *task = &graph->tasks[i];
+            if ((started & STARTUP_AFTER(i)) != 0 || (task->after & ~done) != 0) continue;
+            if (task->mainThread)
+            {
+                if (next < 0) next = i;
+                continue;
+            }
+            started |= STARTUP_AFTER(i);
+            JobsSubmit(StartupWorkerTask, task);
+        }
+
+        if (next >= 0)
+        {
+            StartupTask *task = &graph->tasks[next];
+            started |= STARTUP_AFTER(next);
+            task->previous = lastMain;
+            lastMain = next;
+            StartupRun(task);
+        }
+        pthread_mutex_lock(&startup.lock);
+        if (next >= 0) startup.done |= STARTUP_AFTER(next);
+        // nothing for the main thread, sleep until a worker task finishes
+        else if (startup.done == done) pthread_cond_wait(&startup.finished, &startup.lock);
+    }
+    pthread_mutex_unlock(&startup.lock);
+
+    graph->wall = StartupNow() - startup.origin;
+    startup.graph = NULL;
+
+    double work = 0.0;
+    for (int32_t i = 0; i < graph->taskCount; i++)
+    {
+        const StartupTask *task = &graph->tasks[i];
+        TraceLog(LOG_INFO, "STARTUP: [%s] %.2f ms on %s", task->name, (task->end - task->start)*1000.0,
+                 task->mainThread ? "the main thread" : "a worker");
+        work += task->end - task->start;
+    }
+    TraceLog(LOG_INFO, "STARTUP: %d tasks done in %.2f ms, %.2f ms of work", graph->taskCount, graph->wall*1000.0, work*1000.0);
+}
+
+void PrintStartupReport(const StartupGraph *graph)
+{
+    if (graph->taskCount == 0) return;
+
+    printf("Startup: %d tasks, %.2f ms wall\n", graph->taskCount, graph->wall*1000.0);
+    printf("  %-20s %-7s %10s %10s\n", "task", "thread", "start ms", "time ms");
+    double work = 0.0;
+    int32_t last = 0;
+    for (int32_t i = 0; i < graph->taskCount; i++)
+    {
+        const StartupTask *task = &graph->tasks[i];
+        printf("  %-20s %-7s %10.2f %10.2f\n", task->name, task->mainThread ? "main" : "worker", task->start*1000.0,
+               (task->end - task->start)*1000.0);
+        work += task->end - task->start;
+        if (task->end > graph->tasks[last].end) last = i;
+    }
+    printf("  %.2f ms of work in %.2f ms, %.2fx over running it serially\n", work*1000.0, graph->wall*1000.0,
+           (graph->wall > 0.0) ? work/graph->wall : 1.0);
+
+    // walk back from the last task along whatever finished last before it started
+    int32_t path[STARTUP_MAX_TASKS];
+    int32_t length = 0;
+    for (int32_t task = last; task >= 0 && length < STARTUP_MAX_TASKS;)
+    {
+        path[length++] = task;
+        int32_t blocker = graph->tasks[task].previous;
+        for (int32_t i = 0; i < task; i++)
+        {
+            if ((graph->tasks[task].after & STARTUP_AFTER(i)) == 0) continue;
+            if (blocker < 0 || graph->tasks[i].end > graph->tasks[blocker].end) blocker = i;
+        }
+        task = blocker;
+    }
+
+    double onPath = 0.0;
+    printf("Critical path:\n");
+    for (int32_t i = length - 1; i >= 0; i--)
+    {
+        const StartupTask *task = &graph->tasks[path[i]];
+        double ready = (i == length - 1) ? 0.0 : graph->tasks[path[i + 1]].end;
+        printf("  %-20s %10.2f ms", task->name, (task->end - task->start)*1000.0);
+        // a gap is the main thread busy with work off the path or workers still queued
+        if (task->start - ready > 0.0005) printf("  (+%.2f ms waiting)", (task->start - ready)*1000.0);
+        printf("\n");
+        onPath += task->end - task->start;
+    }
+    printf("  %.2f ms of %.2f ms on the path is task work\n", onPath*1000.0, graph->tasks[last].end*1000.0);
+}
@@ -0,0 +1,51 @@
+#ifndef STARTUP_H
+#define STARTUP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Startup as a task graph instead of one serial chain.
+// Each task names the tasks that have to finish before it. Worker tasks
+// (file decoding, mesh generation, table baking) go to the job system as
+// soon as their dependencies are done, main thread tasks (window, GL,
+// anything raylib) run on the caller in the order they were added, so CPU
+// work overlaps window and context creation.
+//
+// Every task is timed; PrintStartupReport() walks back from the last task to
+// finish along whatever held each task up, a dependency or the main thread
+// task before it, which is the critical path to shorten.
+
+#define STARTUP_MAX_TASKS 32
+#define STARTUP_AFTER(task) (1u << (task))
+
+typedef void (*StartupFunc)(void *user);
+
+typedef struct {
+    const char *name;
+    StartupFunc fn;
+    void *user;
+    uint32_t after;         // STARTUP_AFTER() of every task that has to finish first
+    bool mainThread;
+    // filled in by RunStartupGraph(), seconds since the graph started
+    double start;
+    double end;
+    int32_t previous;       // main thread task that ran just before, -1 for none
+} StartupTask;
+
+typedef struct {
+    StartupTask tasks[STARTUP_MAX_TASKS];
+    int32_t taskCount;
+    double wall;            // seconds RunStartupGraph() took
+} StartupGraph;
+
+// Returns the task id, -1 when the graph is full. A task can only wait for
+// tasks added before it, which keeps the graph free of cycles.
+int32_t AddStartupTask(StartupGraph *graph, const char *name, StartupFunc fn, void *user, bool mainThread, uint32_t after);
+
+// Blocks until every task ran, then logs the time each one took
+void RunStartupGraph(StartupGraph *graph);
+
+// Per task timeline and the critical path, for --startup-report
+void PrintStartupReport(const StartupGraph *graph);
+
+#endif
@@ -0,0 +1,184 @@
+#include "text.h"
+#include "bundle.h"
+#include "memtrack.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// Distance is stored in the atlas alpha, 0.5 is the glyph edge. The edge is
+// smoothed over one screen pixel whatever size the glyph is drawn at.
+static const char *sdfFragmentShader =
+    "#version 330\n"
+    "in vec2 fragTexCoord;\n"
+    "in vec4 fragColor;\n"
+    "uniform sampler2D texture0;\n"
+    "uniform vec4 colDiffuse;\n"
+    "out vec4 finalColor;\n"
+    "void main()\n"
+    "{\n"
+    "    float distance = texture(texture0, fragTexCoord).a - 0.5;\n"
+    "    float width = max(length(vec2(dFdx(distance), dFdy(distance))), 0.0001);\n"
+    "    float alpha = smoothstep(-width, width, distance);\n"
+    "    finalColor = vec4(fragColor.rgb, fragColor.a*alpha)*colDiffuse;\n"
+    "}\n";
+
+typedef struct {
+    char magic[4];
+    int32_t version;
+    int32_t baseSize;
+    int32_t glyphPadding;
+    int32_t glyphCount;
+    int32_t atlasWidth;
+    int32_t atlasHeight;
+    int32_t atlasFormat;
+} TextFileHeader;
+
+typedef struct {
+    int32_t value;
+    int32_t offsetX;
+    int32_t offsetY;
+    int32_t advanceX;
+    Rectangle rec;
+} TextFileGlyph;
+
+bool SaveSdfFont(const GlyphInfo *glyphs, const Rectangle *recs, int glyphCount, Image atlas, const char *fileName)
+{
+    FILE *file = fopen(fileName, "wb");
+    if (file == NULL) return false;
+
+    TextFileHeader header = {
+        { 'S', 'D', 'F', ' ' }, TEXT_FILE_VERSION, TEXT_SDF_BASE_SIZE, TEXT_SDF_PADDING,
+        glyphCount, atlas.width, atlas.height, atlas.format
+    };
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    for (int i = 0; ok && i < glyphCount; i++)
+    {
+        TextFileGlyph glyph = { glyphs[i].value, glyphs[i].offsetX, glyphs[i].offsetY, glyphs[i].advanceX, recs[i] };
+        ok = fwrite(&glyph, sizeof(glyph), 1, file) == 1;
+    }
+    int size = GetPixelDataSize(atlas.width, atlas.height, atlas.format);
+    ok = ok && fwrite(atlas.data, size, 1, file) == 1;
+    fclose(file);
+
+    return ok;
+}
+
+// Glyph tables of a font read from the SDF file, glyph images are never loaded
+static size_t TextFontMemorySize(const Font *font)
+{
+    return (sizeof(Rectangle) + sizeof(GlyphInfo))*(size_t)font->glyphCount;
+}
+
+// Glyphs and the atlas image, the texture is left for TextUploadSdfFont()
+static bool TextDecodeSdfFont(Font *font, Image *image, const char *fileName)
+{
+    FILE *file = OpenAssetFile(fileName);
+    if (file == NULL) return false;
+
+    TextFileHeader header;
+    bool ok = fread(&header, sizeof(header), 1, file) == 1 && memcmp(header.magic, "SDF ", 4) == 0 &&
+              header.version == TEXT_FILE_VERSION && header.glyphCount > 0 && header.atlasWidth > 0 && header.atlasHeight > 0;
+
+    Font result = { 0 };
+    Image atlas = { 0 };
+    if (ok)
+    {
+        result.baseSize = header.baseSize;
+        result.glyphCount = header.glyphCount;
+        result.glyphPadding = header.glyphPadding;
+        result.recs = MemAlloc(sizeof(Rectangle)*header.glyphCount);
+        result.glyphs = MemAlloc(sizeof(GlyphInfo)*header.glyphCount);
+    }
+    for (int i = 0; ok && i < header.glyphCount; i++)
+    {
+        TextFileGlyph glyph;
+        ok = fread(&glyph, sizeof(glyph), 1, file) == 1;
+        result.recs[i] = glyph.rec;
+        result.glyphs[i] = (GlyphInfo){ glyph.value, glyph.offsetX, glyph.offsetY, glyph.advanceX, { 0 } };
+    }
+    if (ok)
+    {
+        int size = GetPixelDataSize(header.atlasWidth, header.atlasHeight, header.atlasFormat);
+        atlas = (Image){ MemAlloc(size), header.atlasWidth, header.atlasHeight, 1, header.atlasFormat };
+        ok = size > 0 && fread(atlas.data, size, 1, file) == 1;
+    }
+    fclose(file);
+
+    if (!ok)
+    {
+        MemFree(result.recs);
+        MemFree(result.glyphs);
+        UnloadImage(atlas);
+        return false;
+    }
+
+    // UnloadFont() frees the tables, UploadTextRenderer() the atlas image
+    MemChargeTagged(MEM_TAG_UI, TextFontMemorySize(&result));
+    MemChargeTagged(MEM_TAG_UI, GetImageMemorySize(atlas));
+    *font = result;
+    *image = atlas;
+    return true;
+}
+
+TextRenderer LoadTextRenderer(const char *fileName)
+{
+    TextRenderer text = DecodeTextRenderer(fileName);
+    UploadTextRenderer(&text);
+    return text;
+}
+
+TextRenderer DecodeTextRenderer(const char *fileName)
+{
+    TextRenderer text = { 0 };
+    text.sdf = TextDecodeSdfFont(&text.font, &text.atlas, fileName);
+    if (!text.sdf) TraceLog(LOG_WARNING, "TEXT: %s missing, run make font; using the default font", fileName);
+    return text;
+}
+
+void UploadTextRenderer(TextRenderer *text)
+{
+    if (text->sdf)
+    {
+        text->font.texture = LoadTextureFromImage(text->atlas);
+        SetTextureFilter(text->font.texture, TEXTURE_FILTER_BILINEAR);
+        MemReleaseTagged(MEM_TAG_UI, GetImageMemorySize(text->atlas));
+        UnloadImage(text->atlas);
+        text->atlas = (Image){ 0 };
+        text->shader = LoadShaderFromMemory(NULL, sdfFragmentShader);
+    }
+    else text->font = GetFontDefault();
+}
+
+void UnloadTextRenderer(TextRenderer *text)
+{
+    if (text->sdf)
+    {
+        UnloadShader(text->shader);
+        MemReleaseTagged(MEM_TAG_UI, TextFontMemorySize(&text->font));
+        UnloadFont(text->font);
+    }
+    *text = (TextRenderer){ 0 };
+}
+
+void BeginText(const TextRenderer *text)
+{
+    if (text->sdf) BeginShaderMode(text->shader);
+}
+
+void EndText(void)
+{
+    EndShaderMode();
+}
+
+void DrawTextSdf(const TextRenderer *text, const char *string, int posX, int posY, int fontSize, Color color)
+{
+    // same spacing DrawText() uses with the default font
+    if (fontSize < 10) fontSize = 10;
+    DrawTextEx(text->font, string, (Vector2){ (float)posX, (float)posY }, (float)fontSize, (float)(fontSize/10), color);
+}
+
+int MeasureTextSdf(const TextRenderer *text, const char *string, int fontSize)
+{
+    if (fontSize < 10) fontSize = 10;
+    return (int)MeasureTextEx(text->font, string, (float)fontSize, (float)(fontSize/10)).x;
+}
@@ -0,0 +1,42 @@
+#ifndef TEXT_H
+#define TEXT_H
+
+#include "raylib.h"
+#include <stdbool.h>
+
+// Text through a signed distance field glyph atlas baked from the bundled
+// JetBrainsMono TTF at build time (make font), so startup never rasterizes
+// the TTF and one texture serves every size. All text between BeginText()
+// and EndText() shares the atlas and the SDF shader and ends up in a single
+// rlgl batch.
+// Without a baked file it falls back to raylib's default bitmap font.
+
+#define TEXT_SDF_BASE_SIZE 48
+#define TEXT_SDF_PADDING 4
+#define TEXT_FILE_VERSION 1
+
+typedef struct {
+    Font font;
+    Shader shader;
+    Image atlas;            // between DecodeTextRenderer() and UploadTextRenderer()
+    bool sdf;               // false when running on the default font fallback
+} TextRenderer;
+
+TextRenderer LoadTextRenderer(const char *fileName);
+// LoadTextRenderer() in two steps: the file is read anywhere (a worker at
+// startup), the atlas and shader go to the GPU on the raylib thread
+TextRenderer DecodeTextRenderer(const char *fileName);
+void UploadTextRenderer(TextRenderer *text);
+void UnloadTextRenderer(TextRenderer *text);
+
+// Writes glyph metrics and the atlas of an SDF font, used by tools/font_bake.c
+bool SaveSdfFont(const GlyphInfo *glyphs, const Rectangle *recs, int glyphCount, Image atlas, const char *fileName);
+
+void BeginText(const TextRenderer *text);
+void EndText(void);
+
+// Drop-in for DrawText(), same spacing rule
+void DrawTextSdf(const TextRenderer *text, const char *string, int posX, int posY, int fontSize, Color color);
+int MeasureTextSdf(const TextRenderer *text, const char *string, int fontSize);
+
+#endif
@@ -0,0 +1,55 @@
+// Build time sprite atlas packer, see src/atlas.h
+// Usage: atlas_pack out.atlas sprite.png [sprite.png ...]
+#include "atlas.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        printf("usage: %s out.atlas sprite.png [sprite.png ...]\n", argv[0]);
+        return 1;
+    }
+
+    int32_t count = argc - 2;
+    Image *images = calloc(count, sizeof(Image));
+    char (*names)[ATLAS_NAME_LENGTH] = calloc(count, ATLAS_NAME_LENGTH);
+    const char **namePointers = calloc(count, sizeof(char *));
+
+    for (int32_t i = 0; i < count; i++)
+    {
+        images[i] = LoadImage(argv[i + 2]);
+        if (!IsImageReady(images[i]))
+        {
+            printf("atlas_pack: cannot load %s\n", argv[i + 2]);
+            return 1;
+        }
+        // sprites are looked up by file name without extension
+        strncpy(names[i], GetFileNameWithoutExt(argv[i + 2]), ATLAS_NAME_LENGTH - 1);
+        namePointers[i] = names[i];
+    }
+
+    SpriteAtlas atlas = BuildSpriteAtlas(images, namePointers, count);
+    if (!IsSpriteAtlasReady(&atlas))
+    {
+        printf("atlas_pack: sprites do not fit in %d pages of %dx%d\n", ATLAS_MAX_PAGES, ATLAS_PAGE_SIZE, ATLAS_PAGE_SIZE);
+        return 1;
+    }
+
+    for (int32_t i = 0; i < atlas.spriteCount; i++)
+    {
+        const AtlasSprite *s = &atlas.sprites[i];
+        printf("%-24s page %d  %4.0f,%4.0f  %4.0fx%-4.0f\n", s->name, s->page, s->source.x, s->source.y, s->source.width, s->source.height);
+    }
+    bool saved = SaveSpriteAtlas(&atlas, argv[1]);
+    printf("%s: %d sprites, %d pages, %d mip levels\n", argv[1], atlas.spriteCount, atlas.pageCount, ATLAS_MIP_LEVELS);
+
+    UnloadSpriteAtlas(&atlas);
+    for (int32_t i = 0; i < count; i++) UnloadImage(images[i]);
+    free(namePointers);
+    free(names);
+    free(images);
+    return saved ? 0 : 1;
+}
@@ -0,0 +1,552 @@
+// Headless benchmark scenarios over the GL free parts of src, no window needed.
+// Each scenario does a fixed batch of work per sample. The samples are
+// summarized as median, median absolute deviation and minimum, printed and
+// written as JSON together with the machine they ran on, so results can be
+// tracked over time. The level is ye.png when it is there and a generated map
+// otherwise; the asset load scenarios only run for the baked files present.
+// Usage: bench [--samples N] [--entities N] [--threads N] [--filter name] [--out results.json]
+#include "atlas.h"
+#include "decals.h"
+#include "grid.h"
+#include "jobs.h"
+#include "levelfile.h"
+#include "levelmesh.h"
+#include "lod.h"
+#include "memtrack.h"
+#include "particles.h"
+#include "pvs.h"
+#include "raylib.h"
+#include "raymath.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if !defined(_WIN32)
+#include <sys/utsname.h>
+#endif
+
+#define BENCH_MAX_SAMPLES 256
+#define BENCH_WARMUP 2
+#define BENCH_RAYS 4096
+#define BENCH_BOXES 15              // the columns and the three walls fire_weapon() tests
+#define BENCH_DECALS 16384
+#define BENCH_INSTANCES 10000
+#define BENCH_VIEWS 64
+#define BENCH_TICKS 60
+
+typedef struct {
+    // shared
+    OccupancyGrid grid;
+    PVS pvs;
+    const char *mapName;
+    int32_t entities;
+    uint32_t random;
+    int32_t sink;                   // results land here so nothing is optimized away
+
+    // per scenario
+    ParticleSystem particles;
+    Ray rays[BENCH_RAYS];
+    BoundingBox boxes[BENCH_BOXES];
+    DecalManager *decals;
+    Vector3 decalPositions[BENCH_DECALS];
+    LodModel lod;
+    LodInstances instances;
+    Camera views[BENCH_VIEWS];
+} Bench;
+
+typedef struct {
+    const char *name;
+    const char *unit;               // what one of the iterations in a sample is
+    int32_t iterations;
+    const char *file;               // needed on disk, NULL for none
+    bool (*setup)(Bench *bench);
+    void (*run)(Bench *bench);
+    void (*teardown)(Bench *bench);
+} BenchScenario;
+
+typedef struct {
+    double median;                  // milliseconds per sample
+    double mad;
+    double min;
+} BenchStats;
+
+static double NowMs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec*1000.0 + ts.tv_nsec/1000000.0;
+}
+
+// xorshift, the same sequence on every platform so runs compare
+static uint32_t BenchRandom(Bench *bench)
+{
+    bench->random ^= bench->random << 13;
+    bench->random ^= bench->random >> 17;
+    bench->random ^= bench->random << 5;
+    return bench->random;
+}
+
+static float BenchRandomFloat(Bench *bench, float min, float max)
+{
+    return min + (max - min)*(BenchRandom(bench) >> 8)/16777216.0f;
+}
+
+// centre of a random open cell, in the map's model space like the level drawn at the origin
+static Vector3 BenchOpenCell(Bench *bench, float y)
+{
+    for (int attempt = 0; attempt < 1000; attempt++)
+    {
+        int32_t x = (int32_t)(BenchRandom(bench)%(uint32_t)bench->grid.width);
+        int32_t z = (int32_t)(BenchRandom(bench)%(uint32_t)bench->grid.height);
+        if (!GridIsSolid(&bench->grid, x, z)) return (Vector3){ (float)x, y, (float)z };
+    }
+    return (Vector3){ bench->grid.width/2.0f, y, bench->grid.height/2.0f };
+}
+
+// rooms and corridors, walls around the edge and a pillar in every few cells
+static OccupancyGrid BenchGenerateMap(int32_t size)
+{
+    Color *pixels = malloc(sizeof(Color)*size*size);
+    for (int32_t z = 0; z < size; z++)
+    {
+        for (int32_t x = 0; x < size; x++)
+        {
+            bool edge = (x == 0 || z == 0 || x == size - 1 || z == size - 1);
+            bool wall = ((x%24 == 0) && (z%24 > 4)) || ((z%24 == 0) && (x%24 > 4));
+            bool pillar = (x%6 == 3) && (z%6 == 3);
+            pixels[z*size + x] = (edge || wall || pillar) ? WHITE : BLACK;
+        }
+    }
+    OccupancyGrid grid = LoadOccupancyGrid(pixels, size, size);
+    free(pixels);
+    return grid;
+}
+
+static bool LoadBenchLevel(Bench *bench)
+{
+    Image map = LoadImage("ye.png");
+    if (IsImageReady(map))
+    {
+        ImageFlipVertical(&map);
+        Color *pixels = LoadImageColors(map);
+        bench->grid = LoadOccupancyGrid(pixels, map.width, map.height);
+        UnloadImageColors(pixels);
+        UnloadImage(map);
+        bench->mapName = "ye.png";
+        // same freshness rule as the game
+        if (GetFileModTime("ye.pvs") >= GetFileModTime("ye.png")) bench->pvs = LoadPVS("ye.pvs");
+        if (IsPVSReady(&bench->pvs) && !PVSMatchesGrid(&bench->pvs, &bench->grid)) UnloadPVS(&bench->pvs);
+    }
+    else
+    {
+        bench->grid = BenchGenerateMap(400);
+        bench->mapName = "generated";
+    }
+    if (bench->grid.solid == NULL) return false;
+    if (!IsPVSReady(&bench->pvs)) bench->pvs = BakePVS(&bench->grid);
+    return IsPVSReady(&bench->pvs);
+}
+
+//----------------------------------------------------------------------------------
+// Simulation ticks, the particle system standing in for N entities
+//----------------------------------------------------------------------------------
+static bool SetupSimTicks(Bench *bench)
+{
+    bench->particles = LoadParticleSystem(bench->entities);
+    int32_t emitters = 8;
+    for (int32_t i = 0; i < emitters; i++)
+    {
+        AddParticleEmitter(&bench->particles, (ParticleEmitterDesc){
+            .speedMin = 1.0f, .speedMax = 5.0f, .spread = 1.0f,
+            .lifetimeMin = 1.0f, .lifetimeMax = 4.0f,
+            .sizeStart = 0.1f, .sizeEnd = 0.0f, .gravity = 9.8f, .drag = 0.5f,
+            .colorStart = { 255, 255, 255, 255 }, .colorEnd = { 255, 255, 255, 0 }
+        }, bench->entities/emitters);
+        EmitParticles(&bench->particles, i, (Vector3){ 0 }, (Vector3){ 0, 1, 0 }, bench->entities/emitters);
+    }
+    return bench->particles.capacity > 0;
+}
+
+static void RunSimTicks(Bench *bench)
+{
+    int32_t emitters = bench->particles.emitterCount;
+    for (int32_t t = 0; t < BENCH_TICKS; t++)
+    {
+        // enough respawns per tick to keep the pool full while lifetimes run out
+        for (int32_t i = 0; i < emitters; i++)
+        {
+            EmitParticles(&bench->particles, i, (Vector3){ 0 }, (Vector3){ 0, 1, 0 }, bench->entities/emitters/BENCH_TICKS);
+        }
+        UpdateParticleSystem(&bench->particles, 1.0f/BENCH_TICKS);
+    }
+    bench->sink += GetParticleCount(&bench->particles);
+}
+
+static void TeardownSimTicks(Bench *bench)
+{
+    UnloadParticleSystem(&bench->particles);
+}
+
+//----------------------------------------------------------------------------------
+// Hitscan, fire_weapon()'s ray against the floor, the boxes and the level's walls
+//----------------------------------------------------------------------------------
+static bool SetupHitscan(Bench *bench)
+{
+    for (int32_t i = 0; i < BENCH_RAYS; i++)
+    {
+        float yaw = BenchRandomFloat(bench, 0.0f, 2.0f*PI);
+        float pitch = BenchRandomFloat(bench, -0.4f, 0.2f);
+        Vector3 direction = { cosf(yaw)*cosf(pitch), sinf(pitch), sinf(yaw)*cosf(pitch) };
+        bench->rays[i] = (Ray){ BenchOpenCell(bench, 1.5f), direction };
+    }
+    bench->boxes[0] = (BoundingBox){ { -16.5f, 0.0f, -16.0f }, { -15.5f, 5.0f, 16.0f } };
+    bench->boxes[1] = (BoundingBox){ { 15.5f, 0.0f, -16.0f }, { 16.5f, 5.0f, 16.0f } };
+    bench->boxes[2] = (BoundingBox){ { -16.0f, 0.0f, 15.5f }, { 16.0f, 5.0f, 16.5f } };
+    for (int32_t i = 3; i < BENCH_BOXES; i++)
+    {
+        // the columns, moved under the rays
+        Vector3 cell = BenchOpenCell(bench, 0.0f);
+        float height = BenchRandomFloat(bench, 1.0f, 12.0f);
+        bench->boxes[i] = (BoundingBox){ { cell.x - 1.0f, 0.0f, cell.z - 1.0f }, { cell.x + 1.0f, height, cell.z + 1.0f } };
+    }
+    return true;
+}
+
+static void RunHitscan(Bench *bench)
+{
+    int32_t hits = 0;
+    for (int32_t i = 0; i < BENCH_RAYS; i++)
+    {
+        Ray ray = bench->rays[i];
+        RayCollision hit = { .hit = false, .distance = 100.0f };
+        if (ray.direction.y < 0.0f)
+        {
+            hit.distance = -ray.position.y/ray.direction.y;
+            hit.hit = true;
+        }
+        for (int32_t b = 0; b < BENCH_BOXES; b++)
+        {
+            RayCollision boxHit = GetRayCollisionBox(ray, bench->boxes[b]);
+            if (boxHit.hit && boxHit.distance < hit.distance) hit = boxHit;
+        }
+        // the walls of the level are cells, not boxes
+        RayCollision wallHit = GridRaycast(&bench->grid, (Vector3){ 0.0f, 0.0f, 0.0f }, ray, hit.distance);
+        if (wallHit.hit) hit = wallHit;
+        hits += hit.hit;
+    }
+    bench->sink += hits;
+}
+
+//----------------------------------------------------------------------------------
+// Broadphase churn, decals binned into and unlinked from the chunk grid
+//----------------------------------------------------------------------------------
+static bool SetupBroadphase(Bench *bench)
+{
+    // LoadDecalManager() also creates a GL material, the bins are all that is timed here
+    DecalManager *decals = MemCallocTagged(MEM_TAG_RENDER, 1, sizeof(DecalManager));
+    decals->chunksX = (bench->grid.width + PVS_CLUSTER_SIZE - 1)/PVS_CLUSTER_SIZE;
+    decals->chunksZ = (bench->grid.height + PVS_CLUSTER_SIZE - 1)/PVS_CLUSTER_SIZE;
+    decals->chunkHeads = MemAllocTagged(MEM_TAG_RENDER, sizeof(int32_t)*decals->chunksX*decals->chunksZ);
+    for (int32_t i = 0; i < decals->chunksX*decals->chunksZ; i++) decals->chunkHeads[i] = -1;
+    for (int32_t i = 0; i < DECAL_CAPACITY; i++) decals->decals[i].page = -1;
+    decals->pageCount = 1;
+    decals->cameraChunk = -1;
+    bench->decals = decals;
+
+    for (int32_t i = 0; i < BENCH_DECALS; i++) bench->decalPositions[i] = BenchOpenCell(bench, BenchRandomFloat(bench, 0.0f, 2.0f));
+    return true;
+}
+
+static void RunBroadphase(Bench *bench)
+{
+    for (int32_t i = 0; i < BENCH_DECALS; i++)
+    {
+        AddDecal(bench->decals, 0, (Rectangle){ 0.0f, 0.0f, 0.5f, 1.0f }, bench->decalPositions[i], (Vector3){ 0.0f, 1.0f, 0.0f },
+                 0.15f, 0.0f, WHITE);
+    }
+    bench->sink += bench->decals->count;
+}
+
+static void TeardownBroadphase(Bench *bench)
+{
+    MemFreeTagged(bench->decals->chunkHeads);
+    MemFreeTagged(bench->decals);
+    bench->decals = NULL;
+}
+
+//----------------------------------------------------------------------------------
+// Culling, render_3d()'s PVS test per instance followed by LOD selection
+//----------------------------------------------------------------------------------
+static bool SetupCulling(Bench *bench)
+{
+    bench->instances = LoadLodInstances(BENCH_INSTANCES);
+    for (int32_t i = 0; i < BENCH_INSTANCES; i++) AddLodInstance(&bench->instances, BenchOpenCell(bench, 1.0f), 1.0f);
+    bench->lod = (LodModel){ .levelCount = LOD_MAX_LEVELS, .radius = 1.0f, .screenSizes = { 0.0f, 240.0f, 90.0f, 30.0f } };
+    for (int32_t i = 0; i < BENCH_VIEWS; i++)
+    {
+        Vector3 position = BenchOpenCell(bench, 2.0f);
+        bench->views[i] = (Camera){ position, Vector3Add(position, (Vector3){ 1.0f, 0.0f, 0.0f }), { 0.0f, 1.0f, 0.0f }, 90.0f, CAMERA_PERSPECTIVE };
+    }
+    return bench->instances.count == BENCH_INSTANCES;
+}
+
+static void RunCulling(Bench *bench)
+{
+    LodInstances *instances = &bench->instances;
+    for (int32_t v = 0; v < BENCH_VIEWS; v++)
+    {
+        const Camera *view = &bench->views[v];
+        int32_t fromX = (int32_t)(view->position.x + 0.5f), fromZ = (int32_t)(view->position.z + 0.5f);
+        instances->visibleCount = 0;
+        for (int32_t i = 0; i < instances->count; i++)
+        {
+            int32_t toX = (int32_t)(instances->x[i] + 0.5f), toZ = (int32_t)(instances->z[i] + 0.5f);
+            if (PVSCellVisible(&bench->pvs, fromX, fromZ, toX, toZ)) instances->visible[instances->visibleCount++] = i;
+        }
+        SelectLodLevels(&bench->lod, instances, *view, 1080);
+        bench->sink += instances->visibleCount;
+    }
+}
+
+static void TeardownCulling(Bench *bench)
+{
+    UnloadLodInstances(&bench->instances);
+}
+
+//----------------------------------------------------------------------------------
+// Level meshing, what --bake-level and the ye.png path do before upload
+//----------------------------------------------------------------------------------
+static void RunLevelMeshing(Bench *bench)
+{
+    LevelMesh mesh = GenLevelMesh(&bench->grid);
+    PackLevelMesh(&mesh);
+    bench->sink += mesh.chunkCount;
+    UnloadLevelMesh(&mesh);
+}
+
+//----------------------------------------------------------------------------------
+// Asset loads, warm file cache, decoding only (no upload)
+//----------------------------------------------------------------------------------
+static void RunLoadLevelFile(Bench *bench)
+{
+    LevelFile file = LoadLevelFile("ye.lvl");
+    OccupancyGrid grid = GetLevelFileGrid(&file);
+    PVS pvs = GetLevelFilePVS(&file);
+    LevelMesh mesh = GetLevelFileMesh(&file);
+    // touch every page, a mapped file costs nothing until it is read
+    for (int32_t i = 0; i < mesh.chunkCount; i++) PageLevelFileChunk(&file, i, true);
+    bench->sink += grid.width + pvs.clusterCount + mesh.chunkCount;
+    UnloadLevelMesh(&mesh);
+    UnloadLevelFile(&file);
+}
+
+static void RunLoadAtlas(Bench *bench)
+{
+    SpriteAtlas atlas = LoadSpriteAtlas("sprites.atlas");
+    bench->sink += atlas.spriteCount;
+    UnloadSpriteAtlas(&atlas);
+}
+
+static void RunLoadLod(Bench *bench)
+{
+    LodModel lod = LoadLodModel("props.lod");
+    bench->sink += lod.levelCount;
+    UnloadLodModel(&lod);
+}
+
+static void RunDecodeMap(Bench *bench)
+{
+    Image map = LoadImage("ye.png");
+    Color *pixels = LoadImageColors(map);
+    OccupancyGrid grid = LoadOccupancyGrid(pixels, map.width, map.height);
+    bench->sink += grid.width;
+    UnloadOccupancyGrid(&grid);
+    UnloadImageColors(pixels);
+    UnloadImage(map);
+}
+
+static const BenchScenario scenarios[] = {
+    { "sim_ticks", "tick", BENCH_TICKS, NULL, SetupSimTicks, RunSimTicks, TeardownSimTicks },
+    { "hitscan", "ray", BENCH_RAYS, NULL, SetupHitscan, RunHitscan, NULL },
+    { "broadphase_churn", "insert", BENCH_DECALS, NULL, SetupBroadphase, RunBroadphase, TeardownBroadphase },
+    { "culling", "view", BENCH_VIEWS, NULL, SetupCulling, RunCulling, TeardownCulling },
+    { "level_meshing", "level", 1, NULL, NULL, RunLevelMeshing, NULL },
+    { "asset_load_level", "load", 1, "ye.lvl", NULL, RunLoadLevelFile, NULL },
+    { "asset_load_atlas", "load", 1, "sprites.atlas", NULL, RunLoadAtlas, NULL },
+    { "asset_load_lod", "load", 1, "props.lod", NULL, RunLoadLod, NULL },
+    { "asset_decode_map", "load", 1, "ye.png", NULL, RunDecodeMap, NULL },
+};
+
+static int CompareDoubles(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// sorts values
+static double BenchMedian(double *values, int32_t count)
+{
+    qsort(values, count, sizeof(double), CompareDoubles);
+    return (count%2 == 1) ? values[count/2] : (values[count/2 - 1] + values[count/2])*0.5;
+}
+
+static BenchStats BenchSummarize(const double *samples, int32_t count)
+{
+    double sorted[BENCH_MAX_SAMPLES], deviations[BENCH_MAX_SAMPLES];
+    memcpy(sorted, samples, sizeof(double)*count);
+    BenchStats stats = { .median = BenchMedian(sorted, count) };
+    stats.min = sorted[0];
+    for (int32_t i = 0; i < count; i++) deviations[i] = fabs(samples[i] - stats.median);
+    stats.mad = BenchMedian(deviations, count);
+    return stats;
+}
+
+static void WriteJsonString(FILE *file, const char *string)
+{
+    fputc('"', file);
+    for (const unsigned char *c = (const unsigned char *)string; *c != '\0'; c++)
+    {
+        if (*c == '"' || *c == '\\') fprintf(file, "\\%c", *c);
+        else if (*c < 0x20) fprintf(file, "\\u%04x", *c);
+        else fputc(*c, file);
+    }
+    fputc('"', file);
+}
+
+static void GetCpuName(char *name, size_t size)
+{
+    snprintf(name, size, "unknown");
+    FILE *file = fopen("/proc/cpuinfo", "r");
+    if (file == NULL) return;
+    char line[256];
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        char *value = strchr(line, ':');
+        if (strncmp(line, "model name", 10) != 0 || value == NULL) continue;
+        value += (value[1] == ' ') ? 2 : 1;
+        value[strcspn(value, "\n")] = '\0';
+        snprintf(name, size, "%s", value);
+        break;
+    }
+    fclose(file);
+}
+
+static void WriteMachineInfo(FILE *file, const Bench *bench, int32_t samples)
+{
+    char cpu[128], os[256] = "windows", timestamp[32];
+    GetCpuName(cpu, sizeof(cpu));
+#if !defined(_WIN32)
+    struct utsname name;
+    if (uname(&name) == 0) snprintf(os, sizeof(os), "%s %s %s", name.sysname, name.release, name.machine);
+#endif
+    time_t now = time(NULL);
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+
+    fprintf(file, "  \"timestamp\": \"%s\",\n  \"machine\": {\n    \"cpu\": ", timestamp);
+    WriteJsonString(file, cpu);
+    fprintf(file, ",\n    \"logical_cores\": %d,\n    \"threads\": %d,\n    \"os\": ", JobsCoreCount(), JobsWorkerCount() + 1);
+    WriteJsonString(file, os);
+#if defined(__VERSION__)
+    fprintf(file, ",\n    \"compiler\": ");
+    WriteJsonString(file, __VERSION__);
+#endif
+    fprintf(file, "\n  },\n  \"config\": { \"samples\": %d, \"warmup\": %d, \"entities\": %d, \"map\": \"%s\", \"map_width\": %d, \"map_height\": %d },\n",
+            samples, BENCH_WARMUP, bench->entities, bench->mapName, bench->grid.width, bench->grid.height);
+}
+
+int main(int argc, char **argv)
+{
+    int32_t samples = 15;
+    int32_t threads = 0;
+    const char *filter = NULL;
+    const char *outName = "bench.json";
+    static Bench bench = { .entities = 100000, .random = 0x9e3779b9u };
+    for (int a = 1; a < argc; a++)
+    {
+        if (strcmp(argv[a], "--samples") == 0 && a + 1 < argc) samples = atoi(argv[++a]);
+        else if (strcmp(argv[a], "--entities") == 0 && a + 1 < argc) bench.entities = atoi(argv[++a]);
+        else if (strcmp(argv[a], "--threads") == 0 && a + 1 < argc) threads = atoi(argv[++a]);
+        else if (strcmp(argv[a], "--filter") == 0 && a + 1 < argc) filter = argv[++a];
+        else if (strcmp(argv[a], "--out") == 0 && a + 1 < argc) outName = argv[++a];
+        else
+        {
+            printf("usage: %s [--samples N] [--entities N] [--threads N] [--filter name] [--out results.json]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (samples < 1) samples = 1;
+    if (samples > BENCH_MAX_SAMPLES) samples = BENCH_MAX_SAMPLES;
+    if (bench.entities < 8) bench.entities = 8;
+
+    // the loaders log every call, only problems matter here
+    SetTraceLogLevel(LOG_WARNING);
+    JobsInit(threads);
+    if (!LoadBenchLevel(&bench))
+    {
+        printf("could not build a level to benchmark\n");
+        JobsShutdown();
+        return 1;
+    }
+
+    FILE *out = fopen(outName, "w");
+    if (out == NULL)
+    {
+        printf("could not write %s\n", outName);
+        UnloadPVS(&bench.pvs);
+        UnloadOccupancyGrid(&bench.grid);
+        JobsShutdown();
+        return 1;
+    }
+    fprintf(out, "{\n");
+    WriteMachineInfo(out, &bench, samples);
+    fprintf(out, "  \"results\": [");
+
+    printf("map %s %dx%d, %d threads, %d samples\n", bench.mapName, bench.grid.width, bench.grid.height, JobsWorkerCount() + 1, samples);
+    printf("%-18s %10s %10s %10s %14s\n", "scenario", "median ms", "mad ms", "min ms", "per iteration");
+    int32_t written = 0;
+    for (int32_t s = 0; s < (int32_t)(sizeof(scenarios)/sizeof(scenarios[0])); s++)
+    {
+        const BenchScenario *scenario = &scenarios[s];
+        if (filter != NULL && strstr(scenario->name, filter) == NULL) continue;
+        if (scenario->file != NULL && !FileExists(scenario->file))
+        {
+            printf("%-18s skipped, no %s\n", scenario->name, scenario->file);
+            continue;
+        }
+        if (scenario->setup != NULL && !scenario->setup(&bench))
+        {
+            printf("%-18s setup failed\n", scenario->name);
+            if (scenario->teardown != NULL) scenario->teardown(&bench);
+            continue;
+        }
+
+        double times[BENCH_MAX_SAMPLES];
+        for (int32_t i = 0; i < BENCH_WARMUP; i++) scenario->run(&bench);
+        for (int32_t i = 0; i < samples; i++)
+        {
+            double start = NowMs();
+            scenario->run(&bench);
+            times[i] = NowMs() - start;
+        }
+        if (scenario->teardown != NULL) scenario->teardown(&bench);
+
+        BenchStats stats = BenchSummarize(times, samples);
+        double perIteration = stats.median*1000.0/scenario->iterations;
+        printf("%-18s %10.3f %10.3f %10.3f %9.3f us/%s\n", scenario->name, stats.median, stats.mad, stats.min, perIteration, scenario->unit);
+
+        fprintf(out, "%s\n    { \"name\": \"%s\", \"unit\": \"%s\", \"iterations\": %d, \"median_ms\": %.6f, \"mad_ms\": %.6f, \"min_ms\": %.6f, "
+                "\"median_us_per_%s\": %.6f, \"samples_ms\": [", (written > 0) ? "," : "", scenario->name, scenario->unit, scenario->iterations,
+                stats.median, stats.mad, stats.min, scenario->unit, perIteration);
+        for (int32_t i = 0; i < samples; i++) fprintf(out, "%s%.6f", (i > 0) ? ", " : "", times[i]);
+        fprintf(out, "] }");
+        written++;
+    }
+    fprintf(out, "\n  ]\n}\n");
+    bool ok = fclose(out) == 0;
+    printf("%s %s\n", ok ? "wrote" : "could not write", outName);
+
+    UnloadPVS(&bench.pvs);
+    UnloadOccupancyGrid(&bench.grid);
+    JobsShutdown();
+    return ok ? 0 : 1;
+}
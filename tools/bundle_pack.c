@@ -0,0 +1,33 @@
+// Build time asset bundle packer, see src/bundle.h
+// Usage: bundle_pack out.bundle file [file ...]
+#include "bundle.h"
+#include "raylib.h"
+#include <stdio.h>
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        printf("usage: %s out.bundle file [file ...]\n", argv[0]);
+        return 1;
+    }
+
+    SetTraceLogLevel(LOG_WARNING);
+    int32_t count = argc - 2;
+    bool saved = SaveBundle(argv[1], (const char **)(argv + 2), count);
+    if (!saved)
+    {
+        printf("bundle_pack: could not write %s\n", argv[1]);
+        return 1;
+    }
+
+    long total = 0;
+    for (int32_t i = 0; i < count; i++)
+    {
+        int size = GetFileLength(argv[i + 2]);
+        printf("%-24s %9d bytes\n", GetFileName(argv[i + 2]), size);
+        total += size;
+    }
+    printf("%s: %d files, %ld bytes, %d bytes on disk\n", argv[1], count, total, GetFileLength(argv[1]));
+    return 0;
+}
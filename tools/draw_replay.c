@@ -0,0 +1,240 @@
+// Replays a draw stream captured by src/rlstats.c without a GPU, to benchmark
+// render submission and catch rendering regressions on machines with no GL.
+// Backends:
+//   null  the CPU side of rlgl (matrix stack, vertex transform, batch arrays,
+//         draw grouping, buffer upload copy), nothing is drawn
+//   soft  the tiled multithreaded rasterizer in src/softrender.c, vertex array
+//         draws included when the capture tracked resources; after the
+//         timed runs one more pass prints a hash per frame and, with --dump,
+//         writes every frame as <prefix>NNN.png for golden image comparison
+// Usage: draw_replay capture.drw [iterations] [--backend null|soft] [--threads N] [--dump prefix]
+#include "drawstream.h"
+#include "jobs.h"
+#include "softrender.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct {
+    float vertices[DRAW_STREAM_BATCH_VERTICES*3];
+    float texcoords[DRAW_STREAM_BATCH_VERTICES*2];
+    float normals[DRAW_STREAM_BATCH_VERTICES*3];
+    uint8_t colors[DRAW_STREAM_BATCH_VERTICES*4];
+    float upload[DRAW_STREAM_BATCH_VERTICES*12];    // stands in for the GL buffers
+    int32_t vertexCount;
+
+    float texcoord[2];
+    float normal[3];
+    uint8_t color[4];
+} NullBackend;
+
+typedef struct {
+    DrawStreamState state;
+    DrawStreamTracker tracker;
+    NullBackend *null;              // exactly one of the backends is set
+    SoftRenderer *soft;
+    const char *dumpPrefix;         // soft only, NULL to skip writing frames
+    bool printHashes;
+} Replay;
+
+static double NowMs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec*1000.0 + ts.tv_nsec/1000000.0;
+}
+
+static void NullFlush(NullBackend *nb)
+{
+    // what rlDrawRenderBatch() hands to glBufferSubData()
+    int32_t n = nb->vertexCount;
+    memcpy(nb->upload, nb->vertices, sizeof(float)*3*n);
+    memcpy(nb->upload + 3*n, nb->texcoords, sizeof(float)*2*n);
+    memcpy(nb->upload + 5*n, nb->normals, sizeof(float)*3*n);
+    memcpy(nb->upload + 8*n, nb->colors, sizeof(uint8_t)*4*n);
+    nb->vertexCount = 0;
+}
+
+static void NullVertex(NullBackend *nb, const DrawStreamState *state, float x, float y, float z)
+{
+    if (nb->vertexCount >= DRAW_STREAM_BATCH_VERTICES) NullFlush(nb);
+
+    Vector3 p = DrawStateVertex(state, x, y, z);
+    int32_t i = nb->vertexCount++;
+    nb->vertices[i*3] = p.x;
+    nb->vertices[i*3 + 1] = p.y;
+    nb->vertices[i*3 + 2] = p.z;
+    memcpy(&nb->texcoords[i*2], nb->texcoord, sizeof(nb->texcoord));
+    memcpy(&nb->normals[i*3], nb->normal, sizeof(nb->normal));
+    memcpy(&nb->colors[i*4], nb->color, sizeof(nb->color));
+}
+
+static void ReplayEndFrame(Replay *replay, int32_t frame)
+{
+    if (replay->soft == NULL) return;
+
+    const SoftTarget *screen = GetSoftTarget(replay->soft, 0);
+    if (replay->printHashes) printf("frame %03d: %016llx\n", frame, (unsigned long long)GetSoftTargetHash(screen));
+    if (replay->dumpPrefix != NULL)
+    {
+        char fileName[512];
+        snprintf(fileName, sizeof(fileName), "%s%03d.png", replay->dumpPrefix, frame);
+        if (!ExportSoftTarget(screen, fileName)) printf("draw_replay: cannot write %s\n", fileName);
+    }
+}
+
+// Null backend: what rlgl does on the CPU with the immediate mode ops
+static void NullApplyOp(NullBackend *nb, const DrawStreamState *state, DrawOp op, const uint8_t *payload)
+{
+    float f[3];
+    switch (op)
+    {
+        case DRAW_OP_FLUSH: NullFlush(nb); break;
+        case DRAW_OP_VERTEX2: memcpy(f, payload, 8); NullVertex(nb, state, f[0], f[1], 0.0f); break;
+        case DRAW_OP_VERTEX3: memcpy(f, payload, 12); NullVertex(nb, state, f[0], f[1], f[2]); break;
+        case DRAW_OP_TEXCOORD: memcpy(nb->texcoord, payload, 8); break;
+        case DRAW_OP_NORMAL: memcpy(nb->normal, payload, 12); break;
+        case DRAW_OP_COLOR: memcpy(nb->color, payload, 4); break;
+        default: break;
+    }
+}
+
+static int32_t ReplayFrames(Replay *replay, const DrawStreamBuffer *stream)
+{
+    int32_t frames = 0;
+    size_t at = 0;
+
+    while (at < stream->size)
+    {
+        const uint8_t *data = stream->data + at;
+        const uint8_t *payload = data + 1;
+        DrawOp op = data[0];
+        int32_t i[3];
+        uint32_t id;
+        at += GetDrawOpSize(data);
+
+        // the tracker counts batches and draws the same way for either backend
+        switch (op)
+        {
+            case DRAW_OP_FLUSH: DrawTrackFlush(&replay->tracker); break;
+            case DRAW_OP_BEGIN: memcpy(i, payload, 4); DrawTrackBegin(&replay->tracker, i[0]); break;
+            case DRAW_OP_VERTEX2:
+            case DRAW_OP_VERTEX3:
+            {
+                // the tracker flushes at the same vertex rlgl (and both backends) do
+                if (replay->tracker.pendingVertices >= DRAW_STREAM_BATCH_VERTICES) DrawTrackFlush(&replay->tracker);
+                DrawTrackVertex(&replay->tracker);
+            } break;
+            case DRAW_OP_SET_TEXTURE: memcpy(&id, payload, 4); DrawTrackSetTexture(&replay->tracker, id); break;
+            case DRAW_OP_ENABLE_TEXTURE: DrawTrackEnableTexture(&replay->tracker); break;
+            case DRAW_OP_DRAW_ARRAYS:
+            case DRAW_OP_DRAW_ELEMENTS: memcpy(i, payload, 12); DrawTrackVertexArray(&replay->tracker, i[1], i[2]); break;
+            default: break;
+        }
+
+        ApplyDrawStateOp(&replay->state, op, payload);
+        if (op == DRAW_OP_FRAME) ReplayEndFrame(replay, frames++);
+        else if (replay->null != NULL) NullApplyOp(replay->null, &replay->state, op, payload);
+        else SoftApplyOp(replay->soft, data);
+    }
+
+    return frames;
+}
+
+static int CompareDouble(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Fresh backend and rlgl state for one pass over the stream
+static void ResetReplay(Replay *replay)
+{
+    // captures start with a STATE op that sets the real screen size
+    ResetDrawState(&replay->state, 1, 1);
+    memset(&replay->tracker, 0, sizeof(replay->tracker));
+    if (replay->null != NULL) replay->null->vertexCount = 0;
+    if (replay->soft != NULL)
+    {
+        UnloadSoftRenderer(replay->soft);
+        *replay->soft = LoadSoftRenderer(&replay->state);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *fileName = NULL, *backend = "null", *dumpPrefix = NULL;
+    int iterations = 100, threads = 0;
+    for (int a = 1; a < argc; a++)
+    {
+        if (strcmp(argv[a], "--backend") == 0 && a + 1 < argc) backend = argv[++a];
+        else if (strcmp(argv[a], "--threads") == 0 && a + 1 < argc) threads = atoi(argv[++a]);
+        else if (strcmp(argv[a], "--dump") == 0 && a + 1 < argc) dumpPrefix = argv[++a];
+        else if (fileName == NULL) fileName = argv[a];
+        else iterations = atoi(argv[a]);
+    }
+    bool soft = strcmp(backend, "soft") == 0;
+    if (fileName == NULL || (!soft && strcmp(backend, "null") != 0))
+    {
+        printf("usage: %s capture.drw [iterations] [--backend null|soft] [--threads N] [--dump prefix]\n", argv[0]);
+        return 1;
+    }
+    if (iterations < 1) iterations = 1;
+
+    DrawStreamBuffer stream = LoadDrawStream(fileName);
+    if (stream.data == NULL)
+    {
+        printf("draw_replay: %s is not a draw capture (or an older version)\n", fileName);
+        return 1;
+    }
+
+    JobsInit(soft ? threads : 1);
+    Replay *replay = calloc(1, sizeof(Replay));
+    if (soft) replay->soft = calloc(1, sizeof(SoftRenderer));
+    else replay->null = calloc(1, sizeof(NullBackend));
+    double *times = malloc(sizeof(double)*iterations);
+    DrawStats stats = { 0 };
+    int32_t frames = 0;
+
+    for (int it = 0; it < iterations; it++)
+    {
+        ResetReplay(replay);
+        double start = NowMs();
+        frames = ReplayFrames(replay, &stream);
+        times[it] = NowMs() - start;
+        stats = replay->tracker.stats;
+    }
+    qsort(times, iterations, sizeof(double), CompareDouble);
+
+    if (frames < 1) frames = 1;
+    printf("%s: %d frames, %zu bytes, %s backend, %d worker threads\n", fileName, stream.frameCount, stream.size, backend, JobsWorkerCount());
+    printf("per frame: %.1f batches, %.1f draw calls, %.0f vertices, %.1f texture binds, %.1f mesh draws\n",
+           (double)stats.batches/frames, (double)stats.drawCalls/frames, (double)stats.vertices/frames,
+           (double)stats.textureBinds/frames, (double)stats.meshDraws/frames);
+    if (soft)
+    {
+        SoftStats s = replay->soft->stats;
+        printf("rasterized per frame: %.0f triangles, %.0f culled, %.1f mesh draws, %.1f draws skipped (lines, unknown resources)\n",
+               (double)s.triangles/frames, (double)s.culled/frames, (double)s.meshDraws/frames, (double)s.skippedDraws/frames);
+    }
+    printf("iterations: %d, median %.4f ms/frame, min %.4f ms/frame\n", iterations, times[iterations/2]/frames, times[0]/frames);
+
+    if (soft)
+    {
+        // untimed pass for the golden image checks
+        ResetReplay(replay);
+        replay->printHashes = true;
+        replay->dumpPrefix = dumpPrefix;
+        ReplayFrames(replay, &stream);
+        UnloadSoftRenderer(replay->soft);
+    }
+
+    free(times);
+    free(replay->soft);
+    free(replay->null);
+    free(replay);
+    UnloadDrawStream(&stream);
+    JobsShutdown();
+    return 0;
+}
@@ -0,0 +1,41 @@
+// Build time SDF font baker, see src/text.h
+// Usage: font_bake out.sdf font.ttf
+#include "text.h"
+#include <stdio.h>
+
+int main(int argc, char **argv)
+{
+    if (argc != 3)
+    {
+        printf("usage: %s out.sdf font.ttf\n", argv[0]);
+        return 1;
+    }
+
+    int dataSize = 0;
+    unsigned char *data = LoadFileData(argv[2], &dataSize);
+    if (data == NULL)
+    {
+        printf("font_bake: cannot load %s\n", argv[2]);
+        return 1;
+    }
+
+    // printable ASCII, everything the console and HUD can show
+    int glyphCount = 95;
+    GlyphInfo *glyphs = LoadFontData(data, dataSize, TEXT_SDF_BASE_SIZE, NULL, glyphCount, FONT_SDF);
+    UnloadFileData(data);
+    if (glyphs == NULL)
+    {
+        printf("font_bake: %s is not a usable font\n", argv[2]);
+        return 1;
+    }
+
+    Rectangle *recs = NULL;
+    Image atlas = GenImageFontAtlas(glyphs, &recs, glyphCount, TEXT_SDF_BASE_SIZE, TEXT_SDF_PADDING, 1);
+    bool saved = SaveSdfFont(glyphs, recs, glyphCount, atlas, argv[1]);
+    printf("%s: %d glyphs at %dpx, %dx%d atlas\n", argv[1], glyphCount, TEXT_SDF_BASE_SIZE, atlas.width, atlas.height);
+
+    UnloadImage(atlas);
+    MemFree(recs);
+    UnloadFontData(glyphs, glyphCount);
+    return saved ? 0 : 1;
+}
@@ -0,0 +1,43 @@
+// Build time LOD baker, see src/lod.h
+// Usage: lod_bake out.lod [model.obj|.gltf|.glb|.iqm]
+// Without a model it bakes the sphere prop physim puts on the columns.
+#include "lod.h"
+#include <stdio.h>
+
+int main(int argc, char **argv)
+{
+    if (argc < 2 || argc > 3)
+    {
+        printf("usage: %s out.lod [model]\n", argv[0]);
+        return 1;
+    }
+
+    // model loaders and mesh generators upload to the GPU, they need a context
+    SetConfigFlags(FLAG_WINDOW_HIDDEN);
+    SetTraceLogLevel(LOG_WARNING);
+    InitWindow(64, 64, "lod_bake");
+
+    Model model = { 0 };
+    if (argc == 3) model = LoadModel(argv[2]);
+    else model = LoadModelFromMesh(GenMeshSphere(1.0f, 48, 48));
+    if (model.meshCount < 1)
+    {
+        printf("lod_bake: cannot load %s\n", argv[2]);
+        CloseWindow();
+        return 1;
+    }
+    if (model.meshCount > 1) printf("lod_bake: only the first of %d meshes is baked\n", model.meshCount);
+
+    LodModel lod = BuildLodModel(&model.meshes[0], LOD_MAX_LEVELS, NULL);
+    for (int32_t l = 0; l < lod.levelCount; l++)
+    {
+        printf("level %d: %6d triangles %6d vertices\n", l, lod.meshes[l].triangleCount, lod.meshes[l].vertexCount);
+    }
+    bool saved = SaveLodModel(&lod, argv[1]);
+    printf("%s: %d levels, radius %.3f\n", argv[1], lod.levelCount, lod.radius);
+
+    UnloadLodModel(&lod);
+    UnloadModel(model);
+    CloseWindow();
+    return saved ? 0 : 1;
+}
@@ -0,0 +1,61 @@
+// Headless particle update benchmark, no window or GL needed.
+// Usage: particle_bench [particles] [emitters] [threads]
+#include "particles.h"
+#include "jobs.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static double NowMs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec*1000.0 + ts.tv_nsec/1000000.0;
+}
+
+int main(int argc, char **argv)
+{
+    int32_t particles = (argc > 1) ? atoi(argv[1]) : 1000000;
+    int32_t emitters = (argc > 2) ? atoi(argv[2]) : PARTICLE_MAX_EMITTERS;
+    int32_t threads = (argc > 3) ? atoi(argv[3]) : 0;
+    const int frames = 240;
+    const float dt = 1.0f/60.0f;
+
+    if (emitters < 1) emitters = 1;
+    if (emitters > PARTICLE_MAX_EMITTERS) emitters = PARTICLE_MAX_EMITTERS;
+    JobsInit(threads);
+
+    ParticleSystem system = LoadParticleSystem(particles);
+    int32_t perEmitter = particles/emitters;
+    for (int32_t i = 0; i < emitters; i++)
+    {
+        // lifetimes long enough that the pool stays full and churns a bit each frame
+        AddParticleEmitter(&system, (ParticleEmitterDesc){
+            .speedMin = 1.0f, .speedMax = 5.0f, .spread = 1.0f,
+            .lifetimeMin = 1.0f, .lifetimeMax = 4.0f,
+            .sizeStart = 0.1f, .sizeEnd = 0.0f, .gravity = 9.8f, .drag = 0.5f,
+            .colorStart = { 255, 255, 255, 255 }, .colorEnd = { 255, 255, 255, 0 }
+        }, perEmitter);
+    }
+
+    // warm up: fill every emitter
+    for (int32_t i = 0; i < emitters; i++) EmitParticles(&system, i, (Vector3){ 0 }, (Vector3){ 0, 1, 0 }, perEmitter);
+    UpdateParticleSystem(&system, dt);
+
+    long long updated = 0;
+    double start = NowMs();
+    for (int f = 0; f < frames; f++)
+    {
+        updated += GetParticleCount(&system);
+        for (int32_t i = 0; i < emitters; i++) EmitParticles(&system, i, (Vector3){ 0 }, (Vector3){ 0, 1, 0 }, perEmitter/60);
+        UpdateParticleSystem(&system, dt);
+    }
+    double elapsed = NowMs() - start;
+
+    printf("particles: %d, emitters: %d, threads: %d\n", particles, emitters, JobsWorkerCount() + 1);
+    printf("frames: %d, %.3f ms/frame, %.0f particles/ms\n", frames, elapsed/frames, updated/elapsed);
+
+    UnloadParticleSystem(&system);
+    JobsShutdown();
+    return 0;
+}